@@ -5,11 +5,12 @@ import socket
 
 CURRENT_REQUEST_VERSION = 1
 MAX_REQUEST_DATA_SIZE = 32
-MAX_PACKET_SIZE = 48
+MAX_PACKET_SIZE = 56
 
 class RequestType(enum.IntEnum):
     ReadMemory = 1,
-    WriteMemory = 2
+    WriteMemory = 2,
+    GetIPCStats = 3
 
 CITRA_PORT = 45987
 
@@ -90,6 +91,26 @@ class Citra:
                 return False
         return True
 
+    def get_ipc_stats(self):
+        """
+        Returns a (service, header, calls, host_ns, sleep_ticks) tuple for each command of each
+        HLE service.
+        """
+        stats = []
+        while True:
+            request_data = struct.pack("II", len(stats), 0)
+            request, request_id = self._generate_header(RequestType.GetIPCStats, len(request_data))
+            request += request_data
+            self.socket.sendto(request, (self.address, CITRA_PORT))
+
+            raw_reply = self.socket.recv(MAX_PACKET_SIZE)
+            reply_data = self._read_and_validate_header(raw_reply, request_id, RequestType.GetIPCStats)
+
+            if not reply_data:
+                return stats
+            service, header, calls, host_ns, sleep_ticks = struct.unpack("8sI4xQQQ", reply_data)
+            stats.append((service.rstrip(b"\0").decode(), header, calls, host_ns, sleep_ticks))
+
 if "__main__" == __name__:
     import doctest
     doctest.testmod(extraglobs={'c': Citra()})
@@ -8,6 +8,7 @@
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/filter.h"
 #include "audio_core/hle/shared_memory.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 
 namespace AudioCore::HLE {
@@ -49,6 +50,13 @@ void SourceFilters::ProcessFrame(StereoFrame16& frame) {
 
 // SimpleFilter
 
+void SourceFilters::DoState(PointerWrap& p) {
+    p.Do(simple_filter_enabled);
+    p.Do(biquad_filter_enabled);
+    simple_filter.DoState(p);
+    biquad_filter.DoState(p);
+}
+
 void SourceFilters::SimpleFilter::Reset() {
     y1.fill(0);
     // Configure as passthrough.
@@ -77,6 +85,12 @@ std::array<s16, 2> SourceFilters::SimpleFilter::ProcessSample(const std::array<s
 
 // BiquadFilter
 
+void SourceFilters::SimpleFilter::DoState(PointerWrap& p) {
+    p.Do(a1);
+    p.Do(b0);
+    p.Do(y1);
+}
+
 void SourceFilters::BiquadFilter::Reset() {
     x1.fill(0);
     x2.fill(0);
@@ -112,4 +126,16 @@ std::array<s16, 2> SourceFilters::BiquadFilter::ProcessSample(const std::array<s
     return y0;
 }
 
+void SourceFilters::BiquadFilter::DoState(PointerWrap& p) {
+    p.Do(a1);
+    p.Do(a2);
+    p.Do(b0);
+    p.Do(b1);
+    p.Do(b2);
+    p.Do(x1);
+    p.Do(x2);
+    p.Do(y1);
+    p.Do(y2);
+}
+
 } // namespace AudioCore::HLE
@@ -9,6 +9,8 @@
 #include "audio_core/hle/shared_memory.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace AudioCore::HLE {
 
 /// Preprocessing filters. There is an independent set of filters for each Source.
@@ -48,6 +50,9 @@ public:
      */
     void ProcessFrame(StereoFrame16& frame);
 
+    /// Saves or restores the configuration and the internal state of the filters.
+    void DoState(PointerWrap& p);
+
 private:
     bool simple_filter_enabled;
     bool biquad_filter_enabled;
@@ -73,6 +78,8 @@ private:
          */
         std::array<s16, 2> ProcessSample(const std::array<s16, 2>& x0);
 
+        void DoState(PointerWrap& p);
+
     private:
         // Configuration
         s32 a1, b0;
@@ -101,6 +108,8 @@ private:
          */
         std::array<s16, 2> ProcessSample(const std::array<s16, 2>& x0);
 
+        void DoState(PointerWrap& p);
+
     private:
         // Configuration
         s32 a1, a2, b0, b1, b2;
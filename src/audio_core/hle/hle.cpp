@@ -16,6 +16,7 @@
 #include "audio_core/hle/source.h"
 #include "audio_core/sink.h"
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
@@ -46,6 +47,8 @@ public:
 
     void SetServiceToInterrupt(std::weak_ptr<DSP_DSP> dsp);
 
+    void DoState(PointerWrap& p);
+
 private:
     void ResetPipes();
     void WriteU16(DspPipe pipe_number, u16 value);
@@ -270,6 +273,17 @@ void DspHle::Impl::SetServiceToInterrupt(std::weak_ptr<DSP_DSP> dsp) {
     dsp_dsp = std::move(dsp);
 }
 
+void DspHle::Impl::DoState(PointerWrap& p) {
+    p.Do(dsp_state);
+    for (auto& data : pipe_data) {
+        p.Do(data);
+    }
+    for (auto& source : sources) {
+        source.DoState(p);
+    }
+    mixers.DoState(p);
+}
+
 void DspHle::Impl::ResetPipes() {
     for (auto& data : pipe_data) {
         data.clear();
@@ -454,4 +468,8 @@ void DspHle::UnloadComponent() {
     // Do nothing
 }
 
+void DspHle::DoState(PointerWrap& p) {
+    impl->DoState(p);
+}
+
 } // namespace AudioCore
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include "audio_core/hle/mixers.h"
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 
 namespace AudioCore::HLE {
@@ -15,6 +16,15 @@ void Mixers::Reset() {
     state = {};
 }
 
+void Mixers::DoState(PointerWrap& p) {
+    p.Do(current_frame);
+    p.Do(state.intermediate_mixer_volume);
+    p.Do(state.mixer1_enabled);
+    p.Do(state.mixer2_enabled);
+    p.Do(state.intermediate_mix_buffer);
+    p.Do(state.output_format);
+}
+
 DspStatus Mixers::Tick(DspConfiguration& config, const IntermediateMixSamples& read_samples,
                        IntermediateMixSamples& write_samples,
                        const std::array<QuadFrame32, 3>& input) {
@@ -8,6 +8,8 @@
 #include "audio_core/audio_types.h"
 #include "audio_core/hle/shared_memory.h"
 
+class PointerWrap;
+
 namespace AudioCore::HLE {
 
 class Mixers final {
@@ -25,6 +27,9 @@ public:
         return current_frame;
     }
 
+    /// Saves or restores the internal state.
+    void DoState(PointerWrap& p);
+
 private:
     StereoFrame16 current_frame = {};
 
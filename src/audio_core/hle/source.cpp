@@ -9,6 +9,7 @@
 #include "audio_core/hle/source.h"
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/memory.h"
 
@@ -48,6 +49,45 @@ void Source::SetMemory(Memory::MemorySystem& memory) {
     memory_system = &memory;
 }
 
+void Source::DoState(PointerWrap& p) {
+    p.Do(current_frame);
+    p.Do(state.enabled);
+    p.Do(state.sync);
+    p.Do(state.gain);
+
+    // The queue can only be walked by emptying it, so it's saved through a copy
+    std::vector<Buffer> input_queue;
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        auto queue = state.input_queue;
+        for (; !queue.empty(); queue.pop()) {
+            input_queue.push_back(queue.top());
+        }
+    }
+    p.Do(input_queue);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        state.input_queue = {};
+        for (const Buffer& buffer : input_queue) {
+            state.input_queue.push(buffer);
+        }
+    }
+
+    p.Do(state.mono_or_stereo);
+    p.Do(state.format);
+    p.Do(state.current_sample_number);
+    p.Do(state.next_sample_number);
+    p.Do(state.current_buffer);
+    p.Do(state.buffer_update);
+    p.Do(state.current_buffer_id);
+    p.Do(state.adpcm_coeffs);
+    p.Do(state.adpcm_state);
+    p.Do(state.rate_multiplier);
+    p.Do(state.interpolation_mode);
+    p.Do(state.interp_state.xn1);
+    p.Do(state.interp_state.xn2);
+    p.Do(state.interp_state.fposition);
+    state.filters.DoState(p);
+}
+
 void Source::ParseConfig(SourceConfiguration::Configuration& config,
                          const s16_le (&adpcm_coeffs)[16]) {
     if (!config.dirty_raw) {
@@ -14,6 +14,8 @@
 #include "audio_core/interpolate.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Memory {
 class MemorySystem;
 }
@@ -41,6 +43,9 @@ public:
     /// Sets the memory system to read data from
     void SetMemory(Memory::MemorySystem& memory);
 
+    /// Saves or restores the internal state, including the queued buffers.
+    void DoState(PointerWrap& p);
+
     /**
      * This is called once every audio frame. This performs per-source processing every frame.
      * @param config The new configuration we've got for this Source from the application.
@@ -245,8 +245,9 @@ std::optional<BinaryResponse> WMFDecoder::Impl::Decode(const BinaryRequest& requ
             LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch0 {:08x}", request.dst_addr_ch0);
             return {};
         }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch0 - Memory::FCRAM_PADDR),
-                    out_streams[0].data(), out_streams[0].size());
+        u8* dst = memory.GetFCRAMPointer(request.dst_addr_ch0 - Memory::FCRAM_PADDR);
+        std::memcpy(dst, out_streams[0].data(), out_streams[0].size());
+        memory.MarkHostRegionDirty(dst, out_streams[0].size());
     }
 
     if (out_streams[1].size() != 0) {
@@ -256,8 +257,9 @@ std::optional<BinaryResponse> WMFDecoder::Impl::Decode(const BinaryRequest& requ
             LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch1 {:08x}", request.dst_addr_ch1);
             return {};
         }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch1 - Memory::FCRAM_PADDR),
-                    out_streams[1].data(), out_streams[1].size());
+        u8* dst = memory.GetFCRAMPointer(request.dst_addr_ch1 - Memory::FCRAM_PADDR);
+        std::memcpy(dst, out_streams[1].data(), out_streams[1].size());
+        memory.MarkHostRegionDirty(dst, out_streams[1].size());
     }
 
     return response;
@@ -9,6 +9,7 @@
 #include "audio_core/lle/lle.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/chunk_file.h"
 #include "common/swap.h"
 #include "common/thread.h"
 #include "core/core.h"
@@ -473,6 +474,12 @@ void DspLle::UnloadComponent() {
     impl->UnloadComponent();
 }
 
+void DspLle::DoState(PointerWrap& p) {
+    // The state of the emulated DSP core isn't accessible through Teakra
+    LOG_ERROR(Audio_DSP, "States can't be saved or loaded with the LLE DSP");
+    p.SetError(PointerWrap::ERROR_FAILURE);
+}
+
 DspLle::DspLle(Memory::MemorySystem& memory, bool multithread)
     : impl(std::make_unique<Impl>(multithread)) {
     Teakra::AHBMCallback ahbm;
@@ -480,7 +487,9 @@ DspLle::DspLle(Memory::MemorySystem& memory, bool multithread)
         return *memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR);
     };
     ahbm.write8 = [&memory](u32 address, u8 value) {
-        *memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR) = value;
+        u8* dst = memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR);
+        *dst = value;
+        memory.MarkHostRegionDirty(dst, sizeof(value));
     };
     impl->teakra.SetAHBMCallback(ahbm);
     impl->teakra.SetAudioCallback([this](std::array<s16, 2> sample) { OutputSample(sample); });
@@ -103,6 +103,10 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.enable_idle_loop_detection =
+        sdl2_config->GetBoolean("Core", "enable_idle_loop_detection", true);
+    Settings::values.idle_loop_detection_excluded_titles =
+        sdl2_config->GetString("Core", "idle_loop_detection_excluded_titles", "");
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -175,6 +179,10 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.keep_saves_in_memory =
+        sdl2_config->GetBoolean("Data Storage", "keep_saves_in_memory", false);
+    Settings::values.use_shared_title_cache =
+        sdl2_config->GetBoolean("Data Storage", "use_shared_title_cache", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
@@ -231,6 +239,9 @@ void Config::ReadValues() {
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
+    Settings::values.enable_guest_profiler =
+        sdl2_config->GetBoolean("Debugging", "enable_guest_profiler", false);
+    Settings::values.log_ipc_stats = sdl2_config->GetBoolean("Debugging", "log_ipc_stats", false);
 
     for (const auto& service_module : Service::service_module_map) {
         bool use_lle = sdl2_config->GetBoolean("Debugging", "LLE\\" + service_module.name, false);
@@ -10,8 +10,10 @@
 #include "citra_qt/applets/mii_selector.h"
 #include "common/file_util.h"
 #include "common/string_util.h"
+#include "core/core.h"
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/file_backend.h"
+#include "core/hle/service/fs/archive.h"
 #include "core/hle/service/ptm/ptm.h"
 
 QtMiiSelectorDialog::QtMiiSelectorDialog(QWidget* parent, QtMiiSelector* mii_selector_)
@@ -35,7 +37,8 @@ QtMiiSelectorDialog::QtMiiSelectorDialog(QWidget* parent, QtMiiSelector* mii_sel
     combobox->addItem(tr("Standard Mii"));
 
     std::string nand_directory{FileUtil::GetUserPath(FileUtil::UserPath::NANDDir)};
-    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(nand_directory, true);
+    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(
+        nand_directory, true, Core::System::GetInstance().ArchiveManager().GetWriteBackCache());
 
     auto archive_result = extdata_archive_factory.Open(Service::PTM::ptm_shared_extdata_id, 0);
     if (archive_result.Succeeded()) {
@@ -54,19 +54,22 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // QKeySequnce(...).toString() is NOT ALLOWED HERE.
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
-const std::array<UISettings::Shortcut, 19> Config::default_hotkeys{
+const std::array<UISettings::Shortcut, 22> Config::default_hotkeys{
     {{"Advance Frame", "Main Window", {"\\", Qt::ApplicationShortcut}},
      {"Capture Screenshot", "Main Window", {"Ctrl+P", Qt::ApplicationShortcut}},
      {"Continue/Pause Emulation", "Main Window", {"F4", Qt::WindowShortcut}},
      {"Decrease Speed Limit", "Main Window", {"-", Qt::ApplicationShortcut}},
+     {"Dump Guest Profile", "Main Window", {"Ctrl+Shift+P", Qt::ApplicationShortcut}},
      {"Exit Citra", "Main Window", {"Ctrl+Q", Qt::WindowShortcut}},
      {"Exit Fullscreen", "Main Window", {"Esc", Qt::WindowShortcut}},
      {"Fullscreen", "Main Window", {"F11", Qt::WindowShortcut}},
      {"Increase Speed Limit", "Main Window", {"+", Qt::ApplicationShortcut}},
      {"Load Amiibo", "Main Window", {"F2", Qt::ApplicationShortcut}},
      {"Load File", "Main Window", {"Ctrl+O", Qt::WindowShortcut}},
+     {"Load State", "Main Window", {"F8", Qt::ApplicationShortcut}},
      {"Remove Amiibo", "Main Window", {"F3", Qt::ApplicationShortcut}},
      {"Restart Emulation", "Main Window", {"F6", Qt::WindowShortcut}},
+     {"Save State", "Main Window", {"F7", Qt::ApplicationShortcut}},
      {"Stop Emulation", "Main Window", {"F5", Qt::WindowShortcut}},
      {"Swap Screens", "Main Window", {"F9", Qt::WindowShortcut}},
      {"Toggle Filter Bar", "Main Window", {"Ctrl+F", Qt::WindowShortcut}},
@@ -145,6 +148,10 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = ReadSetting("use_cpu_jit", true).toBool();
+    Settings::values.enable_idle_loop_detection =
+        ReadSetting("enable_idle_loop_detection", true).toBool();
+    Settings::values.idle_loop_detection_excluded_titles =
+        ReadSetting("idle_loop_detection_excluded_titles", "").toString().toStdString();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -227,6 +234,9 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = ReadSetting("use_virtual_sd", true).toBool();
+    Settings::values.keep_saves_in_memory = ReadSetting("keep_saves_in_memory", false).toBool();
+    Settings::values.use_shared_title_cache =
+        ReadSetting("use_shared_title_cache", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -245,6 +255,8 @@ void Config::ReadValues() {
     qt_config->beginGroup("Debugging");
     Settings::values.use_gdbstub = ReadSetting("use_gdbstub", false).toBool();
     Settings::values.gdbstub_port = ReadSetting("gdbstub_port", 24689).toInt();
+    Settings::values.enable_guest_profiler = ReadSetting("enable_guest_profiler", false).toBool();
+    Settings::values.log_ipc_stats = ReadSetting("log_ipc_stats", false).toBool();
 
     qt_config->beginGroup("LLE");
     for (const auto& service_module : Service::service_module_map) {
@@ -442,6 +454,9 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     WriteSetting("use_cpu_jit", Settings::values.use_cpu_jit, true);
+    WriteSetting("enable_idle_loop_detection", Settings::values.enable_idle_loop_detection, true);
+    WriteSetting("idle_loop_detection_excluded_titles",
+                 QString::fromStdString(Settings::values.idle_loop_detection_excluded_titles), "");
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -510,6 +525,8 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Data Storage");
     WriteSetting("use_virtual_sd", Settings::values.use_virtual_sd, true);
+    WriteSetting("keep_saves_in_memory", Settings::values.keep_saves_in_memory, false);
+    WriteSetting("use_shared_title_cache", Settings::values.use_shared_title_cache, false);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -528,6 +545,8 @@ void Config::SaveValues() {
     qt_config->beginGroup("Debugging");
     WriteSetting("use_gdbstub", Settings::values.use_gdbstub, false);
     WriteSetting("gdbstub_port", Settings::values.gdbstub_port, 24689);
+    WriteSetting("enable_guest_profiler", Settings::values.enable_guest_profiler, false);
+    WriteSetting("log_ipc_stats", Settings::values.log_ipc_stats, false);
 
     qt_config->beginGroup("LLE");
     for (const auto& service_module : Settings::values.lle_modules) {
@@ -51,12 +51,14 @@ std::size_t WaitTreeItem::Row() const {
 }
 
 std::vector<std::unique_ptr<WaitTreeThread>> WaitTreeItem::MakeThreadItemList() {
-    const auto& threads = Core::System::GetInstance().Kernel().GetThreadManager().GetThreadList();
+    auto& kernel = Core::System::GetInstance().Kernel();
     std::vector<std::unique_ptr<WaitTreeThread>> item_list;
-    item_list.reserve(threads.size());
-    for (std::size_t i = 0; i < threads.size(); ++i) {
-        item_list.push_back(std::make_unique<WaitTreeThread>(*threads[i]));
-        item_list.back()->row = i;
+    for (u32 core_id = 0; core_id < kernel.GetNumCores(); ++core_id) {
+        const auto& threads = kernel.GetThreadManager(core_id).GetThreadList();
+        for (const auto& thread : threads) {
+            item_list.push_back(std::make_unique<WaitTreeThread>(*thread));
+            item_list.back()->row = item_list.size() - 1;
+        }
     }
     return item_list;
 }
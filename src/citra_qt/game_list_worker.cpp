@@ -18,6 +18,7 @@
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
+#include "core/loader/title_info_cache.h"
 
 namespace {
 bool HasSupportedFileExtension(const std::string& file_name) {
@@ -34,87 +35,94 @@ GameListWorker::~GameListWorker() = default;
 
 void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                              GameListDir* parent_dir) {
-    const auto callback = [this, recursion, parent_dir](u64* num_entries_out,
-                                                        const std::string& directory,
-                                                        const std::string& virtual_name) -> bool {
+    std::vector<std::string> files;
+    std::vector<std::string> subdirs;
+    const auto callback = [this, recursion, &files, &subdirs](u64* num_entries_out,
+                                                              const std::string& directory,
+                                                              const std::string& virtual_name) {
         if (stop_processing) {
             // Breaks the callback loop.
             return false;
         }
 
-        const std::string physical_name = directory + DIR_SEP + virtual_name;
+        std::string physical_name = directory + DIR_SEP + virtual_name;
         const bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
-
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
-
-            u64 extdata_id = 0;
-            loader->ReadExtdataId(extdata_id);
-
-            std::vector<u8> smdh = [program_id, &loader]() -> std::vector<u8> {
-                std::vector<u8> original_smdh;
-                loader->ReadIcon(original_smdh);
-
-                if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
-                    return original_smdh;
-
-                std::string update_path = Service::AM::GetTitleContentPath(
-                    Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000);
-
-                if (!FileUtil::Exists(update_path))
-                    return original_smdh;
-
-                std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+            files.push_back(std::move(physical_name));
+        } else if (is_dir && recursion > 0) {
+            subdirs.push_back(std::move(physical_name));
+        }
+        return true;
+    };
+    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
 
-                if (!update_loader)
-                    return original_smdh;
+    // Only files that changed since the last scan are opened, several at a time
+    const std::vector<Loader::TitleInfo> infos = title_info_cache->Scan(files, &stop_processing);
+    for (std::size_t i = 0; i < infos.size(); ++i) {
+        const Loader::TitleInfo& info = infos[i];
+        if (info.file_type == Loader::FileType::Unknown ||
+            info.file_type == Loader::FileType::Error) {
+            continue;
+        }
 
-                std::vector<u8> update_smdh;
-                update_loader->ReadIcon(update_smdh);
-                return update_smdh;
-            }();
+        const u64 program_id = info.program_id;
+        std::vector<u8> smdh = [this, &info]() -> std::vector<u8> {
+            if (info.program_id < 0x0004000000000000 || info.program_id > 0x00040000FFFFFFFF)
+                return info.smdh;
 
-            if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
-                // Skip this invalid entry
-                return true;
-            }
+            std::string update_path = Service::AM::GetTitleContentPath(
+                Service::FS::MediaType::SDMC, info.program_id + 0x0000000E00000000);
 
-            auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
+            if (!FileUtil::Exists(update_path))
+                return info.smdh;
 
-            // The game list uses this as compatibility number for untested games
-            QString compatibility("99");
-            if (it != compatibility_list.end())
-                compatibility = it->second.first;
+            Loader::TitleInfo update_info = title_info_cache->Get(update_path);
+            if (update_info.file_type == Loader::FileType::Unknown ||
+                update_info.file_type == Loader::FileType::Error)
+                return info.smdh;
 
-            emit EntryReady(
-                {
-                    new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id,
-                                         extdata_id),
-                    new GameListItemCompat(compatibility),
-                    new GameListItemRegion(smdh),
-                    new GameListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                    new GameListItemSize(FileUtil::GetSize(physical_name)),
-                },
-                parent_dir);
+            return std::move(update_info.smdh);
+        }();
 
-        } else if (is_dir && recursion > 0) {
-            watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+        if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
+            // Skip this invalid entry
+            continue;
         }
 
-        return true;
-    };
-
-    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+        // Compatibility is looked up on every scan, so that updates to the list show up
+        auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
+
+        // The game list uses this as compatibility number for untested games
+        QString compatibility("99");
+        if (it != compatibility_list.end())
+            compatibility = it->second.first;
+
+        emit EntryReady(
+            {
+                new GameListItemPath(QString::fromStdString(files[i]), smdh, program_id,
+                                     info.extdata_id),
+                new GameListItemCompat(compatibility),
+                new GameListItemRegion(smdh),
+                new GameListItem(
+                    QString::fromStdString(Loader::GetFileTypeString(info.file_type))),
+                new GameListItemSize(FileUtil::GetSize(files[i])),
+            },
+            parent_dir);
+    }
+
+    for (const std::string& subdir : subdirs) {
+        if (stop_processing) {
+            return;
+        }
+        watch_list.append(QString::fromStdString(subdir));
+        AddFstEntriesToGameList(subdir, recursion - 1, parent_dir);
+    }
 }
 
 void GameListWorker::run() {
     stop_processing = false;
+    title_info_cache =
+        std::make_unique<Loader::TitleInfoCache>(Loader::GetDefaultTitleInfoCachePath());
     for (UISettings::GameDir& game_dir : game_dirs) {
         if (game_dir.path == "INSTALLED") {
             QString games_path =
@@ -149,6 +157,8 @@ void GameListWorker::run() {
                                     game_list_dir);
         }
     };
+    title_info_cache->Save();
+    title_info_cache.reset();
     emit Finished(watch_list);
 }
 
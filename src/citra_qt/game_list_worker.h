@@ -18,6 +18,10 @@
 
 class QStandardItem;
 
+namespace Loader {
+class TitleInfoCache;
+}
+
 /**
  * Asynchronous worker object for populating the game list.
  * Communicates with other threads through Qt's signal/slot system.
@@ -59,4 +63,5 @@ private:
     const CompatibilityList& compatibility_list;
     QList<UISettings::GameDir>& game_dirs;
     std::atomic_bool stop_processing;
+    std::unique_ptr<Loader::TitleInfoCache> title_info_cache;
 };
@@ -441,6 +441,26 @@ void GMainWindow::InitializeHotkeys() {
                     OnRemoveAmiibo();
                 }
             });
+    connect(hotkey_registry.GetHotkey("Main Window", "Dump Guest Profile", this),
+            &QShortcut::activated, this, [&] {
+                if (emu_thread != nullptr) {
+                    Core::System::GetInstance().RequestGuestProfileDump();
+                }
+            });
+    connect(hotkey_registry.GetHotkey("Main Window", "Save State", this), &QShortcut::activated,
+            this, [&] {
+                if (emu_thread != nullptr) {
+                    auto& system = Core::System::GetInstance();
+                    system.RequestSaveState(system.GetSaveStatePath(0), Core::SaveStateMode::Full);
+                }
+            });
+    connect(hotkey_registry.GetHotkey("Main Window", "Load State", this), &QShortcut::activated,
+            this, [&] {
+                if (emu_thread != nullptr) {
+                    auto& system = Core::System::GetInstance();
+                    system.RequestLoadState(system.GetSaveStatePath(0));
+                }
+            });
     connect(hotkey_registry.GetHotkey("Main Window", "Capture Screenshot", this),
             &QShortcut::activated, this, [&] {
                 if (emu_thread->IsRunning()) {
@@ -103,6 +103,10 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl1_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.enable_idle_loop_detection =
+        sdl1_config->GetBoolean("Core", "enable_idle_loop_detection", true);
+    Settings::values.idle_loop_detection_excluded_titles =
+        sdl1_config->GetString("Core", "idle_loop_detection_excluded_titles", "");
 
     // Renderer
     // Always use software rendering
@@ -169,6 +173,10 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl1_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.keep_saves_in_memory =
+        sdl1_config->GetBoolean("Data Storage", "keep_saves_in_memory", false);
+    Settings::values.use_shared_title_cache =
+        sdl1_config->GetBoolean("Data Storage", "use_shared_title_cache", false);
 
     // System
     Settings::values.is_new_3ds = sdl1_config->GetBoolean("System", "is_new_3ds", false);
@@ -225,6 +233,9 @@ void Config::ReadValues() {
     Settings::values.use_gdbstub = sdl1_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl1_config->GetInteger("Debugging", "gdbstub_port", 24689));
+    Settings::values.enable_guest_profiler =
+        sdl1_config->GetBoolean("Debugging", "enable_guest_profiler", false);
+    Settings::values.log_ipc_stats = sdl1_config->GetBoolean("Debugging", "log_ipc_stats", false);
 
     for (const auto& service_module : Service::service_module_map) {
         bool use_lle = sdl1_config->GetBoolean("Debugging", "LLE\\" + service_module.name, false);
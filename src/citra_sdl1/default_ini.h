@@ -91,6 +91,14 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether to fast-forward to the next event when the CPU is detected spinning in an idle loop
+# 0: Off, 1 (default): On
+enable_idle_loop_detection =
+
+# Comma-separated list of program IDs (in hex) for which idle loop detection is always disabled
+# Default: empty
+idle_loop_detection_excluded_titles =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -205,6 +213,16 @@ volume =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether to keep writes to save data, extra data and the SD card in memory instead of writing
+# them to disk, for throwaway and automated runs. They are lost when Citra exits.
+# 0 (default): No, 1: Yes
+keep_saves_in_memory =
+
+# Whether to keep decrypted and decompressed title code and RomFS in the cache directory, where
+# other Citra instances running the same title map them instead of decrypting their own copy.
+# 0 (default): No, 1: Yes
+use_shared_title_cache =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
@@ -254,6 +272,13 @@ log_filter = *:Info
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
+# Counts executed guest code blocks and cycles per module, and writes a hotspot report and
+# flamegraph-compatible folded stacks to the log directory on exit
+# 0 (default): Off, 1: On
+enable_guest_profiler =
+# Logs the HLE service commands that took the most host time every 10 seconds of emulated time
+# 0 (default): Off, 1: On
+log_ipc_stats =
 # To LLE a service module add "LLE\<module name>=true"
 
 [WebService]
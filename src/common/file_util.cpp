@@ -42,6 +42,7 @@
 #include <cstring>
 #include <dirent.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -350,6 +351,21 @@ u64 GetSize(const std::string& filename) {
     return 0;
 }
 
+s64 GetModificationTime(const std::string& filename) {
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(filename).c_str(), &buf) == 0)
+#else
+    if (stat(filename.c_str(), &buf) == 0)
+#endif
+    {
+        return static_cast<s64>(buf.st_mtime);
+    }
+
+    LOG_ERROR(Common_Filesystem, "Stat failed {}: {}", filename, GetLastErrorMsg());
+    return 0;
+}
+
 // Overloaded GetSize, accepts file descriptor
 u64 GetSize(const int fd) {
     struct stat buf;
@@ -447,6 +463,62 @@ bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
     return true;
 }
 
+bool ForeachDirectoryEntryWithType(const std::string& directory,
+                                   DirectoryEntryTypeCallable callback) {
+    LOG_TRACE(Common_Filesystem, "directory {}", directory);
+
+    bool callback_error = false;
+
+#ifdef _WIN32
+    WIN32_FIND_DATAW ffd;
+
+    HANDLE handle_find = FindFirstFileW(Common::UTF8ToUTF16W(directory + "\\*").c_str(), &ffd);
+    if (handle_find == INVALID_HANDLE_VALUE) {
+        FindClose(handle_find);
+        return false;
+    }
+    do {
+        const std::string virtual_name(Common::UTF16ToUTF8(ffd.cFileName));
+        if (virtual_name == "." || virtual_name == "..")
+            continue;
+
+        const bool is_directory = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+    DIR* dirp = opendir(directory.c_str());
+    if (!dirp)
+        return false;
+
+    while (struct dirent* result = readdir(dirp)) {
+        const std::string virtual_name(result->d_name);
+        if (virtual_name == "." || virtual_name == "..")
+            continue;
+
+#ifdef DT_DIR
+        // Not every file system fills in the type, and symlinks have to be followed
+        const bool is_directory = result->d_type == DT_UNKNOWN || result->d_type == DT_LNK
+                                      ? IsDirectory(directory + DIR_SEP + virtual_name)
+                                      : result->d_type == DT_DIR;
+#else
+        const bool is_directory = IsDirectory(directory + DIR_SEP + virtual_name);
+#endif
+#endif
+
+        if (!callback(directory, virtual_name, is_directory)) {
+            callback_error = true;
+            break;
+        }
+
+#ifdef _WIN32
+    } while (FindNextFileW(handle_find, &ffd) != 0);
+    FindClose(handle_find);
+#else
+    }
+    closedir(dirp);
+#endif
+
+    return !callback_error;
+}
+
 u64 ScanDirectoryTree(const std::string& directory, FSTEntry& parent_entry,
                       unsigned int recursion) {
     const auto callback = [recursion, &parent_entry](u64* num_entries_out,
@@ -721,6 +793,7 @@ void SetUserPath(const std::string& path) {
     g_paths.emplace(UserPath::LogDir, user_path + LOG_DIR DIR_SEP);
     g_paths.emplace(UserPath::CheatsDir, user_path + CHEATS_DIR DIR_SEP);
     g_paths.emplace(UserPath::DLLDir, user_path + DLL_DIR DIR_SEP);
+    g_paths.emplace(UserPath::StatesDir, user_path + STATES_DIR DIR_SEP);
 }
 
 // Returns a string with a Citra data dir or file in the user's home
@@ -866,6 +939,47 @@ bool IOFile::Flush() {
     return m_good;
 }
 
+std::size_t IOFile::ReadBytesAt(void* data, std::size_t length, u64 offset) const {
+    if (!IsOpen()) {
+        return 0;
+    }
+
+    u8* out = static_cast<u8*>(data);
+    std::size_t total_read = 0;
+#ifdef _WIN32
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+    while (total_read < length) {
+        const u64 position = offset + total_read;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        // ReadFile takes a 32-bit size
+        const DWORD chunk =
+            static_cast<DWORD>(std::min<std::size_t>(length - total_read, 0x80000000));
+        DWORD chunk_read = 0;
+        if (!ReadFile(handle, out + total_read, chunk, &chunk_read, &overlapped) ||
+            chunk_read == 0) {
+            break;
+        }
+        total_read += chunk_read;
+    }
+#else
+    const int fd = fileno(m_file);
+    while (total_read < length) {
+        const ssize_t chunk_read =
+            pread(fd, out + total_read, length - total_read, offset + total_read);
+        if (chunk_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (chunk_read <= 0) {
+            break;
+        }
+        total_read += static_cast<std::size_t>(chunk_read);
+    }
+#endif
+    return total_read;
+}
+
 bool IOFile::Resize(u64 size) {
     if (!IsOpen() || 0 !=
 #ifdef _WIN32
@@ -882,4 +996,113 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+FileMapping::FileMapping() = default;
+
+FileMapping::~FileMapping() {
+    Unmap();
+}
+
+FileMapping::FileMapping(FileMapping&& other) {
+    Swap(other);
+}
+
+FileMapping& FileMapping::operator=(FileMapping&& other) {
+    Swap(other);
+    return *this;
+}
+
+void FileMapping::Swap(FileMapping& other) {
+    std::swap(view, other.view);
+    std::swap(view_size, other.view_size);
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(file_end, other.file_end);
+#ifdef _WIN32
+    std::swap(mapping_handle, other.mapping_handle);
+#endif
+}
+
+bool FileMapping::Map(const IOFile& file, u64 offset, std::size_t size_) {
+    Unmap();
+    if (!file.IsOpen() || size_ == 0) {
+        return false;
+    }
+
+    // Pages of a mapping past the end of the file can't be read, accessing them raises SIGBUS
+    const u64 file_size = file.GetSize();
+    if (offset > file_size || size_ > file_size - offset) {
+        LOG_ERROR(Common_Filesystem, "Can't map 0x{:X} bytes at 0x{:X} of a 0x{:X} byte file",
+                  size_, offset, file_size);
+        return false;
+    }
+
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    const u64 granularity = system_info.dwAllocationGranularity;
+    const u64 view_offset = offset - offset % granularity;
+    const std::size_t new_view_size = static_cast<std::size_t>(offset - view_offset) + size_;
+
+    const HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file.m_file)));
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        LOG_ERROR(Common_Filesystem, "CreateFileMapping failed: {}", GetLastErrorMsg());
+        return false;
+    }
+    view = MapViewOfFile(mapping_handle, FILE_MAP_READ, static_cast<DWORD>(view_offset >> 32),
+                         static_cast<DWORD>(view_offset), new_view_size);
+    if (view == nullptr) {
+        LOG_ERROR(Common_Filesystem, "MapViewOfFile failed: {}", GetLastErrorMsg());
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+        return false;
+    }
+#else
+    const u64 granularity = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    const u64 view_offset = offset - offset % granularity;
+    const std::size_t new_view_size = static_cast<std::size_t>(offset - view_offset) + size_;
+
+    void* new_view = mmap(nullptr, new_view_size, PROT_READ, MAP_SHARED, fileno(file.m_file),
+                          static_cast<off_t>(view_offset));
+    if (new_view == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "mmap failed: {}", GetLastErrorMsg());
+        return false;
+    }
+    view = new_view;
+#endif
+
+    view_size = new_view_size;
+    data = static_cast<const u8*>(view) + (offset - view_offset);
+    size = size_;
+    file_end = offset + size_;
+    return true;
+}
+
+bool FileMapping::IsInBounds(const IOFile& file) const {
+#ifdef _WIN32
+    return true;
+#else
+    struct stat file_info;
+    return fstat(fileno(file.m_file), &file_info) == 0 &&
+           static_cast<u64>(file_info.st_size) >= file_end;
+#endif
+}
+
+void FileMapping::Unmap() {
+    if (view != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+#else
+        munmap(view, view_size);
+#endif
+    }
+    view = nullptr;
+    view_size = 0;
+    data = nullptr;
+    size = 0;
+    file_end = 0;
+}
+
 } // namespace FileUtil
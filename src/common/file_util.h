@@ -29,6 +29,7 @@ enum class UserPath {
     NANDDir,
     RootDir,
     SDMCDir,
+    StatesDir,
     SysDataDir,
     UserDir,
 };
@@ -57,6 +58,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the last modification time of filename in seconds since the epoch, or 0 on failure
+s64 GetModificationTime(const std::string& filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -101,6 +105,26 @@ using DirectoryEntryCallable = std::function<bool(
 bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
                            DirectoryEntryCallable callback);
 
+/**
+ * @param directory the path to the enclosing directory
+ * @param virtual_name the entry name, without any preceding directory info
+ * @param is_directory whether the entry is a directory
+ * @return whether handling the entry succeeded
+ */
+using DirectoryEntryTypeCallable = std::function<bool(
+    const std::string& directory, const std::string& virtual_name, bool is_directory)>;
+
+/**
+ * Scans a directory like ForeachDirectoryEntry, also telling the callback whether each entry is a
+ * directory. The type is taken from the directory listing where the host provides it, so that
+ * entries don't have to be looked up one by one.
+ * @param directory the directory to scan
+ * @param callback The callback which will be called for each entry
+ * @return whether scanning the directory succeeded
+ */
+bool ForeachDirectoryEntryWithType(const std::string& directory,
+                                   DirectoryEntryTypeCallable callback);
+
 /**
  * Scans the directory tree, storing the results.
  * @param directory the parent directory to start scanning from
@@ -232,6 +256,14 @@ public:
         return WriteArray(str.c_str(), str.length());
     }
 
+    /**
+     * Reads from the given position of the file, with pread() where available. Unlike the other
+     * read functions, this doesn't use the file position, so several threads can read from the
+     * same file at once. It should not be mixed with buffered reads and writes on the same file.
+     * @returns The number of bytes read
+     */
+    std::size_t ReadBytesAt(void* data, std::size_t length, u64 offset) const;
+
     bool IsOpen() const {
         return nullptr != m_file;
     }
@@ -257,10 +289,66 @@ public:
     }
 
 private:
+    friend class FileMapping;
+
     std::FILE* m_file = nullptr;
     bool m_good = true;
 };
 
+/// A read-only view of part of a file, mapped into memory
+class FileMapping : public NonCopyable {
+public:
+    FileMapping();
+    ~FileMapping();
+
+    FileMapping(FileMapping&& other);
+    FileMapping& operator=(FileMapping&& other);
+
+    /**
+     * Maps part of a file into memory. The mapping stays valid after the file is closed.
+     * @returns false if the host doesn't support mapping files, if the range doesn't lie within
+     *          the file, or if the mapping failed
+     */
+    bool Map(const IOFile& file, u64 offset, std::size_t size);
+
+    /**
+     * Checks that the file still covers the mapped range. On POSIX hosts, reading a part of the
+     * mapping that was cut off by truncating the file raises SIGBUS. Windows doesn't allow
+     * truncating mapped files.
+     * @param file The file the mapping was created from
+     */
+    bool IsInBounds(const IOFile& file) const;
+
+    void Unmap();
+
+    bool IsMapped() const {
+        return data != nullptr;
+    }
+
+    /// Gets a pointer to the start of the mapped part of the file
+    const u8* GetPointer() const {
+        return data;
+    }
+
+    std::size_t GetSize() const {
+        return size;
+    }
+
+private:
+    void Swap(FileMapping& other);
+
+    // The view starts at an offset the host can map at, which may be before the requested one
+    void* view = nullptr;
+    std::size_t view_size = 0;
+    const u8* data = nullptr;
+    std::size_t size = 0;
+    /// Offset in the file of the end of the mapped range
+    u64 file_end = 0;
+#ifdef _WIN32
+    void* mapping_handle = nullptr;
+#endif
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
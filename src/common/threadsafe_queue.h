@@ -7,6 +7,7 @@
 // a simple lockless thread-safe,
 // single reader, single writer queue
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
@@ -162,4 +163,71 @@ private:
     SPSCQueue<T> spsc_queue;
     std::mutex write_lock;
 };
+
+// a lockless thread-safe, bounded,
+// single reader, multiple writer queue
+
+template <typename T, std::size_t Capacity>
+class BoundedMPSCQueue {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    BoundedMPSCQueue() {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false without blocking if the queue is full.
+    template <typename Arg>
+    bool Push(Arg&& t) {
+        std::size_t pos = write_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                // The cell is free, try to claim it
+                if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::forward<Arg>(t);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The reader hasn't consumed this cell yet
+                return false;
+            } else {
+                // Another writer claimed the cell first
+                pos = write_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Must only be called from the reader thread.
+    bool Pop(T& t) {
+        Cell& cell = cells[read_pos & (Capacity - 1)];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != read_pos + 1) {
+            return false;
+        }
+        t = std::move(cell.value);
+        cell.sequence.store(read_pos + Capacity, std::memory_order_release);
+        ++read_pos;
+        return true;
+    }
+
+private:
+    // A slot of the ring. The sequence number tells whose turn it is: it equals the write
+    // position when the cell is free, and the write position plus one once it holds a value.
+    struct Cell {
+        std::atomic_size_t sequence;
+        T value;
+    };
+
+    std::array<Cell, Capacity> cells;
+    alignas(64) std::atomic_size_t write_pos{0};
+    alignas(64) std::size_t read_pos = 0;
+};
 } // namespace Common
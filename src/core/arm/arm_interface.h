@@ -4,15 +4,20 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <memory>
 #include "common/common_types.h"
+#include "core/arm/idle_loop_detector.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/arm/skyeye_common/vfp/asm_vfp.h"
 
+class GuestProfiler;
+
 /// Generic ARM11 CPU interface
 class ARM_Interface : NonCopyable {
 public:
+    explicit ARM_Interface(Memory::MemorySystem& memory) : idle_loop_detector(memory) {}
     virtual ~ARM_Interface() {}
 
     class ThreadContext {
@@ -98,6 +103,13 @@ public:
      */
     virtual void SetReg(int index, u32 value) = 0;
 
+    /**
+     * Gets the general purpose register file of the running context, for callers that access many
+     * registers in a row, like SVC handlers. The reference is only valid until the page table
+     * changes.
+     */
+    virtual std::array<u32, 16>& GetRegisters() = 0;
+
     /**
      * Gets the value of a VFP register
      * @param index Register index (0-31)
@@ -172,4 +184,38 @@ public:
 
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
+
+    /// Enables or disables idle-loop and spin-wait detection for this core
+    void SetIdleLoopDetection(bool enable) {
+        idle_loop_detector.SetEnabled(enable);
+        ClearInstructionCache();
+    }
+
+    IdleLoopDetector& GetIdleLoopDetector() {
+        return idle_loop_detector;
+    }
+
+    /**
+     * Stops execution as soon as possible and, once the executed cycles have been accounted for,
+     * fast-forwards Core::Timing to the next scheduled event. Used when the running thread is
+     * known to be spinning without making progress.
+     */
+    void RequestIdle() {
+        idle_requested = true;
+        PrepareReschedule();
+    }
+
+    /// Sets the profiler that executed guest code is reported to, or nullptr to stop reporting.
+    virtual void SetGuestProfiler(GuestProfiler* profiler) {
+        guest_profiler = profiler;
+    }
+
+protected:
+    IdleLoopDetector idle_loop_detector;
+
+    /// Receives execution statistics while guest profiling is enabled
+    GuestProfiler* guest_profiler = nullptr;
+
+    /// Set by RequestIdle(), consumed by the backend once the current run returns
+    bool idle_requested = false;
 };
@@ -9,6 +9,7 @@
 #include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
+#include "core/arm/guest_profiler.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -103,6 +104,11 @@ public:
     }
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
+        RunInterpreter(pc, num_instructions);
+    }
+
+    /// Runs instructions on the interpreter, returning the number of instructions executed
+    unsigned RunInterpreter(VAddr pc, std::size_t num_instructions) {
         parent.interpreter_state->Reg = parent.jit->Regs();
         parent.interpreter_state->Cpsr = parent.jit->Cpsr();
         parent.interpreter_state->Reg[15] = pc;
@@ -110,7 +116,7 @@ public:
         parent.interpreter_state->VFP[VFP_FPSCR] = parent.jit->Fpscr();
         parent.interpreter_state->NumInstrsToExecute = num_instructions;
 
-        InterpreterMainLoop(parent.interpreter_state.get());
+        const unsigned instructions_executed = InterpreterMainLoop(parent.interpreter_state.get());
 
         bool is_thumb = (parent.interpreter_state->Cpsr & (1 << 5)) != 0;
         parent.interpreter_state->Reg[15] &= (is_thumb ? 0xFFFFFFFE : 0xFFFFFFFC);
@@ -121,6 +127,7 @@ public:
         parent.jit->SetFpscr(parent.interpreter_state->VFP[VFP_FPSCR]);
 
         parent.interpreter_state->ServeBreak();
+        return instructions_executed;
     }
 
     void CallSVC(std::uint32_t swi) override {
@@ -165,8 +172,10 @@ public:
 
 ARM_Dynarmic::ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory,
                            PrivilegeMode initial_mode)
-    : system(*system), memory(memory), cb(std::make_unique<DynarmicUserCallbacks>(*this)) {
+    : ARM_Interface(memory), system(*system), timing(system->CoreTiming()), memory(memory),
+      cb(std::make_unique<DynarmicUserCallbacks>(*this)) {
     interpreter_state = std::make_shared<ARMul_State>(system, memory, initial_mode);
+    interpreter_state->idle_loop_detector = &idle_loop_detector;
     PageTableChanged();
 }
 
@@ -178,7 +187,41 @@ void ARM_Dynarmic::Run() {
     ASSERT(memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
+    // We can't observe branches from inside the JIT, so idle loops are caught at slice granularity:
+    // when the previous run ended inside one, a single iteration is run on the interpreter, which
+    // fast-forwards to the next event if the loop is still spinning.
+    if (idle_loop_stop_pc && *idle_loop_stop_pc == jit->Regs()[15]) {
+        // Enough to finish a partial iteration and then run a full one.
+        const unsigned instructions_executed = cb->RunInterpreter(
+            *idle_loop_stop_pc, 2 * IdleLoopDetector::MAX_LOOP_INSTRUCTIONS);
+        timing.AddTicks(instructions_executed);
+        if (idle_requested) {
+            idle_requested = false;
+            timing.Idle();
+            return;
+        }
+    }
+
+    const u64 ticks_before_run = timing.GetTicks();
     jit->Run();
+
+    // Attribute the whole run to the PC it stopped at. Over many runs this approximates where
+    // time is spent, like a sampling profiler.
+    if (guest_profiler != nullptr) {
+        guest_profiler->RecordBlock(jit->Regs()[15], timing.GetTicks() - ticks_before_run);
+    }
+
+    if (idle_requested) {
+        idle_requested = false;
+        timing.Idle();
+    }
+    const u32 stop_pc = jit->Regs()[15];
+    const bool is_thumb = (jit->Cpsr() & (1 << 5)) != 0;
+    if (!is_thumb && idle_loop_detector.FindIdleLoop(stop_pc)) {
+        idle_loop_stop_pc = stop_pc;
+    } else {
+        idle_loop_stop_pc.reset();
+    }
 }
 
 void ARM_Dynarmic::Step() {
@@ -201,6 +244,10 @@ void ARM_Dynarmic::SetReg(int index, u32 value) {
     jit->Regs()[index] = value;
 }
 
+std::array<u32, 16>& ARM_Dynarmic::GetRegisters() {
+    return jit->Regs();
+}
+
 u32 ARM_Dynarmic::GetVFPReg(int index) const {
     return jit->ExtRegs()[index];
 }
@@ -261,6 +308,7 @@ void ARM_Dynarmic::LoadContext(const std::unique_ptr<ThreadContext>& arg) {
 
     jit->LoadContext(ctx->ctx);
     interpreter_state->VFP[VFP_FPEXC] = ctx->fpexc;
+    idle_loop_stop_pc.reset();
 }
 
 void ARM_Dynarmic::PrepareReschedule() {
@@ -275,10 +323,14 @@ void ARM_Dynarmic::ClearInstructionCache() {
         j.second->ClearCache();
     }
     interpreter_state->instruction_cache.clear();
+    idle_loop_detector.Clear();
+    idle_loop_stop_pc.reset();
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
     jit->InvalidateCacheRange(start_address, length);
+    idle_loop_detector.InvalidateRange(start_address, length);
+    idle_loop_stop_pc.reset();
 }
 
 void ARM_Dynarmic::PageTableChanged() {
@@ -6,6 +6,7 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <dynarmic/A32/a32.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
@@ -18,7 +19,8 @@ class MemorySystem;
 
 namespace Core {
 struct System;
-}
+class Timing;
+} // namespace Core
 
 class DynarmicUserCallbacks;
 
@@ -34,6 +36,7 @@ public:
     u32 GetPC() const override;
     u32 GetReg(int index) const override;
     void SetReg(int index, u32 value) override;
+    std::array<u32, 16>& GetRegisters() override;
     u32 GetVFPReg(int index) const override;
     void SetVFPReg(int index, u32 value) override;
     u32 GetVFPSystemReg(VFPSystemRegister reg) const override;
@@ -56,6 +59,7 @@ public:
 private:
     friend class DynarmicUserCallbacks;
     Core::System& system;
+    Core::Timing& timing;
     Memory::MemorySystem& memory;
     std::unique_ptr<DynarmicUserCallbacks> cb;
     std::unique_ptr<Dynarmic::A32::Jit> MakeJit();
@@ -64,4 +68,7 @@ private:
     Memory::PageTable* current_page_table = nullptr;
     std::map<Memory::PageTable*, std::unique_ptr<Dynarmic::A32::Jit>> jits;
     std::shared_ptr<ARMul_State> interpreter_state;
+
+    /// Address the previous run stopped at, if it stopped inside an idle loop
+    std::optional<u32> idle_loop_stop_pc;
 };
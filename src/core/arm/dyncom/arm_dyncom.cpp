@@ -8,6 +8,7 @@
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
+#include "core/arm/guest_profiler.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -70,8 +71,9 @@ private:
 
 ARM_DynCom::ARM_DynCom(Core::System* system, Memory::MemorySystem& memory,
                        PrivilegeMode initial_mode)
-    : system(system) {
+    : ARM_Interface(memory), system(system) {
     state = std::make_unique<ARMul_State>(system, memory, initial_mode);
+    state->idle_loop_detector = &idle_loop_detector;
 }
 
 ARM_DynCom::~ARM_DynCom() {}
@@ -87,7 +89,8 @@ void ARM_DynCom::Step() {
 
 void ARM_DynCom::ClearInstructionCache() {
     state->instruction_cache.clear();
-    trans_cache_buf_top = 0;
+    state->trans_cache_buf_top = 0;
+    idle_loop_detector.Clear();
 }
 
 void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
@@ -114,6 +117,10 @@ void ARM_DynCom::SetReg(int index, u32 value) {
     state->Reg[index] = value;
 }
 
+std::array<u32, 16>& ARM_DynCom::GetRegisters() {
+    return state->Reg;
+}
+
 u32 ARM_DynCom::GetVFPReg(int index) const {
     return state->ExtReg[index];
 }
@@ -149,12 +156,24 @@ void ARM_DynCom::SetCP15Register(CP15Register reg, u32 value) {
 void ARM_DynCom::ExecuteInstructions(u64 num_instructions) {
     state->NumInstrsToExecute = num_instructions;
     unsigned ticks_executed = InterpreterMainLoop(state.get());
+    if (guest_profiler != nullptr) {
+        guest_profiler->ExitBlock(ticks_executed);
+    }
     if (system != nullptr) {
         system->CoreTiming().AddTicks(ticks_executed);
+        if (idle_requested) {
+            system->CoreTiming().Idle();
+        }
     }
+    idle_requested = false;
     state->ServeBreak();
 }
 
+void ARM_DynCom::SetGuestProfiler(GuestProfiler* profiler) {
+    guest_profiler = profiler;
+    state->guest_profiler = profiler;
+}
+
 std::unique_ptr<ARM_Interface::ThreadContext> ARM_DynCom::NewContext() const {
     return std::make_unique<DynComThreadContext>();
 }
@@ -35,6 +35,7 @@ public:
     u32 GetPC() const override;
     u32 GetReg(int index) const override;
     void SetReg(int index, u32 value) override;
+    std::array<u32, 16>& GetRegisters() override;
     u32 GetVFPReg(int index) const override;
     void SetVFPReg(int index, u32 value) override;
     u32 GetVFPSystemReg(VFPSystemRegister reg) const override;
@@ -49,6 +50,7 @@ public:
     void LoadContext(const std::unique_ptr<ThreadContext>& arg) override;
 
     void PrepareReschedule() override;
+    void SetGuestProfiler(GuestProfiler* profiler) override;
 
 private:
     void ExecuteInstructions(u64 num_instructions);
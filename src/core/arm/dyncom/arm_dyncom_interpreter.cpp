@@ -10,11 +10,13 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "core/arm/arm_interface.h"
 #include "core/arm/dyncom/arm_dyncom_dec.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_run.h"
 #include "core/arm/dyncom/arm_dyncom_thumb.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
+#include "core/arm/guest_profiler.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/arm/skyeye_common/armsupp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
@@ -755,55 +757,6 @@ get_addr_fp_t GetAddressingOpLoadStoreT(unsigned int inst) {
 
 enum { FETCH_SUCCESS, FETCH_FAILURE };
 
-static ThumbDecodeStatus DecodeThumbInstruction(u32 inst, u32 addr, u32* arm_inst, u32* inst_size,
-                                                ARM_INST_PTR* ptr_inst_base) {
-    // Check if in Thumb mode
-    ThumbDecodeStatus ret = TranslateThumbInstruction(addr, inst, arm_inst, inst_size);
-    if (ret == ThumbDecodeStatus::BRANCH) {
-        int inst_index;
-        int table_length = static_cast<int>(arm_instruction_trans_len);
-        u32 tinstr = GetThumbInstruction(inst, addr);
-
-        switch ((tinstr & 0xF800) >> 11) {
-        case 26:
-        case 27:
-            if (((tinstr & 0x0F00) != 0x0E00) && ((tinstr & 0x0F00) != 0x0F00)) {
-                inst_index = table_length - 4;
-                *ptr_inst_base = arm_instruction_trans[inst_index](tinstr, inst_index);
-            } else {
-                LOG_ERROR(Core_ARM11, "thumb decoder error");
-            }
-            break;
-        case 28:
-            // Branch 2, unconditional branch
-            inst_index = table_length - 5;
-            *ptr_inst_base = arm_instruction_trans[inst_index](tinstr, inst_index);
-            break;
-
-        case 8:
-        case 29:
-            // For BLX 1 thumb instruction
-            inst_index = table_length - 1;
-            *ptr_inst_base = arm_instruction_trans[inst_index](tinstr, inst_index);
-            break;
-        case 30:
-            // For BL 1 thumb instruction
-            inst_index = table_length - 3;
-            *ptr_inst_base = arm_instruction_trans[inst_index](tinstr, inst_index);
-            break;
-        case 31:
-            // For BL 2 thumb instruction
-            inst_index = table_length - 2;
-            *ptr_inst_base = arm_instruction_trans[inst_index](tinstr, inst_index);
-            break;
-        default:
-            ret = ThumbDecodeStatus::UNDEFINED;
-            break;
-        }
-    }
-    return ret;
-}
-
 enum { KEEP_GOING, FETCH_EXCEPTION };
 
 MICROPROFILE_DEFINE(DynCom_Decode, "DynCom", "Decode", MP_RGB(255, 64, 64));
@@ -812,23 +765,22 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
                                                     ARM_INST_PTR& inst_base) {
     u32 inst_size = 4;
     u32 inst = cpu->memory.Read32(phys_addr & 0xFFFFFFFC);
+    ARMDecodeStatus status;
+    int idx;
 
-    // If we are in Thumb mode, we'll translate one Thumb instruction to the corresponding ARM
-    // instruction
+    // Thumb instructions are looked up in a table of their pre-decoded ARM equivalents
     if (cpu->TFlag) {
-        u32 arm_inst;
-        ThumbDecodeStatus state =
-            DecodeThumbInstruction(inst, phys_addr, &arm_inst, &inst_size, &inst_base);
-
-        // We have translated the Thumb branch instruction in the Thumb decoder
-        if (state == ThumbDecodeStatus::BRANCH) {
-            return inst_size;
-        }
-        inst = arm_inst;
+        const ThumbInstructionInfo& info =
+            LookupThumbInstruction(static_cast<u16>(GetThumbInstruction(inst, phys_addr)));
+        inst = info.instruction;
+        idx = info.trans_index;
+        inst_size = 2;
+        status = idx >= 0 ? ARMDecodeStatus::SUCCESS : ARMDecodeStatus::FAILURE;
+    } else {
+        status = DecodeARMInstruction(inst, &idx);
     }
 
-    int idx;
-    if (DecodeARMInstruction(inst, &idx) == ARMDecodeStatus::FAILURE) {
+    if (status == ARMDecodeStatus::FAILURE) {
         LOG_ERROR(Core_ARM11, "Decode failure.\tPC: [{:#010X}]\tInstruction: {:08X}", phys_addr,
                   inst);
         LOG_ERROR(Core_ARM11, "cpsr={:#X}, cpu->TFlag={}, r15={:#010X}", cpu->Cpsr, cpu->TFlag,
@@ -840,6 +792,21 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     return inst_size;
 }
 
+static bool IsRegularMemory(Memory::PageType type) {
+    return type == Memory::PageType::Memory || type == Memory::PageType::WriteTrackedMemory;
+}
+
+// Checks whether a block may continue into the page starting at the given address. That is the
+// case when both the page and the one before it are regular memory, so fetching across the
+// boundary can't fault or hit an I/O region.
+static bool CanTranslateAcrossPage(const ARMul_State* cpu, u32 page_addr) {
+    const Memory::PageTable* page_table = cpu->memory.GetCurrentPageTable();
+    const std::size_t page = page_addr >> Memory::PAGE_BITS;
+    return page != 0 && page_table != nullptr &&
+           IsRegularMemory(page_table->attributes[page - 1]) &&
+           IsRegularMemory(page_table->attributes[page]);
+}
+
 static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
@@ -850,7 +817,8 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
     int size = 0; // instruction size of basic block
-    bb_start = trans_cache_buf_top;
+    trans_cache_state = cpu;
+    bb_start = cpu->trans_cache_buf_top;
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
@@ -862,12 +830,26 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
 
         phys_addr += inst_size;
 
-        if ((phys_addr & 0xfff) == 0) {
+        if ((phys_addr & Memory::PAGE_MASK) == 0 && inst_base->br == TransExtData::NON_BRANCH &&
+            !CanTranslateAcrossPage(cpu, phys_addr)) {
             inst_base->br = TransExtData::END_OF_PAGE;
         }
         ret = inst_base->br;
     };
 
+    // A block ending with a plain branch back to its own start may be an idle loop.
+    if (cpu->idle_loop_detector != nullptr && !cpu->TFlag &&
+        ret == TransExtData::DIRECT_BRANCH) {
+        const u32 branch_addr = phys_addr - 4;
+        const u32 inst = cpu->memory.Read32(branch_addr);
+        if (BITS(inst, 24, 27) == 0xA && BITS(inst, 28, 31) != 0xF) {
+            bbl_inst* inst_cream = (bbl_inst*)inst_base->component;
+            inst_cream->idle_loop =
+                branch_addr + 8 + inst_cream->signed_immed_24 == pc_start &&
+                cpu->idle_loop_detector->IsIdleLoop(pc_start, branch_addr);
+        }
+    }
+
     cpu->instruction_cache[pc_start] = bb_start;
 
     return KEEP_GOING;
@@ -877,7 +859,8 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     ARM_INST_PTR inst_base = nullptr;
-    bb_start = trans_cache_buf_top;
+    trans_cache_state = cpu;
+    bb_start = cpu->trans_cache_buf_top;
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
@@ -948,7 +931,7 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
 #define FETCH_INST                                                                                 \
     if (inst_base->br != TransExtData::NON_BRANCH)                                                 \
         goto DISPATCH;                                                                             \
-    inst_base = (arm_inst*)&trans_cache_buf[ptr]
+    inst_base = (arm_inst*)&cpu->trans_cache_buf[ptr]
 
 #define INC_PC(l) ptr += sizeof(arm_inst) + l
 #define INC_PC_STUB ptr += sizeof(arm_inst)
@@ -1652,13 +1635,17 @@ DISPATCH : {
             goto END;
     }
 
+    if (cpu->guest_profiler != nullptr) {
+        cpu->guest_profiler->EnterBlock(cpu->Reg[15], num_instrs);
+    }
+
     // Find breakpoint if one exists within the block
     if (GDBStub::IsConnected()) {
         breakpoint_data =
             GDBStub::GetNextBreakpointFromAddress(cpu->Reg[15], GDBStub::BreakpointType::Execute);
     }
 
-    inst_base = (arm_inst*)&trans_cache_buf[ptr];
+    inst_base = (arm_inst*)&cpu->trans_cache_buf[ptr];
     GOTO_NEXT_INST;
 }
 ADC_INST : {
@@ -1768,6 +1755,12 @@ BBL_INST : {
         }
         SET_PC;
         INC_PC(sizeof(bbl_inst));
+        if (inst_cream->idle_loop) {
+            // Another iteration can't observe anything new before the next event fires
+            DEBUG_ASSERT(cpu->system != nullptr);
+            cpu->system->CPU().RequestIdle();
+            goto END;
+        }
         goto DISPATCH;
     }
     cpu->Reg[15] += cpu->GetInstructionSize();
@@ -3,11 +3,14 @@
 // Refer to the license.txt file included.
 
 #include <cstddef>
+#include <vector>
 
 // We can provide simple Thumb simulation by decoding the Thumb instruction into its corresponding
 // ARM instruction, and using the existing ARM simulator.
 
+#include "core/arm/dyncom/arm_dyncom_dec.h"
 #include "core/arm/dyncom/arm_dyncom_thumb.h"
+#include "core/arm/dyncom/arm_dyncom_trans.h"
 #include "core/arm/skyeye_common/armsupp.h"
 
 // Decode a 16bit Thumb instruction.  The instruction is in the low 16-bits of the tinstr field,
@@ -388,3 +391,62 @@ ThumbDecodeStatus TranslateThumbInstruction(u32 addr, u32 instr, u32* ainstr, u3
 
     return valid;
 }
+
+// Finds the translation function of a Thumb branch, which has no ARM equivalent. These live at the
+// end of arm_instruction_trans.
+static int GetThumbBranchTransIndex(u32 tinstr) {
+    const int table_length = static_cast<int>(arm_instruction_trans_len);
+
+    switch ((tinstr & 0xF800) >> 11) {
+    case 26:
+    case 27:
+        // Conditional branch
+        if (((tinstr & 0x0F00) != 0x0E00) && ((tinstr & 0x0F00) != 0x0F00))
+            return table_length - 4;
+        return -1;
+    case 28:
+        // Branch 2, unconditional branch
+        return table_length - 5;
+    case 8:
+    case 29:
+        // BLX 1
+        return table_length - 1;
+    case 30:
+        // BL 1
+        return table_length - 3;
+    case 31:
+        // BL 2
+        return table_length - 2;
+    default:
+        return -1;
+    }
+}
+
+static ThumbInstructionInfo DecodeThumbInstruction(u16 tinstr) {
+    ThumbInstructionInfo info;
+    u32 inst_size;
+
+    if (TranslateThumbInstruction(0, tinstr, &info.instruction, &inst_size) ==
+        ThumbDecodeStatus::BRANCH) {
+        info.instruction = tinstr;
+        info.trans_index = GetThumbBranchTransIndex(tinstr);
+        return info;
+    }
+
+    int idx;
+    if (DecodeARMInstruction(info.instruction, &idx) == ARMDecodeStatus::SUCCESS)
+        info.trans_index = idx;
+    else
+        info.trans_index = -1;
+    return info;
+}
+
+const ThumbInstructionInfo& LookupThumbInstruction(u16 tinstr) {
+    static const std::vector<ThumbInstructionInfo> table = [] {
+        std::vector<ThumbInstructionInfo> decoded(0x10000);
+        for (u32 i = 0; i < decoded.size(); ++i)
+            decoded[i] = DecodeThumbInstruction(static_cast<u16>(i));
+        return decoded;
+    }();
+    return table[tinstr];
+}
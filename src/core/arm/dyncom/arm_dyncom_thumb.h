@@ -38,6 +38,20 @@ enum class ThumbDecodeStatus {
 // Translates a Thumb mode instruction into its ARM equivalent.
 ThumbDecodeStatus TranslateThumbInstruction(u32 addr, u32 instr, u32* ainstr, u32* inst_size);
 
+// Result of decoding a 16-bit Thumb instruction for the interpreter.
+struct ThumbInstructionInfo {
+    // Instruction to pass to the translation function: the ARM equivalent, or the Thumb
+    // instruction itself for the Thumb-only branches.
+    u32 instruction;
+    // Index into arm_instruction_trans, or -1 if the instruction could not be decoded.
+    int trans_index;
+};
+
+// Looks up the decoded form of a Thumb instruction. Every Thumb encoding is decoded once, the
+// first time this is called, so that translating Thumb code never needs to search the ARM
+// decoding table.
+const ThumbInstructionInfo& LookupThumbInstruction(u16 tinstr);
+
 inline u32 GetThumbInstruction(u32 instr, u32 address) {
     // Normally you would need to handle instruction endianness,
     // however, it is fixed to little-endian on the MPCore, so
@@ -6,14 +6,14 @@
 #include "core/arm/skyeye_common/armsupp.h"
 #include "core/arm/skyeye_common/vfp/vfp.h"
 
-char trans_cache_buf[TRANS_CACHE_SIZE];
-size_t trans_cache_buf_top = 0;
+thread_local ARMul_State* trans_cache_state = nullptr;
 
 static void* AllocBuffer(std::size_t size) {
-    std::size_t start = trans_cache_buf_top;
-    trans_cache_buf_top += size;
-    ASSERT_MSG(trans_cache_buf_top <= TRANS_CACHE_SIZE, "Translation cache is full!");
-    return static_cast<void*>(&trans_cache_buf[start]);
+    std::size_t start = trans_cache_state->trans_cache_buf_top;
+    trans_cache_state->trans_cache_buf_top += size;
+    ASSERT_MSG(trans_cache_state->trans_cache_buf_top <= TRANS_CACHE_SIZE,
+               "Translation cache is full!");
+    return static_cast<void*>(&trans_cache_state->trans_cache_buf[start]);
 }
 
 #define glue(x, y) x##y
@@ -99,6 +99,7 @@ static ARM_INST_PTR INTERPRETER_TRANSLATE(bbl)(unsigned int inst, int index) {
 
     inst_cream->L = BIT(inst, 24);
     inst_cream->signed_immed_24 = BIT(inst, 23) ? NEGBRANCH : POSBRANCH;
+    inst_cream->idle_loop = false;
 
     return inst_base;
 }
@@ -88,6 +88,7 @@ struct bbl_inst {
     int signed_immed_24;
     unsigned int next_addr;
     unsigned int jmp_addr;
+    bool idle_loop; // Branches back to the start of a loop that spins without making progress
 };
 
 struct bx_inst {
@@ -494,5 +495,6 @@ extern const transop_fp_t arm_instruction_trans[];
 extern const std::size_t arm_instruction_trans_len;
 
 #define TRANS_CACHE_SIZE (64 * 1024 * 2000)
-extern char trans_cache_buf[TRANS_CACHE_SIZE];
-extern std::size_t trans_cache_buf_top;
+// The core whose code the calling host thread is translating, which the translated instructions
+// are allocated from the buffer of.
+extern thread_local ARMul_State* trans_cache_state;
@@ -0,0 +1,114 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <fmt/format.h>
+#include "core/arm/guest_profiler.h"
+
+namespace {
+
+const GuestProfiler::Module* FindModule(const std::vector<GuestProfiler::Module>& modules,
+                                        VAddr address) {
+    const auto itr = std::find_if(modules.begin(), modules.end(), [address](const auto& module) {
+        return address >= module.base && address - module.base < module.size;
+    });
+    return itr != modules.end() ? &*itr : nullptr;
+}
+
+std::string GetModuleName(const GuestProfiler::Module* module) {
+    return module != nullptr ? module->name : "[unknown]";
+}
+
+} // Anonymous namespace
+
+void GuestProfiler::SetEnabled(bool enable) {
+    enabled = enable;
+    current_block.reset();
+}
+
+void GuestProfiler::EnterBlock(VAddr address, u64 instruction_count) {
+    ExitBlock(instruction_count);
+    current_block = address;
+    current_block_start = instruction_count;
+}
+
+void GuestProfiler::ExitBlock(u64 instruction_count) {
+    if (current_block) {
+        RecordBlock(*current_block, instruction_count - current_block_start);
+        current_block.reset();
+    }
+}
+
+void GuestProfiler::Clear() {
+    blocks.clear();
+    current_block.reset();
+}
+
+void GuestProfiler::Merge(const GuestProfiler& other) {
+    for (const auto& [address, other_stats] : other.blocks) {
+        BlockStats& stats = blocks[address];
+        stats.hits += other_stats.hits;
+        stats.cycles += other_stats.cycles;
+    }
+}
+
+std::string GuestProfiler::GetFoldedStacks(const std::vector<Module>& modules) const {
+    // Sort by address so that the output is stable between dumps.
+    const std::map<VAddr, BlockStats> sorted_blocks(blocks.begin(), blocks.end());
+
+    std::string out;
+    for (const auto& [address, stats] : sorted_blocks) {
+        if (stats.cycles == 0) {
+            continue;
+        }
+        const Module* module = FindModule(modules, address);
+        out += fmt::format("{};0x{:08X} {}\n", GetModuleName(module), address, stats.cycles);
+    }
+    return out;
+}
+
+std::string GuestProfiler::GetReport(const std::vector<Module>& modules,
+                                     std::size_t max_entries) const {
+    u64 total_cycles = 0;
+    u64 total_hits = 0;
+    std::map<std::string, BlockStats> module_stats;
+    for (const auto& [address, stats] : blocks) {
+        BlockStats& module = module_stats[GetModuleName(FindModule(modules, address))];
+        module.hits += stats.hits;
+        module.cycles += stats.cycles;
+        total_cycles += stats.cycles;
+        total_hits += stats.hits;
+    }
+
+    const auto percent = [total_cycles](u64 cycles) {
+        return total_cycles != 0 ? cycles * 100.0 / total_cycles : 0.0;
+    };
+
+    std::string out = fmt::format("# Samples: {} blocks, {} cycles\n#\n", total_hits, total_cycles);
+    out += "# Overhead        Cycles        Blocks  Module\n";
+    for (const auto& [name, stats] : module_stats) {
+        out += fmt::format("  {:7.2f}%  {:>12}  {:>12}  {}\n", percent(stats.cycles), stats.cycles,
+                           stats.hits, name);
+    }
+
+    std::vector<std::pair<VAddr, BlockStats>> hottest(blocks.begin(), blocks.end());
+    std::sort(hottest.begin(), hottest.end(), [](const auto& a, const auto& b) {
+        return a.second.cycles != b.second.cycles ? a.second.cycles > b.second.cycles
+                                                  : a.first < b.first;
+    });
+    if (hottest.size() > max_entries) {
+        hottest.resize(max_entries);
+    }
+
+    out += "#\n# Overhead        Cycles        Blocks  Module                Address  Offset\n";
+    for (const auto& [address, stats] : hottest) {
+        const Module* module = FindModule(modules, address);
+        const u32 offset = module != nullptr ? address - module->base : address;
+        out += fmt::format("  {:7.2f}%  {:>12}  {:>12}  {:<20}  0x{:08X}  +0x{:X}\n",
+                           percent(stats.cycles), stats.cycles, stats.hits,
+                           GetModuleName(module), address, offset);
+    }
+    return out;
+}
@@ -0,0 +1,95 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Collects how often guest code blocks run and how many cycles are spent in them.
+ *
+ * The interpreter reports every basic block it dispatches, giving exact counts. The JIT can't be
+ * hooked at block granularity, so it reports the PC it stopped at after each run together with
+ * the cycles of that run, which makes its data a statistical sample of where time is spent.
+ */
+class GuestProfiler {
+public:
+    /// Execution statistics of a single guest address
+    struct BlockStats {
+        u64 hits = 0;
+        u64 cycles = 0;
+    };
+
+    /// A loaded guest module that samples are attributed to
+    struct Module {
+        std::string name;
+        VAddr base;
+        u32 size;
+    };
+
+    bool IsEnabled() const {
+        return enabled;
+    }
+
+    /// Enables or disables collection. Collected data is kept until Clear() is called.
+    void SetEnabled(bool enable);
+
+    /**
+     * Records that the code at the given address ran.
+     * @param address Guest address of the block, or the sampled PC
+     * @param cycles Number of cycles spent executing it
+     */
+    void RecordBlock(VAddr address, u64 cycles) {
+        BlockStats& stats = blocks[address];
+        ++stats.hits;
+        stats.cycles += cycles;
+    }
+
+    /**
+     * Marks the start of a basic block, closing the previous one.
+     * @param address Guest address of the block
+     * @param instruction_count Running count of instructions executed by the caller
+     */
+    void EnterBlock(VAddr address, u64 instruction_count);
+
+    /// Closes the block opened by EnterBlock(), if any.
+    void ExitBlock(u64 instruction_count);
+
+    /// Discards all collected data.
+    void Clear();
+
+    /// Adds the data collected by another profiler, like the one of another CPU core, to this one.
+    void Merge(const GuestProfiler& other);
+
+    const std::unordered_map<VAddr, BlockStats>& GetBlocks() const {
+        return blocks;
+    }
+
+    /**
+     * Writes the collected data in the folded stack format read by flamegraph.pl, speedscope and
+     * the other tools that consume the output of `perf script | stackcollapse-perf.pl`. Each line
+     * is a "module;address" stack followed by its cycle count.
+     */
+    std::string GetFoldedStacks(const std::vector<Module>& modules) const;
+
+    /**
+     * Builds a human readable hotspot report in the style of `perf report`, listing the hottest
+     * addresses first, after a per-module summary.
+     * @param max_entries Maximum number of addresses to list
+     */
+    std::string GetReport(const std::vector<Module>& modules, std::size_t max_entries) const;
+
+private:
+    bool enabled = false;
+
+    std::unordered_map<VAddr, BlockStats> blocks;
+
+    // Block opened by EnterBlock(), along with the instruction count at that point
+    std::optional<VAddr> current_block;
+    u64 current_block_start = 0;
+};
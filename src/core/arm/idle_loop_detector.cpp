@@ -0,0 +1,317 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include "core/arm/idle_loop_detector.h"
+#include "core/memory.h"
+
+namespace {
+
+constexpr u32 COND_AL = 0xE;
+constexpr u32 COND_UNCONDITIONAL = 0xF;
+
+// Flag masks used to track loop-carried dependencies through the CPSR
+constexpr u32 FLAG_N = 1 << 0;
+constexpr u32 FLAG_Z = 1 << 1;
+constexpr u32 FLAG_C = 1 << 2;
+constexpr u32 FLAG_V = 1 << 3;
+constexpr u32 FLAGS_ALL = FLAG_N | FLAG_Z | FLAG_C | FLAG_V;
+
+/// Register and flag usage of a single instruction inside a candidate loop
+struct InstructionEffects {
+    bool allowed = false;
+    bool conditional = false;
+    u32 regs_read = 0;
+    u32 regs_written = 0;
+    u32 flags_read = 0;
+    u32 flags_written = 0;
+};
+
+u32 Bits(u32 inst, u32 low, u32 high) {
+    return (inst >> low) & ((1u << (high - low + 1)) - 1);
+}
+
+u32 Bit(u32 inst, u32 n) {
+    return (inst >> n) & 1;
+}
+
+u32 RegMask(u32 reg) {
+    // The PC is constant for a given instruction address, so reading it carries no state.
+    return reg == 15 ? 0 : (1u << reg);
+}
+
+u32 FlagsReadByCondition(u32 cond) {
+    switch (cond >> 1) {
+    case 0: // EQ, NE
+        return FLAG_Z;
+    case 1: // CS, CC
+        return FLAG_C;
+    case 2: // MI, PL
+        return FLAG_N;
+    case 3: // VS, VC
+        return FLAG_V;
+    case 4: // HI, LS
+        return FLAG_C | FLAG_Z;
+    case 5: // GE, LT
+        return FLAG_N | FLAG_V;
+    case 6: // GT, LE
+        return FLAG_N | FLAG_Z | FLAG_V;
+    default: // AL
+        return 0;
+    }
+}
+
+bool IsBranch(u32 inst) {
+    return Bits(inst, 28, 31) != COND_UNCONDITIONAL && Bits(inst, 24, 27) == 0xA;
+}
+
+u32 BranchTarget(u32 inst, u32 address) {
+    const s32 offset = static_cast<s32>(inst << 8) >> 6;
+    return address + 8 + offset;
+}
+
+/// Register shifted by an immediate or by a register (bits 0-11 of a data processing operand)
+void DecodeShiftedRegister(u32 inst, InstructionEffects& effects) {
+    effects.regs_read |= RegMask(Bits(inst, 0, 3));
+    if (Bit(inst, 4)) {
+        effects.regs_read |= RegMask(Bits(inst, 8, 11));
+    } else if (Bits(inst, 5, 6) == 3 && Bits(inst, 7, 11) == 0) {
+        // RRX shifts the carry flag in
+        effects.flags_read |= FLAG_C;
+    }
+}
+
+InstructionEffects DecodeDataProcessing(u32 inst) {
+    InstructionEffects effects;
+    const u32 opcode = Bits(inst, 21, 24);
+    const bool set_flags = Bit(inst, 20) != 0;
+    const bool is_compare = opcode >= 0x8 && opcode <= 0xB;
+    const bool is_logical = opcode == 0x0 || opcode == 0x1 || opcode == 0x8 || opcode == 0x9 ||
+                            opcode >= 0xC;
+
+    // TST/TEQ/CMP/CMN without the S bit encode MSR/MRS/BX and friends.
+    if (is_compare && !set_flags) {
+        return effects;
+    }
+
+    if (!Bit(inst, 25)) {
+        DecodeShiftedRegister(inst, effects);
+    }
+
+    // MOV and MVN have no first operand.
+    if (opcode != 0xD && opcode != 0xF) {
+        effects.regs_read |= RegMask(Bits(inst, 16, 19));
+    }
+
+    // ADC, SBC and RSC consume the carry flag.
+    if (opcode >= 0x5 && opcode <= 0x7) {
+        effects.flags_read |= FLAG_C;
+    }
+
+    if (!is_compare) {
+        const u32 rd = Bits(inst, 12, 15);
+        if (rd == 15) {
+            return effects;
+        }
+        effects.regs_written |= RegMask(rd);
+    }
+
+    if (set_flags) {
+        // Logical operations may leave C and V untouched, so we only count N and Z as written.
+        effects.flags_written = is_logical ? (FLAG_N | FLAG_Z) : FLAGS_ALL;
+    }
+
+    effects.allowed = true;
+    return effects;
+}
+
+InstructionEffects DecodeLoad(u32 inst) {
+    InstructionEffects effects;
+    const u32 rd = Bits(inst, 12, 15);
+
+    // Stores have side effects, and base register writeback makes the loop walk memory.
+    if (!Bit(inst, 20) || !Bit(inst, 24) || Bit(inst, 21) || rd == 15) {
+        return effects;
+    }
+
+    effects.regs_read |= RegMask(Bits(inst, 16, 19));
+    effects.regs_written |= RegMask(rd);
+    effects.allowed = true;
+    return effects;
+}
+
+InstructionEffects DecodeInstruction(u32 inst) {
+    InstructionEffects effects;
+    const u32 cond = Bits(inst, 28, 31);
+    if (cond == COND_UNCONDITIONAL) {
+        return effects;
+    }
+
+    if ((inst & 0x0FFFFFFE) == 0x0320F000) {
+        // NOP and YIELD
+        effects.allowed = true;
+    } else if (Bits(inst, 26, 27) == 1) {
+        // LDR/LDRB
+        if (Bit(inst, 25) && Bit(inst, 4)) {
+            // Media instruction space
+            return effects;
+        }
+        effects = DecodeLoad(inst);
+        if (Bit(inst, 25)) {
+            DecodeShiftedRegister(inst, effects);
+        }
+    } else if (Bits(inst, 25, 27) == 0 && Bit(inst, 7) && Bit(inst, 4)) {
+        // LDRH/LDRSB/LDRSH live in the extra load/store space next to the multiplies.
+        if (Bits(inst, 5, 6) == 0) {
+            return effects;
+        }
+        effects = DecodeLoad(inst);
+        if (!Bit(inst, 22)) {
+            effects.regs_read |= RegMask(Bits(inst, 0, 3));
+        }
+    } else if (Bits(inst, 26, 27) == 0) {
+        effects = DecodeDataProcessing(inst);
+    }
+
+    if (cond != COND_AL) {
+        effects.conditional = true;
+        effects.flags_read |= FlagsReadByCondition(cond);
+    }
+    return effects;
+}
+
+} // Anonymous namespace
+
+IdleLoopDetector::IdleLoopDetector(Memory::MemorySystem& memory) : memory(memory) {}
+
+void IdleLoopDetector::SetEnabled(bool enable) {
+    enabled = enable;
+    Clear();
+}
+
+bool IdleLoopDetector::IsIdleLoop(u32 loop_start, u32 branch_address) {
+    if (!enabled) {
+        return false;
+    }
+
+    const u64 key = (static_cast<u64>(loop_start) << 32) | branch_address;
+    auto itr = loop_cache.find(key);
+    if (itr != loop_cache.end()) {
+        return itr->second;
+    }
+
+    const bool is_idle = AnalyzeLoop(loop_start, branch_address);
+    loop_cache.emplace(key, is_idle);
+    return is_idle;
+}
+
+std::optional<u32> IdleLoopDetector::FindIdleLoop(u32 pc) {
+    if (!enabled || (pc & 3) != 0) {
+        return {};
+    }
+
+    // Only look within the current page, so we never touch unmapped memory.
+    const u32 page_end = (pc & ~Memory::PAGE_MASK) + Memory::PAGE_SIZE;
+    for (u32 i = 0; i < MAX_LOOP_INSTRUCTIONS; ++i) {
+        const u32 address = pc + i * 4;
+        if (address >= page_end) {
+            break;
+        }
+
+        const u32 inst = memory.Read32(address);
+        if (!IsBranch(inst)) {
+            continue;
+        }
+
+        const u32 target = BranchTarget(inst, address);
+        if (Bit(inst, 24) || target > pc || !IsIdleLoop(target, address)) {
+            return {};
+        }
+        return target;
+    }
+    return {};
+}
+
+bool IdleLoopDetector::RecordNoOpSVC() {
+    if (!enabled) {
+        return false;
+    }
+
+    if (++noop_svc_count < NOOP_SVC_THRESHOLD) {
+        return false;
+    }
+
+    noop_svc_count = 0;
+    return true;
+}
+
+void IdleLoopDetector::Clear() {
+    loop_cache.clear();
+    noop_svc_count = 0;
+}
+
+void IdleLoopDetector::InvalidateRange(u32 start_address, std::size_t length) {
+    const u64 end_address = static_cast<u64>(start_address) + length;
+    for (auto itr = loop_cache.begin(); itr != loop_cache.end();) {
+        const u32 loop_start = static_cast<u32>(itr->first >> 32);
+        const u32 branch_address = static_cast<u32>(itr->first);
+        if (loop_start < end_address && branch_address + 4 > start_address) {
+            itr = loop_cache.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+bool IdleLoopDetector::AnalyzeLoop(u32 loop_start, u32 branch_address) const {
+    if (branch_address < loop_start || (loop_start & 3) != 0 || (branch_address & 3) != 0 ||
+        (branch_address - loop_start) / 4 >= MAX_LOOP_INSTRUCTIONS) {
+        return false;
+    }
+
+    const u32 num_instructions = (branch_address - loop_start) / 4 + 1;
+    std::array<InstructionEffects, MAX_LOOP_INSTRUCTIONS> effects;
+
+    u32 regs_written_anywhere = 0;
+    u32 flags_written_anywhere = 0;
+    for (u32 i = 0; i < num_instructions; ++i) {
+        const u32 inst = memory.Read32(loop_start + i * 4);
+        if (i == num_instructions - 1) {
+            // The closing branch: a plain backward B, optionally conditional.
+            if (!IsBranch(inst) || Bit(inst, 24) ||
+                BranchTarget(inst, branch_address) != loop_start) {
+                return false;
+            }
+            effects[i].allowed = true;
+            effects[i].flags_read = FlagsReadByCondition(Bits(inst, 28, 31));
+        } else {
+            effects[i] = DecodeInstruction(inst);
+        }
+
+        if (!effects[i].allowed) {
+            return false;
+        }
+        regs_written_anywhere |= effects[i].regs_written;
+        flags_written_anywhere |= effects[i].flags_written;
+    }
+
+    // A loop whose every iteration recomputes its state from memory is idle. Reading a register or
+    // flag the loop itself modifies before it is (unconditionally) redefined in the same iteration
+    // means the loop carries state, e.g. a countdown, and must run normally.
+    u32 regs_defined = 0;
+    u32 flags_defined = 0;
+    for (u32 i = 0; i < num_instructions; ++i) {
+        const InstructionEffects& e = effects[i];
+        if ((e.regs_read & regs_written_anywhere & ~regs_defined) != 0 ||
+            (e.flags_read & flags_written_anywhere & ~flags_defined) != 0) {
+            return false;
+        }
+        if (!e.conditional) {
+            regs_defined |= e.regs_written;
+            flags_defined |= e.flags_written;
+        }
+    }
+
+    return true;
+}
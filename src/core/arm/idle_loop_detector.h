@@ -0,0 +1,82 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include "common/common_types.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+/**
+ * Recognises guest code that busy-waits without making progress, e.g. a short loop polling a
+ * shared memory flag until a GSP interrupt arrives, or a thread repeatedly yielding with
+ * svcSleepThread(0) while no other thread is ready.
+ *
+ * Since the emulated system only changes memory observed by such a loop from scheduled events,
+ * another iteration of the loop can never exit before the next event fires. The CPU core can then
+ * fast-forward Core::Timing to the next event instead of burning host time spinning.
+ */
+class IdleLoopDetector {
+public:
+    /// Longest loop body (in instructions, including the closing branch) that is considered
+    static constexpr u32 MAX_LOOP_INSTRUCTIONS = 8;
+
+    /// Number of back-to-back no-op SVCs after which a thread is considered to be spinning
+    static constexpr u32 NOOP_SVC_THRESHOLD = 4;
+
+    explicit IdleLoopDetector(Memory::MemorySystem& memory);
+
+    bool IsEnabled() const {
+        return enabled;
+    }
+
+    /// Enables or disables detection, discarding any previous analysis results.
+    void SetEnabled(bool enable);
+
+    /**
+     * Checks whether the ARM-mode loop spanning [loop_start, branch_address] is an idle loop. The
+     * instruction at branch_address must be the backward branch closing the loop.
+     * @return true if the loop has no side effects and no loop-carried register dependencies.
+     */
+    bool IsIdleLoop(u32 loop_start, u32 branch_address);
+
+    /**
+     * Looks for an idle loop containing the given ARM-mode address.
+     * @return The start address of the loop, if one was found.
+     */
+    std::optional<u32> FindIdleLoop(u32 pc);
+
+    /**
+     * Records that the running thread made an SVC which did nothing (e.g. a yield with no other
+     * thread ready to run).
+     * @return true once enough consecutive no-op SVCs were seen to consider the thread spinning.
+     */
+    bool RecordNoOpSVC();
+
+    /// Records that the running thread made an SVC with side effects.
+    void ResetNoOpSVCs() {
+        noop_svc_count = 0;
+    }
+
+    /// Discards all cached analysis results.
+    void Clear();
+
+    /// Discards cached analysis results for loops overlapping the given range.
+    void InvalidateRange(u32 start_address, std::size_t length);
+
+private:
+    bool AnalyzeLoop(u32 loop_start, u32 branch_address) const;
+
+    Memory::MemorySystem& memory;
+    bool enabled = false;
+    u32 noop_svc_count = 0;
+
+    /// Analysis results, keyed by (loop_start << 32 | branch_address)
+    std::unordered_map<u64, bool> loop_cache;
+};
@@ -18,11 +18,15 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <unordered_map>
 #include "common/common_types.h"
 #include "core/arm/skyeye_common/arm_regformat.h"
 #include "core/gdbstub/gdbstub.h"
 
+class GuestProfiler;
+class IdleLoopDetector;
+
 namespace Core {
 class System;
 }
@@ -255,6 +259,17 @@ public:
     // TODO(bunnei): Move this cache to a better place - it should be per codeset (likely per
     // process for our purposes), not per ARMul_State (which tracks CPU core state).
     std::unordered_map<u32, std::size_t> instruction_cache;
+    // Translated instructions the instruction cache points into. Every core has a buffer of its
+    // own, as the cores translate code on separate host threads.
+    std::unique_ptr<char[]> trans_cache_buf;
+    std::size_t trans_cache_buf_top = 0;
+
+    // Used when translating blocks to recognise loops that spin without making progress. Null if
+    // the owning core doesn't do idle-loop detection.
+    IdleLoopDetector* idle_loop_detector = nullptr;
+
+    // Receives every dispatched basic block while guest profiling is enabled.
+    GuestProfiler* guest_profiler = nullptr;
 
 private:
     void ResetMPCoreCP15Registers();
@@ -20,6 +20,9 @@
 
 /* Note: this file handles interface with arm core and vfp registers */
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -88,6 +91,199 @@ void VMOVR(ARMul_State* state, u32 single, u32 d, u32 m) {
     }
 }
 
+namespace {
+
+// FPSCR state under which host IEEE 754 arithmetic can reproduce the emulated VFP bit for bit:
+// scalar operations with no exception traps enabled. Any rounding mode is handled, since the
+// directed modes are derived from the round-to-nearest result below. Flush-to-zero and default
+// NaN mode don't matter, as operands and results that they would affect are left to the emulation.
+constexpr u32 FAST_PATH_FPSCR_MASK = FPSCR_STRIDE_MASK | FPSCR_LENGTH_MASK | FPSCR_IDE | FPSCR_IXE |
+                                     FPSCR_UFE | FPSCR_OFE | FPSCR_DZE | FPSCR_IOE;
+
+template <typename T>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<float> {
+    using Bits = u32;
+    static constexpr int MANTISSA_BITS = 23;
+    static constexpr u32 EXPONENT_MAX = 0xFF;
+
+    static Bits Read(const ARMul_State* state, u32 reg) {
+        return state->ExtReg[reg];
+    }
+    static void Write(ARMul_State* state, u32 reg, Bits value) {
+        state->ExtReg[reg] = value;
+    }
+};
+
+template <>
+struct FloatTraits<double> {
+    using Bits = u64;
+    static constexpr int MANTISSA_BITS = 52;
+    static constexpr u32 EXPONENT_MAX = 0x7FF;
+
+    static Bits Read(const ARMul_State* state, u32 reg) {
+        return static_cast<u64>(state->ExtReg[reg * 2 + 1]) << 32 | state->ExtReg[reg * 2];
+    }
+    static void Write(ARMul_State* state, u32 reg, Bits value) {
+        state->ExtReg[reg * 2] = static_cast<u32>(value);
+        state->ExtReg[reg * 2 + 1] = static_cast<u32>(value >> 32);
+    }
+};
+
+template <typename T>
+u32 GetExponent(typename FloatTraits<T>::Bits bits) {
+    return static_cast<u32>(bits >> FloatTraits<T>::MANTISSA_BITS) & FloatTraits<T>::EXPONENT_MAX;
+}
+
+template <typename T>
+bool IsZero(typename FloatTraits<T>::Bits bits) {
+    return (bits << 1) == 0;
+}
+
+template <typename T>
+bool IsNegative(typename FloatTraits<T>::Bits bits) {
+    return (bits >> (sizeof(bits) * 8 - 1)) != 0;
+}
+
+/// Zero or a finite normal number, which the emulated path consumes without raising any flag
+template <typename T>
+bool IsPlainOperand(typename FloatTraits<T>::Bits bits) {
+    const u32 exponent = GetExponent<T>(bits);
+    return exponent == 0 ? IsZero<T>(bits) : exponent != FloatTraits<T>::EXPONENT_MAX;
+}
+
+/**
+ * A normal number far enough from the flush-to-zero and overflow thresholds to need no handling.
+ * The exponent has to leave room below the result for its rounding error, so that the error
+ * computed with an FMA is exact and never underflows.
+ */
+template <typename T>
+bool IsPlainResult(typename FloatTraits<T>::Bits bits) {
+    const u32 exponent = GetExponent<T>(bits);
+    constexpr u32 min_exponent = FloatTraits<T>::MANTISSA_BITS + 3;
+    return exponent > min_exponent && exponent < FloatTraits<T>::EXPONENT_MAX - 1;
+}
+
+template <typename T>
+bool FastArithmetic(ARMul_State* state, VFPFastOp op, u32 d, u32 n, u32 m) {
+    using Traits = FloatTraits<T>;
+    using Bits = typename Traits::Bits;
+
+    const u32 rmode = state->VFP[VFP_FPSCR] & FPSCR_RMODE_MASK;
+    const Bits n_bits = op == VFPFastOp::Sqrt ? 0 : Traits::Read(state, n);
+    const Bits m_bits = Traits::Read(state, m);
+    if (!IsPlainOperand<T>(n_bits) || !IsPlainOperand<T>(m_bits)) {
+        return false;
+    }
+
+    T a, b;
+    std::memcpy(&a, &n_bits, sizeof(T));
+    std::memcpy(&b, &m_bits, sizeof(T));
+
+    // The host computes the result rounded to nearest. The sign of its rounding error, which the
+    // error-free transformations below give exactly, tells whether the exact result lies above or
+    // below it, and so which of it and its neighbour the other rounding modes pick.
+    T result;
+    T error;
+    // A zero result is only exact if it doesn't come from an underflow.
+    bool zero_is_exact;
+    switch (op) {
+    case VFPFastOp::Add:
+    case VFPFastOp::Sub: {
+        // The sum of two normal numbers is exact whenever it is tiny, so it never underflows. Its
+        // sign does depend on the rounding mode, though, which isn't worth handling here.
+        const T addend = op == VFPFastOp::Add ? b : -b;
+        result = a + addend;
+        const T rounded_addend = result - a;
+        error = (a - (result - rounded_addend)) + (addend - rounded_addend);
+        zero_is_exact = rmode != FPSCR_ROUND_MINUSINF;
+        break;
+    }
+    case VFPFastOp::Mul:
+        result = a * b;
+        error = std::fma(a, b, -result);
+        zero_is_exact = IsZero<T>(n_bits) || IsZero<T>(m_bits);
+        break;
+    case VFPFastOp::Div:
+        // The remainder is far smaller than the dividend, so that has to leave room for it too
+        if (IsZero<T>(m_bits) || (!IsZero<T>(n_bits) && !IsPlainResult<T>(n_bits))) {
+            return false;
+        }
+        result = a / b;
+        // The exact quotient is result + remainder / b
+        error = std::fma(-result, b, a);
+        if (IsNegative<T>(m_bits)) {
+            error = -error;
+        }
+        zero_is_exact = IsZero<T>(n_bits);
+        break;
+    case VFPFastOp::Sqrt:
+        // Likewise for the remainder of the root
+        if (!IsZero<T>(m_bits) && (IsNegative<T>(m_bits) || !IsPlainResult<T>(m_bits))) {
+            return false;
+        }
+        result = std::sqrt(b);
+        // The exact root is larger than result if its square is still below the operand
+        error = std::fma(-result, result, b);
+        zero_is_exact = IsZero<T>(m_bits);
+        break;
+    default:
+        return false;
+    }
+
+    Bits result_bits;
+    std::memcpy(&result_bits, &result, sizeof(T));
+    if (IsZero<T>(result_bits)) {
+        if (!zero_is_exact) {
+            return false;
+        }
+        error = 0;
+    } else if (!IsPlainResult<T>(result_bits)) {
+        return false;
+    }
+
+    if (error != 0) {
+        constexpr T infinity = std::numeric_limits<T>::infinity();
+        const bool round_up = rmode == FPSCR_ROUND_PLUSINF ||
+                              (rmode == FPSCR_ROUND_TOZERO && IsNegative<T>(result_bits));
+        const bool round_down = rmode == FPSCR_ROUND_MINUSINF ||
+                                (rmode == FPSCR_ROUND_TOZERO && !IsNegative<T>(result_bits));
+        if (round_up && error > 0) {
+            result = std::nextafter(result, infinity);
+        } else if (round_down && error < 0) {
+            result = std::nextafter(result, -infinity);
+        }
+        std::memcpy(&result_bits, &result, sizeof(T));
+        state->VFP[VFP_FPSCR] |= FPSCR_IXC;
+    }
+
+    Traits::Write(state, d, result_bits);
+    return true;
+}
+
+} // Anonymous namespace
+
+bool vfp_fast_cpdo(ARMul_State* state, VFPFastOp op, u32 inst, bool double_precision) {
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+    if ((state->VFP[VFP_FPSCR] & FAST_PATH_FPSCR_MASK) != 0) {
+        return false;
+    }
+
+    if (double_precision) {
+        return FastArithmetic<double>(state, op, vfp_get_dd(inst), vfp_get_dn(inst),
+                                      vfp_get_dm(inst));
+    }
+    return FastArithmetic<float>(state, op, vfp_get_sd(inst), vfp_get_sn(inst),
+                                 vfp_get_sm(inst));
+#else
+    // Hosts without SSE2 or an equivalent may evaluate with excess precision, which rounds
+    // differently.
+    return false;
+#endif
+}
+
 /* Miscellaneous functions */
 s32 vfp_get_float(ARMul_State* state, unsigned int reg) {
     LOG_TRACE(Core_ARM11, "VFP get float: s{}=[{:08x}]", reg, state->ExtReg[reg]);
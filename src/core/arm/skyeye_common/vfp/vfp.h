@@ -28,6 +28,19 @@
 
 void VFPInit(ARMul_State* state);
 
+/// Scalar VFP data-processing operations that can be executed on the host FPU
+enum class VFPFastOp { Add, Sub, Mul, Div, Sqrt };
+
+/**
+ * Executes a scalar VFP operation on the host FPU if the result is guaranteed to be identical to
+ * the one produced by vfp_single_cpdo/vfp_double_cpdo. That is the case when FPSCR selects no
+ * vector length and no exception traps, in any rounding mode, and when neither the operands nor
+ * the result are NaN, infinite, denormal or close to the overflow and underflow thresholds. The
+ * inexact flag is raised in FPSCR as the emulation would.
+ * @return true if the operation was executed, false if the exact emulation must be used instead.
+ */
+bool vfp_fast_cpdo(ARMul_State* state, VFPFastOp op, u32 inst, bool double_precision);
+
 s32 vfp_get_float(ARMul_State* state, u32 reg);
 void vfp_put_float(ARMul_State* state, s32 val, u32 reg);
 u64 vfp_get_double(ARMul_State* state, u32 reg);
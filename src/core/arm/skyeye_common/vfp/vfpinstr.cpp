@@ -278,7 +278,9 @@ VMUL_INST : {
 
         int ret;
 
-        if (inst_cream->dp_operation)
+        if (vfp_fast_cpdo(cpu, VFPFastOp::Mul, inst_cream->instr, inst_cream->dp_operation))
+            ret = 0;
+        else if (inst_cream->dp_operation)
             ret = vfp_double_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
         else
             ret = vfp_single_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
@@ -325,7 +327,9 @@ VADD_INST : {
 
         int ret;
 
-        if (inst_cream->dp_operation)
+        if (vfp_fast_cpdo(cpu, VFPFastOp::Add, inst_cream->instr, inst_cream->dp_operation))
+            ret = 0;
+        else if (inst_cream->dp_operation)
             ret = vfp_double_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
         else
             ret = vfp_single_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
@@ -372,7 +376,9 @@ VSUB_INST : {
 
         int ret;
 
-        if (inst_cream->dp_operation)
+        if (vfp_fast_cpdo(cpu, VFPFastOp::Sub, inst_cream->instr, inst_cream->dp_operation))
+            ret = 0;
+        else if (inst_cream->dp_operation)
             ret = vfp_double_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
         else
             ret = vfp_single_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
@@ -419,7 +425,9 @@ VDIV_INST : {
 
         int ret;
 
-        if (inst_cream->dp_operation)
+        if (vfp_fast_cpdo(cpu, VFPFastOp::Div, inst_cream->instr, inst_cream->dp_operation))
+            ret = 0;
+        else if (inst_cream->dp_operation)
             ret = vfp_double_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
         else
             ret = vfp_single_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
@@ -654,7 +662,9 @@ VSQRT_INST : {
 
         int ret;
 
-        if (inst_cream->dp_operation)
+        if (vfp_fast_cpdo(cpu, VFPFastOp::Sqrt, inst_cream->instr, inst_cream->dp_operation))
+            ret = 0;
+        else if (inst_cream->dp_operation)
             ret = vfp_double_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
         else
             ret = vfp_single_cpdo(cpu, inst_cream->instr, cpu->VFP[VFP_FPSCR]);
@@ -4,15 +4,19 @@
 
 #include <memory>
 #include <utility>
+#include <fmt/format.h>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
 #include "audio_core/lle/lle.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "core/arm/arm_interface.h"
 #ifdef ARCHITECTURE_x86_64
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/guest_profiler.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -22,6 +26,7 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hle/service/ldr_ro/ldr_ro.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/hw/hw.h"
@@ -36,9 +41,12 @@ namespace Core {
 
 /*static*/ System System::s_instance;
 
+/// Whether the calling host thread is one of the CPU core threads
+static thread_local bool is_core_thread = false;
+
 System::ResultStatus System::RunLoop(bool tight_loop) {
     status = ResultStatus::Success;
-    if (!cpu_core) {
+    if (cpu_cores.empty()) {
         return ResultStatus::ErrorNotInitialized;
     }
 
@@ -56,19 +64,42 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         }
     }
 
+    bool any_core_active = false;
+    for (u32 core_id = 0; core_id < GetNumCores(); ++core_id) {
+        any_core_active |= kernel->GetThreadManager(core_id).GetCurrentThread() != nullptr;
+    }
+
     // If we don't have a currently active thread then don't execute instructions,
     // instead advance to the next event and try to yield to the next thread
-    if (kernel->GetThreadManager().GetCurrentThread() == nullptr) {
+    if (!any_core_active) {
         LOG_TRACE(Core_ARM11, "Idling");
         timing->Idle();
         timing->Advance();
         PrepareReschedule();
     } else {
         timing->Advance();
-        if (tight_loop) {
-            cpu_core->Run();
+
+        // All cores execute the same slice, and the slice ends at the point the furthest core
+        // reached. Cores without an active thread sit the slice out. Stepping, debugging and
+        // movies need the cores to run in a deterministic order, so they take turns then.
+        const bool deterministic = !tight_loop || GDBStub::IsServerEnabled() ||
+                                   Movie::GetInstance().IsPlayingInput() ||
+                                   Movie::GetInstance().IsRecordingInput();
+        if (!core_threads.empty() && !deterministic) {
+            RunCoresInParallel();
         } else {
-            cpu_core->Step();
+            for (u32 core_id = 0; core_id < GetNumCores(); ++core_id) {
+                if (kernel->GetThreadManager(core_id).GetCurrentThread() == nullptr) {
+                    continue;
+                }
+                SetRunningCore(core_id);
+                if (tight_loop) {
+                    CPU().Run();
+                } else {
+                    CPU().Step();
+                }
+            }
+            SetRunningCore(0);
         }
     }
 
@@ -79,6 +110,14 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     HW::Update();
     Reschedule();
 
+    if (guest_profile_dump_requested.exchange(false)) {
+        DumpGuestProfile();
+    }
+
+    if (save_state_requested.exchange(false)) {
+        HandleSaveStateRequest();
+    }
+
     if (reset_requested.exchange(false)) {
         Reset();
     } else if (shutdown_requested.exchange(false)) {
@@ -142,6 +181,19 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
         }
     }
     memory->SetCurrentPageTable(&kernel->GetCurrentProcess()->vm_manager.page_table);
+
+    u64 program_id = 0;
+    app_loader->ReadProgramId(program_id);
+    for (u32 core_id = 0; core_id < GetNumCores(); ++core_id) {
+        GuestProfiler& guest_profiler = *guest_profilers[core_id];
+        guest_profiler.Clear();
+        guest_profiler.SetEnabled(Settings::values.enable_guest_profiler);
+
+        ARM_Interface& cpu_core = *cpu_cores[core_id];
+        cpu_core.SetIdleLoopDetection(Settings::IsIdleLoopDetectionEnabled(program_id));
+        cpu_core.SetGuestProfiler(guest_profiler.IsEnabled() ? &guest_profiler : nullptr);
+    }
+
     cheat_engine = std::make_unique<Cheats::CheatEngine>(*this);
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
@@ -150,10 +202,57 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
 }
 
 void System::PrepareReschedule() {
-    cpu_core->PrepareReschedule();
+    CPU().PrepareReschedule();
     reschedule_pending = true;
 }
 
+ARM_Interface& System::CPU() {
+    return *cpu_cores[kernel->GetRunningCoreId()];
+}
+
+void System::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    // The code of a core can't be touched while its thread runs it, so the other cores drop it
+    // once they finished the slice.
+    if (in_parallel_slice) {
+        CPU().InvalidateCacheRange(start_address, length);
+        pending_cache_invalidations.emplace_back(start_address, length);
+        return;
+    }
+
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core->InvalidateCacheRange(start_address, length);
+    }
+}
+
+void System::ClearInstructionCache() {
+    if (in_parallel_slice) {
+        CPU().ClearInstructionCache();
+        pending_cache_clear = true;
+        return;
+    }
+
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core->ClearInstructionCache();
+    }
+}
+
+bool System::IsCoreThread() const {
+    return is_core_thread;
+}
+
+void System::RunOnEmulationThread(const std::function<void()>& function) {
+    if (!is_core_thread) {
+        function();
+        return;
+    }
+
+    CoreRequest request{kernel->GetRunningCoreId(), &function};
+    std::unique_lock lock{core_threads_mutex};
+    core_requests.push_back(&request);
+    core_event.notify_one();
+    request_done.wait(lock, [&request] { return request.done; });
+}
+
 PerfStats::Results System::GetAndResetPerfStats() {
     return perf_stats.GetAndResetStats(timing->GetGlobalTimeUs());
 }
@@ -164,7 +263,205 @@ void System::Reschedule() {
     }
 
     reschedule_pending = false;
-    kernel->GetThreadManager().Reschedule();
+
+    // A reschedule can be caused by any core waking up threads on the others, so every core picks
+    // its next thread.
+    for (u32 core_id = 0; core_id < GetNumCores(); ++core_id) {
+        SetRunningCore(core_id);
+        kernel->GetThreadManager().Reschedule();
+    }
+    SetRunningCore(0);
+}
+
+void System::SetRunningCore(u32 core_id) {
+    kernel->SetRunningCore(core_id);
+    memory->SetRunningCore(core_id);
+    timing->SetRunningCore(core_id);
+}
+
+void System::StartCoreThreads() {
+    for (u32 core_id = 0; core_id < GetNumCores(); ++core_id) {
+        core_threads.emplace_back(&System::CoreThreadLoop, this, core_id, slice_id);
+    }
+}
+
+void System::StopCoreThreads() {
+    {
+        std::lock_guard lock{core_threads_mutex};
+        stop_core_threads = true;
+    }
+    slice_started.notify_all();
+    for (auto& thread : core_threads) {
+        thread.join();
+    }
+    core_threads.clear();
+    stop_core_threads = false;
+}
+
+void System::CoreThreadLoop(u32 core_id, u64 first_slice_id) {
+    const std::string name = fmt::format("CPU core {}", core_id);
+    Common::SetCurrentThreadName(name.c_str());
+    is_core_thread = true;
+    SetRunningCore(core_id);
+
+    ARM_Interface& cpu_core = *cpu_cores[core_id];
+    u64 last_slice_id = first_slice_id;
+    std::unique_lock lock{core_threads_mutex};
+    while (true) {
+        slice_started.wait(lock, [&] { return stop_core_threads || slice_id != last_slice_id; });
+        if (stop_core_threads) {
+            break;
+        }
+        last_slice_id = slice_id;
+        if (!core_runs_slice[core_id]) {
+            continue;
+        }
+
+        lock.unlock();
+        cpu_core.Run();
+        lock.lock();
+        if (--cores_running == 0) {
+            core_event.notify_one();
+        }
+    }
+}
+
+void System::RunCoresInParallel() {
+    std::unique_lock lock{core_threads_mutex};
+    for (u32 core_id = 0; core_id < GetNumCores(); ++core_id) {
+        core_runs_slice[core_id] = kernel->GetThreadManager(core_id).GetCurrentThread() != nullptr;
+        cores_running += core_runs_slice[core_id] ? 1 : 0;
+    }
+    ++slice_id;
+    in_parallel_slice = true;
+    slice_started.notify_all();
+
+    // The emulation thread keeps the kernel, the services and the video core to itself, and runs
+    // what the cores need of them until all cores finished the slice.
+    while (true) {
+        core_event.wait(lock, [this] { return cores_running == 0 || !core_requests.empty(); });
+        if (core_requests.empty()) {
+            break;
+        }
+        CoreRequest* const request = core_requests.front();
+        core_requests.erase(core_requests.begin());
+
+        lock.unlock();
+        SetRunningCore(request->core_id);
+        (*request->function)();
+        SetRunningCore(0);
+        lock.lock();
+        request->done = true;
+        request_done.notify_all();
+    }
+    in_parallel_slice = false;
+    lock.unlock();
+
+    if (pending_cache_clear) {
+        for (auto& cpu_core : cpu_cores) {
+            cpu_core->ClearInstructionCache();
+        }
+    } else {
+        for (const auto& [start_address, length] : pending_cache_invalidations) {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->InvalidateCacheRange(start_address, length);
+            }
+        }
+    }
+    pending_cache_invalidations.clear();
+    pending_cache_clear = false;
+}
+
+void System::DumpGuestProfile() {
+    if (guest_profilers.empty() || !guest_profilers[0]->IsEnabled()) {
+        return;
+    }
+
+    GuestProfiler guest_profiler;
+    for (const auto& core_profiler : guest_profilers) {
+        guest_profiler.Merge(*core_profiler);
+    }
+
+    std::vector<GuestProfiler::Module> modules;
+    u64 program_id = 0;
+    if (const auto process = kernel->GetCurrentProcess()) {
+        const auto& codeset = *process->codeset;
+        program_id = codeset.program_id;
+        modules.push_back({codeset.GetName(), codeset.CodeSegment().addr,
+                           codeset.CodeSegment().size});
+
+        if (const auto ldr_ro = service_manager->GetService<Service::LDR::RO>("ldr:ro")) {
+            for (const auto& module : ldr_ro->GetLoadedModules(*process)) {
+                modules.push_back({module.name, module.code_address, module.code_size});
+            }
+        }
+    }
+
+    constexpr std::size_t MAX_REPORT_ENTRIES = 200;
+    const std::string path = fmt::format(
+        "{}guest_profile_{:016X}", FileUtil::GetUserPath(FileUtil::UserPath::LogDir), program_id);
+    FileUtil::CreateFullPath(path);
+    FileUtil::WriteStringToFile(true, guest_profiler.GetFoldedStacks(modules),
+                                (path + ".folded").c_str());
+    FileUtil::WriteStringToFile(true, guest_profiler.GetReport(modules, MAX_REPORT_ENTRIES),
+                                (path + ".txt").c_str());
+    LOG_INFO(Core, "Guest profile written to {}.txt and {}.folded", path, path);
+}
+
+void System::RequestSaveState(std::string path, SaveStateMode mode) {
+    std::lock_guard lock{save_state_request_mutex};
+    save_state_request = {std::move(path), mode};
+    save_state_requested = true;
+}
+
+void System::RequestLoadState(std::string path) {
+    std::lock_guard lock{save_state_request_mutex};
+    save_state_request = {std::move(path), std::nullopt};
+    save_state_requested = true;
+}
+
+bool System::SaveState(const std::string& path, SaveStateMode mode) {
+    return save_state_manager->Save(path, mode);
+}
+
+bool System::LoadState(const std::string& path) {
+    return save_state_manager->Load(path);
+}
+
+std::string System::GetSaveStatePath(u32 slot) const {
+    u64 program_id = 0;
+    if (const auto process = kernel->GetCurrentProcess()) {
+        program_id = process->codeset->program_id;
+    }
+    return fmt::format("{}{:016X}.{:02d}.cst", FileUtil::GetUserPath(FileUtil::UserPath::StatesDir),
+                       program_id, slot);
+}
+
+void System::HandleSaveStateRequest() {
+    SaveStateRequest request;
+    {
+        std::lock_guard lock{save_state_request_mutex};
+        // A thread waiting on an HLE service can't be saved, so the save waits for the service
+        // to resume it, for at most an emulated second.
+        if (save_state_request.save_mode && !kernel->CanSaveState()) {
+            if (!save_state_request.deadline) {
+                save_state_request.deadline = timing->GetTicks() + BASE_CLOCK_RATE_ARM11;
+            }
+            if (timing->GetTicks() < *save_state_request.deadline) {
+                save_state_requested = true;
+                return;
+            }
+            LOG_ERROR(Core, "Gave up saving the state to {}", save_state_request.path);
+            return;
+        }
+        request = std::move(save_state_request);
+    }
+
+    if (request.save_mode) {
+        SaveState(request.path, *request.save_mode);
+    } else {
+        LoadState(request.path);
+    }
 }
 
 System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mode) {
@@ -172,24 +469,44 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
 
     memory = std::make_unique<Memory::MemorySystem>();
 
-    timing = std::make_unique<Timing>();
+    // The New 3DS exposes all four of its ARM11 cores to applications. On the Old 3DS every thread
+    // is scheduled on a single core, as the SysCore only runs system modules.
+    const u32 num_cores = Settings::values.is_new_3ds ? 4 : 1;
+
+    timing = std::make_unique<Timing>(num_cores);
 
-    kernel = std::make_unique<Kernel::KernelSystem>(*memory, *timing,
-                                                    [this] { PrepareReschedule(); }, system_mode);
+    kernel = std::make_unique<Kernel::KernelSystem>(
+        *memory, *timing, [this] { PrepareReschedule(); }, system_mode, num_cores);
 
+#if !defined(ARCHITECTURE_x86_64)
     if (Settings::values.use_cpu_jit) {
+        LOG_WARNING(Core, "CPU JIT requested, but Dynarmic not available");
+    }
+#endif
+
+    for (u32 core_id = 0; core_id < num_cores; ++core_id) {
+        std::unique_ptr<ARM_Interface> cpu_core;
+        if (Settings::values.use_cpu_jit) {
 #ifdef ARCHITECTURE_x86_64
-        cpu_core = std::make_unique<ARM_Dynarmic>(this, *memory, USER32MODE);
+            cpu_core = std::make_unique<ARM_Dynarmic>(this, *memory, USER32MODE);
 #else
-        cpu_core = std::make_unique<ARM_DynCom>(this, *memory, USER32MODE);
-        LOG_WARNING(Core, "CPU JIT requested, but Dynarmic not available");
+            cpu_core = std::make_unique<ARM_DynCom>(this, *memory, USER32MODE);
 #endif
-    } else {
-        cpu_core = std::make_unique<ARM_DynCom>(this, *memory, USER32MODE);
+        } else {
+            cpu_core = std::make_unique<ARM_DynCom>(this, *memory, USER32MODE);
+        }
+
+        kernel->GetThreadManager(core_id).SetCPU(*cpu_core);
+        memory->SetCPU(*cpu_core, core_id);
+        cpu_cores.push_back(std::move(cpu_core));
+        guest_profilers.push_back(std::make_unique<GuestProfiler>());
     }
+    save_state_manager = std::make_unique<SaveStateManager>(*this);
 
-    kernel->GetThreadManager().SetCPU(*cpu_core);
-    memory->SetCPU(*cpu_core);
+    core_runs_slice.assign(num_cores, false);
+    if (num_cores > 1) {
+        StartCoreThreads();
+    }
 
     if (Settings::values.enable_dsp_lle) {
         dsp_core = std::make_unique<AudioCore::DspLle>(*memory,
@@ -294,6 +611,8 @@ void System::Shutdown() {
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                                 perf_results.frametime * 1000.0);
 
+    DumpGuestProfile();
+
     // Shutdown emulation session
     GDBStub::Shutdown();
     VideoCore::Shutdown();
@@ -303,8 +622,14 @@ void System::Shutdown() {
     cheat_engine.reset();
     service_manager.reset();
     dsp_core.reset();
-    cpu_core.reset();
+    StopCoreThreads();
+    cpu_cores.clear();
+    guest_profilers.clear();
+    save_state_manager.reset();
     kernel.reset();
+    // Flushes the writes the closed files left pending, before the timing their periodic flush is
+    // scheduled on goes away
+    archive_manager.reset();
     timing.reset();
     app_loader.reset();
 
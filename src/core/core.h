@@ -4,17 +4,28 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "common/common_types.h"
 #include "core/frontend/applets/mii_selector.h"
 #include "core/frontend/applets/swkbd.h"
 #include "core/loader/loader.h"
 #include "core/memory.h"
 #include "core/perf_stats.h"
+#include "core/savestate.h"
 #include "core/telemetry_session.h"
 
 class ARM_Interface;
+class GuestProfiler;
 
 namespace Frontend {
 class EmuWindow;
@@ -90,6 +101,9 @@ public:
      * is not required to do a full dispatch with each instruction. NOTE: the number of instructions
      * requested is not guaranteed to run, as this will be interrupted preemptively if a hardware
      * update is requested (e.g. on a thread switch).
+     * With several CPU cores, each core runs the slice on its own host thread, while the calling
+     * thread handles what the cores ask of it. The cores run one after another on the calling
+     * thread instead when single-stepping, debugging or playing or recording a movie.
      * @param tight_loop If false, the CPU single-steps.
      * @return Result status, indicating whethor or not the operation succeeded.
      */
@@ -132,7 +146,7 @@ public:
      * @returns True if the emulated system is powered on, otherwise false.
      */
     bool IsPoweredOn() const {
-        return cpu_core != nullptr;
+        return !cpu_cores.empty();
     }
 
     /**
@@ -149,13 +163,71 @@ public:
     PerfStats::Results GetAndResetPerfStats();
 
     /**
-     * Gets a reference to the emulated CPU.
+     * Gets a reference to the emulated CPU core the calling host thread runs. That is core 0 for
+     * threads other than the CPU core threads, unless they handle a request of a core.
      * @returns A reference to the emulated CPU.
      */
-    ARM_Interface& CPU() {
-        return *cpu_core;
+    ARM_Interface& CPU();
+
+    /**
+     * Gets a reference to the emulated CPU core with the given ID.
+     * @returns A reference to the emulated CPU.
+     */
+    ARM_Interface& GetCore(u32 core_id) {
+        return *cpu_cores[core_id];
+    }
+
+    /// Gets the number of emulated CPU cores
+    u32 GetNumCores() const {
+        return static_cast<u32>(cpu_cores.size());
+    }
+
+    /// Invalidates the cached code of all CPU cores in the given address range
+    void InvalidateCacheRange(u32 start_address, std::size_t length);
+
+    /// Clears the cached code of all CPU cores
+    void ClearInstructionCache();
+
+    /// Returns whether the calling host thread is one of the threads running a CPU core
+    bool IsCoreThread() const;
+
+    /**
+     * Runs the given function on the emulation thread, on behalf of the CPU core the calling
+     * thread runs, and waits for it to finish. The kernel, the HLE services and the video core
+     * aren't thread-safe, so the CPU core threads go through this to access them. Called from any
+     * other thread, the function is run right away.
+     */
+    void RunOnEmulationThread(const std::function<void()>& function);
+
+    /**
+     * Requests the guest profile collected so far to be written to the log directory. Does
+     * nothing unless guest profiling is enabled. The dump happens on the emulation thread.
+     */
+    void RequestGuestProfileDump() {
+        guest_profile_dump_requested = true;
     }
 
+    /**
+     * Requests the state of the emulated system to be saved to the given file. Saving happens on
+     * the emulation thread, after the current slice, or once no thread waits on an HLE service.
+     */
+    void RequestSaveState(std::string path, SaveStateMode mode);
+
+    /**
+     * Requests the state of the emulated system to be loaded from the given file. Loading happens
+     * on the emulation thread, after the current slice.
+     */
+    void RequestLoadState(std::string path);
+
+    /// Saves the state of the emulated system right away. Must be called from the emulation thread.
+    bool SaveState(const std::string& path, SaveStateMode mode);
+
+    /// Loads the state of the emulated system right away. Must be called from the emulation thread.
+    bool LoadState(const std::string& path);
+
+    /// Gets the path of the given save state slot of the running title
+    std::string GetSaveStatePath(u32 slot) const;
+
     /**
      * Gets a reference to the emulated DSP.
      * @returns A reference to the emulated DSP.
@@ -251,17 +323,78 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Makes the calling host thread run the given CPU core, in the kernel, memory and timing
+    void SetRunningCore(u32 core_id);
+
+    /// Starts a host thread for each CPU core
+    void StartCoreThreads();
+
+    /// Stops and joins the CPU core threads
+    void StopCoreThreads();
+
+    /// Runs the given CPU core whenever a slice starts, until the core threads are stopped
+    void CoreThreadLoop(u32 core_id, u64 first_slice_id);
+
+    /**
+     * Runs the current slice on the core threads of the cores with an active thread, handling the
+     * requests of the cores until all of them finished it.
+     */
+    void RunCoresInParallel();
+
+    /// Writes the collected guest profile to the log directory
+    void DumpGuestProfile();
+
+    /// Carries out the save or load requested by RequestSaveState() or RequestLoadState()
+    void HandleSaveStateRequest();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
-    /// ARM11 CPU core
-    std::unique_ptr<ARM_Interface> cpu_core;
+    /// ARM11 CPU cores
+    std::vector<std::unique_ptr<ARM_Interface>> cpu_cores;
+
+    /// Host threads running the CPU cores, only used when there are several of them
+    std::vector<std::thread> core_threads;
+
+    /// Something that a CPU core thread asked the emulation thread to run
+    struct CoreRequest {
+        u32 core_id;
+        const std::function<void()>* function;
+        bool done = false;
+    };
+
+    /// Guards the state shared with the CPU core threads below
+    std::mutex core_threads_mutex;
+    /// Notified when a slice starts or the core threads are to stop
+    std::condition_variable slice_started;
+    /// Notified when a core thread made a request or finished its slice
+    std::condition_variable core_event;
+    /// Notified when the emulation thread finished handling a request
+    std::condition_variable request_done;
+    u64 slice_id = 0;
+    bool stop_core_threads = false;
+    /// Whether each CPU core runs the current slice
+    std::vector<bool> core_runs_slice;
+    /// Number of CPU cores that didn't finish the current slice yet
+    u32 cores_running = 0;
+    std::vector<CoreRequest*> core_requests;
+
+    /// Whether the CPU core threads are running a slice. Only used on the emulation thread.
+    bool in_parallel_slice = false;
+    /// Code invalidations of the CPU cores that couldn't be applied while they ran in parallel
+    std::vector<std::pair<u32, std::size_t>> pending_cache_invalidations;
+    bool pending_cache_clear = false;
+
+    /// Collect guest code execution statistics, one for each CPU core
+    std::vector<std::unique_ptr<GuestProfiler>> guest_profilers;
+
+    std::unique_ptr<SaveStateManager> save_state_manager;
 
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
     /// When true, signals that a reschedule should happen
-    bool reschedule_pending{};
+    std::atomic<bool> reschedule_pending{};
 
     /// Telemetry session for this emulation session
     std::unique_ptr<Core::TelemetrySession> telemetry_session;
@@ -296,6 +429,19 @@ private:
 
     std::atomic<bool> reset_requested;
     std::atomic<bool> shutdown_requested;
+    std::atomic<bool> guest_profile_dump_requested{};
+
+    /// A save or load of the system state requested from another thread
+    struct SaveStateRequest {
+        std::string path;
+        /// The mode to save with, or no value to load the state
+        std::optional<SaveStateMode> save_mode;
+        /// Emulated time at which a save waiting for the system to be saveable is given up
+        std::optional<u64> deadline;
+    };
+    std::atomic<bool> save_state_requested{};
+    std::mutex save_state_request_mutex;
+    SaveStateRequest save_state_request;
 };
 
 inline ARM_Interface& CPU() {
@@ -4,13 +4,20 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <optional>
 #include <tuple>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core_timing.h"
 
 namespace Core {
 
+namespace {
+// Core whose timer the calling host thread uses, see Timing::SetRunningCore()
+thread_local u32 running_core_id = 0;
+} // Anonymous namespace
+
 // Sort by time, unless the times are the same, in which case sort by the order added to the queue
 bool Timing::Event::operator>(const Event& right) const {
     return std::tie(time, fifo_order) > std::tie(right.time, right.fifo_order);
@@ -20,6 +27,10 @@ bool Timing::Event::operator<(const Event& right) const {
     return std::tie(time, fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
+std::size_t Timing::EventKeyHash::operator()(const EventKey& key) const {
+    return std::hash<const TimingEventType*>()(key.first) ^ (std::hash<u64>()(key.second) * 31);
+}
+
 TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback callback) {
     // check for existing type with same name.
     // we want event type names to remain unique so that we can use them for serialization.
@@ -34,20 +45,45 @@ TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback ca
     return event_type;
 }
 
+Timing::Timing(u32 num_cores) : timers(num_cores) {
+    ASSERT(num_cores > 0);
+}
+
 Timing::~Timing() {
     MoveEvents();
+
+    if (ts_stats.count != 0) {
+        LOG_DEBUG(Core_Timing,
+                  "{} threadsafe events ({} overflowed), latency avg {} max {} cycles",
+                  ts_stats.count, ts_stats.overflowed, ts_stats.total_latency / ts_stats.count,
+                  ts_stats.max_latency);
+    }
+}
+
+void Timing::SetRunningCore(u32 core_id) {
+    ASSERT(core_id < timers.size());
+    running_core_id = core_id;
+}
+
+Timing::Timer& Timing::GetTimer() {
+    return timers[running_core_id];
+}
+
+const Timing::Timer& Timing::GetTimer() const {
+    return timers[running_core_id];
 }
 
 u64 Timing::GetTicks() const {
     u64 ticks = static_cast<u64>(global_timer);
     if (!is_global_timer_sane) {
-        ticks += slice_length - downcount;
+        const Timer& timer = GetTimer();
+        ticks += timer.slice_length - timer.downcount;
     }
     return ticks;
 }
 
 void Timing::AddTicks(u64 ticks) {
-    downcount -= ticks;
+    GetTimer().downcount -= ticks;
 }
 
 u64 Timing::GetIdleTicks() const {
@@ -63,35 +99,38 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    PushEvent(Event{timeout, event_fifo_id++, userdata, event_type});
 }
 
 void Timing::ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventType* event_type,
                                      u64 userdata) {
-    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
+    const ThreadsafeEvent event{Event{global_timer + cycles_into_future, 0, userdata, event_type},
+                                global_timer};
+    // While the overflow queue holds events, later ones have to follow them there so that events
+    // from the same thread stay in order.
+    if (!ts_overflow_queue.Empty() || !ts_queue.Push(event)) {
+        ts_overflow_queue.Push(event);
+        ++ts_overflow_count;
+    }
 }
 
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    const auto itr = event_index.find(EventKey{event_type, userdata});
+    if (itr == event_index.end()) {
+        return;
     }
+    EraseSlotList(itr->second);
+    event_index.erase(itr);
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    for (auto itr = event_index.begin(); itr != event_index.end();) {
+        if (itr->first.first != event_type) {
+            ++itr;
+            continue;
+        }
+        EraseSlotList(itr->second);
+        itr = event_index.erase(itr);
     }
 }
 
@@ -102,50 +141,76 @@ void Timing::RemoveNormalAndThreadsafeEvent(const TimingEventType* event_type) {
 
 void Timing::ForceExceptionCheck(s64 cycles) {
     cycles = std::max<s64>(0, cycles);
-    if (downcount > cycles) {
-        slice_length -= downcount - cycles;
-        downcount = cycles;
+    Timer& timer = GetTimer();
+    if (timer.downcount > cycles) {
+        timer.slice_length -= timer.downcount - cycles;
+        timer.downcount = cycles;
     }
 }
 
 void Timing::MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    for (ThreadsafeEvent ev; ts_queue.Pop(ev) || ts_overflow_queue.Pop(ev);) {
+        ev.event.fifo_order = event_fifo_id++;
+        ts_batch.push_back(ev.event);
+
+        const u64 latency = static_cast<u64>(std::max<s64>(0, global_timer - ev.scheduled_at));
+        ++ts_stats.count;
+        ts_stats.total_latency += latency;
+        ts_stats.max_latency = std::max(ts_stats.max_latency, latency);
+    }
+
+    if (!ts_batch.empty()) {
+        ts_stats.overflowed = ts_overflow_count.load(std::memory_order_relaxed);
+        PushEvents(ts_batch);
+        ts_batch.clear();
     }
 }
 
 void Timing::Advance() {
     MoveEvents();
 
-    s64 cycles_executed = slice_length - downcount;
+    // The slice was only idle for as long as every core that ran it was. Cores that didn't
+    // execute any of it sat the slice out.
+    s64 cycles_executed = 0;
+    std::optional<s64> slice_idled_cycles;
+    for (const Timer& timer : timers) {
+        const s64 timer_cycles_executed = timer.slice_length - timer.downcount;
+        if (timer_cycles_executed <= 0) {
+            continue;
+        }
+        cycles_executed = std::max(cycles_executed, timer_cycles_executed);
+        slice_idled_cycles = std::min(slice_idled_cycles.value_or(timer.idled_cycles),
+                                      timer.idled_cycles);
+    }
     global_timer += cycles_executed;
-    slice_length = MAX_SLICE_LENGTH;
+    idled_cycles += slice_idled_cycles.value_or(0);
+    s64 slice_length = MAX_SLICE_LENGTH;
 
     is_global_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_heap.empty() && TopEvent().time <= global_timer) {
+        const Event evt = TopEvent();
+        EraseEvent(event_heap.front());
         evt.type->callback(evt.userdata, global_timer - evt.time);
     }
 
     is_global_timer_sane = false;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (!event_heap.empty()) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - global_timer, MAX_SLICE_LENGTH));
+            std::min<s64>(TopEvent().time - global_timer, MAX_SLICE_LENGTH));
     }
 
-    downcount = slice_length;
+    for (Timer& timer : timers) {
+        timer = {slice_length, slice_length, 0};
+    }
 }
 
 void Timing::Idle() {
-    idled_cycles += downcount;
-    downcount = 0;
+    Timer& timer = GetTimer();
+    timer.idled_cycles += timer.downcount;
+    timer.downcount = 0;
 }
 
 std::chrono::microseconds Timing::GetGlobalTimeUs() const {
@@ -153,7 +218,207 @@ std::chrono::microseconds Timing::GetGlobalTimeUs() const {
 }
 
 s64 Timing::GetDowncount() const {
-    return downcount;
+    return GetTimer().downcount;
+}
+
+const Timing::ThreadsafeEventStats& Timing::GetThreadsafeEventStats() const {
+    return ts_stats;
+}
+
+void Timing::DoState(PointerWrap& p) {
+    // Events still queued by other threads are not part of the state, they are moved into the
+    // queue of whichever state is current when they arrive.
+    p.Do(global_timer);
+    u32 num_timers = static_cast<u32>(timers.size());
+    p.Do(num_timers);
+    if (num_timers != timers.size()) {
+        LOG_ERROR(Core_Timing, "Saved state has {} CPU core timers instead of {}", num_timers,
+                  timers.size());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+    for (Timer& timer : timers) {
+        p.Do(timer.slice_length);
+        p.Do(timer.downcount);
+        p.Do(timer.idled_cycles);
+    }
+    p.Do(idled_cycles);
+    p.Do(event_fifo_id);
+    p.Do(is_global_timer_sane);
+
+    // Event types are stored by name, as the callbacks are registered anew on every boot.
+    u32 num_events = static_cast<u32>(event_heap.size());
+    p.Do(num_events);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (std::size_t slot : event_heap) {
+            Event& event = event_slots[slot].event;
+            std::string name = *event.type->name;
+            p.Do(event.time);
+            p.Do(event.fifo_order);
+            p.Do(event.userdata);
+            p.Do(name);
+        }
+        return;
+    }
+
+    std::vector<Event> events(num_events);
+    for (Event& event : events) {
+        std::string name;
+        p.Do(event.time);
+        p.Do(event.fifo_order);
+        p.Do(event.userdata);
+        p.Do(name);
+        const auto itr = event_types.find(name);
+        if (itr == event_types.end()) {
+            LOG_ERROR(Core_Timing, "Saved state refers to unknown event type {}", name);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        event.type = &itr->second;
+    }
+
+    event_slots.clear();
+    free_event_slots.clear();
+    event_heap.clear();
+    event_index.clear();
+    PushEvents(events);
+}
+
+void Timing::PushEvent(const Event& event) {
+    SiftUp(AddEventSlot(event));
+}
+
+void Timing::PushEvents(const std::vector<Event>& events) {
+    const std::size_t first = event_heap.size();
+    for (const Event& event : events) {
+        AddEventSlot(event);
+    }
+
+    // Rebuilding the heap bottom-up is cheaper than sifting up every event of a large batch.
+    if (events.size() * 8 > event_heap.size()) {
+        for (std::size_t i = event_heap.size() / 2; i-- > 0;) {
+            SiftDown(i);
+        }
+    } else {
+        for (std::size_t i = first; i < event_heap.size(); ++i) {
+            SiftUp(i);
+        }
+    }
+}
+
+std::size_t Timing::AddEventSlot(const Event& event) {
+    std::size_t slot;
+    if (free_event_slots.empty()) {
+        slot = event_slots.size();
+        event_slots.emplace_back();
+    } else {
+        slot = free_event_slots.back();
+        free_event_slots.pop_back();
+    }
+
+    EventSlot& event_slot = event_slots[slot];
+    event_slot.event = event;
+    event_slot.heap_index = event_heap.size();
+    event_heap.push_back(slot);
+
+    // Link the slot in at the head of the list of its (type, userdata) pair
+    const auto [itr, inserted] =
+        event_index.try_emplace(EventKey{event.type, event.userdata}, slot);
+    event_slot.index_prev = NO_SLOT;
+    event_slot.index_next = NO_SLOT;
+    if (!inserted) {
+        event_slot.index_next = itr->second;
+        event_slots[itr->second].index_prev = slot;
+        itr->second = slot;
+    }
+    return event_slot.heap_index;
+}
+
+void Timing::EraseEvent(std::size_t slot) {
+    const EventSlot& event_slot = event_slots[slot];
+    if (event_slot.index_prev != NO_SLOT) {
+        event_slots[event_slot.index_prev].index_next = event_slot.index_next;
+    } else {
+        const auto itr =
+            event_index.find(EventKey{event_slot.event.type, event_slot.event.userdata});
+        if (event_slot.index_next == NO_SLOT) {
+            event_index.erase(itr);
+        } else {
+            itr->second = event_slot.index_next;
+        }
+    }
+    if (event_slot.index_next != NO_SLOT) {
+        event_slots[event_slot.index_next].index_prev = event_slot.index_prev;
+    }
+    EraseFromHeap(slot);
+}
+
+void Timing::EraseSlotList(std::size_t first_slot) {
+    for (std::size_t slot = first_slot; slot != NO_SLOT;) {
+        const std::size_t next = event_slots[slot].index_next;
+        EraseFromHeap(slot);
+        slot = next;
+    }
+}
+
+void Timing::EraseFromHeap(std::size_t slot) {
+    const std::size_t heap_index = event_slots[slot].heap_index;
+    free_event_slots.push_back(slot);
+
+    // Move the last heap entry into the hole and restore the heap property around it.
+    const std::size_t last = event_heap.size() - 1;
+    if (heap_index != last) {
+        HeapSwap(heap_index, last);
+    }
+    event_heap.pop_back();
+    if (heap_index != last) {
+        SiftUp(heap_index);
+        SiftDown(heap_index);
+    }
+}
+
+const Timing::Event& Timing::TopEvent() const {
+    return event_slots[event_heap.front()].event;
+}
+
+bool Timing::HeapLess(std::size_t a, std::size_t b) const {
+    return event_slots[event_heap[a]].event < event_slots[event_heap[b]].event;
+}
+
+void Timing::HeapSwap(std::size_t a, std::size_t b) {
+    std::swap(event_heap[a], event_heap[b]);
+    event_slots[event_heap[a]].heap_index = a;
+    event_slots[event_heap[b]].heap_index = b;
+}
+
+void Timing::SiftUp(std::size_t heap_index) {
+    while (heap_index > 0) {
+        const std::size_t parent = (heap_index - 1) / 2;
+        if (!HeapLess(heap_index, parent)) {
+            break;
+        }
+        HeapSwap(heap_index, parent);
+        heap_index = parent;
+    }
+}
+
+void Timing::SiftDown(std::size_t heap_index) {
+    while (true) {
+        const std::size_t left = heap_index * 2 + 1;
+        const std::size_t right = left + 1;
+        std::size_t smallest = heap_index;
+        if (left < event_heap.size() && HeapLess(left, smallest)) {
+            smallest = left;
+        }
+        if (right < event_heap.size() && HeapLess(right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == heap_index) {
+            break;
+        }
+        HeapSwap(heap_index, smallest);
+        heap_index = smallest;
+    }
 }
 
 } // namespace Core
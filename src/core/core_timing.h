@@ -17,16 +17,20 @@
  *   ScheduleEvent(periodInCycles - cyclesLate, callback, "whatever")
  */
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <limits>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/threadsafe_queue.h"
 
+class PointerWrap;
+
 // The timing we get from the assembly is 268,111,855.956 Hz
 // It is possible that this number isn't just an integer because the compiler could have
 // optimized the multiplication by a multiply-by-constant division.
@@ -134,8 +138,20 @@ struct TimingEventType {
 
 class Timing {
 public:
+    /**
+     * @param num_cores Number of emulated CPU cores, each of which executes its slices with a
+     *     timer of its own
+     */
+    explicit Timing(u32 num_cores = 1);
     ~Timing();
 
+    /**
+     * Makes the calling host thread use the timer of the given core. Every host thread starts out
+     * using the timer of core 0. The tick and downcount functions work on the timer of the calling
+     * thread, so that the host threads running the cores can execute a slice at the same time.
+     */
+    void SetRunningCore(u32 core_id);
+
     /**
      * This should only be called from the emu thread, if you are calling it any other thread, you
      * are doing something evil
@@ -165,9 +181,10 @@ public:
     void ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventType* event_type,
                                  u64 userdata);
 
+    /// Removes all scheduled events with the given type and userdata.
     void UnscheduleEvent(const TimingEventType* event_type, u64 userdata);
 
-    /// We only permit one event of each type in the queue at a time.
+    /// Removes all scheduled events of the given type.
     void RemoveEvent(const TimingEventType* event_type);
     void RemoveNormalAndThreadsafeEvent(const TimingEventType* event_type);
 
@@ -175,12 +192,13 @@ public:
      * the previous timing slice and begins the next one, you must Advance from the previous
      * slice to the current one before executing any cycles. CoreTiming starts in slice -1 so an
      * Advance() is required to initialize the slice length before the first cycle of emulated
-     * instructions is executed.
+     * instructions is executed. The slice ends at the furthest point reached by any core, and
+     * Advance() must not be called while a core is executing it.
      */
     void Advance();
     void MoveEvents();
 
-    /// Pretend that the main CPU has executed enough cycles to reach the next event.
+    /// Pretend that the running CPU core has executed enough cycles to reach the next event.
     void Idle();
 
     void ForceExceptionCheck(s64 cycles);
@@ -189,6 +207,23 @@ public:
 
     s64 GetDowncount() const;
 
+    /// Statistics about events scheduled from other threads
+    struct ThreadsafeEventStats {
+        /// Number of events moved into the event queue
+        u64 count = 0;
+        /// Number of events that went through the overflow queue instead of the lock-free ring
+        u64 overflowed = 0;
+        /// Sum of the guest cycles between scheduling each event and moving it into the queue
+        u64 total_latency = 0;
+        /// Longest such delay, in guest cycles
+        u64 max_latency = 0;
+    };
+
+    const ThreadsafeEventStats& GetThreadsafeEventStats() const;
+
+    /// Saves or restores the timer and the scheduled events
+    void DoState(PointerWrap& p);
+
 private:
     struct Event {
         s64 time;
@@ -200,25 +235,89 @@ private:
         bool operator<(const Event& right) const;
     };
 
+    /// An event scheduled by ScheduleEventThreadsafe(), along with the time it was scheduled at
+    struct ThreadsafeEvent {
+        Event event;
+        s64 scheduled_at;
+    };
+
+    /// Event type and userdata of a scheduled event, the key event_index looks events up by
+    using EventKey = std::pair<const TimingEventType*, u64>;
+
+    struct EventKeyHash {
+        std::size_t operator()(const EventKey& key) const;
+    };
+
+    /// A scheduled event, kept at a fixed index so the heap and the index can refer to it
+    struct EventSlot {
+        Event event;
+        std::size_t heap_index;
+        /// Neighbours in the list of slots that share the event's type and userdata
+        std::size_t index_prev;
+        std::size_t index_next;
+    };
+
+    static constexpr std::size_t NO_SLOT = std::numeric_limits<std::size_t>::max();
+
+    void PushEvent(const Event& event);
+    /// Merges a batch of events into the queue at once
+    void PushEvents(const std::vector<Event>& events);
+    /// Stores an event at the end of the heap without restoring the heap property
+    std::size_t AddEventSlot(const Event& event);
+    /// Removes the event in the given slot from the queue
+    void EraseEvent(std::size_t slot);
+    /// Removes the event in the given slot from the heap, leaving its event_index entry alone
+    void EraseFromHeap(std::size_t slot);
+    /// Removes all events in the list of slots starting at the given one from the heap
+    void EraseSlotList(std::size_t first_slot);
+    const Event& TopEvent() const;
+
+    bool HeapLess(std::size_t a, std::size_t b) const;
+    void HeapSwap(std::size_t a, std::size_t b);
+    void SiftUp(std::size_t heap_index);
+    void SiftDown(std::size_t heap_index);
+
     static constexpr int MAX_SLICE_LENGTH = 20000;
+    static constexpr std::size_t THREADSAFE_QUEUE_SIZE = 1024;
+
+    /// Progress of a CPU core through the current slice
+    struct Timer {
+        s64 slice_length = MAX_SLICE_LENGTH;
+        s64 downcount = MAX_SLICE_LENGTH;
+        // Cycles of the slice the core idled through
+        s64 idled_cycles = 0;
+    };
+
+    /// Gets the timer of the core the calling host thread runs
+    Timer& GetTimer();
+    const Timer& GetTimer() const;
 
     s64 global_timer = 0;
-    s64 slice_length = MAX_SLICE_LENGTH;
-    s64 downcount = MAX_SLICE_LENGTH;
+    std::vector<Timer> timers;
 
     // unordered_map stores each element separately as a linked list node so pointers to
     // elements remain stable regardless of rehashes/resizing.
     std::unordered_map<std::string, TimingEventType> event_types;
 
-    // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-    // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-    // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-    // accomodated by the standard adaptor class.
-    std::vector<Event> event_queue;
+    // The queue is an indexed min-heap over event_slots, ordered by time and then by the order the
+    // events were scheduled in. Every slot knows its position in the heap, so that arbitrary events
+    // can be erased in O(log n) instead of rebuilding the heap. event_index maps each
+    // (type, userdata) pair to the first of its slots, which are linked into a list through the
+    // slots themselves, so that events are added to and removed from it in O(1).
+    std::vector<EventSlot> event_slots;
+    std::vector<std::size_t> free_event_slots;
+    std::vector<std::size_t> event_heap;
+    std::unordered_map<EventKey, std::size_t, EventKeyHash> event_index;
     u64 event_fifo_id = 0;
     // the queue for storing the events from other threads threadsafe until they will be added
-    // to the event_queue by the emu thread
-    Common::MPSCQueue<Event> ts_queue;
+    // to the event heap by the emu thread. Events that don't fit into the lock-free ring go to the
+    // (locking) overflow queue.
+    Common::BoundedMPSCQueue<ThreadsafeEvent, THREADSAFE_QUEUE_SIZE> ts_queue;
+    Common::MPSCQueue<ThreadsafeEvent> ts_overflow_queue;
+    std::atomic<u64> ts_overflow_count{0};
+    // Events drained from the queues by MoveEvents(), kept around to avoid reallocating
+    std::vector<Event> ts_batch;
+    ThreadsafeEventStats ts_stats;
     s64 idled_cycles = 0;
 
     // Are we in a function that has been called from Advance()
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <iomanip>
 #include <sstream>
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "core/file_sys/archive_backend.h"
@@ -118,4 +119,16 @@ std::vector<u8> Path::AsBinary() const {
         return {};
     }
 }
+
+void Path::DoState(PointerWrap& p) {
+    p.Do(type);
+    p.Do(binary);
+    p.Do(string);
+    std::vector<char16_t> wide(u16str.begin(), u16str.end());
+    p.Do(wide);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        u16str.assign(wide.begin(), wide.end());
+    }
+}
+
 } // namespace FileSys
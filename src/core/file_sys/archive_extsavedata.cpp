@@ -10,6 +10,7 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/archive_extsavedata.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/path_parser.h"
@@ -27,9 +28,11 @@ namespace FileSys {
  */
 class FixSizeDiskFile : public DiskFile {
 public:
-    FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode,
-                    std::unique_ptr<DelayGenerator> delay_generator_)
-        : DiskFile(std::move(file), mode, std::move(delay_generator_)) {
+    FixSizeDiskFile(FileUtil::IOFile&& file, const std::string& path, const Mode& mode,
+                    std::unique_ptr<DelayGenerator> delay_generator_,
+                    std::shared_ptr<WriteBackCache> write_back_cache_)
+        : DiskFile(std::move(file), path, mode, std::move(delay_generator_),
+                   std::move(write_back_cache_)) {
         size = GetSize();
     }
 
@@ -88,9 +91,10 @@ public:
  */
 class ExtSaveDataArchive : public SaveDataArchive {
 public:
-    explicit ExtSaveDataArchive(const std::string& mount_point,
-                                std::unique_ptr<DelayGenerator> delay_generator_)
-        : SaveDataArchive(mount_point) {
+    ExtSaveDataArchive(const std::string& mount_point,
+                       std::unique_ptr<DelayGenerator> delay_generator_,
+                       std::shared_ptr<WriteBackCache> write_back_cache_)
+        : SaveDataArchive(mount_point, std::move(write_back_cache_)) {
         delay_generator = std::move(delay_generator_);
     }
 
@@ -150,8 +154,8 @@ public:
         rwmode.read_flag.Assign(1);
         std::unique_ptr<DelayGenerator> delay_generator =
             std::make_unique<ExtSaveDataDelayGenerator>();
-        auto disk_file =
-            std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator));
+        auto disk_file = std::make_unique<FixSizeDiskFile>(
+            std::move(file), full_path, rwmode, std::move(delay_generator), write_back_cache);
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
@@ -207,9 +211,11 @@ Path ConstructExtDataBinaryPath(u32 media_type, u32 high, u32 low) {
     return {binary_path};
 }
 
-ArchiveFactory_ExtSaveData::ArchiveFactory_ExtSaveData(const std::string& mount_location,
-                                                       bool shared)
-    : shared(shared), mount_point(GetExtDataContainerPath(mount_location, shared)) {
+ArchiveFactory_ExtSaveData::ArchiveFactory_ExtSaveData(
+    const std::string& mount_location, bool shared,
+    std::shared_ptr<WriteBackCache> write_back_cache)
+    : shared(shared), mount_point(GetExtDataContainerPath(mount_location, shared)),
+      write_back_cache(std::move(write_back_cache)) {
     LOG_DEBUG(Service_FS, "Directory {} set as base for ExtSaveData.", mount_point);
 }
 
@@ -245,7 +251,8 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_ExtSaveData::Open(cons
         }
     }
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<ExtSaveDataDelayGenerator>();
-    auto archive = std::make_unique<ExtSaveDataArchive>(fullpath, std::move(delay_generator));
+    auto archive = std::make_unique<ExtSaveDataArchive>(fullpath, std::move(delay_generator),
+                                                        write_back_cache);
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
 
@@ -259,6 +266,7 @@ ResultCode ArchiveFactory_ExtSaveData::Format(const Path& path,
     std::string boss_path = GetExtSaveDataPath(mount_point, corrected_path) + "boss/";
     FileUtil::CreateFullPath(user_path);
     FileUtil::CreateFullPath(boss_path);
+    InvalidateDirectorySnapshots(GetExtSaveDataPath(mount_point, corrected_path));
 
     // Write the format metadata
     std::string metadata_path = GetExtSaveDataPath(mount_point, corrected_path) + "metadata";
@@ -8,6 +8,7 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,7 +19,8 @@ namespace FileSys {
 /// File system interface to the ExtSaveData archive
 class ArchiveFactory_ExtSaveData final : public ArchiveFactory {
 public:
-    ArchiveFactory_ExtSaveData(const std::string& mount_point, bool shared);
+    ArchiveFactory_ExtSaveData(const std::string& mount_point, bool shared,
+                               std::shared_ptr<WriteBackCache> write_back_cache);
 
     std::string GetName() const override {
         return "ExtSaveData";
@@ -52,6 +54,8 @@ private:
      */
     std::string mount_point;
 
+    std::shared_ptr<WriteBackCache> write_back_cache;
+
     /// Returns a path with the correct SaveIdHigh value for Shared extdata paths.
     Path GetCorrectedPath(const Path& path);
 };
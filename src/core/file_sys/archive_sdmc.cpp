@@ -7,6 +7,7 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/archive_sdmc.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/path_parser.h"
@@ -92,6 +93,7 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
         } else {
             // Create the file
             FileUtil::CreateEmptyFile(full_path);
+            InvalidateDirectorySnapshots(full_path);
         }
         break;
     case PathParser::FileFound:
@@ -105,7 +107,8 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
     }
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SDMCDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<DiskFile>(std::move(file), full_path, mode,
+                                                std::move(delay_generator), write_back_cache);
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -136,6 +139,8 @@ ResultCode SDMCArchive::DeleteFile(const Path& path) const {
     }
 
     if (FileUtil::Delete(full_path)) {
+        write_back_cache->DiscardPendingWrites(full_path);
+        InvalidateDirectorySnapshots(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -163,6 +168,9 @@ ResultCode SDMCArchive::RenameFile(const Path& src_path, const Path& dest_path)
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        write_back_cache->RenamePendingWrites(src_path_full, dest_path_full);
+        InvalidateDirectorySnapshots(src_path_full);
+        InvalidateDirectorySnapshots(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -174,7 +182,7 @@ ResultCode SDMCArchive::RenameFile(const Path& src_path, const Path& dest_path)
 
 template <typename T>
 static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mount_point,
-                                        T deleter) {
+                                        WriteBackCache& write_back_cache, T deleter) {
     const PathParser path_parser(path);
 
     if (!path_parser.IsValid()) {
@@ -204,6 +212,8 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
     }
 
     if (deleter(full_path)) {
+        write_back_cache.DiscardPendingWrites(full_path);
+        InvalidateDirectorySnapshots(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -212,12 +222,13 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
 }
 
 ResultCode SDMCArchive::DeleteDirectory(const Path& path) const {
-    return DeleteDirectoryHelper(path, mount_point, FileUtil::DeleteDir);
+    return DeleteDirectoryHelper(path, mount_point, *write_back_cache, FileUtil::DeleteDir);
 }
 
 ResultCode SDMCArchive::DeleteDirectoryRecursively(const Path& path) const {
-    return DeleteDirectoryHelper(
-        path, mount_point, [](const std::string& p) { return FileUtil::DeleteDirRecursively(p); });
+    return DeleteDirectoryHelper(path, mount_point, *write_back_cache, [](const std::string& p) {
+        return FileUtil::DeleteDirRecursively(p);
+    });
 }
 
 ResultCode SDMCArchive::CreateFile(const FileSys::Path& path, u64 size) const {
@@ -248,6 +259,7 @@ ResultCode SDMCArchive::CreateFile(const FileSys::Path& path, u64 size) const {
         break; // Expected 'success' case
     }
 
+    InvalidateDirectorySnapshots(full_path);
     if (size == 0) {
         FileUtil::CreateEmptyFile(full_path);
         return RESULT_SUCCESS;
@@ -292,6 +304,7 @@ ResultCode SDMCArchive::CreateDirectory(const Path& path) const {
     }
 
     if (FileUtil::CreateDir(mount_point + path.AsString())) {
+        InvalidateDirectorySnapshots(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -320,6 +333,9 @@ ResultCode SDMCArchive::RenameDirectory(const Path& src_path, const Path& dest_p
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        write_back_cache->RenamePendingWrites(src_path_full, dest_path_full);
+        InvalidateDirectorySnapshots(src_path_full);
+        InvalidateDirectorySnapshots(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -355,7 +371,7 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SDMCArchive::OpenDirectory(const Pa
         break; // Expected 'success' case
     }
 
-    auto directory = std::make_unique<DiskDirectory>(full_path);
+    auto directory = std::make_unique<DiskDirectory>(full_path, *write_back_cache);
     return MakeResult<std::unique_ptr<DirectoryBackend>>(std::move(directory));
 }
 
@@ -364,8 +380,9 @@ u64 SDMCArchive::GetFreeBytes() const {
     return 1024 * 1024 * 1024;
 }
 
-ArchiveFactory_SDMC::ArchiveFactory_SDMC(const std::string& sdmc_directory)
-    : sdmc_directory(sdmc_directory) {
+ArchiveFactory_SDMC::ArchiveFactory_SDMC(const std::string& sdmc_directory,
+                                         std::shared_ptr<WriteBackCache> write_back_cache)
+    : sdmc_directory(sdmc_directory), write_back_cache(std::move(write_back_cache)) {
 
     LOG_DEBUG(Service_FS, "Directory {} set as SDMC.", sdmc_directory);
 }
@@ -387,7 +404,8 @@ bool ArchiveFactory_SDMC::Initialize() {
 ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_SDMC::Open(const Path& path,
                                                                      u64 program_id) {
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SDMCDelayGenerator>();
-    auto archive = std::make_unique<SDMCArchive>(sdmc_directory, std::move(delay_generator));
+    auto archive = std::make_unique<SDMCArchive>(sdmc_directory, std::move(delay_generator),
+                                                 write_back_cache);
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
 
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,9 +18,9 @@ namespace FileSys {
 /// Archive backend for SDMC archive
 class SDMCArchive : public ArchiveBackend {
 public:
-    explicit SDMCArchive(const std::string& mount_point_,
-                         std::unique_ptr<DelayGenerator> delay_generator_)
-        : mount_point(mount_point_) {
+    SDMCArchive(const std::string& mount_point_, std::unique_ptr<DelayGenerator> delay_generator_,
+                std::shared_ptr<WriteBackCache> write_back_cache_)
+        : mount_point(mount_point_), write_back_cache(std::move(write_back_cache_)) {
         delay_generator = std::move(delay_generator_);
     }
 
@@ -42,12 +43,14 @@ public:
 protected:
     ResultVal<std::unique_ptr<FileBackend>> OpenFileBase(const Path& path, const Mode& mode) const;
     std::string mount_point;
+    std::shared_ptr<WriteBackCache> write_back_cache;
 };
 
 /// File system interface to the SDMC archive
 class ArchiveFactory_SDMC final : public ArchiveFactory {
 public:
-    explicit ArchiveFactory_SDMC(const std::string& mount_point);
+    ArchiveFactory_SDMC(const std::string& mount_point,
+                        std::shared_ptr<WriteBackCache> write_back_cache);
 
     /**
      * Initialize the archive.
@@ -66,6 +69,7 @@ public:
 
 private:
     std::string sdmc_directory;
+    std::shared_ptr<WriteBackCache> write_back_cache;
 };
 
 } // namespace FileSys
@@ -52,8 +52,9 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SDMCWriteOnlyArchive::OpenDirectory
     return ERROR_UNSUPPORTED_OPEN_FLAGS;
 }
 
-ArchiveFactory_SDMCWriteOnly::ArchiveFactory_SDMCWriteOnly(const std::string& mount_point)
-    : sdmc_directory(mount_point) {
+ArchiveFactory_SDMCWriteOnly::ArchiveFactory_SDMCWriteOnly(
+    const std::string& mount_point, std::shared_ptr<WriteBackCache> write_back_cache)
+    : sdmc_directory(mount_point), write_back_cache(std::move(write_back_cache)) {
     LOG_DEBUG(Service_FS, "Directory {} set as SDMCWriteOnly.", sdmc_directory);
 }
 
@@ -75,8 +76,8 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_SDMCWriteOnly::Open(co
                                                                               u64 program_id) {
     std::unique_ptr<DelayGenerator> delay_generator =
         std::make_unique<SDMCWriteOnlyDelayGenerator>();
-    auto archive =
-        std::make_unique<SDMCWriteOnlyArchive>(sdmc_directory, std::move(delay_generator));
+    auto archive = std::make_unique<SDMCWriteOnlyArchive>(
+        sdmc_directory, std::move(delay_generator), write_back_cache);
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
 
@@ -19,9 +19,10 @@ namespace FileSys {
  */
 class SDMCWriteOnlyArchive : public SDMCArchive {
 public:
-    explicit SDMCWriteOnlyArchive(const std::string& mount_point,
-                                  std::unique_ptr<DelayGenerator> delay_generator_)
-        : SDMCArchive(mount_point, std::move(delay_generator_)) {}
+    SDMCWriteOnlyArchive(const std::string& mount_point,
+                         std::unique_ptr<DelayGenerator> delay_generator_,
+                         std::shared_ptr<WriteBackCache> write_back_cache_)
+        : SDMCArchive(mount_point, std::move(delay_generator_), std::move(write_back_cache_)) {}
 
     std::string GetName() const override {
         return "SDMCWriteOnlyArchive: " + mount_point;
@@ -36,7 +37,8 @@ public:
 /// File system interface to the SDMC write-only archive
 class ArchiveFactory_SDMCWriteOnly final : public ArchiveFactory {
 public:
-    explicit ArchiveFactory_SDMCWriteOnly(const std::string& mount_point);
+    ArchiveFactory_SDMCWriteOnly(const std::string& mount_point,
+                                 std::shared_ptr<WriteBackCache> write_back_cache);
 
     /**
      * Initialize the archive.
@@ -55,6 +57,7 @@ public:
 
 private:
     std::string sdmc_directory;
+    std::shared_ptr<WriteBackCache> write_back_cache;
 };
 
 } // namespace FileSys
@@ -6,6 +6,7 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/savedata_archive.h"
 #include "core/hle/service/fs/archive.h"
@@ -35,8 +36,10 @@ std::string GetSaveDataMetadataPath(const std::string& mount_location, u64 progr
 
 } // namespace
 
-ArchiveSource_SDSaveData::ArchiveSource_SDSaveData(const std::string& sdmc_directory)
-    : mount_point(GetSaveDataContainerPath(sdmc_directory)) {
+ArchiveSource_SDSaveData::ArchiveSource_SDSaveData(
+    const std::string& sdmc_directory, std::shared_ptr<WriteBackCache> write_back_cache)
+    : mount_point(GetSaveDataContainerPath(sdmc_directory)),
+      write_back_cache(std::move(write_back_cache)) {
     LOG_DEBUG(Service_FS, "Directory {} set as SaveData.", mount_point);
 }
 
@@ -50,7 +53,8 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveSource_SDSaveData::Open(u64 pr
         return ERR_NOT_FORMATTED;
     }
 
-    auto archive = std::make_unique<SaveDataArchive>(std::move(concrete_mount_point));
+    auto archive =
+        std::make_unique<SaveDataArchive>(std::move(concrete_mount_point), write_back_cache);
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
 
@@ -58,6 +62,8 @@ ResultCode ArchiveSource_SDSaveData::Format(u64 program_id,
                                             const FileSys::ArchiveFormatInfo& format_info) {
     std::string concrete_mount_point = GetSaveDataPath(mount_point, program_id);
     FileUtil::DeleteDirRecursively(concrete_mount_point);
+    write_back_cache->DiscardPendingWrites(concrete_mount_point);
+    InvalidateDirectorySnapshots(concrete_mount_point);
     FileUtil::CreateFullPath(concrete_mount_point);
 
     // Write the format metadata
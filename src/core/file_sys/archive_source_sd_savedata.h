@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,7 +18,8 @@ namespace FileSys {
 /// A common source of SD save data archive
 class ArchiveSource_SDSaveData {
 public:
-    explicit ArchiveSource_SDSaveData(const std::string& mount_point);
+    ArchiveSource_SDSaveData(const std::string& mount_point,
+                             std::shared_ptr<WriteBackCache> write_back_cache);
 
     ResultVal<std::unique_ptr<ArchiveBackend>> Open(u64 program_id);
     ResultCode Format(u64 program_id, const FileSys::ArchiveFormatInfo& format_info);
@@ -27,6 +29,7 @@ public:
 
 private:
     std::string mount_point;
+    std::shared_ptr<WriteBackCache> write_back_cache;
 };
 
 } // namespace FileSys
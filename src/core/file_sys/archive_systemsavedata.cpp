@@ -10,6 +10,7 @@
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "core/file_sys/archive_systemsavedata.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/savedata_archive.h"
 #include "core/hle/service/fs/archive.h"
@@ -49,8 +50,10 @@ Path ConstructSystemSaveDataBinaryPath(u32 high, u32 low) {
     return {binary_path};
 }
 
-ArchiveFactory_SystemSaveData::ArchiveFactory_SystemSaveData(const std::string& nand_path)
-    : base_path(GetSystemSaveDataContainerPath(nand_path)) {}
+ArchiveFactory_SystemSaveData::ArchiveFactory_SystemSaveData(
+    const std::string& nand_path, std::shared_ptr<WriteBackCache> write_back_cache)
+    : base_path(GetSystemSaveDataContainerPath(nand_path)),
+      write_back_cache(std::move(write_back_cache)) {}
 
 ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_SystemSaveData::Open(const Path& path,
                                                                                u64 program_id) {
@@ -59,7 +62,7 @@ ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveFactory_SystemSaveData::Open(c
         // TODO(Subv): Check error code, this one is probably wrong
         return ERR_NOT_FORMATTED;
     }
-    auto archive = std::make_unique<SaveDataArchive>(fullpath);
+    auto archive = std::make_unique<SaveDataArchive>(fullpath, write_back_cache);
     return MakeResult<std::unique_ptr<ArchiveBackend>>(std::move(archive));
 }
 
@@ -68,6 +71,8 @@ ResultCode ArchiveFactory_SystemSaveData::Format(const Path& path,
                                                  u64 program_id) {
     std::string fullpath = GetSystemSaveDataPath(base_path, path);
     FileUtil::DeleteDirRecursively(fullpath);
+    write_back_cache->DiscardPendingWrites(fullpath);
+    InvalidateDirectorySnapshots(fullpath);
     FileUtil::CreateFullPath(fullpath);
     return RESULT_SUCCESS;
 }
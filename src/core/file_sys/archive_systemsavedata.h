@@ -8,6 +8,7 @@
 #include <string>
 #include "common/common_types.h"
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,7 +19,8 @@ namespace FileSys {
 /// File system interface to the SystemSaveData archive
 class ArchiveFactory_SystemSaveData final : public ArchiveFactory {
 public:
-    explicit ArchiveFactory_SystemSaveData(const std::string& mount_point);
+    ArchiveFactory_SystemSaveData(const std::string& mount_point,
+                                  std::shared_ptr<WriteBackCache> write_back_cache);
 
     ResultVal<std::unique_ptr<ArchiveBackend>> Open(const Path& path, u64 program_id) override;
     ResultCode Format(const Path& path, const FileSys::ArchiveFormatInfo& format_info,
@@ -31,6 +33,7 @@ public:
 
 private:
     std::string base_path;
+    std::shared_ptr<WriteBackCache> write_back_cache;
 };
 
 /**
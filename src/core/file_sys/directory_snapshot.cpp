@@ -0,0 +1,135 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/directory_snapshot.h"
+#include "core/file_sys/write_back_cache.h"
+
+namespace FileSys {
+
+namespace {
+
+/// Number of directories kept at once. Games only list a handful of directories repeatedly.
+constexpr std::size_t MAX_SNAPSHOTS = 32;
+
+std::mutex snapshot_mutex;
+std::unordered_map<std::string, std::shared_ptr<const DirectorySnapshot>> snapshots;
+
+/// Incremented by every invalidation, to tell whether one happened during a scan
+u64 generation = 0;
+
+/// Strips trailing separators, so that "dir/" and "dir" share a snapshot
+std::string NormalizePath(std::string path) {
+    while (path.size() > 1 && path.back() == DIR_SEP_CHR) {
+        path.pop_back();
+    }
+    return path;
+}
+
+Entry MakeEntry(const std::string& name, bool is_directory, u64 size) {
+    Entry entry{};
+
+    // TODO(Link Mauve): use a proper conversion to UTF-16.
+    for (std::size_t j = 0; j < FILENAME_LENGTH; ++j) {
+        entry.filename[j] = name[j];
+        if (!name[j])
+            break;
+    }
+
+    FileUtil::SplitFilename83(name, entry.short_name, entry.extension);
+
+    entry.is_directory = is_directory;
+    entry.is_hidden = (name[0] == '.');
+    entry.is_read_only = 0;
+    entry.file_size = size;
+
+    // We emulate a SD card where the archive bit has never been cleared, as it would be on
+    // most user SD cards.
+    // Some homebrews (blargSNES for instance) are known to mistakenly use the archive bit as a
+    // file bit.
+    entry.is_archive = !is_directory;
+    return entry;
+}
+
+std::shared_ptr<const DirectorySnapshot> ScanDirectory(const std::string& path,
+                                                       const WriteBackCache& write_back_cache) {
+    auto snapshot = std::make_shared<DirectorySnapshot>();
+    const auto callback = [&snapshot, &write_back_cache](const std::string& directory,
+                                                         const std::string& virtual_name,
+                                                         bool is_directory) {
+        u64 size = 0;
+        if (!is_directory) {
+            // Writes that haven't reached the host file yet can change its size
+            const std::string physical_name = directory + DIR_SEP + virtual_name;
+            const std::optional<u64> pending_size =
+                write_back_cache.GetPendingFileSize(physical_name);
+            size = pending_size ? *pending_size : FileUtil::GetSize(physical_name);
+        }
+        LOG_TRACE(Service_FS, "File {}: size={} dir={}", virtual_name, size, is_directory);
+        snapshot->push_back(MakeEntry(virtual_name, is_directory, size));
+        return true;
+    };
+    FileUtil::ForeachDirectoryEntryWithType(path, callback);
+    return snapshot;
+}
+
+} // Anonymous namespace
+
+std::shared_ptr<const DirectorySnapshot> GetDirectorySnapshot(
+    const std::string& path, const WriteBackCache& write_back_cache) {
+    std::string key = NormalizePath(path);
+    u64 scan_generation;
+    {
+        std::lock_guard lock(snapshot_mutex);
+        const auto itr = snapshots.find(key);
+        if (itr != snapshots.end()) {
+            return itr->second;
+        }
+        scan_generation = generation;
+    }
+
+    // Scan without the lock held, so that listing a large directory doesn't stall other ones.
+    // A snapshot that something was invalidated during is still returned, but not kept.
+    auto snapshot = ScanDirectory(key, write_back_cache);
+    std::lock_guard lock(snapshot_mutex);
+    if (generation != scan_generation) {
+        return snapshot;
+    }
+    if (snapshots.size() >= MAX_SNAPSHOTS) {
+        snapshots.clear();
+    }
+    snapshots.emplace(std::move(key), snapshot);
+    return snapshot;
+}
+
+void ClearDirectorySnapshots() {
+    std::lock_guard lock(snapshot_mutex);
+    ++generation;
+    snapshots.clear();
+}
+
+void InvalidateDirectorySnapshots(const std::string& path) {
+    const std::string key = NormalizePath(path);
+    const std::string parent = key.substr(0, key.find_last_of(DIR_SEP_CHR));
+    const std::string prefix = key + DIR_SEP;
+
+    std::lock_guard lock(snapshot_mutex);
+    ++generation;
+    for (auto itr = snapshots.begin(); itr != snapshots.end();) {
+        const std::string& snapshot_path = itr->first;
+        if (snapshot_path == key || snapshot_path == parent ||
+            snapshot_path.compare(0, prefix.size(), prefix) == 0) {
+            itr = snapshots.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+} // namespace FileSys
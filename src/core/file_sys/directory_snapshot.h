@@ -0,0 +1,37 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/file_sys/directory_backend.h"
+
+namespace FileSys {
+
+class WriteBackCache;
+
+/// The entries of a host directory, already converted to the format games read them in
+using DirectorySnapshot = std::vector<Entry>;
+
+/**
+ * Returns the entries of a host directory. The directory is only enumerated the first time, or
+ * after it was invalidated, and the same snapshot is shared by every handle opened meanwhile.
+ * A handle keeps the snapshot it was opened with, so later changes don't affect it.
+ * @param write_back_cache The cache holding the pending writes, which can change file sizes
+ */
+std::shared_ptr<const DirectorySnapshot> GetDirectorySnapshot(
+    const std::string& path, const WriteBackCache& write_back_cache);
+
+/**
+ * Drops the snapshots that a change to a host path makes stale: the one of its parent directory,
+ * and those of the path itself and anything under it, in case it is a directory.
+ */
+void InvalidateDirectorySnapshots(const std::string& path);
+
+/// Drops all snapshots, so that a new emulation session starts from the current host directories
+void ClearDirectorySnapshots();
+
+} // namespace FileSys
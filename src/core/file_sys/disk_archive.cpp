@@ -10,19 +10,34 @@
 #include "common/logging/log.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
 
 namespace FileSys {
 
+DiskFile::DiskFile(FileUtil::IOFile&& file_, const std::string& path, const Mode& mode_,
+                   std::unique_ptr<DelayGenerator> delay_generator_,
+                   std::shared_ptr<WriteBackCache> write_back_cache_)
+    : file(new FileUtil::IOFile(std::move(file_))),
+      write_back_cache(std::move(write_back_cache_)) {
+    delay_generator = std::move(delay_generator_);
+    mode.hex = mode_.hex;
+    overlay = write_back_cache->AcquireFileOverlay(path, file->GetSize(),
+                                                   Settings::values.keep_saves_in_memory);
+}
+
+DiskFile::~DiskFile() {
+    Close();
+}
+
 ResultVal<std::size_t> DiskFile::Read(const u64 offset, const std::size_t length,
                                       u8* buffer) const {
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    return MakeResult<std::size_t>(file->ReadBytes(buffer, length));
+    return MakeResult<std::size_t>(overlay->Read(*file, offset, length, buffer));
 }
 
 ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t length, const bool flush,
@@ -30,70 +45,50 @@ ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t lengt
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    std::size_t written = file->WriteBytes(buffer, length);
-    if (flush)
-        file->Flush();
-    return MakeResult<std::size_t>(written);
+    const u64 old_size = overlay->GetSize();
+    overlay->Write(offset, length, buffer);
+    if (overlay->GetSize() != old_size)
+        InvalidateDirectorySnapshots(overlay->GetPath());
+    if (flush || overlay->ShouldFlush())
+        write_back_cache->Flush(*overlay, *file);
+    return MakeResult<std::size_t>(length);
 }
 
 u64 DiskFile::GetSize() const {
-    return file->GetSize();
+    return overlay->GetSize();
 }
 
 bool DiskFile::SetSize(const u64 size) const {
-    file->Resize(size);
-    file->Flush();
+    if (overlay->GetSize() != size)
+        InvalidateDirectorySnapshots(overlay->GetPath());
+    overlay->Resize(size);
     return true;
 }
 
 bool DiskFile::Close() const {
+    if (overlay) {
+        Flush();
+        write_back_cache->ReleaseFileOverlay(overlay);
+    }
     return file->Close();
 }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-DiskDirectory::DiskDirectory(const std::string& path) {
-    unsigned size = FileUtil::ScanDirectoryTree(path, directory);
-    directory.size = size;
-    directory.isDirectory = true;
-    children_iterator = directory.children.begin();
+void DiskFile::Flush() const {
+    // Read-only handles can't write to the host file. Whoever made the writes flushes them.
+    if (mode.write_flag && overlay)
+        write_back_cache->Flush(*overlay, *file);
 }
 
-u32 DiskDirectory::Read(const u32 count, Entry* entries) {
-    u32 entries_read = 0;
-
-    while (entries_read < count && children_iterator != directory.children.cend()) {
-        const FileUtil::FSTEntry& file = *children_iterator;
-        const std::string& filename = file.virtualName;
-        Entry& entry = entries[entries_read];
-
-        LOG_TRACE(Service_FS, "File {}: size={} dir={}", filename, file.size, file.isDirectory);
-
-        // TODO(Link Mauve): use a proper conversion to UTF-16.
-        for (std::size_t j = 0; j < FILENAME_LENGTH; ++j) {
-            entry.filename[j] = filename[j];
-            if (!filename[j])
-                break;
-        }
-
-        FileUtil::SplitFilename83(filename, entry.short_name, entry.extension);
-
-        entry.is_directory = file.isDirectory;
-        entry.is_hidden = (filename[0] == '.');
-        entry.is_read_only = 0;
-        entry.file_size = file.size;
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        // We emulate a SD card where the archive bit has never been cleared, as it would be on
-        // most user SD cards.
-        // Some homebrews (blargSNES for instance) are known to mistakenly use the archive bit as a
-        // file bit.
-        entry.is_archive = !file.isDirectory;
+DiskDirectory::DiskDirectory(const std::string& path, const WriteBackCache& write_back_cache)
+    : snapshot(GetDirectorySnapshot(path, write_back_cache)) {}
 
-        ++entries_read;
-        ++children_iterator;
-    }
-    return entries_read;
+u32 DiskDirectory::Read(const u32 count, Entry* entries) {
+    const std::size_t entries_read = std::min<std::size_t>(count, snapshot->size() - position);
+    std::copy_n(snapshot->begin() + position, entries_read, entries);
+    position += entries_read;
+    return static_cast<u32>(entries_read);
 }
 
 } // namespace FileSys
@@ -12,7 +12,9 @@
 #include "common/file_util.h"
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20,14 +22,18 @@
 
 namespace FileSys {
 
+/**
+ * A file on the host file system. Writes and resizes are held back in a FileOverlay shared by all
+ * handles of the file, and reach the host file in batches when the file is flushed or closed, when
+ * a write asks for it, once enough of them are pending, or by the periodic flush of the
+ * WriteBackCache.
+ */
 class DiskFile : public FileBackend {
 public:
-    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
-             std::unique_ptr<DelayGenerator> delay_generator_)
-        : file(new FileUtil::IOFile(std::move(file_))) {
-        delay_generator = std::move(delay_generator_);
-        mode.hex = mode_.hex;
-    }
+    DiskFile(FileUtil::IOFile&& file_, const std::string& path, const Mode& mode_,
+             std::unique_ptr<DelayGenerator> delay_generator_,
+             std::shared_ptr<WriteBackCache> write_back_cache_);
+    ~DiskFile() override;
 
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
@@ -35,19 +41,24 @@ public:
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
-
-    void Flush() const override {
-        file->Flush();
-    }
+    void Flush() const override;
 
 protected:
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+    std::shared_ptr<WriteBackCache> write_back_cache;
+
+    /// Pending writes to the file, released when the file is closed
+    mutable std::shared_ptr<FileOverlay> overlay;
 };
 
+/**
+ * A directory on the host file system. Its entries are read from a snapshot shared by all handles
+ * of the directory, which the archive invalidates when it changes the directory.
+ */
 class DiskDirectory : public DirectoryBackend {
 public:
-    explicit DiskDirectory(const std::string& path);
+    DiskDirectory(const std::string& path, const WriteBackCache& write_back_cache);
 
     ~DiskDirectory() override {
         Close();
@@ -60,11 +71,11 @@ public:
     }
 
 protected:
-    FileUtil::FSTEntry directory{};
+    std::shared_ptr<const DirectorySnapshot> snapshot;
 
     // We need to remember the last entry we returned, so a subsequent call to Read will continue
-    // from the next one.  This iterator will always point to the next unread entry.
-    std::vector<FileUtil::FSTEntry>::iterator children_iterator;
+    // from the next one.  This is always the index of the next unread entry.
+    std::size_t position = 0;
 };
 
 } // namespace FileSys
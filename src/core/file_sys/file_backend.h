@@ -30,6 +30,17 @@ public:
      */
     virtual ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const = 0;
 
+    /**
+     * Get a pointer to the data of the file, for backends that keep it in host memory, so that it
+     * can be read without copying it into an intermediate buffer
+     * @param offset Offset in bytes of the data
+     * @param length Length in bytes of the data
+     * @return Pointer to the data, or nullptr if it has to be read with Read()
+     */
+    virtual const u8* GetDataPointer(u64 offset, std::size_t length) const {
+        return nullptr;
+    }
+
     /**
      * Write data to the file
      * @param offset Offset in bytes to start writing data to
@@ -2,11 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <future>
 #include <memory>
+#include <thread>
 #include <utility>
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/threadsafe_queue.h"
 #include "core/file_sys/ivfc_archive.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -88,16 +93,163 @@ u64 IVFCArchive::GetFreeBytes() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+/// Thread that reads ahead for all IVFC files, one read at a time, for the lifetime of the program
+class ReadAheadWorker {
+public:
+    ReadAheadWorker() : thread([this] { Run(); }) {}
+
+    ~ReadAheadWorker() {
+        tasks.Push(std::shared_ptr<Task>{});
+        thread.join();
+    }
+
+    /// Queues a read of a RomFS, and returns the future data read
+    std::future<std::vector<u8>> Queue(std::shared_ptr<RomFSReader> file, u64 offset,
+                                       std::size_t length) {
+        auto task = std::make_shared<Task>([file = std::move(file), offset, length] {
+            std::vector<u8> data(length);
+            data.resize(file->ReadFile(static_cast<std::size_t>(offset), length, data.data()));
+            return data;
+        });
+        auto future = task->get_future();
+        tasks.Push(task);
+        return future;
+    }
+
+private:
+    using Task = std::packaged_task<std::vector<u8>()>;
+
+    void Run() {
+        while (const auto task = tasks.PopWait()) {
+            (*task)();
+        }
+    }
+
+    Common::MPSCQueue<std::shared_ptr<Task>> tasks;
+    std::thread thread;
+};
+
+ReadAheadWorker& GetReadAheadWorker() {
+    static ReadAheadWorker worker;
+    return worker;
+}
+
+} // Anonymous namespace
+
+struct IVFCFile::ReadAhead {
+    /// Data that was read ahead, starting at buffer_offset
+    std::vector<u8> buffer;
+    u64 buffer_offset = 0;
+
+    /// Read ahead queued on the worker thread
+    std::future<std::vector<u8>> pending;
+    u64 pending_offset = 0;
+    std::size_t pending_length = 0;
+
+    /// Offset right after the previous read, and the number of reads that started there
+    u64 next_offset = 0;
+    u32 sequential_reads = 0;
+};
+
 IVFCFile::IVFCFile(std::shared_ptr<RomFSReader> file,
                    std::unique_ptr<DelayGenerator> delay_generator_)
-    : romfs_file(std::move(file)) {
+    : romfs_file(std::move(file)), read_ahead(std::make_unique<ReadAhead>()) {
     delay_generator = std::move(delay_generator_);
 }
 
+IVFCFile::~IVFCFile() = default;
+
 ResultVal<std::size_t> IVFCFile::Read(const u64 offset, const std::size_t length,
                                       u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset={}, length={}", offset, length);
-    return MakeResult<std::size_t>(romfs_file->ReadFile(offset, length, buffer));
+    const u64 size = romfs_file->GetSize();
+    // Mapped files are read ahead by the host when they are accessed sequentially.
+    if (romfs_file->IsMapped() || offset >= size) {
+        return MakeResult<std::size_t>(romfs_file->ReadFile(offset, length, buffer));
+    }
+
+    const std::size_t read_length = static_cast<std::size_t>(std::min<u64>(length, size - offset));
+    std::size_t total_read = ReadFromReadAhead(offset, read_length, buffer);
+    if (total_read < read_length) {
+        total_read += romfs_file->ReadFile(offset + total_read, read_length - total_read,
+                                           buffer + total_read);
+    }
+
+    UpdateReadAhead(offset, total_read);
+    return MakeResult<std::size_t>(total_read);
+}
+
+std::size_t IVFCFile::ReadFromReadAhead(u64 offset, std::size_t length, u8* buffer) const {
+    ReadAhead& state = *read_ahead;
+    std::size_t copied = 0;
+    while (copied < length) {
+        const u64 position = offset + copied;
+        const u64 buffer_end = state.buffer_offset + state.buffer.size();
+        if (position >= state.buffer_offset && position < buffer_end) {
+            const std::size_t chunk =
+                static_cast<std::size_t>(std::min<u64>(length - copied, buffer_end - position));
+            std::memcpy(buffer + copied, &state.buffer[position - state.buffer_offset], chunk);
+            copied += chunk;
+        } else if (state.pending.valid() && position >= state.pending_offset &&
+                   position < state.pending_offset + state.pending_length) {
+            // The read ahead for this data is still running, so wait for it.
+            state.buffer = state.pending.get();
+            state.buffer_offset = state.pending_offset;
+            if (position >= state.buffer_offset + state.buffer.size()) {
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+    return copied;
+}
+
+void IVFCFile::UpdateReadAhead(u64 offset, std::size_t length) const {
+    ReadAhead& state = *read_ahead;
+    state.sequential_reads = offset == state.next_offset ? state.sequential_reads + 1 : 0;
+    state.next_offset = offset + length;
+
+    if (state.pending.valid()) {
+        const bool is_ahead = state.next_offset >= state.pending_offset &&
+                              state.next_offset < state.pending_offset + state.pending_length;
+        const bool is_done =
+            state.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (is_ahead || !is_done) {
+            return;
+        }
+        // The file is no longer read where this was reading ahead.
+        state.pending = {};
+    }
+
+    if (state.sequential_reads < SEQUENTIAL_READS_THRESHOLD) {
+        return;
+    }
+
+    // Continue after the data that was already read ahead, once less than half of it is left.
+    const u64 size = romfs_file->GetSize();
+    const u64 buffer_end = state.buffer_offset + state.buffer.size();
+    const bool is_buffered =
+        state.next_offset >= state.buffer_offset && state.next_offset < buffer_end;
+    const u64 start = is_buffered ? buffer_end : state.next_offset;
+    if (start >= size || start - state.next_offset >= READ_AHEAD_SIZE / 2) {
+        return;
+    }
+
+    const std::size_t read_length =
+        static_cast<std::size_t>(std::min<u64>(READ_AHEAD_SIZE, size - start));
+    state.pending_offset = start;
+    state.pending_length = read_length;
+    state.pending = GetReadAheadWorker().Queue(romfs_file, start, read_length);
+}
+
+const u8* IVFCFile::GetDataPointer(u64 offset, std::size_t length) const {
+    if (offset > romfs_file->GetSize()) {
+        return nullptr;
+    }
+    return romfs_file->GetDataPointer(static_cast<std::size_t>(offset), length);
 }
 
 ResultVal<std::size_t> IVFCFile::Write(const u64 offset, const std::size_t length, const bool flush,
@@ -133,6 +285,13 @@ ResultVal<std::size_t> IVFCFileInMemory::Read(const u64 offset, const std::size_
     return MakeResult<std::size_t>(read_length);
 }
 
+const u8* IVFCFileInMemory::GetDataPointer(u64 offset, std::size_t length) const {
+    if (offset > data_size || length > data_size - offset) {
+        return nullptr;
+    }
+    return romfs_file.data() + data_offset + offset;
+}
+
 ResultVal<std::size_t> IVFCFileInMemory::Write(const u64 offset, const std::size_t length,
                                                const bool flush, const u8* buffer) {
     LOG_ERROR(Service_FS, "Attempted to write to IVFC file");
@@ -112,11 +112,18 @@ protected:
     std::shared_ptr<RomFSReader> romfs_file;
 };
 
+/**
+ * A file of an IVFC archive. When a file is read sequentially, it reads ahead on a worker thread
+ * shared by all IVFC files, so that the disk access for the next read overlaps with the delay the
+ * guest is charged for the current one.
+ */
 class IVFCFile : public FileBackend {
 public:
     IVFCFile(std::shared_ptr<RomFSReader> file, std::unique_ptr<DelayGenerator> delay_generator_);
+    ~IVFCFile() override;
 
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
+    const u8* GetDataPointer(u64 offset, std::size_t length) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
@@ -127,7 +134,21 @@ public:
     void Flush() const override {}
 
 private:
+    /// Amount of data read ahead at a time
+    static constexpr std::size_t READ_AHEAD_SIZE = 0x40000;
+    /// Number of back-to-back reads after which a file is considered to be read sequentially
+    static constexpr u32 SEQUENTIAL_READS_THRESHOLD = 2;
+
+    struct ReadAhead;
+
+    /// Copies the part of a read that was already read ahead, and returns its length
+    std::size_t ReadFromReadAhead(u64 offset, std::size_t length, u8* buffer) const;
+
+    /// Tracks sequential reads, and starts reading ahead of them
+    void UpdateReadAhead(u64 offset, std::size_t length) const;
+
     std::shared_ptr<RomFSReader> romfs_file;
+    std::unique_ptr<ReadAhead> read_ahead;
 };
 
 class IVFCDirectory : public DirectoryBackend {
@@ -146,6 +167,7 @@ public:
                      std::unique_ptr<DelayGenerator> delay_generator_);
 
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
+    const u8* GetDataPointer(u64 offset, std::size_t length) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
@@ -2,9 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
@@ -13,6 +17,7 @@
 #include "core/core.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/seed_db.h"
+#include "core/file_sys/title_image_cache.h"
 #include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
 
@@ -24,6 +29,13 @@ namespace FileSys {
 static const int kMaxSections = 8;   ///< Maximum number of sections (files) in an ExeFs
 static const int kBlockSize = 0x200; ///< Size of ExeFS blocks (in bytes)
 
+/// Amount of an ExeFS section read and decrypted at a time
+static constexpr std::size_t EXEFS_CHUNK_SIZE = 0x100000;
+
+/// Serializes the key derivation of NCCHs loaded on different threads, as it goes through the
+/// global AES key slots
+static std::mutex key_slot_mutex;
+
 /**
  * Attempts to patch a buffer using an IPS
  * @param ips Vector of the patches to apply
@@ -71,18 +83,6 @@ static void ApplyIPS(std::vector<u8>& ips, std::vector<u8>& buffer) {
     }
 }
 
-/**
- * Get the decompressed size of an LZSS compressed ExeFS file
- * @param buffer Buffer of compressed file
- * @param size Size of compressed buffer
- * @return Size of decompressed buffer
- */
-static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
-    u32 offset_size;
-    std::memcpy(&offset_size, buffer + size - sizeof(u32), sizeof(u32));
-    return offset_size + size;
-}
-
 /**
  * Decompress ExeFS file (compressed with LZSS)
  * @param compressed Compressed buffer
@@ -102,8 +102,12 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
     u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
     u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
 
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
+    // The format is made to be decompressed in place, with the compressed data at the start of the
+    // output buffer: the output always stays ahead of the input as both move towards the start
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
+    if (decompressed != compressed) {
+        std::memcpy(decompressed, compressed, compressed_size);
+    }
 
     while (index > stop_index) {
         u8 control = compressed[--index];
@@ -151,6 +155,53 @@ static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decom
     return true;
 }
 
+/**
+ * Reads an ExeFS section or the logo region into a buffer, decrypting it one chunk at a time, and
+ * checks it against its SHA-256 hash. Each chunk is hashed on another thread while the next one is
+ * read, so checking the hash adds next to nothing to the load time.
+ * @param file File positioned at the start of the data
+ * @param decryption Decryptor positioned at the start of the data, or nullptr if it isn't encrypted
+ * @param expected_hash Hash of the decrypted data
+ * @return ResultStatus::Error if the data couldn't be read, ResultStatus::ErrorInvalidFormat if it
+ *         doesn't match its hash
+ */
+static Loader::ResultStatus ReadVerifiedSection(
+    FileUtil::IOFile& file, u8* buffer, std::size_t size,
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption* decryption, const u8* expected_hash,
+    const char* name) {
+    CryptoPP::SHA256 sha;
+    std::future<void> hashing;
+    for (std::size_t offset = 0; offset < size; offset += EXEFS_CHUNK_SIZE) {
+        u8* const chunk = buffer + offset;
+        const std::size_t chunk_size = std::min(EXEFS_CHUNK_SIZE, size - offset);
+        const bool read = file.ReadBytes(chunk, chunk_size) == chunk_size;
+        if (read && decryption) {
+            decryption->ProcessData(chunk, chunk, chunk_size);
+        }
+
+        if (hashing.valid()) {
+            hashing.wait();
+        }
+        if (!read) {
+            return Loader::ResultStatus::Error;
+        }
+        if (offset + chunk_size < size) {
+            hashing = std::async(std::launch::async,
+                                 [&sha, chunk, chunk_size] { sha.Update(chunk, chunk_size); });
+        } else {
+            sha.Update(chunk, chunk_size);
+        }
+    }
+
+    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+    sha.Final(hash.data());
+    if (std::memcmp(hash.data(), expected_hash, hash.size()) != 0) {
+        LOG_ERROR(Service_FS, "Hash mismatch in {}, the dump is corrupted", name);
+        return Loader::ResultStatus::ErrorInvalidFormat;
+    }
+    return Loader::ResultStatus::Success;
+}
+
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
     : ncch_offset(ncch_offset), filepath(filepath) {
     file = FileUtil::IOFile(filepath, "rb");
@@ -206,6 +257,7 @@ Loader::ResultStatus NCCHContainer::Load() {
                 secondary_key.fill(0);
             } else {
                 using namespace HW::AES;
+                std::lock_guard lock(key_slot_mutex);
                 InitKeys();
                 std::array<u8, 16> key_y_primary, key_y_secondary;
 
@@ -461,11 +513,8 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             buffer.resize(logo_size);
             file.Seek(ncch_offset + logo_offset, SEEK_SET);
 
-            if (file.ReadBytes(buffer.data(), logo_size) != logo_size) {
-                LOG_ERROR(Service_FS, "Could not read NCCH logo");
-                return Loader::ResultStatus::Error;
-            }
-            return Loader::ResultStatus::Success;
+            return ReadVerifiedSection(file, buffer.data(), logo_size, nullptr,
+                                       ncch_header.logo_region_hash, "logo");
         } else {
             LOG_INFO(Service_FS, "Attempting to load logo from the ExeFS");
         }
@@ -499,38 +548,72 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
                                                               exefs_ctr.data());
             dec.Seek(section.offset + sizeof(ExeFs_Header));
+            auto* const decryption = is_encrypted ? &dec : nullptr;
+            const u8(&expected_hash)[0x20] = exefs_header.hashes[kMaxSections - 1 - section_number];
+
+            // Code is only worth sharing when other instances would have to decrypt or
+            // decompress it, and before patches, which are applied per instance below
+            const bool is_code = strcmp(section.name, ".code") == 0;
+            std::string image_path;
+            if (is_code && (is_encrypted || is_compressed) && IsTitleImageCacheEnabled())
+                image_path = GetTitleImagePath(ncch_header.program_id, "code", expected_hash);
+
+            if (!image_path.empty() && ReadTitleImage(image_path, buffer)) {
+                LOG_DEBUG(Service_FS, "Loaded .code from {}", image_path);
+                image_path.clear();
+            } else if (is_code && is_compressed) {
+                if (section.size < 8)
+                    return Loader::ResultStatus::ErrorInvalidFormat;
+
+                // The decompressed size is in the footer, so decrypt that first to size the buffer
+                // once, then decompress in place instead of going through a second buffer
+                std::array<u8, 4> footer;
+                exefs_file.Seek(section_offset + section.size - footer.size(), SEEK_SET);
+                if (exefs_file.ReadBytes(footer.data(), footer.size()) != footer.size())
+                    return Loader::ResultStatus::Error;
+                if (is_encrypted) {
+                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption footer_dec(
+                        key.data(), key.size(), exefs_ctr.data());
+                    footer_dec.Seek(section.offset + sizeof(ExeFs_Header) + section.size -
+                                    footer.size());
+                    footer_dec.ProcessData(footer.data(), footer.data(), footer.size());
+                }
+                // The last word of the footer is how much larger the decompressed data is
+                u32 additional_size;
+                std::memcpy(&additional_size, footer.data(), sizeof(u32));
+                if (additional_size > std::numeric_limits<u32>::max() - section.size)
+                    return Loader::ResultStatus::ErrorInvalidFormat;
+                const u32 decompressed_size = section.size + additional_size;
 
-            if (strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
-                std::unique_ptr<u8[]> temp_buffer;
                 try {
-                    temp_buffer.reset(new u8[section.size]);
+                    buffer.resize(decompressed_size);
                 } catch (std::bad_alloc&) {
                     return Loader::ResultStatus::ErrorMemoryAllocationFailed;
                 }
 
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-
-                if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
-                }
+                exefs_file.Seek(section_offset, SEEK_SET);
+                const auto read_result =
+                    ReadVerifiedSection(exefs_file, buffer.data(), section.size, decryption,
+                                        expected_hash, section.name);
+                if (read_result != Loader::ResultStatus::Success)
+                    return read_result;
 
-                // Decompress .code section...
-                u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
-                buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
+                if (!LZSS_Decompress(buffer.data(), section.size, buffer.data(), decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
-                if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-                if (is_encrypted) {
-                    dec.ProcessData(&buffer[0], &buffer[0], section.size);
-                }
+                const auto read_result =
+                    ReadVerifiedSection(exefs_file, buffer.data(), section.size, decryption,
+                                        expected_hash, section.name);
+                if (read_result != Loader::ResultStatus::Success)
+                    return read_result;
             }
 
+            // Only data that matched its hash gets here, as the image is found by the hash
+            if (!image_path.empty())
+                StoreTitleImage(image_path, buffer);
+
             std::string override_ips = filepath + ".exefsdir/code.ips";
 
             if (FileUtil::Exists(override_ips) && strcmp(name, ".code") == 0) {
@@ -608,6 +691,10 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     if (file.GetSize() < romfs_offset + romfs_size)
         return Loader::ResultStatus::Error;
 
+    if (is_encrypted && IsTitleImageCacheEnabled() &&
+        ReadRomFSImage(romfs_offset, romfs_size, romfs_file) == Loader::ResultStatus::Success)
+        return Loader::ResultStatus::Success;
+
     // We reopen the file, to allow its position to be independent from file's
     FileUtil::IOFile romfs_file_inner(filepath, "rb");
     if (!romfs_file_inner.IsOpen())
@@ -624,6 +711,57 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     return Loader::ResultStatus::Success;
 }
 
+Loader::ResultStatus NCCHContainer::ReadRomFSImage(u32 romfs_offset, u32 romfs_size,
+                                                   std::shared_ptr<RomFSReader>& romfs_file) {
+    const std::string image_path =
+        GetTitleImagePath(ncch_header.program_id, "romfs", ncch_header.romfs_super_block_hash);
+
+    if (!FileUtil::Exists(image_path)) {
+        // The RomFS is decrypted once for every instance, so do it all up front
+        RomFSReader encrypted_romfs(FileUtil::IOFile(filepath, "rb"), romfs_offset, romfs_size,
+                                    secondary_key, romfs_ctr, 0x1000);
+
+        // The image is found by the superblock hash, so a RomFS that doesn't match it must not be
+        // stored, or other instances would load it in place of the right one
+        const u64 hash_region_size =
+            static_cast<u64>(ncch_header.romfs_hash_region_size) * kBlockSize;
+        if (hash_region_size > romfs_size)
+            return Loader::ResultStatus::ErrorInvalidFormat;
+        CryptoPP::SHA256 sha;
+        std::vector<u8> chunk(
+            static_cast<std::size_t>(std::min<u64>(hash_region_size, EXEFS_CHUNK_SIZE)));
+        for (u64 offset = 0; offset < hash_region_size; offset += chunk.size()) {
+            const auto length =
+                static_cast<std::size_t>(std::min<u64>(chunk.size(), hash_region_size - offset));
+            if (encrypted_romfs.ReadFile(offset, length, chunk.data()) != length)
+                return Loader::ResultStatus::Error;
+            sha.Update(chunk.data(), length);
+        }
+        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+        sha.Final(hash.data());
+        if (std::memcmp(hash.data(), ncch_header.romfs_super_block_hash, hash.size()) != 0) {
+            LOG_ERROR(Service_FS, "Hash mismatch in the RomFS superblock, not storing {}",
+                      image_path);
+            return Loader::ResultStatus::ErrorInvalidFormat;
+        }
+
+        const auto source = [&encrypted_romfs](u64 offset, std::size_t length, u8* buffer) {
+            return encrypted_romfs.ReadFile(offset, length, buffer) == length;
+        };
+        if (!StoreTitleImage(image_path, romfs_size, source))
+            return Loader::ResultStatus::Error;
+    }
+
+    FileUtil::IOFile image_file(image_path, "rb");
+    if (!image_file.IsOpen() || image_file.GetSize() != romfs_size) {
+        LOG_ERROR(Service_FS, "Title image {} doesn't match the RomFS", image_path);
+        return Loader::ResultStatus::Error;
+    }
+    LOG_DEBUG(Service_FS, "Reading RomFS from {}", image_path);
+    romfs_file = std::make_shared<RomFSReader>(std::move(image_file), 0, romfs_size);
+    return Loader::ResultStatus::Success;
+}
+
 Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<RomFSReader>& romfs_file) {
     // Check for RomFS overrides
     std::string split_filepath = filepath + ".romfs";
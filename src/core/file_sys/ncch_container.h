@@ -294,6 +294,14 @@ public:
     ExHeader_Header exheader_header;
 
 private:
+    /**
+     * Gets the RomFS from the shared title image cache, decrypting it into the cache first if no
+     * instance has done so yet
+     * @return ResultStatus result of function
+     */
+    Loader::ResultStatus ReadRomFSImage(u32 romfs_offset, u32 romfs_size,
+                                        std::shared_ptr<RomFSReader>& romfs_file);
+
     bool has_header = false;
     bool has_exheader = false;
     bool has_exefs = false;
@@ -1,22 +1,155 @@
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include "common/logging/log.h"
 #include "core/file_sys/romfs_reader.h"
 
 namespace FileSys {
 
+struct RomFSReader::Cipher {
+    // Crypto++ picks AES-NI or the ARMv8 crypto extensions at runtime when the host has them.
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption decryption;
+};
+
+RomFSReader::RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
+    : is_encrypted(false), file(std::move(file)), file_offset(file_offset), data_size(data_size) {
+    if (data_size <= MAX_MAPPED_SIZE) {
+        use_mapping = mapping.Map(this->file, file_offset, data_size);
+        if (!use_mapping) {
+            LOG_DEBUG(Service_FS, "Could not map the RomFS, falling back to file reads");
+        }
+    }
+}
+
+RomFSReader::RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
+                         const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
+                         std::size_t crypto_offset)
+    : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
+      crypto_offset(crypto_offset), data_size(data_size), cipher(std::make_unique<Cipher>()) {
+    cipher->decryption.SetKeyWithIV(key.data(), key.size(), ctr.data());
+}
+
+RomFSReader::~RomFSReader() {
+    if (cache_stats.hits + cache_stats.misses != 0) {
+        LOG_DEBUG(Service_FS, "RomFS block cache: {} hits, {} misses", cache_stats.hits,
+                  cache_stats.misses);
+    }
+}
+
 std::size_t RomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
-    if (length == 0)
+    if (length == 0 || offset >= data_size)
         return 0; // Crypto++ does not like zero size buffer
-    file.Seek(file_offset + offset, SEEK_SET);
-    std::size_t read_length = std::min(length, data_size - offset);
-    read_length = file.ReadBytes(buffer, read_length);
+    const std::size_t read_length = std::min(length, data_size - offset);
+    if (CheckMapping()) {
+        std::memcpy(buffer, mapping.GetPointer() + offset, read_length);
+        return read_length;
+    }
     if (is_encrypted) {
-        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
-        d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+        return ReadEncrypted(offset, read_length, buffer);
     }
+    return file.ReadBytesAt(buffer, read_length, file_offset + offset);
+}
+
+std::size_t RomFSReader::ReadEncrypted(std::size_t offset, std::size_t length, u8* buffer) {
+    std::lock_guard lock{cache_mutex};
+
+    std::size_t total_read = 0;
+    while (total_read < length) {
+        const std::size_t position = offset + total_read;
+        const std::size_t index = position / BLOCK_SIZE;
+        const std::size_t block_offset = position % BLOCK_SIZE;
+        const std::size_t chunk = std::min(BLOCK_SIZE - block_offset, length - total_read);
+
+        std::size_t chunk_read;
+        if (chunk == BLOCK_SIZE && cached_block_map.count(index) == 0) {
+            // Whole blocks are only needed once by large reads, so they are decrypted in place
+            // instead of pushing the blocks of small reads out of the cache.
+            chunk_read = DecryptRange(position, chunk, buffer + total_read);
+        } else {
+            const CachedBlock* block = GetBlock(index);
+            const std::size_t available =
+                block->data.size() > block_offset ? block->data.size() - block_offset : 0;
+            chunk_read = std::min(chunk, available);
+            std::memcpy(buffer + total_read, block->data.data() + block_offset, chunk_read);
+        }
+
+        total_read += chunk_read;
+        if (chunk_read != chunk) {
+            break;
+        }
+    }
+    return total_read;
+}
+
+std::size_t RomFSReader::DecryptRange(std::size_t offset, std::size_t length, u8* buffer) {
+    const std::size_t read_length = file.ReadBytesAt(buffer, length, file_offset + offset);
+    if (read_length == 0)
+        return 0;
+    cipher->decryption.Seek(crypto_offset + offset);
+    cipher->decryption.ProcessData(buffer, buffer, read_length);
     return read_length;
 }
 
+const RomFSReader::CachedBlock* RomFSReader::GetBlock(std::size_t index) {
+    const auto itr = cached_block_map.find(index);
+    if (itr != cached_block_map.end()) {
+        ++cache_stats.hits;
+        cached_blocks.splice(cached_blocks.begin(), cached_blocks, itr->second);
+        return &*itr->second;
+    }
+
+    ++cache_stats.misses;
+    if (cached_blocks.size() < MAX_CACHED_BLOCKS) {
+        cached_blocks.emplace_front();
+    } else {
+        // Reuse the least recently used block along with its buffer
+        cached_block_map.erase(cached_blocks.back().index);
+        cached_blocks.splice(cached_blocks.begin(), cached_blocks, std::prev(cached_blocks.end()));
+    }
+
+    CachedBlock& block = cached_blocks.front();
+    block.index = index;
+    const std::size_t block_start = index * BLOCK_SIZE;
+    const std::size_t block_size = std::min(BLOCK_SIZE, data_size - block_start);
+    block.data.resize(block_size);
+    block.data.resize(DecryptRange(block_start, block_size, block.data.data()));
+    if (block.data.size() == block_size) {
+        cached_block_map.emplace(index, cached_blocks.begin());
+        return &block;
+    }
+
+    // Blocks that could only be read partially, e.g. from a truncated file, are not cached, so
+    // that the next read tries again instead of getting the short block.
+    short_block = std::move(block);
+    cached_blocks.pop_front();
+    return &short_block;
+}
+
+const u8* RomFSReader::GetDataPointer(std::size_t offset, std::size_t length) const {
+    if (offset > data_size || length > data_size - offset || !CheckMapping()) {
+        return nullptr;
+    }
+    return mapping.GetPointer() + offset;
+}
+
+bool RomFSReader::CheckMapping() const {
+    if (!use_mapping.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (mapping.IsInBounds(file)) {
+        return true;
+    }
+    if (use_mapping.exchange(false)) {
+        LOG_ERROR(Service_FS, "The RomFS file was truncated, reading it from the file instead");
+    }
+    return false;
+}
+
+RomFSReader::CacheStats RomFSReader::GetCacheStats() const {
+    std::lock_guard lock{cache_mutex};
+    return cache_stats;
+}
+
 } // namespace FileSys
@@ -1,22 +1,41 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 
 namespace FileSys {
 
+/**
+ * Reads the RomFS of a title from a file. Unencrypted RomFS are mapped into memory when possible,
+ * so that reads are served without system calls and can be accessed without copying them. Other
+ * reads use positional reads, which lets several threads read from the same RomFS at once.
+ *
+ * Encrypted RomFS are decrypted in blocks, through a cipher whose key schedule is only computed
+ * once, and the most recently used blocks are kept decrypted so that small reads of the same data
+ * don't decrypt it again.
+ */
 class RomFSReader {
 public:
-    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
-        : is_encrypted(false), file(std::move(file)), file_offset(file_offset),
-          data_size(data_size) {}
+    /// Hit rate counters of the decrypted block cache
+    struct CacheStats {
+        u64 hits = 0;
+        u64 misses = 0;
+    };
+
+    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size);
 
     RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                 const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
-          crypto_offset(crypto_offset), data_size(data_size) {}
+                std::size_t crypto_offset);
+
+    ~RomFSReader();
 
     std::size_t GetSize() const {
         return data_size;
@@ -24,14 +43,73 @@ public:
 
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer);
 
+    /**
+     * Gets a pointer to part of the RomFS, without copying it. IVFCFile uses it to let the FS
+     * service copy file reads straight into guest memory.
+     * @returns A pointer that is valid for the lifetime of the reader, or nullptr if the RomFS
+     *          isn't mapped into memory and has to be read with ReadFile().
+     */
+    const u8* GetDataPointer(std::size_t offset, std::size_t length) const;
+
+    /// Whether the RomFS is mapped into memory, in which case reads don't wait for the disk
+    bool IsMapped() const {
+        return use_mapping.load(std::memory_order_relaxed);
+    }
+
+    CacheStats GetCacheStats() const;
+
 private:
+    /// Size of the blocks encrypted RomFS are decrypted and cached in
+    static constexpr std::size_t BLOCK_SIZE = 0x10000;
+    /// Number of decrypted blocks kept in the cache
+    static constexpr std::size_t MAX_CACHED_BLOCKS = 64;
+
+    struct CachedBlock {
+        std::size_t index;
+        std::vector<u8> data;
+    };
+
+    /// Reads and decrypts part of an encrypted RomFS
+    std::size_t ReadEncrypted(std::size_t offset, std::size_t length, u8* buffer);
+
+    /// Reads and decrypts a range that lies within a single block. Must be called with the cache
+    /// mutex held.
+    std::size_t DecryptRange(std::size_t offset, std::size_t length, u8* buffer);
+
+    /// Gets a decrypted block from the cache, decrypting it if needed. The block is valid until the
+    /// next call. Must be called with the cache mutex held.
+    const CachedBlock* GetBlock(std::size_t index);
+
+    /// Checks that reads can be served from the mapping, and stops using it if the file was
+    /// truncated below the mapped range
+    bool CheckMapping() const;
+
+    struct Cipher;
+
+    /// RomFS larger than this are not mapped, so that they don't exhaust the address space of
+    /// 32-bit hosts.
+    static constexpr u64 MAX_MAPPED_SIZE = sizeof(void*) >= 8 ? 0x100000000ULL : 0x10000000ULL;
+
     bool is_encrypted;
     FileUtil::IOFile file;
+    FileUtil::FileMapping mapping;
+    /// Whether reads are served from the mapping rather than with positional reads
+    mutable std::atomic<bool> use_mapping{false};
     std::array<u8, 16> key;
     std::array<u8, 16> ctr;
     std::size_t file_offset;
     std::size_t crypto_offset;
     std::size_t data_size;
+
+    std::unique_ptr<Cipher> cipher;
+
+    mutable std::mutex cache_mutex;
+    /// Cached blocks, most recently used first
+    std::list<CachedBlock> cached_blocks;
+    std::unordered_map<std::size_t, std::list<CachedBlock>::iterator> cached_block_map;
+    /// Last block that could not be read completely, which is not cached
+    CachedBlock short_block;
+    CacheStats cache_stats;
 };
 
 } // namespace FileSys
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/file_util.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/path_parser.h"
@@ -77,6 +78,7 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
         } else {
             // Create the file
             FileUtil::CreateEmptyFile(full_path);
+            InvalidateDirectorySnapshots(full_path);
         }
         break;
     case PathParser::FileFound:
@@ -90,7 +92,8 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
     }
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SaveDataDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<DiskFile>(std::move(file), full_path, mode,
+                                                std::move(delay_generator), write_back_cache);
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -121,6 +124,8 @@ ResultCode SaveDataArchive::DeleteFile(const Path& path) const {
     }
 
     if (FileUtil::Delete(full_path)) {
+        write_back_cache->DiscardPendingWrites(full_path);
+        InvalidateDirectorySnapshots(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -148,6 +153,9 @@ ResultCode SaveDataArchive::RenameFile(const Path& src_path, const Path& dest_pa
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        write_back_cache->RenamePendingWrites(src_path_full, dest_path_full);
+        InvalidateDirectorySnapshots(src_path_full);
+        InvalidateDirectorySnapshots(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -159,7 +167,7 @@ ResultCode SaveDataArchive::RenameFile(const Path& src_path, const Path& dest_pa
 
 template <typename T>
 static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mount_point,
-                                        T deleter) {
+                                        WriteBackCache& write_back_cache, T deleter) {
     const PathParser path_parser(path);
 
     if (!path_parser.IsValid()) {
@@ -189,6 +197,8 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
     }
 
     if (deleter(full_path)) {
+        write_back_cache.DiscardPendingWrites(full_path);
+        InvalidateDirectorySnapshots(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -197,12 +207,13 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
 }
 
 ResultCode SaveDataArchive::DeleteDirectory(const Path& path) const {
-    return DeleteDirectoryHelper(path, mount_point, FileUtil::DeleteDir);
+    return DeleteDirectoryHelper(path, mount_point, *write_back_cache, FileUtil::DeleteDir);
 }
 
 ResultCode SaveDataArchive::DeleteDirectoryRecursively(const Path& path) const {
-    return DeleteDirectoryHelper(
-        path, mount_point, [](const std::string& p) { return FileUtil::DeleteDirRecursively(p); });
+    return DeleteDirectoryHelper(path, mount_point, *write_back_cache, [](const std::string& p) {
+        return FileUtil::DeleteDirRecursively(p);
+    });
 }
 
 ResultCode SaveDataArchive::CreateFile(const FileSys::Path& path, u64 size) const {
@@ -233,6 +244,7 @@ ResultCode SaveDataArchive::CreateFile(const FileSys::Path& path, u64 size) cons
         break; // Expected 'success' case
     }
 
+    InvalidateDirectorySnapshots(full_path);
     if (size == 0) {
         FileUtil::CreateEmptyFile(full_path);
         return RESULT_SUCCESS;
@@ -279,6 +291,7 @@ ResultCode SaveDataArchive::CreateDirectory(const Path& path) const {
     }
 
     if (FileUtil::CreateDir(mount_point + path.AsString())) {
+        InvalidateDirectorySnapshots(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -307,6 +320,9 @@ ResultCode SaveDataArchive::RenameDirectory(const Path& src_path, const Path& de
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        write_back_cache->RenamePendingWrites(src_path_full, dest_path_full);
+        InvalidateDirectorySnapshots(src_path_full);
+        InvalidateDirectorySnapshots(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -343,7 +359,7 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SaveDataArchive::OpenDirectory(
         break; // Expected 'success' case
     }
 
-    auto directory = std::make_unique<DiskDirectory>(full_path);
+    auto directory = std::make_unique<DiskDirectory>(full_path, *write_back_cache);
     return MakeResult<std::unique_ptr<DirectoryBackend>>(std::move(directory));
 }
 
@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,7 +20,9 @@ namespace FileSys {
 /// Archive backend for general save data archive type (SaveData and SystemSaveData)
 class SaveDataArchive : public ArchiveBackend {
 public:
-    explicit SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
+    SaveDataArchive(const std::string& mount_point_,
+                    std::shared_ptr<WriteBackCache> write_back_cache_)
+        : mount_point(mount_point_), write_back_cache(std::move(write_back_cache_)) {}
 
     std::string GetName() const override {
         return "SaveDataArchive: " + mount_point;
@@ -38,6 +42,7 @@ public:
 
 protected:
     std::string mount_point;
+    std::shared_ptr<WriteBackCache> write_back_cache;
 };
 
 } // namespace FileSys
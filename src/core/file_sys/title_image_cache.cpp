@@ -0,0 +1,94 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/title_image_cache.h"
+#include "core/settings.h"
+
+namespace FileSys {
+
+namespace {
+
+/// Amount of an image read from its source and written at a time
+constexpr std::size_t STORE_CHUNK_SIZE = 0x100000;
+
+/// Returns a temporary path next to an image, unique to this writer
+std::string GetTemporaryPath(const std::string& path) {
+    std::random_device device;
+    return fmt::format("{}.{:08x}{:08x}.tmp", path, device(), device());
+}
+
+} // Anonymous namespace
+
+bool IsTitleImageCacheEnabled() {
+    return Settings::values.use_shared_title_cache;
+}
+
+std::string GetTitleImagePath(u64 program_id, const std::string& name, const u8 (&hash)[0x20]) {
+    std::string hash_string;
+    for (const u8 byte : hash) {
+        hash_string += fmt::format("{:02x}", byte);
+    }
+    return fmt::format("{}title_images" DIR_SEP "{:016X}" DIR_SEP "{}_{}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), program_id, name,
+                       hash_string);
+}
+
+bool StoreTitleImage(const std::string& path, u64 size, const TitleImageSource& source) {
+    if (FileUtil::Exists(path)) {
+        return true;
+    }
+    if (!FileUtil::CreateFullPath(path)) {
+        return false;
+    }
+
+    const std::string temp_path = GetTemporaryPath(path);
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        std::vector<u8> chunk(static_cast<std::size_t>(std::min<u64>(size, STORE_CHUNK_SIZE)));
+        bool success = file.IsOpen();
+        for (u64 offset = 0; success && offset < size; offset += chunk.size()) {
+            const auto length =
+                static_cast<std::size_t>(std::min<u64>(chunk.size(), size - offset));
+            success = source(offset, length, chunk.data()) &&
+                      file.WriteBytes(chunk.data(), length) == length;
+        }
+        if (!success || !file.Close()) {
+            LOG_ERROR(Service_FS, "Could not store title image {}", path);
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+
+    // Another instance may have stored the same image meanwhile, in which case either copy will do
+    if (!FileUtil::Rename(temp_path, path)) {
+        FileUtil::Delete(temp_path);
+        return FileUtil::Exists(path);
+    }
+    LOG_INFO(Service_FS, "Stored title image {}", path);
+    return true;
+}
+
+bool StoreTitleImage(const std::string& path, const std::vector<u8>& data) {
+    return StoreTitleImage(path, data.size(), [&data](u64 offset, std::size_t length, u8* buffer) {
+        std::copy_n(data.begin() + offset, length, buffer);
+        return true;
+    });
+}
+
+bool ReadTitleImage(const std::string& path, std::vector<u8>& buffer) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+    buffer.resize(file.GetSize());
+    return file.ReadBytes(buffer.data(), buffer.size()) == buffer.size();
+}
+
+} // namespace FileSys
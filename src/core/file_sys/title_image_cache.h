@@ -0,0 +1,51 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace FileSys {
+
+/**
+ * Decrypted and decompressed parts of titles, kept as plain files in the cache directory so that
+ * emulator instances running the same title share a single copy. The first instance to load a
+ * part stores it. The others read or map the stored image instead of decrypting the title again,
+ * and mapped images share their pages through the host's page cache.
+ *
+ * Images are addressed by program ID and by the SHA-256 of their content as recorded in the NCCH,
+ * so an image is never used for content other than the one it was made from. They are written
+ * to a temporary file and renamed into place, so instances never see a partial image.
+ */
+
+/// Whether title images are shared through the cache directory
+bool IsTitleImageCacheEnabled();
+
+/**
+ * Returns the path of a title image.
+ * @param name Name of the part of the title the image holds
+ * @param hash SHA-256 of the part, as recorded in the NCCH
+ */
+std::string GetTitleImagePath(u64 program_id, const std::string& name, const u8 (&hash)[0x20]);
+
+/// Reads part of the content of an image being stored. Returns false on failure.
+using TitleImageSource = std::function<bool(u64 offset, std::size_t length, u8* buffer)>;
+
+/**
+ * Stores an image, reading its content piece by piece. Does nothing if the image already exists.
+ * @returns true if the image exists afterwards
+ */
+bool StoreTitleImage(const std::string& path, u64 size, const TitleImageSource& source);
+
+/// Stores an image held in memory
+bool StoreTitleImage(const std::string& path, const std::vector<u8>& data);
+
+/// Reads a whole image into a buffer. Returns false if the image doesn't exist.
+bool ReadTitleImage(const std::string& path, std::vector<u8>& buffer);
+
+} // namespace FileSys
@@ -0,0 +1,497 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <fmt/format.h>
+#include "common/cityhash.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "core/core_timing.h"
+#include "core/file_sys/write_back_cache.h"
+
+namespace FileSys {
+
+namespace {
+
+/// Amount of pending data after which an overlay is flushed right away
+constexpr std::size_t WRITE_BACK_LIMIT = 0x100000;
+
+/// Interval of the periodic flush, in milliseconds of emulated time
+constexpr int FLUSH_INTERVAL_MS = 1000;
+
+constexpr u32 JOURNAL_MAGIC = 0x4C4E4A43;  // "CJNL"
+constexpr u32 JOURNAL_COMMIT = 0x54494D43; // "CMIT"
+constexpr u32 JOURNAL_VERSION = 1;
+constexpr u32 MAX_JOURNAL_PATH_LENGTH = 0x1000;
+
+struct JournalHeader {
+    u32_le magic;
+    u32_le version;
+    u64_le host_size;
+    u64_le size;
+    u32_le path_length;
+    u32_le num_extents;
+};
+static_assert(sizeof(JournalHeader) == 32, "JournalHeader has incorrect size");
+
+struct JournalExtent {
+    u64_le offset;
+    u64_le length;
+};
+static_assert(sizeof(JournalExtent) == 16, "JournalExtent has incorrect size");
+
+using Extents = std::map<u64, std::vector<u8>>;
+
+/// A batch of writes, as it was journaled
+struct Batch {
+    std::string path;
+    u64 host_size;
+    u64 size;
+    Extents extents;
+};
+
+/// Collapses repeated separators, so that paths built in different ways compare equal
+std::string NormalizePath(const std::string& path) {
+    std::string normalized;
+    normalized.reserve(path.size());
+    for (const char c : path) {
+        if (c == '/' && !normalized.empty() && normalized.back() == '/') {
+            continue;
+        }
+        normalized += c;
+    }
+    if (normalized.size() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+bool IsInDirectory(const std::string& path, const std::string& directory) {
+    return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 &&
+           path[directory.size()] == '/';
+}
+
+/// Applies a batch of writes to a host file
+bool ApplyBatch(FileUtil::IOFile& file, u64 host_size, u64 size, const Extents& extents) {
+    if (file.GetSize() > host_size && !file.Resize(host_size)) {
+        return false;
+    }
+    for (const auto& [offset, data] : extents) {
+        if (!file.Seek(static_cast<s64>(offset), SEEK_SET) ||
+            file.WriteBytes(data.data(), data.size()) != data.size()) {
+            return false;
+        }
+    }
+    if (!file.Flush()) {
+        return false;
+    }
+    if (file.GetSize() < size && !file.Resize(size)) {
+        return false;
+    }
+    return file.Flush();
+}
+
+bool WriteJournal(const std::string& journal_path, const std::string& path, u64 host_size,
+                  u64 size, const Extents& extents) {
+    FileUtil::IOFile journal(journal_path, "wb");
+    if (!journal.IsOpen()) {
+        return false;
+    }
+
+    JournalHeader header{};
+    header.magic = JOURNAL_MAGIC;
+    header.version = JOURNAL_VERSION;
+    header.host_size = host_size;
+    header.size = size;
+    header.path_length = static_cast<u32>(path.size());
+    header.num_extents = static_cast<u32>(extents.size());
+    bool success = journal.WriteObject(header) == 1 &&
+                   journal.WriteBytes(path.data(), path.size()) == path.size();
+    for (const auto& [offset, data] : extents) {
+        JournalExtent extent{};
+        extent.offset = offset;
+        extent.length = data.size();
+        success = success && journal.WriteObject(extent) == 1 &&
+                  journal.WriteBytes(data.data(), data.size()) == data.size();
+    }
+
+    // The commit marker is only written once the rest of the batch is on disk, so that a journal
+    // cut short by a crash is recognized as incomplete and ignored
+    success = success && journal.Flush();
+    const u32_le commit = JOURNAL_COMMIT;
+    return success && journal.WriteObject(commit) == 1 && journal.Flush();
+}
+
+/**
+ * Reads a batch back from its journal.
+ * @returns The batch, or nothing if the journal is invalid or was cut short before it was
+ *          committed, in which case the batch wasn't applied to the file at all
+ */
+std::optional<Batch> ReadJournal(const std::string& journal_path) {
+    FileUtil::IOFile journal(journal_path, "rb");
+    JournalHeader header{};
+    if (journal.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION ||
+        header.path_length > MAX_JOURNAL_PATH_LENGTH) {
+        return {};
+    }
+
+    Batch batch{std::string(header.path_length, '\0'), header.host_size, header.size, {}};
+    if (journal.ReadBytes(batch.path.data(), batch.path.size()) != batch.path.size()) {
+        return {};
+    }
+    for (u32 i = 0; i < header.num_extents; ++i) {
+        JournalExtent extent{};
+        if (journal.ReadBytes(&extent, sizeof(extent)) != sizeof(extent) ||
+            extent.offset + extent.length > header.size) {
+            return {};
+        }
+        std::vector<u8> data(static_cast<std::size_t>(extent.length));
+        if (journal.ReadBytes(data.data(), data.size()) != data.size()) {
+            return {};
+        }
+        batch.extents.emplace(extent.offset, std::move(data));
+    }
+    u32_le commit = 0;
+    if (journal.ReadBytes(&commit, sizeof(commit)) != sizeof(commit) || commit != JOURNAL_COMMIT) {
+        return {};
+    }
+    return batch;
+}
+
+/// Applies a batch left behind by an interrupted flush
+void ReplayBatch(const Batch& batch) {
+    FileUtil::IOFile file(batch.path, "r+b");
+    if (!file.IsOpen() || !ApplyBatch(file, batch.host_size, batch.size, batch.extents)) {
+        LOG_ERROR(Service_FS, "Failed to replay the journal of {}", batch.path);
+        return;
+    }
+    LOG_INFO(Service_FS, "Replayed {} pending writes to {}", batch.extents.size(), batch.path);
+}
+
+} // Anonymous namespace
+
+FileOverlay::FileOverlay(std::string path, u64 host_size, bool in_memory)
+    : path(std::move(path)), in_memory(in_memory), host_size(host_size), size(host_size) {}
+
+std::size_t FileOverlay::Read(const FileUtil::IOFile& file, u64 offset, std::size_t length,
+                              u8* buffer) const {
+    if (offset >= size) {
+        return 0;
+    }
+    length = static_cast<std::size_t>(std::min<u64>(length, size - offset));
+
+    std::size_t read = 0;
+    if (offset < host_size) {
+        const u64 host_length = std::min<u64>(length, host_size - offset);
+        read = file.ReadBytesAt(buffer, static_cast<std::size_t>(host_length), offset);
+    }
+    // Data past the valid part of the host file was either truncated or never written
+    std::fill(buffer + read, buffer + length, 0);
+
+    const u64 end = offset + length;
+    auto itr = extents.upper_bound(offset);
+    if (itr != extents.begin()) {
+        --itr;
+    }
+    for (; itr != extents.end() && itr->first < end; ++itr) {
+        const u64 extent_end = itr->first + itr->second.size();
+        const u64 copy_start = std::max(itr->first, offset);
+        const u64 copy_end = std::min(extent_end, end);
+        if (copy_start < copy_end) {
+            std::memcpy(buffer + (copy_start - offset),
+                        itr->second.data() + (copy_start - itr->first),
+                        static_cast<std::size_t>(copy_end - copy_start));
+        }
+    }
+    return length;
+}
+
+void FileOverlay::Write(u64 offset, std::size_t length, const u8* data) {
+    if (length == 0) {
+        return;
+    }
+    dirty = true;
+
+    // Find the extents the write overlaps or touches, which it gets merged with
+    const u64 end = offset + length;
+    auto first = extents.upper_bound(offset);
+    if (first != extents.begin()) {
+        const auto previous = std::prev(first);
+        if (previous->first + previous->second.size() >= offset) {
+            first = previous;
+        }
+    }
+    auto last = first;
+    u64 merged_end = end;
+    while (last != extents.end() && last->first <= end) {
+        merged_end = std::max<u64>(merged_end, last->first + last->second.size());
+        ++last;
+    }
+
+    if (first == last) {
+        extents.emplace(offset, std::vector<u8>(data, data + length));
+        pending_bytes += length;
+    } else if (first->first <= offset) {
+        // Grow the first extent in place, which keeps sequential writes from being copied over
+        // and over
+        std::vector<u8>& merged = first->second;
+        const u64 merged_start = first->first;
+        pending_bytes -= merged.size();
+        merged.resize(static_cast<std::size_t>(merged_end - merged_start));
+        for (auto itr = std::next(first); itr != last; ++itr) {
+            std::memcpy(merged.data() + (itr->first - merged_start), itr->second.data(),
+                        itr->second.size());
+            pending_bytes -= itr->second.size();
+        }
+        std::memcpy(merged.data() + (offset - merged_start), data, length);
+        pending_bytes += merged.size();
+        extents.erase(std::next(first), last);
+    } else {
+        std::vector<u8> merged(static_cast<std::size_t>(merged_end - offset));
+        for (auto itr = first; itr != last; ++itr) {
+            std::memcpy(merged.data() + (itr->first - offset), itr->second.data(),
+                        itr->second.size());
+            pending_bytes -= itr->second.size();
+        }
+        std::memcpy(merged.data(), data, length);
+        pending_bytes += merged.size();
+        extents.erase(first, last);
+        extents.emplace(offset, std::move(merged));
+    }
+
+    size = std::max(size, end);
+}
+
+void FileOverlay::Resize(u64 new_size) {
+    if (new_size == size) {
+        return;
+    }
+    dirty = true;
+
+    if (new_size < size) {
+        host_size = std::min(host_size, new_size);
+
+        auto itr = extents.lower_bound(new_size);
+        for (auto erased = itr; erased != extents.end(); ++erased) {
+            pending_bytes -= erased->second.size();
+        }
+        extents.erase(itr, extents.end());
+
+        if (!extents.empty()) {
+            auto& [offset, data] = *extents.rbegin();
+            if (offset + data.size() > new_size) {
+                pending_bytes -= static_cast<std::size_t>(offset + data.size() - new_size);
+                data.resize(static_cast<std::size_t>(new_size - offset));
+            }
+        }
+    }
+    size = new_size;
+}
+
+bool FileOverlay::ShouldFlush() const {
+    return !in_memory && pending_bytes >= WRITE_BACK_LIMIT;
+}
+
+bool FileOverlay::Flush(FileUtil::IOFile& file, const std::string& journal_path) {
+    if (!dirty || in_memory) {
+        return true;
+    }
+
+    const bool journaled = FileUtil::CreateFullPath(journal_path) &&
+                           WriteJournal(journal_path, path, host_size, size, extents);
+    if (!journaled) {
+        LOG_WARNING(Service_FS, "Could not write a journal, flushing {} without one", path);
+    }
+
+    if (!ApplyBatch(file, host_size, size, extents)) {
+        // The journal is kept, so that the file gets the whole batch once it is opened again
+        LOG_ERROR(Service_FS, "Failed to write {} pending bytes to {}", pending_bytes, path);
+        return false;
+    }
+    if (journaled) {
+        FileUtil::Delete(journal_path);
+    }
+
+    extents.clear();
+    pending_bytes = 0;
+    host_size = size;
+    dirty = false;
+    return true;
+}
+
+WriteBackCache::WriteBackCache(Core::Timing* timing)
+    : WriteBackCache(FileUtil::GetUserPath(FileUtil::UserPath::UserDir) + "journal" DIR_SEP,
+                     timing) {}
+
+WriteBackCache::WriteBackCache(std::string journal_directory, Core::Timing* timing)
+    : journal_directory(std::move(journal_directory)), timing(timing) {
+    if (!timing) {
+        return;
+    }
+    flush_event = timing->RegisterEvent(
+        "FileSys::WriteBackCache::Flush",
+        [this](u64 userdata, s64 cycles_late) { PeriodicFlush(cycles_late); });
+    timing->ScheduleEvent(msToCycles(FLUSH_INTERVAL_MS), flush_event);
+}
+
+WriteBackCache::~WriteBackCache() {
+    FlushAll();
+}
+
+std::shared_ptr<FileOverlay> WriteBackCache::AcquireFileOverlay(const std::string& path,
+                                                                u64 host_size, bool in_memory) {
+    std::string key = NormalizePath(path);
+    std::lock_guard lock(mutex);
+    auto& overlay = overlays[key];
+    if (overlay) {
+        return overlay;
+    }
+
+    // A journal of this file means that the last run stopped while it was flushing the file
+    const std::string journal_path = GetJournalPath(key);
+    if (FileUtil::Exists(journal_path)) {
+        const std::optional<Batch> batch = ReadJournal(journal_path);
+        if (!batch) {
+            LOG_WARNING(Service_FS, "Discarding incomplete journal for {}", key);
+        }
+        // Journals of other files can only end up here through a hash collision
+        if (!batch || batch->path == key) {
+            if (batch) {
+                ReplayBatch(*batch);
+                host_size = FileUtil::GetSize(key);
+            }
+            FileUtil::Delete(journal_path);
+        }
+    }
+
+    overlay = std::make_shared<FileOverlay>(std::move(key), host_size, in_memory);
+    return overlay;
+}
+
+void WriteBackCache::ReleaseFileOverlay(std::shared_ptr<FileOverlay>& overlay) {
+    if (!overlay) {
+        return;
+    }
+
+    std::lock_guard lock(mutex);
+    const auto itr = overlays.find(overlay->GetPath());
+    // In-memory overlays have to outlive their handles, as the host file never gets their data
+    if (itr != overlays.end() && itr->second == overlay && !overlay->IsInMemory() &&
+        overlay.use_count() == 2) {
+        overlays.erase(itr);
+    }
+    overlay.reset();
+}
+
+bool WriteBackCache::Flush(FileOverlay& overlay, FileUtil::IOFile& file) const {
+    return overlay.Flush(file, GetJournalPath(overlay.GetPath()));
+}
+
+void WriteBackCache::FlushAll() {
+    std::lock_guard lock(mutex);
+    for (const auto& [path, overlay] : overlays) {
+        if (!overlay->IsDirty() || overlay->IsInMemory()) {
+            continue;
+        }
+        FileUtil::IOFile file(path, "r+b");
+        if (!file.IsOpen()) {
+            LOG_ERROR(Service_FS, "Could not open {} to flush it", path);
+            continue;
+        }
+        Flush(*overlay, file);
+    }
+}
+
+void WriteBackCache::PeriodicFlush(s64 cycles_late) {
+    FlushAll();
+    timing->ScheduleEvent(msToCycles(FLUSH_INTERVAL_MS) - cycles_late, flush_event);
+}
+
+std::optional<u64> WriteBackCache::GetPendingFileSize(const std::string& path) const {
+    std::lock_guard lock(mutex);
+    const auto itr = overlays.find(NormalizePath(path));
+    if (itr == overlays.end()) {
+        return {};
+    }
+    return itr->second->GetSize();
+}
+
+void WriteBackCache::DiscardPendingWrites(const std::string& path) {
+    const std::string key = NormalizePath(path);
+    std::lock_guard lock(mutex);
+    for (auto itr = overlays.begin(); itr != overlays.end();) {
+        if (itr->first == key || IsInDirectory(itr->first, key)) {
+            itr = overlays.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+
+    // Journals left behind for the deleted files must not be replayed onto new files
+    for (const std::string& journal_path : ListJournals()) {
+        const std::optional<Batch> batch = ReadJournal(journal_path);
+        if (batch && (batch->path == key || IsInDirectory(batch->path, key))) {
+            FileUtil::Delete(journal_path);
+        }
+    }
+}
+
+void WriteBackCache::RenamePendingWrites(const std::string& src_path,
+                                         const std::string& dest_path) {
+    const std::string src_key = NormalizePath(src_path);
+    const std::string dest_key = NormalizePath(dest_path);
+    std::lock_guard lock(mutex);
+    std::vector<std::shared_ptr<FileOverlay>> renamed;
+    for (auto itr = overlays.begin(); itr != overlays.end();) {
+        if (itr->first == src_key || IsInDirectory(itr->first, src_key)) {
+            renamed.push_back(std::move(itr->second));
+            itr = overlays.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+    for (auto& overlay : renamed) {
+        overlay->SetPath(dest_key + overlay->GetPath().substr(src_key.size()));
+        overlays[overlay->GetPath()] = std::move(overlay);
+    }
+
+    // Journals left behind for the renamed files are replayed onto them where they are now
+    for (const std::string& journal_path : ListJournals()) {
+        std::optional<Batch> batch = ReadJournal(journal_path);
+        if (batch && (batch->path == src_key || IsInDirectory(batch->path, src_key))) {
+            batch->path = dest_key + batch->path.substr(src_key.size());
+            ReplayBatch(*batch);
+            FileUtil::Delete(journal_path);
+        }
+    }
+}
+
+std::string WriteBackCache::GetJournalPath(const std::string& path) const {
+    return journal_directory +
+           fmt::format("{:016X}.journal", Common::CityHash64(path.data(), path.size()));
+}
+
+std::vector<std::string> WriteBackCache::ListJournals() const {
+    std::vector<std::string> journals;
+    if (!FileUtil::Exists(journal_directory)) {
+        return journals;
+    }
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, journal_directory,
+        [&journals](u64*, const std::string& parent, const std::string& virtual_name) {
+            if (virtual_name.size() > 8 &&
+                virtual_name.compare(virtual_name.size() - 8, 8, ".journal") == 0) {
+                journals.push_back(parent + DIR_SEP + virtual_name);
+            }
+            return true;
+        });
+    return journals;
+}
+
+} // namespace FileSys
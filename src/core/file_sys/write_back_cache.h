@@ -0,0 +1,180 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+class Timing;
+struct TimingEventType;
+} // namespace Core
+
+namespace FileUtil {
+class IOFile;
+}
+
+namespace FileSys {
+
+/**
+ * Writes to a host file that haven't been applied to it yet, shared by all open handles of that
+ * file so that they see each other's writes.
+ *
+ * Writes are coalesced into non-overlapping extents. Flushing applies all of them as one batch:
+ * the batch is first written to a journal, which is replayed the next time the file is opened if
+ * the emulator stops while the batch is being applied, so a save file never ends up with half of
+ * a batch.
+ *
+ * An in-memory overlay is never flushed, and keeps its writes until the emulated system shuts down.
+ */
+class FileOverlay {
+public:
+    FileOverlay(std::string path, u64 host_size, bool in_memory);
+
+    const std::string& GetPath() const {
+        return path;
+    }
+
+    void SetPath(std::string new_path) {
+        path = std::move(new_path);
+    }
+
+    bool IsInMemory() const {
+        return in_memory;
+    }
+
+    /// Whether there are writes or resizes that haven't been applied to the host file
+    bool IsDirty() const {
+        return dirty;
+    }
+
+    /// Returns the size of the file, including the pending writes and resizes
+    u64 GetSize() const {
+        return size;
+    }
+
+    /// Returns the number of bytes held in the pending extents
+    std::size_t GetPendingBytes() const {
+        return pending_bytes;
+    }
+
+    /// Returns the number of pending extents
+    std::size_t GetNumExtents() const {
+        return extents.size();
+    }
+
+    /**
+     * Reads from the file, taking the pending writes into account.
+     * @param file Any open handle of the host file
+     * @returns The number of bytes read, which is only short at the end of the file
+     */
+    std::size_t Read(const FileUtil::IOFile& file, u64 offset, std::size_t length,
+                     u8* buffer) const;
+
+    void Write(u64 offset, std::size_t length, const u8* data);
+
+    void Resize(u64 new_size);
+
+    /// Whether enough data is pending to flush it without waiting for the periodic flush
+    bool ShouldFlush() const;
+
+    /**
+     * Applies the pending writes to the host file. Does nothing for in-memory overlays. If the
+     * batch can't be applied, its journal is kept so that it is replayed later.
+     * @param file A handle of the host file opened for writing
+     * @param journal_path Path the batch is journaled to while it is applied
+     * @returns true on success
+     */
+    bool Flush(FileUtil::IOFile& file, const std::string& journal_path);
+
+private:
+    std::string path;
+    bool in_memory;
+
+    /// Pending writes by offset. Extents never overlap or touch each other.
+    std::map<u64, std::vector<u8>> extents;
+    std::size_t pending_bytes = 0;
+
+    /// Size of the prefix of the host file that is still valid after pending truncations
+    u64 host_size;
+    u64 size;
+
+    bool dirty = false;
+};
+
+/**
+ * The overlays of the host files opened by an emulated system. Pending writes are applied to the
+ * host files when a file is flushed or closed, and at the latest a second of emulated time after
+ * they were made. Journals left behind by an earlier run are only replayed when the file they
+ * belong to is opened again, so that the journals of another instance sharing the journal
+ * directory are left alone.
+ */
+class WriteBackCache {
+public:
+    /**
+     * Creates a cache that keeps its journals in the journal directory of the user directory.
+     * @param timing The timing the periodic flush is scheduled on, which must not advance once the
+     *               cache is destroyed, or nullptr to only flush files when asked to
+     */
+    explicit WriteBackCache(Core::Timing* timing);
+
+    WriteBackCache(std::string journal_directory, Core::Timing* timing);
+
+    ~WriteBackCache();
+
+    /**
+     * Returns the overlay of a host file, creating it if no handle of the file is open. A journal
+     * left behind for the file is replayed first.
+     * @param host_size Current size of the host file
+     * @param in_memory Whether a newly created overlay keeps its writes in memory
+     */
+    std::shared_ptr<FileOverlay> AcquireFileOverlay(const std::string& path, u64 host_size,
+                                                    bool in_memory);
+
+    /// Releases a handle's reference to an overlay, forgetting it once no handle uses it anymore
+    void ReleaseFileOverlay(std::shared_ptr<FileOverlay>& overlay);
+
+    /// Applies the pending writes of an overlay to its host file
+    bool Flush(FileOverlay& overlay, FileUtil::IOFile& file) const;
+
+    /// Applies the pending writes of every file
+    void FlushAll();
+
+    /// Returns the size of a file with pending writes, which differs from the host file's
+    std::optional<u64> GetPendingFileSize(const std::string& path) const;
+
+    /// Drops the pending writes of a deleted file, or of all files in a deleted directory
+    void DiscardPendingWrites(const std::string& path);
+
+    /// Moves the pending writes of a renamed file, or of all files in a renamed directory
+    void RenamePendingWrites(const std::string& src_path, const std::string& dest_path);
+
+private:
+    /// Flushes every file, and schedules the next periodic flush
+    void PeriodicFlush(s64 cycles_late);
+
+    std::string GetJournalPath(const std::string& path) const;
+
+    /// Returns the paths of the journals in the journal directory
+    std::vector<std::string> ListJournals() const;
+
+    std::string journal_directory;
+    Core::Timing* timing;
+    Core::TimingEventType* flush_event = nullptr;
+
+    mutable std::mutex mutex;
+    /// Overlays of the files that have open handles or, for in-memory overlays, pending writes
+    std::unordered_map<std::string, std::shared_ptr<FileOverlay>> overlays;
+};
+
+} // namespace FileSys
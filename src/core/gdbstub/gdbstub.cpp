@@ -12,7 +12,9 @@
 #include <cstdio>
 #include <cstring>
 #include <map>
+#include <memory>
 #include <numeric>
+#include <vector>
 #include <fcntl.h>
 #include <fmt/format.h>
 
@@ -159,8 +161,19 @@ BreakpointMap breakpoints_read;
 BreakpointMap breakpoints_write;
 } // Anonymous namespace
 
+/// Gets the threads scheduled on all emulated cores
+static std::vector<std::shared_ptr<Kernel::Thread>> GetThreadList() {
+    auto& kernel = Core::System::GetInstance().Kernel();
+    std::vector<std::shared_ptr<Kernel::Thread>> threads;
+    for (u32 core_id = 0; core_id < kernel.GetNumCores(); ++core_id) {
+        const auto& core_threads = kernel.GetThreadManager(core_id).GetThreadList();
+        threads.insert(threads.end(), core_threads.begin(), core_threads.end());
+    }
+    return threads;
+}
+
 static Kernel::Thread* FindThreadById(int id) {
-    const auto& threads = Core::System::GetInstance().Kernel().GetThreadManager().GetThreadList();
+    const auto threads = GetThreadList();
     for (auto& thread : threads) {
         if (thread->GetThreadId() == static_cast<u32>(id)) {
             return thread.get();
@@ -414,7 +427,7 @@ static void RemoveBreakpoint(BreakpointType type, VAddr addr) {
         Core::System::GetInstance().Memory().WriteBlock(
             *Core::System::GetInstance().Kernel().GetCurrentProcess(), bp->second.addr,
             bp->second.inst.data(), bp->second.inst.size());
-        Core::CPU().ClearInstructionCache();
+        Core::System::GetInstance().ClearInstructionCache();
     }
     p.erase(addr);
 }
@@ -540,8 +553,7 @@ static void HandleQuery() {
         SendReply(target_xml);
     } else if (strncmp(query, "fThreadInfo", strlen("fThreadInfo")) == 0) {
         std::string val = "m";
-        const auto& threads =
-            Core::System::GetInstance().Kernel().GetThreadManager().GetThreadList();
+        const auto threads = GetThreadList();
         for (const auto& thread : threads) {
             val += fmt::format("{:x},", thread->GetThreadId());
         }
@@ -553,8 +565,7 @@ static void HandleQuery() {
         std::string buffer;
         buffer += "l<?xml version=\"1.0\"?>";
         buffer += "<threads>";
-        const auto& threads =
-            Core::System::GetInstance().Kernel().GetThreadManager().GetThreadList();
+        const auto threads = GetThreadList();
         for (const auto& thread : threads) {
             buffer += fmt::format(R"*(<thread id="{:x}" name="Thread {:x}"></thread>)*",
                                   thread->GetThreadId(), thread->GetThreadId());
@@ -869,7 +880,7 @@ static void WriteMemory() {
     GdbHexToMem(data.data(), len_pos + 1, len);
     Core::System::GetInstance().Memory().WriteBlock(
         *Core::System::GetInstance().Kernel().GetCurrentProcess(), addr, data.data(), len);
-    Core::CPU().ClearInstructionCache();
+    Core::System::GetInstance().ClearInstructionCache();
     SendReply("OK");
 }
 
@@ -888,7 +899,7 @@ static void Step() {
     step_loop = true;
     halt_loop = true;
     send_trap = true;
-    Core::CPU().ClearInstructionCache();
+    Core::System::GetInstance().ClearInstructionCache();
 }
 
 bool IsMemoryBreak() {
@@ -904,7 +915,7 @@ static void Continue() {
     memory_break = false;
     step_loop = false;
     halt_loop = false;
-    Core::CPU().ClearInstructionCache();
+    Core::System::GetInstance().ClearInstructionCache();
 }
 
 /**
@@ -930,7 +941,7 @@ static bool CommitBreakpoint(BreakpointType type, VAddr addr, u32 len) {
         Core::System::GetInstance().Memory().WriteBlock(
             *Core::System::GetInstance().Kernel().GetCurrentProcess(), addr, btrap.data(),
             btrap.size());
-        Core::CPU().ClearInstructionCache();
+        Core::System::GetInstance().ClearInstructionCache();
     }
     p.insert({addr, breakpoint});
 
@@ -76,17 +76,18 @@ std::shared_ptr<AddressArbiter> KernelSystem::CreateAddressArbiter(std::string n
     return address_arbiter;
 }
 
-ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, ArbitrationType type,
-                                            VAddr address, s32 value, u64 nanoseconds) {
-
-    auto timeout_callback = [this](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
-                                   std::shared_ptr<WaitObject> object) {
+std::function<Thread::WakeupCallback> AddressArbiter::MakeTimeoutCallback() {
+    return [this](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
+                  std::shared_ptr<WaitObject> object) {
         ASSERT(reason == ThreadWakeupReason::Timeout);
         // Remove the newly-awakened thread from the Arbiter's waiting list.
         waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
                               waiting_threads.end());
     };
+}
 
+ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, ArbitrationType type,
+                                            VAddr address, s32 value, u64 nanoseconds) {
     switch (type) {
 
     // Signal thread(s) waiting for arbitrate address...
@@ -109,7 +110,8 @@ ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, Arbi
         break;
     case ArbitrationType::WaitIfLessThanWithTimeout:
         if ((s32)kernel.memory.Read32(address) < value) {
-            thread->wakeup_callback = timeout_callback;
+            thread->wakeup_callback = MakeTimeoutCallback();
+            thread->wakeup_callback_kind = WakeupCallbackKind::ArbitrateAddress;
             thread->WakeAfterDelay(nanoseconds);
             WaitThread(std::move(thread), address);
         }
@@ -128,7 +130,8 @@ ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, Arbi
         if (memory_value < value) {
             // Only change the memory value if the thread should wait
             kernel.memory.Write32(address, (s32)memory_value - 1);
-            thread->wakeup_callback = timeout_callback;
+            thread->wakeup_callback = MakeTimeoutCallback();
+            thread->wakeup_callback_kind = WakeupCallbackKind::ArbitrateAddress;
             thread->WakeAfterDelay(nanoseconds);
             WaitThread(std::move(thread), address);
         }
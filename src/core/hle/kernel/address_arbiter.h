@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 
 // Address arbiters are an underlying kernel synchronization object that can be created/used via
@@ -20,8 +22,6 @@
 
 namespace Kernel {
 
-class Thread;
-
 enum class ArbitrationType : u32 {
     Signal,
     WaitIfLessThan,
@@ -65,8 +65,13 @@ private:
     /// the resumed thread.
     std::shared_ptr<Thread> ResumeHighestPriorityThread(VAddr address);
 
+    /// Gets the callback that takes a thread whose wait timed out off the waiting list
+    std::function<Thread::WakeupCallback> MakeTimeoutCallback();
+
     /// Threads waiting for the address arbiter to be signaled.
     std::vector<std::shared_ptr<Thread>> waiting_threads;
+
+    friend class KernelSystem;
 };
 
 } // namespace Kernel
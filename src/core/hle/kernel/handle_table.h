@@ -87,9 +87,38 @@ public:
         return DynamicObjectCast<T>(GetGeneric(handle));
     }
 
+    /**
+     * Looks up a handle without taking a reference to the object. The returned pointer is
+     * borrowed from the table and stays valid only until the handle is closed, so this is meant
+     * for SVCs that use the object for the duration of the call. Use SharedFrom() to keep it.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
+     */
+    Object* GetGenericPointer(Handle handle) const;
+
+    /**
+     * Looks up a handle while verifying its type, without taking a reference to the object.
+     * @see GetGenericPointer()
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid or its
+     *         type differs from the requested one.
+     */
+    template <class T>
+    T* GetPointer(Handle handle) const {
+        return DynamicObjectCast<T>(GetGenericPointer(handle));
+    }
+
     /// Closes all handles held in this table.
     void Clear();
 
+    /// Calls func(handle, object) for every valid handle, in slot order.
+    template <typename Func>
+    void ForEachHandle(Func&& func) const {
+        for (u16 slot = 0; slot < MAX_COUNT; ++slot) {
+            if (objects[slot] != nullptr) {
+                func(static_cast<Handle>(generations[slot] | (slot << 15)), objects[slot]);
+            }
+        }
+    }
+
 private:
     /**
      * This is the maximum limit of handles allowed per process in CTR-OS. It can be further
@@ -116,6 +145,8 @@ private:
     u16 next_free_slot;
 
     KernelSystem& kernel;
+
+    friend class KernelSystem;
 };
 
 } // namespace Kernel
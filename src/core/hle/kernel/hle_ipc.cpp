@@ -5,13 +5,17 @@
 #include <algorithm>
 #include <vector>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
+#include "common/logging/log.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/service/ipc_stats.h"
 
 namespace Kernel {
 
@@ -32,29 +36,81 @@ void SessionRequestHandler::ClientDisconnected(std::shared_ptr<ServerSession> se
         connected_sessions.end());
 }
 
+void SessionRequestHandler::DoSessionsState(PointerWrap& p, KernelSystem& kernel) {
+    u32 num_sessions = static_cast<u32>(connected_sessions.size());
+    p.Do(num_sessions);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (auto& info : connected_sessions) {
+            kernel.DoObjectReference(p, info.session);
+            info.data->DoState(p, kernel);
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < num_sessions && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        std::shared_ptr<ServerSession> session;
+        kernel.DoObjectReference(p, session);
+        if (session == nullptr) {
+            LOG_ERROR(Service, "Saved session of a service is missing");
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+
+        auto itr = std::find_if(connected_sessions.begin(), connected_sessions.end(),
+                                [&](const SessionInfo& info) { return info.session == session; });
+        if (itr == connected_sessions.end()) {
+            if (session->hle_handler != nullptr) {
+                LOG_ERROR(Service, "Saved session {} belongs to another service",
+                          session->GetName());
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                return;
+            }
+            ClientConnected(session);
+            itr = std::prev(connected_sessions.end());
+        }
+        itr->data->DoState(p, kernel);
+    }
+}
+
 std::shared_ptr<Event> HLERequestContext::SleepClientThread(const std::string& reason,
                                                             std::chrono::nanoseconds timeout,
                                                             WakeupCallback&& callback) {
+    // The callback keeps the context alive while the thread sleeps. Contexts that don't come from
+    // the pool, like the ones built by tests, live on the stack and have to be copied.
+    std::shared_ptr<HLERequestContext> context = weak_from_this().lock();
+    if (!context) {
+        context = std::make_shared<HLERequestContext>(*this);
+    }
+    // The callback and the event
+    RecordAllocation();
+    RecordAllocation();
+
     // Put the client thread to sleep until the wait event is signaled or the timeout expires.
-    thread->wakeup_callback = [context = *this,
-                               callback](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
-                                         std::shared_ptr<WaitObject> object) mutable {
+    thread->wakeup_callback = [context, callback = std::move(callback),
+                               sleep_start = kernel.timing.GetTicks()](
+                                  ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
+                                  std::shared_ptr<WaitObject> object) mutable {
         ASSERT(thread->status == ThreadStatus::WaitHleEvent);
-        callback(thread, context, reason);
+        if (context->command_stats != nullptr) {
+            context->command_stats->RecordSleep(context->kernel.timing.GetTicks() - sleep_start);
+        }
+        callback(thread, *context, reason);
 
         auto& process = thread->owner_process;
         // We must copy the entire command buffer *plus* the entire static buffers area, since
         // the translation might need to read from it in order to retrieve the StaticBuffer
         // target addresses.
         std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2 * IPC::MAX_STATIC_BUFFERS> cmd_buff;
-        Memory::MemorySystem& memory = context.kernel.memory;
+        Memory::MemorySystem& memory = context->kernel.memory;
         memory.ReadBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
                          cmd_buff.size() * sizeof(u32));
-        context.WriteToOutgoingCommandBuffer(cmd_buff.data(), *process);
+        context->WriteToOutgoingCommandBuffer(cmd_buff.data(), *process);
         // Copy the translated command buffer back into the thread's command buffer area.
         memory.WriteBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
                           cmd_buff.size() * sizeof(u32));
+        context->Release();
     };
+    thread->wakeup_callback_kind = WakeupCallbackKind::HLE;
 
     auto event = kernel.CreateEvent(Kernel::ResetType::OneShot, "HLE Pause Event: " + reason);
     thread->status = ThreadStatus::WaitHleEvent;
@@ -75,12 +131,30 @@ HLERequestContext::HLERequestContext(KernelSystem& kernel, std::shared_ptr<Serve
 
 HLERequestContext::~HLERequestContext() = default;
 
+void HLERequestContext::Release() {
+    session = nullptr;
+    thread = nullptr;
+    request_handles.clear();
+    for (auto& buffer : static_buffers) {
+        buffer.clear();
+    }
+    request_mapped_buffers.clear();
+    command_stats = nullptr;
+}
+
+void HLERequestContext::RecordAllocation() const {
+    ++kernel.GetHLERequestContextPool().stats.allocations;
+}
+
 std::shared_ptr<Object> HLERequestContext::GetIncomingHandle(u32 id_from_cmdbuf) const {
     ASSERT(id_from_cmdbuf < request_handles.size());
     return request_handles[id_from_cmdbuf];
 }
 
 u32 HLERequestContext::AddOutgoingHandle(std::shared_ptr<Object> object) {
+    if (request_handles.size() == request_handles.capacity()) {
+        RecordAllocation();
+    }
     request_handles.push_back(std::move(object));
     return static_cast<u32>(request_handles.size() - 1);
 }
@@ -140,16 +214,23 @@ ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* sr
             VAddr source_address = src_cmdbuf[i];
             IPC::StaticBufferDescInfo buffer_info{descriptor};
 
-            // Copy the input buffer into our own vector and store it.
-            std::vector<u8> data(buffer_info.size);
+            // Copy the input buffer into our own vector, reusing its storage from earlier
+            // requests when it is large enough.
+            std::vector<u8>& data = static_buffers[buffer_info.buffer_id];
+            if (data.capacity() < buffer_info.size) {
+                RecordAllocation();
+            }
+            data.resize(buffer_info.size);
             kernel.memory.ReadBlock(src_process, source_address, data.data(), data.size());
 
-            AddStaticBuffer(buffer_info.buffer_id, std::move(data));
             cmd_buf[i++] = source_address;
             break;
         }
         case IPC::DescriptorType::MappedBuffer: {
             u32 next_id = static_cast<u32>(request_mapped_buffers.size());
+            if (request_mapped_buffers.size() == request_mapped_buffers.capacity()) {
+                RecordAllocation();
+            }
             request_mapped_buffers.emplace_back(kernel.memory, src_process, descriptor,
                                                 src_cmdbuf[i], next_id);
             cmd_buf[i++] = next_id;
@@ -233,6 +314,38 @@ MappedBuffer& HLERequestContext::GetMappedBuffer(u32 id_from_cmdbuf) {
     return request_mapped_buffers[id_from_cmdbuf];
 }
 
+HLERequestContextPool::HLERequestContextPool(KernelSystem& kernel) : kernel(kernel) {}
+
+HLERequestContextPool::~HLERequestContextPool() {
+    if (stats.requests != 0) {
+        LOG_INFO(Kernel, "HLE IPC: {} requests, {} allocations ({:.3f} per request)",
+                 stats.requests, stats.allocations,
+                 static_cast<double>(stats.allocations) / stats.requests);
+    }
+}
+
+std::shared_ptr<HLERequestContext> HLERequestContextPool::Acquire(
+    std::shared_ptr<ServerSession> session, Thread* thread) {
+    ++stats.requests;
+
+    // Contexts only referenced by the pool are not in use by a sleeping thread
+    const auto itr = std::find_if(contexts.begin(), contexts.end(),
+                                  [](const auto& context) { return context.use_count() == 1; });
+    if (itr == contexts.end()) {
+        ++stats.allocations;
+        return contexts.emplace_back(
+            std::make_shared<HLERequestContext>(kernel, std::move(session), thread));
+    }
+
+    HLERequestContext& context = **itr;
+    // A context whose wakeup callback was dropped without running was never released
+    context.Release();
+    context.session = std::move(session);
+    context.thread = thread;
+    context.cmd_buf[0] = 0;
+    return *itr;
+}
+
 MappedBuffer::MappedBuffer(Memory::MemorySystem& memory, const Process& process, u32 descriptor,
                            VAddr address, u32 id)
     : memory(&memory), id(id), address(address), process(&process) {
@@ -17,9 +17,12 @@
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/server_session.h"
 
+class PointerWrap;
+
 namespace Service {
 class ServiceFrameworkBase;
-}
+struct IPCCommandStats;
+} // namespace Service
 
 namespace Memory {
 class MemorySystem;
@@ -68,8 +71,18 @@ public:
     /// in each service must inherit from this.
     struct SessionDataBase {
         virtual ~SessionDataBase() = default;
+
+        /// Saves or restores the session data, for the services whose sessions have some
+        virtual void DoState(PointerWrap& p, KernelSystem& kernel) {}
     };
 
+    /**
+     * Saves or restores the sessions connected to this handler along with their data. When
+     * loading, the sessions are taken from the restored kernel state, and the ones that weren't
+     * already connected to the handler are connected to it.
+     */
+    void DoSessionsState(PointerWrap& p, KernelSystem& kernel);
+
 protected:
     /// Creates the storage for the session data of the service.
     virtual std::unique_ptr<SessionDataBase> MakeSessionData() const = 0;
@@ -156,7 +169,7 @@ private:
  * id of the memory interface and let kernel convert it back to client vaddr. No real unmapping is
  * needed in this case, though.
  */
-class HLERequestContext {
+class HLERequestContext : public std::enable_shared_from_this<HLERequestContext> {
 public:
     HLERequestContext(KernelSystem& kernel, std::shared_ptr<ServerSession> session, Thread* thread);
     ~HLERequestContext();
@@ -234,7 +247,23 @@ public:
     /// Writes data from this context back to the requesting process/thread.
     ResultCode WriteToOutgoingCommandBuffer(u32_le* dst_cmdbuf, Process& dst_process) const;
 
+    /// Sets the statistics that the time the client thread spends in SleepClientThread is added to
+    void SetCommandStats(Service::IPCCommandStats* stats) {
+        command_stats = stats;
+    }
+
+    /**
+     * Drops the references this context holds to the session, objects and buffers of the request,
+     * keeping the storage for the next request handled with it.
+     */
+    void Release();
+
 private:
+    friend class HLERequestContextPool;
+
+    /// Counts a heap allocation made for this request in the pool statistics
+    void RecordAllocation() const;
+
     KernelSystem& kernel;
     std::array<u32, IPC::COMMAND_BUFFER_LENGTH> cmd_buf;
     std::shared_ptr<ServerSession> session;
@@ -245,6 +274,49 @@ private:
     std::array<std::vector<u8>, IPC::MAX_STATIC_BUFFERS> static_buffers;
     // The mapped buffers will be created when the IPC request is translated
     boost::container::small_vector<MappedBuffer, 8> request_mapped_buffers;
+    Service::IPCCommandStats* command_stats = nullptr;
+};
+
+/**
+ * Recycles HLERequestContexts between requests. The handle and mapped buffer lists and the static
+ * buffers of a context keep their storage, so once they have grown to the sizes a title uses,
+ * translating its requests doesn't allocate anymore. All HLE requests are handled on the
+ * emulation thread, so a single pool serves them all.
+ */
+class HLERequestContextPool {
+public:
+    struct Stats {
+        /// Number of requests handled with a context from the pool
+        u64 requests = 0;
+        /// Heap allocations made by the IPC layer for these requests, not counting the ones made
+        /// by the service handlers themselves
+        u64 allocations = 0;
+    };
+
+    explicit HLERequestContextPool(KernelSystem& kernel);
+    ~HLERequestContextPool();
+
+    /**
+     * Gets a context to handle a request with. A context is reused once it has been released and
+     * no sleeping thread's wakeup callback refers to it anymore.
+     */
+    std::shared_ptr<HLERequestContext> Acquire(std::shared_ptr<ServerSession> session,
+                                               Thread* thread);
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+    void ResetStats() {
+        stats = {};
+    }
+
+private:
+    friend class HLERequestContext;
+
+    KernelSystem& kernel;
+    std::vector<std::shared_ptr<HLERequestContext>> contexts;
+    Stats stats;
 };
 
 } // namespace Kernel
@@ -2,9 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/assert.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/config_mem.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
@@ -12,23 +14,36 @@
 #include "core/hle/kernel/shared_page.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
+#include "core/memory.h"
 
 namespace Kernel {
 
+/// Core the calling host thread runs, see KernelSystem::SetRunningCore()
+static thread_local u32 running_core_id = 0;
+
 /// Initialize the kernel
 KernelSystem::KernelSystem(Memory::MemorySystem& memory, Core::Timing& timing,
-                           std::function<void()> prepare_reschedule_callback, u32 system_mode)
+                           std::function<void()> prepare_reschedule_callback, u32 system_mode,
+                           u32 num_cores)
     : memory(memory), timing(timing),
       prepare_reschedule_callback(std::move(prepare_reschedule_callback)) {
+    ASSERT(num_cores > 0 && num_cores <= ThreadProcessorIdMax);
     MemoryInit(system_mode);
 
     resource_limits = std::make_unique<ResourceLimitList>(*this);
-    thread_manager = std::make_unique<ThreadManager>(*this);
+    core_processes.resize(num_cores);
+    for (u32 core_id = 0; core_id < num_cores; ++core_id) {
+        thread_managers.push_back(std::make_unique<ThreadManager>(*this, core_id));
+    }
     timer_manager = std::make_unique<TimerManager>(timing);
+    hle_request_context_pool = std::make_unique<HLERequestContextPool>(*this);
 }
 
 /// Shutdown the kernel
-KernelSystem::~KernelSystem() = default;
+KernelSystem::~KernelSystem() {
+    // The named ports are declared before the object registry, so they must be released first.
+    named_ports.clear();
+}
 
 ResourceLimitList& KernelSystem::ResourceLimit() {
     return *resource_limits;
@@ -42,20 +57,59 @@ u32 KernelSystem::GenerateObjectID() {
     return next_object_id++;
 }
 
-std::shared_ptr<Process> KernelSystem::GetCurrentProcess() const {
-    return current_process;
+void KernelSystem::RegisterObject(Object& object) {
+    std::lock_guard lock{objects_mutex};
+    objects[object.GetObjectId()] = &object;
+}
+
+void KernelSystem::UnregisterObject(Object& object) {
+    std::lock_guard lock{objects_mutex};
+    // Objects replaced by a loaded state are no longer registered under their ID.
+    const auto itr = objects.find(object.GetObjectId());
+    if (itr != objects.end() && itr->second == &object) {
+        objects.erase(itr);
+    }
+}
+
+const std::shared_ptr<Process>& KernelSystem::GetCurrentProcess() const {
+    return core_processes[running_core_id];
 }
 
 void KernelSystem::SetCurrentProcess(std::shared_ptr<Process> process) {
-    current_process = std::move(process);
+    core_processes[running_core_id] = std::move(process);
 }
 
 ThreadManager& KernelSystem::GetThreadManager() {
-    return *thread_manager;
+    return *thread_managers[running_core_id];
 }
 
 const ThreadManager& KernelSystem::GetThreadManager() const {
-    return *thread_manager;
+    return *thread_managers[running_core_id];
+}
+
+ThreadManager& KernelSystem::GetThreadManager(u32 core_id) {
+    return *thread_managers.at(core_id);
+}
+
+const ThreadManager& KernelSystem::GetThreadManager(u32 core_id) const {
+    return *thread_managers.at(core_id);
+}
+
+u32 KernelSystem::GetNumCores() const {
+    return static_cast<u32>(thread_managers.size());
+}
+
+u32 KernelSystem::GetRunningCoreId() const {
+    return running_core_id;
+}
+
+void KernelSystem::SetRunningCore(u32 core_id) {
+    ASSERT(core_id < GetNumCores());
+    running_core_id = core_id;
+}
+
+u32 KernelSystem::NewThreadId() {
+    return next_thread_id++;
 }
 
 TimerManager& KernelSystem::GetTimerManager() {
@@ -66,6 +120,14 @@ const TimerManager& KernelSystem::GetTimerManager() const {
     return *timer_manager;
 }
 
+HLERequestContextPool& KernelSystem::GetHLERequestContextPool() {
+    return *hle_request_context_pool;
+}
+
+const HLERequestContextPool& KernelSystem::GetHLERequestContextPool() const {
+    return *hle_request_context_pool;
+}
+
 SharedPage::Handler& KernelSystem::GetSharedPageHandler() {
     return *shared_page_handler;
 }
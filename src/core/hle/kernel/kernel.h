@@ -7,7 +7,10 @@
 #include <array>
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -15,6 +18,8 @@
 #include "core/hle/kernel/memory.h"
 #include "core/hle/result.h"
 
+class PointerWrap;
+
 namespace ConfigMem {
 class Handler;
 }
@@ -35,6 +40,7 @@ namespace Kernel {
 
 class AddressArbiter;
 class Event;
+class Object;
 class Mutex;
 class CodeSet;
 class Process;
@@ -45,12 +51,14 @@ class ClientPort;
 class ServerPort;
 class ClientSession;
 class ServerSession;
+class HLERequestContextPool;
 class ResourceLimitList;
 class SharedMemory;
 class ThreadManager;
 class TimerManager;
 class VMManager;
 struct AddressMapping;
+enum class HandleType : u32;
 
 enum class ResetType {
     OneShot,
@@ -80,7 +88,8 @@ enum class MemoryRegion : u16 {
 class KernelSystem {
 public:
     explicit KernelSystem(Memory::MemorySystem& memory, Core::Timing& timing,
-                          std::function<void()> prepare_reschedule_callback, u32 system_mode);
+                          std::function<void()> prepare_reschedule_callback, u32 system_mode,
+                          u32 num_cores = 1);
     ~KernelSystem();
 
     using PortPair = std::pair<std::shared_ptr<ServerPort>, std::shared_ptr<ClientPort>>;
@@ -203,15 +212,39 @@ public:
     /// Retrieves a process from the current list of processes.
     std::shared_ptr<Process> GetProcessById(u32 process_id) const;
 
-    std::shared_ptr<Process> GetCurrentProcess() const;
+    /// Gets or sets the process the running core executes
+    const std::shared_ptr<Process>& GetCurrentProcess() const;
     void SetCurrentProcess(std::shared_ptr<Process> process);
 
+    /// Gets the thread manager of the core currently running emulated code
     ThreadManager& GetThreadManager();
     const ThreadManager& GetThreadManager() const;
 
+    /// Gets the thread manager of the specified core
+    ThreadManager& GetThreadManager(u32 core_id);
+    const ThreadManager& GetThreadManager(u32 core_id) const;
+
+    /// Gets the number of emulated CPU cores that threads are scheduled on
+    u32 GetNumCores() const;
+
+    /// Gets the ID of the core the calling host thread runs
+    u32 GetRunningCoreId() const;
+
+    /**
+     * Makes the calling host thread act as the specified core, whose thread manager and current
+     * process the kernel then works with. Every host thread starts out as core 0.
+     */
+    void SetRunningCore(u32 core_id);
+
+    /// Creates a new thread ID, unique across all cores
+    u32 NewThreadId();
+
     TimerManager& GetTimerManager();
     const TimerManager& GetTimerManager() const;
 
+    HLERequestContextPool& GetHLERequestContextPool();
+    const HLERequestContextPool& GetHLERequestContextPool() const;
+
     void MapSharedPages(VMManager& address_space);
 
     SharedPage::Handler& GetSharedPageHandler();
@@ -233,6 +266,46 @@ public:
     /// Map of named ports managed by the kernel, which can be retrieved using the ConnectToPort
     std::unordered_map<std::string, std::shared_ptr<ClientPort>> named_ports;
 
+    /**
+     * Saves or restores the state of the kernel: every kernel object, the handle tables and
+     * memory mappings of the processes, the scheduling and waits of the threads, and the kernel
+     * memory allocators. Loading recreates the objects, so a state can be restored into a kernel
+     * that didn't run the session it was saved from. The ports of HLE services are connected to
+     * the handlers of the ports with the same name in the running kernel. Loading fails without
+     * modifying anything if the state is inconsistent or refers to a service that isn't running.
+     */
+    void DoState(PointerWrap& p);
+
+    /**
+     * Whether the kernel is in a state that DoState() can save. States can't be saved while a
+     * thread is paused by an HLE service, as the service would have to resume it, nor while an
+     * IPC request with mapped buffers is being handled by an emulated service.
+     */
+    bool CanSaveState() const;
+
+    /**
+     * Releases the sessions to HLE services that were restored by DoState() but not taken over by
+     * a service, once the state of the services has been loaded. Their clients see them closed.
+     */
+    void ReleaseRestoredHLESessions();
+
+    /**
+     * Saves or restores a reference to a kernel object, for the state of the HLE services. The
+     * object is stored by ID, so the kernel state must be restored before the references to its
+     * objects are.
+     */
+    template <typename T>
+    void DoObjectReference(PointerWrap& p, std::shared_ptr<T>& object) {
+        std::shared_ptr<Object> generic = object;
+        DoObjectReference(p, generic, T::HANDLE_TYPE);
+        object = std::static_pointer_cast<T>(std::move(generic));
+    }
+
+    /// Saves or restores a reference to a kernel object of any type, see above
+    void DoObjectReference(PointerWrap& p, std::shared_ptr<Object>& object) {
+        DoObjectReference(p, object, std::nullopt);
+    }
+
     Memory::MemorySystem& memory;
 
     Core::Timing& timing;
@@ -240,6 +313,27 @@ public:
 private:
     void MemoryInit(u32 mem_type);
 
+    class StateSerializer;
+
+    void DoObjectReference(PointerWrap& p, std::shared_ptr<Object>& object,
+                           std::optional<HandleType> type);
+
+    /// Gets the registered objects that aren't being destroyed, keyed by object ID
+    std::map<u32, std::shared_ptr<Object>> GetLiveObjects();
+
+    friend class Object;
+
+    /// Adds an object to the objects a state is saved from, called when the object is created
+    void RegisterObject(Object& object);
+
+    /// Removes an object from the registered objects, called when the object is destroyed
+    void UnregisterObject(Object& object);
+
+    /// Every live kernel object, keyed by object ID. Declared before the members holding objects,
+    /// so that the objects can unregister themselves when they are destroyed along with them.
+    std::unordered_map<u32, Object*> objects;
+    mutable std::mutex objects_mutex;
+
     std::function<void()> prepare_reschedule_callback;
 
     std::unique_ptr<ResourceLimitList> resource_limits;
@@ -261,12 +355,22 @@ private:
     // Lists all processes that exist in the current session.
     std::vector<std::shared_ptr<Process>> process_list;
 
-    std::shared_ptr<Process> current_process;
+    /// Process each core is running
+    std::vector<std::shared_ptr<Process>> core_processes;
+
+    u32 next_thread_id = 1;
 
-    std::unique_ptr<ThreadManager> thread_manager;
+    std::vector<std::unique_ptr<ThreadManager>> thread_managers;
 
     std::unique_ptr<ConfigMem::Handler> config_mem_handler;
     std::unique_ptr<SharedPage::Handler> shared_page_handler;
+
+    // Destructed first, so that contexts still held by it release their objects before the
+    // processes and threads are torn down.
+    std::unique_ptr<HLERequestContextPool> hle_request_context_pool;
+
+    /// Sessions to HLE services restored by DoState(), kept alive until a service takes them over
+    std::vector<std::shared_ptr<ServerSession>> restored_hle_sessions;
 };
 
 } // namespace Kernel
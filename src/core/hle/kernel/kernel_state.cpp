@@ -0,0 +1,1247 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/chunk_file.h"
+#include "common/logging/log.h"
+#include "core/hle/kernel/address_arbiter.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/config_mem.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/server_port.h"
+#include "core/hle/kernel/server_session.h"
+#include "core/hle/kernel/session.h"
+#include "core/hle/kernel/shared_memory.h"
+#include "core/hle/kernel/shared_page.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/timer.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+namespace {
+
+/// Stands for a null object reference in a saved kernel state
+constexpr u32 NO_OBJECT = 0xFFFFFFFF;
+
+/// What a saved memory mapping or block is backed by
+enum class BackingType : u32 {
+    Physical,
+    ConfigMem,
+    SharedPage,
+};
+
+struct SavedObject {
+    u32 object_id;
+    HandleType type;
+    /// Core the thread is scheduled on, for threads
+    u32 core_id;
+};
+
+struct SavedInterval {
+    u32 lower;
+    u32 upper;
+};
+
+struct SavedMapping {
+    VAddr base;
+    u32 size;
+    u32 permissions;
+    u32 meminfo_state;
+    BackingType backing;
+    /// Physical address, or offset into the config memory or shared page
+    u32 address;
+};
+
+struct SavedBlock {
+    PAddr address;
+    u32 size;
+};
+
+/// Whether a wakeup callback can be recreated from its kind when loading a state
+bool CanRestoreWakeupCallback(const Thread& thread) {
+    switch (thread.wakeup_callback_kind) {
+    case WakeupCallbackKind::None:
+        return thread.wakeup_callback == nullptr;
+    case WakeupCallbackKind::WaitSynch1:
+    case WakeupCallbackKind::WaitSynchAll:
+    case WakeupCallbackKind::WaitSynchAny:
+    case WakeupCallbackKind::ReplyAndReceive:
+    case WakeupCallbackKind::ArbitrateAddress:
+        return true;
+    case WakeupCallbackKind::HLE:
+        return false;
+    }
+    return false;
+}
+
+} // Anonymous namespace
+
+/**
+ * Saves or loads the kernel state. Every live object is saved with its ID, then the fields of each
+ * object, in which objects refer to each other by ID. Loading creates a new object for every saved
+ * one and fills it in, and only replaces the objects of the kernel once the whole state has been
+ * read and checked.
+ */
+class KernelSystem::StateSerializer {
+public:
+    StateSerializer(KernelSystem& kernel, PointerWrap& p)
+        : kernel(kernel), p(p), loading(p.GetMode() == PointerWrap::MODE_READ) {}
+
+    void DoState() {
+        if (loading) {
+            running_objects = kernel.GetLiveObjects();
+            running_next_object_id = kernel.next_object_id;
+        } else {
+            Capture();
+        }
+
+        DoObjectList();
+        for (const auto& [id, object] : state_objects) {
+            if (p.error == PointerWrap::ERROR_FAILURE) {
+                break;
+            }
+            DoObject(*object);
+        }
+        DoSessions();
+        DoKernel();
+
+        if (!loading) {
+            return;
+        }
+        if (p.error != PointerWrap::ERROR_FAILURE) {
+            Validate();
+        }
+        if (p.error == PointerWrap::ERROR_FAILURE) {
+            // Take the half loaded objects apart before they are destroyed, as their destructors
+            // would otherwise act on the running kernel.
+            std::vector<std::shared_ptr<Object>> loaded;
+            for (const auto& [id, object] : state_objects) {
+                loaded.push_back(object);
+            }
+            Detach(loaded, false);
+            // Creating them used up object IDs of the running kernel
+            kernel.next_object_id = running_next_object_id;
+            return;
+        }
+        Commit();
+    }
+
+private:
+    struct CoreState {
+        std::vector<std::shared_ptr<Thread>> thread_list;
+        std::shared_ptr<Thread> current_thread;
+        std::shared_ptr<Process> process;
+        std::vector<Thread*> ready_queue;
+        std::vector<Thread*> wakeup_slots;
+        std::vector<u32> free_wakeup_slots;
+    };
+
+    void Fail(const char* reason) {
+        if (p.error != PointerWrap::ERROR_FAILURE) {
+            LOG_ERROR(Kernel, "Kernel state can't be {}: {}", loading ? "loaded" : "saved",
+                      reason);
+        }
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+
+    /// Copies the tables of the kernel, which are then saved like the loaded ones are restored
+    void Capture() {
+        state_objects = kernel.GetLiveObjects();
+        for (const auto& [id, object] : state_objects) {
+            saved_ids.emplace(object.get(), id);
+        }
+
+        next_object_id = kernel.next_object_id;
+        next_process_id = kernel.next_process_id;
+        next_thread_id = kernel.next_thread_id;
+        next_timer_callback_id = kernel.timer_manager->next_timer_callback_id;
+        memory_regions = kernel.memory_regions;
+        process_list = kernel.process_list;
+        for (u32 core_id = 0; core_id < kernel.GetNumCores(); ++core_id) {
+            const ThreadManager& thread_manager = *kernel.thread_managers[core_id];
+            CoreState& core = cores.emplace_back();
+            core.thread_list = thread_manager.thread_list;
+            core.current_thread = thread_manager.current_thread;
+            core.process = kernel.core_processes[core_id];
+            core.ready_queue = thread_manager.ready_queue.GetThreads();
+            core.wakeup_slots = thread_manager.wakeup_slots;
+            core.free_wakeup_slots = thread_manager.free_wakeup_slots;
+        }
+        named_ports.assign(kernel.named_ports.begin(), kernel.named_ports.end());
+        std::sort(named_ports.begin(), named_ports.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        resource_limits = kernel.resource_limits->resource_limits;
+
+        // The code of a process is only read from its CodeSet when the process starts.
+        for (const auto& process : process_list) {
+            if (process->status == ProcessStatus::Created) {
+                needed_codesets.insert(process->codeset.get());
+            }
+        }
+    }
+
+    std::shared_ptr<Object> CreateObject(HandleType type, u32 core_id) {
+        switch (type) {
+        case HandleType::Event:
+            return std::make_shared<Event>(kernel);
+        case HandleType::Mutex:
+            return std::make_shared<Mutex>(kernel);
+        case HandleType::SharedMemory: {
+            auto shared_memory = std::make_shared<SharedMemory>(kernel);
+            shared_memory->owner_process = nullptr;
+            return shared_memory;
+        }
+        case HandleType::Thread:
+            if (core_id >= kernel.GetNumCores()) {
+                return nullptr;
+            }
+            return std::make_shared<Thread>(kernel, core_id);
+        case HandleType::Process:
+            return std::make_shared<Process>(kernel);
+        case HandleType::AddressArbiter:
+            return std::make_shared<AddressArbiter>(kernel);
+        case HandleType::Semaphore:
+            return std::make_shared<Semaphore>(kernel);
+        case HandleType::Timer: {
+            auto timer = std::make_shared<Timer>(kernel);
+            // Only registered with the timer manager when the state is applied
+            timer->callback_id = 0;
+            return timer;
+        }
+        case HandleType::ResourceLimit:
+            return std::make_shared<Kernel::ResourceLimit>(kernel);
+        case HandleType::CodeSet:
+            return std::make_shared<CodeSet>(kernel);
+        case HandleType::ClientPort:
+            return std::make_shared<ClientPort>(kernel);
+        case HandleType::ServerPort:
+            return std::make_shared<ServerPort>(kernel);
+        case HandleType::ClientSession: {
+            // The session endpoints get their parent from the saved sessions
+            auto session = std::make_shared<ClientSession>(kernel);
+            session->parent = std::make_shared<Session>();
+            return session;
+        }
+        case HandleType::ServerSession: {
+            auto session = std::make_shared<ServerSession>(kernel);
+            session->parent = std::make_shared<Session>();
+            return session;
+        }
+        case HandleType::Unknown:
+            break;
+        }
+        return nullptr;
+    }
+
+    void DoObjectList() {
+        std::vector<SavedObject> saved;
+        for (const auto& [id, object] : state_objects) {
+            const auto thread = DynamicObjectCast<Thread>(object.get());
+            saved.push_back({id, object->GetHandleType(),
+                             thread != nullptr ? thread->thread_manager.GetCoreId() : 0});
+        }
+        p.Do(saved);
+        if (!loading || p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+
+        for (const SavedObject& object : saved) {
+            auto created = CreateObject(object.type, object.core_id);
+            if (created == nullptr || object.object_id == NO_OBJECT ||
+                !state_objects.emplace(object.object_id, std::move(created)).second) {
+                Fail("invalid object list");
+                return;
+            }
+        }
+    }
+
+    template <typename T>
+    std::shared_ptr<T> Find(u32 id) {
+        const auto itr = state_objects.find(id);
+        if (itr == state_objects.end()) {
+            return nullptr;
+        }
+        if constexpr (std::is_same_v<T, Object>) {
+            return itr->second;
+        } else {
+            return DynamicObjectCast<T>(itr->second);
+        }
+    }
+
+    template <typename T>
+    void DoReference(std::shared_ptr<T>& object) {
+        u32 id = object != nullptr ? object->GetObjectId() : NO_OBJECT;
+        p.Do(id);
+        if (!loading) {
+            if (object != nullptr && state_objects.count(id) == 0) {
+                Fail("an object refers to an object that is being destroyed");
+            }
+            return;
+        }
+
+        object = nullptr;
+        if (id != NO_OBJECT && p.error != PointerWrap::ERROR_FAILURE) {
+            object = Find<T>(id);
+            if (object == nullptr) {
+                Fail("an object refers to a missing object or one of the wrong type");
+            }
+        }
+    }
+
+    template <typename T>
+    void DoReference(T*& object) {
+        // Raw references don't keep their object alive, so they are looked up without using them
+        std::shared_ptr<T> shared;
+        if (!loading && object != nullptr) {
+            const auto itr = saved_ids.find(object);
+            if (itr != saved_ids.end()) {
+                shared = std::static_pointer_cast<T>(state_objects.at(itr->second));
+            }
+        }
+        DoReference(shared);
+        object = shared.get();
+    }
+
+    template <typename Container>
+    void DoReferences(Container& objects) {
+        u32 count = static_cast<u32>(objects.size());
+        p.Do(count);
+        if (loading) {
+            if (count > state_objects.size()) {
+                Fail("invalid list of objects");
+                count = 0;
+            }
+            objects.clear();
+            objects.resize(count);
+        }
+        for (auto& object : objects) {
+            DoReference(object);
+        }
+    }
+
+    template <typename T>
+    void DoReferences(boost::container::flat_set<std::shared_ptr<T>>& objects) {
+        std::vector<std::shared_ptr<T>> list(objects.begin(), objects.end());
+        DoReferences(list);
+        if (loading) {
+            objects.clear();
+            objects.insert(list.begin(), list.end());
+        }
+    }
+
+    void DoIntervals(MemoryRegionInfo::IntervalSet& intervals) {
+        std::vector<SavedInterval> saved;
+        for (const auto& interval : intervals) {
+            saved.push_back({interval.lower(), interval.upper()});
+        }
+        p.Do(saved);
+        if (!loading) {
+            return;
+        }
+
+        intervals.clear();
+        for (const SavedInterval& interval : saved) {
+            if (interval.lower >= interval.upper) {
+                Fail("invalid memory intervals");
+                return;
+            }
+            intervals.insert(
+                MemoryRegionInfo::Interval::right_open(interval.lower, interval.upper));
+        }
+    }
+
+    /// Finds what a range of host memory mapped into the emulated system belongs to
+    bool GetBacking(const u8* pointer, u32 size, BackingType& type, u32& address) {
+        const auto InHandler = [&](const void* handler_memory, u32 handler_size) {
+            const auto* base = static_cast<const u8*>(handler_memory);
+            if (pointer < base || pointer >= base + handler_size ||
+                size > static_cast<u32>(base + handler_size - pointer)) {
+                return false;
+            }
+            address = static_cast<u32>(pointer - base);
+            return true;
+        };
+        if (InHandler(&kernel.config_mem_handler->GetConfigMem(), Memory::CONFIG_MEMORY_SIZE)) {
+            type = BackingType::ConfigMem;
+            return true;
+        }
+        if (InHandler(&kernel.shared_page_handler->GetSharedPage(), Memory::SHARED_PAGE_SIZE)) {
+            type = BackingType::SharedPage;
+            return true;
+        }
+
+        const auto start = kernel.memory.GetPhysicalAddress(pointer);
+        const auto last = kernel.memory.GetPhysicalAddress(pointer + size - 1);
+        if (!start || !last || *last - *start != size - 1) {
+            return false;
+        }
+        type = BackingType::Physical;
+        address = *start;
+        return true;
+    }
+
+    /// Gets the host memory backing a saved range, or nullptr if the range isn't valid
+    u8* GetBackingPointer(BackingType type, u32 address, u32 size) {
+        const auto InHandler = [&](void* handler_memory, u32 handler_size) -> u8* {
+            if (address >= handler_size || size > handler_size - address) {
+                return nullptr;
+            }
+            return static_cast<u8*>(handler_memory) + address;
+        };
+        switch (type) {
+        case BackingType::ConfigMem:
+            return InHandler(&kernel.config_mem_handler->GetConfigMem(),
+                             Memory::CONFIG_MEMORY_SIZE);
+        case BackingType::SharedPage:
+            return InHandler(&kernel.shared_page_handler->GetSharedPage(),
+                             Memory::SHARED_PAGE_SIZE);
+        case BackingType::Physical: {
+            u8* const pointer = kernel.memory.GetPhysicalPointer(address);
+            if (pointer == nullptr || size == 0 ||
+                kernel.memory.GetPhysicalPointer(address + size - 1) != pointer + size - 1) {
+                return nullptr;
+            }
+            return pointer;
+        }
+        }
+        return nullptr;
+    }
+
+    void DoWaitObject(WaitObject& object) {
+        DoReferences(object.waiting_threads);
+    }
+
+    void DoObject(Event& event) {
+        DoWaitObject(event);
+        p.Do(event.reset_type);
+        p.Do(event.signaled);
+        p.Do(event.name);
+    }
+
+    void DoObject(Mutex& mutex) {
+        DoWaitObject(mutex);
+        p.Do(mutex.lock_count);
+        p.Do(mutex.priority);
+        p.Do(mutex.name);
+        DoReference(mutex.holding_thread);
+    }
+
+    void DoObject(Semaphore& semaphore) {
+        DoWaitObject(semaphore);
+        p.Do(semaphore.max_count);
+        p.Do(semaphore.available_count);
+        p.Do(semaphore.name);
+    }
+
+    void DoObject(Timer& timer) {
+        DoWaitObject(timer);
+        p.Do(timer.reset_type);
+        p.Do(timer.initial_delay);
+        p.Do(timer.interval_delay);
+        p.Do(timer.signaled);
+        p.Do(timer.name);
+        p.Do(timer.callback_id);
+    }
+
+    void DoObject(AddressArbiter& arbiter) {
+        p.Do(arbiter.name);
+        DoReferences(arbiter.waiting_threads);
+    }
+
+    void DoObject(Kernel::ResourceLimit& limit) {
+        p.Do(limit.name);
+        p.Do(limit.max_priority);
+        p.Do(limit.max_commit);
+        p.Do(limit.max_threads);
+        p.Do(limit.max_events);
+        p.Do(limit.max_mutexes);
+        p.Do(limit.max_semaphores);
+        p.Do(limit.max_timers);
+        p.Do(limit.max_shared_mems);
+        p.Do(limit.max_address_arbiters);
+        p.Do(limit.max_cpu_time);
+        p.Do(limit.current_commit);
+        p.Do(limit.current_threads);
+        p.Do(limit.current_events);
+        p.Do(limit.current_mutexes);
+        p.Do(limit.current_semaphores);
+        p.Do(limit.current_timers);
+        p.Do(limit.current_shared_mems);
+        p.Do(limit.current_address_arbiters);
+        p.Do(limit.current_cpu_time);
+    }
+
+    void DoObject(CodeSet& codeset) {
+        p.Do(codeset.name);
+        p.Do(codeset.program_id);
+        p.Do(codeset.entrypoint);
+        for (CodeSet::Segment& segment : codeset.segments) {
+            u64 offset = segment.offset;
+            p.Do(offset);
+            segment.offset = static_cast<std::size_t>(offset);
+            p.Do(segment.addr);
+            p.Do(segment.size);
+        }
+        bool has_memory = needed_codesets.count(&codeset) != 0;
+        p.Do(has_memory);
+        if (has_memory) {
+            p.Do(codeset.memory);
+        }
+    }
+
+    void DoHandleTable(HandleTable& table) {
+        for (auto& object : table.objects) {
+            DoReference(object);
+        }
+        p.DoArray(table.generations.data(), static_cast<int>(table.generations.size()));
+        p.Do(table.next_generation);
+        p.Do(table.next_free_slot);
+    }
+
+    void DoMappings(VMManager& vm_manager) {
+        std::vector<SavedMapping> saved;
+        for (const auto& [base, vma] : vm_manager.vma_map) {
+            if (loading || vma.type == VMAType::Free) {
+                continue;
+            }
+            SavedMapping& mapping = saved.emplace_back();
+            mapping.base = base;
+            mapping.size = vma.size;
+            mapping.permissions = static_cast<u32>(vma.permissions);
+            mapping.meminfo_state = static_cast<u32>(vma.meminfo_state);
+            if (vma.type != VMAType::BackingMemory ||
+                !GetBacking(vma.backing_memory, vma.size, mapping.backing, mapping.address)) {
+                Fail("a process maps memory that isn't part of the emulated system");
+                return;
+            }
+        }
+        p.Do(saved);
+        if (!loading || p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+
+        for (const SavedMapping& mapping : saved) {
+            u8* const pointer = GetBackingPointer(mapping.backing, mapping.address, mapping.size);
+            if (pointer == nullptr ||
+                vm_manager
+                        .MapBackingMemory(mapping.base, pointer, mapping.size,
+                                          static_cast<MemoryState>(mapping.meminfo_state))
+                        .Failed() ||
+                vm_manager
+                    .ReprotectRange(mapping.base, mapping.size,
+                                    static_cast<VMAPermission>(mapping.permissions))
+                    .IsError()) {
+                Fail("invalid memory mapping");
+                return;
+            }
+        }
+    }
+
+    void DoObject(Process& process) {
+        DoReference(process.codeset);
+        DoReference(process.resource_limit);
+
+        std::array<u32, 0x80 / 32> svc_access_mask{};
+        for (std::size_t i = 0; i < process.svc_access_mask.size(); ++i) {
+            svc_access_mask[i / 32] |= static_cast<u32>(process.svc_access_mask[i]) << (i % 32);
+        }
+        p.Do(svc_access_mask);
+        for (std::size_t i = 0; i < process.svc_access_mask.size(); ++i) {
+            process.svc_access_mask[i] = (svc_access_mask[i / 32] >> (i % 32)) & 1;
+        }
+
+        p.Do(process.handle_table_size);
+        u32 num_mappings = static_cast<u32>(process.address_mappings.size());
+        p.Do(num_mappings);
+        if (loading) {
+            if (num_mappings > process.address_mappings.capacity()) {
+                Fail("invalid address mappings");
+                num_mappings = 0;
+            }
+            process.address_mappings.resize(num_mappings);
+        }
+        for (AddressMapping& mapping : process.address_mappings) {
+            p.Do(mapping.address);
+            p.Do(mapping.size);
+            p.Do(mapping.read_only);
+            p.Do(mapping.unk_flag);
+        }
+
+        p.Do(process.flags.raw);
+        p.Do(process.kernel_version);
+        p.Do(process.ideal_processor);
+        p.Do(process.status);
+        p.Do(process.process_id);
+        p.Do(process.memory_used);
+
+        u32 memory_region = NO_OBJECT;
+        if (process.memory_region != nullptr) {
+            memory_region = static_cast<u32>(process.memory_region - kernel.memory_regions.data());
+        }
+        p.Do(memory_region);
+        if (loading) {
+            process.memory_region = nullptr;
+            if (memory_region < kernel.memory_regions.size()) {
+                process.memory_region = &kernel.memory_regions[memory_region];
+            } else if (memory_region != NO_OBJECT) {
+                Fail("invalid memory region");
+            }
+        }
+
+        std::vector<u8> tls_slots;
+        for (const auto& slots : process.tls_slots) {
+            tls_slots.push_back(static_cast<u8>(slots.to_ulong()));
+        }
+        p.Do(tls_slots);
+        process.tls_slots.assign(tls_slots.begin(), tls_slots.end());
+
+        DoHandleTable(process.handle_table);
+        DoMappings(process.vm_manager);
+    }
+
+    void DoObject(Thread& thread) {
+        DoWaitObject(thread);
+        p.Do(thread.thread_id);
+        p.Do(thread.status);
+        p.Do(thread.entry_point);
+        p.Do(thread.stack_top);
+        p.Do(thread.nominal_priority);
+        p.Do(thread.current_priority);
+        p.Do(thread.last_running_ticks);
+        p.Do(thread.processor_id);
+        p.Do(thread.tls_address);
+        DoReferences(thread.held_mutexes);
+        DoReferences(thread.pending_mutexes);
+        DoReference(thread.owner_process);
+        DoReferences(thread.wait_objects);
+        p.Do(thread.wait_address);
+        p.Do(thread.name);
+        p.Do(thread.wakeup_slot);
+
+        if (!loading && !CanRestoreWakeupCallback(thread)) {
+            Fail("a thread is paused by an HLE service");
+        }
+        p.Do(thread.wakeup_callback_kind);
+    }
+
+    void DoObject(ClientPort& port) {
+        DoReference(port.server_port);
+        p.Do(port.max_sessions);
+        p.Do(port.active_sessions);
+        p.Do(port.name);
+    }
+
+    void DoObject(ServerPort& port) {
+        DoWaitObject(port);
+        p.Do(port.name);
+        DoReferences(port.pending_sessions);
+
+        // HLE handlers are connected to the port of the same name in the running kernel
+        bool is_hle = port.hle_handler != nullptr;
+        p.Do(is_hle);
+        if (loading && is_hle) {
+            hle_ports.push_back(&port);
+        }
+    }
+
+    void DoObject(ServerSession& session) {
+        DoWaitObject(session);
+        p.Do(session.name);
+        DoReferences(session.pending_requesting_threads);
+        DoReference(session.currently_handling);
+        if (!loading && !session.mapped_buffer_context.empty()) {
+            Fail("an emulated service is handling a request with mapped buffers");
+        }
+
+        bool is_hle = session.hle_handler != nullptr;
+        p.Do(is_hle);
+        if (loading && is_hle) {
+            hle_sessions.push_back(SharedFrom(&session));
+        }
+    }
+
+    void DoObject(ClientSession& session) {
+        p.Do(session.name);
+    }
+
+    void DoObject(SharedMemory& shared_memory) {
+        DoReference(shared_memory.owner_process);
+        p.Do(shared_memory.linear_heap_phys_offset);
+        p.Do(shared_memory.size);
+        p.Do(shared_memory.permissions);
+        p.Do(shared_memory.other_permissions);
+        p.Do(shared_memory.base_address);
+        p.Do(shared_memory.name);
+        DoIntervals(shared_memory.holding_memory);
+
+        std::vector<SavedBlock> blocks;
+        for (const auto& [pointer, size] : shared_memory.backing_blocks) {
+            const auto address = kernel.memory.GetPhysicalAddress(pointer);
+            if (!loading && !address) {
+                Fail("a shared memory block isn't part of the emulated memory");
+                return;
+            }
+            blocks.push_back({address.value_or(0), size});
+        }
+        p.Do(blocks);
+        if (!loading || p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+
+        shared_memory.backing_blocks.clear();
+        for (const SavedBlock& block : blocks) {
+            u8* const pointer = GetBackingPointer(BackingType::Physical, block.address, block.size);
+            if (pointer == nullptr) {
+                Fail("invalid shared memory block");
+                return;
+            }
+            shared_memory.backing_blocks.emplace_back(pointer, block.size);
+        }
+    }
+
+    void DoObject(Object& object) {
+        switch (object.GetHandleType()) {
+        case HandleType::Event:
+            return DoObject(static_cast<Event&>(object));
+        case HandleType::Mutex:
+            return DoObject(static_cast<Mutex&>(object));
+        case HandleType::SharedMemory:
+            return DoObject(static_cast<SharedMemory&>(object));
+        case HandleType::Thread:
+            return DoObject(static_cast<Thread&>(object));
+        case HandleType::Process:
+            return DoObject(static_cast<Process&>(object));
+        case HandleType::AddressArbiter:
+            return DoObject(static_cast<AddressArbiter&>(object));
+        case HandleType::Semaphore:
+            return DoObject(static_cast<Semaphore&>(object));
+        case HandleType::Timer:
+            return DoObject(static_cast<Timer&>(object));
+        case HandleType::ResourceLimit:
+            return DoObject(static_cast<Kernel::ResourceLimit&>(object));
+        case HandleType::CodeSet:
+            return DoObject(static_cast<CodeSet&>(object));
+        case HandleType::ClientPort:
+            return DoObject(static_cast<ClientPort&>(object));
+        case HandleType::ServerPort:
+            return DoObject(static_cast<ServerPort&>(object));
+        case HandleType::ClientSession:
+            return DoObject(static_cast<ClientSession&>(object));
+        case HandleType::ServerSession:
+            return DoObject(static_cast<ServerSession&>(object));
+        case HandleType::Unknown:
+            break;
+        }
+        Fail("unknown object type");
+    }
+
+    /// Saves the sessions that link the client and server endpoints
+    void DoSessions() {
+        std::vector<std::shared_ptr<Session>> sessions;
+        std::set<const Session*> saved_sessions;
+        for (const auto& [id, object] : state_objects) {
+            std::shared_ptr<Session> parent;
+            if (const auto client = DynamicObjectCast<ClientSession>(object.get())) {
+                parent = client->parent;
+            } else if (const auto server = DynamicObjectCast<ServerSession>(object.get())) {
+                parent = server->parent;
+            }
+            if (!loading && parent != nullptr && saved_sessions.insert(parent.get()).second) {
+                sessions.push_back(std::move(parent));
+            }
+        }
+
+        u32 count = static_cast<u32>(sessions.size());
+        p.Do(count);
+        if (loading) {
+            if (count > state_objects.size()) {
+                Fail("invalid sessions");
+                return;
+            }
+            for (u32 i = 0; i < count; ++i) {
+                sessions.push_back(std::make_shared<Session>());
+            }
+        }
+
+        std::set<const Object*> bound_endpoints;
+        for (const auto& session : sessions) {
+            DoReference(session->client);
+            DoReference(session->server);
+            DoReference(session->port);
+            if (!loading || p.error == PointerWrap::ERROR_FAILURE) {
+                continue;
+            }
+            if ((session->client != nullptr && !bound_endpoints.insert(session->client).second) ||
+                (session->server != nullptr && !bound_endpoints.insert(session->server).second)) {
+                Fail("a session endpoint belongs to several sessions");
+                return;
+            }
+            if (session->client != nullptr) {
+                session->client->parent = session;
+            }
+            if (session->server != nullptr) {
+                session->server->parent = session;
+            }
+        }
+
+        if (!loading || p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+        for (const auto& [id, object] : state_objects) {
+            const auto type = object->GetHandleType();
+            if ((type == HandleType::ClientSession || type == HandleType::ServerSession) &&
+                bound_endpoints.count(object.get()) == 0) {
+                Fail("a session endpoint has no session");
+                return;
+            }
+        }
+    }
+
+    /// Saves the tables of the kernel and its thread and timer managers
+    void DoKernel() {
+        p.Do(next_object_id);
+        p.Do(next_process_id);
+        p.Do(next_thread_id);
+        p.Do(next_timer_callback_id);
+        for (MemoryRegionInfo& region : memory_regions) {
+            p.Do(region.base);
+            p.Do(region.size);
+            p.Do(region.used);
+            DoIntervals(region.free_blocks);
+        }
+        DoReferences(process_list);
+
+        u32 num_cores = kernel.GetNumCores();
+        p.Do(num_cores);
+        if (loading && num_cores != kernel.GetNumCores()) {
+            Fail("the state was saved with a different number of cores");
+            return;
+        }
+        cores.resize(num_cores);
+        for (CoreState& core : cores) {
+            DoReferences(core.thread_list);
+            DoReference(core.current_thread);
+            DoReference(core.process);
+            DoReferences(core.ready_queue);
+            DoReferences(core.wakeup_slots);
+            p.Do(core.free_wakeup_slots);
+        }
+
+        u32 num_named_ports = static_cast<u32>(named_ports.size());
+        p.Do(num_named_ports);
+        if (loading) {
+            if (num_named_ports > state_objects.size()) {
+                Fail("invalid named ports");
+                return;
+            }
+            named_ports.resize(num_named_ports);
+        }
+        for (auto& [name, port] : named_ports) {
+            p.Do(name);
+            DoReference(port);
+        }
+
+        for (auto& limit : resource_limits) {
+            DoReference(limit);
+        }
+    }
+
+    /// Checks the loaded state for what would break the kernel once it is applied
+    void Validate() {
+        std::set<u64> timer_callback_ids;
+        for (const auto& [id, object] : state_objects) {
+            if (const auto timer = DynamicObjectCast<Timer>(object.get())) {
+                if (timer->callback_id == 0 || timer->callback_id > next_timer_callback_id ||
+                    !timer_callback_ids.insert(timer->callback_id).second) {
+                    return Fail("invalid timer");
+                }
+            }
+        }
+
+        for (const auto& [id, object] : state_objects) {
+            const auto thread = DynamicObjectCast<Thread>(object.get());
+            if (thread == nullptr) {
+                continue;
+            }
+            if (thread->current_priority > ThreadPrioLowest ||
+                thread->wakeup_callback_kind == WakeupCallbackKind::HLE) {
+                return Fail("invalid thread");
+            }
+            if (thread->wakeup_callback_kind == WakeupCallbackKind::ArbitrateAddress &&
+                FindArbiter(*thread) == nullptr) {
+                return Fail("a thread waits on a missing address arbiter");
+            }
+        }
+
+        for (u32 core_id = 0; core_id < cores.size(); ++core_id) {
+            const CoreState& core = cores[core_id];
+            for (const auto& thread : core.thread_list) {
+                if (thread->thread_manager.GetCoreId() != core_id ||
+                    thread->owner_process == nullptr) {
+                    return Fail("invalid thread");
+                }
+            }
+            const auto OnThisCore = [&core](const Thread* thread) {
+                return std::any_of(core.thread_list.begin(), core.thread_list.end(),
+                                   [thread](const auto& t) { return t.get() == thread; });
+            };
+            if (core.current_thread != nullptr && !OnThisCore(core.current_thread.get())) {
+                return Fail("invalid current thread");
+            }
+            std::set<const Thread*> ready_threads;
+            for (const Thread* thread : core.ready_queue) {
+                if (thread == nullptr || !OnThisCore(thread) ||
+                    thread->status != ThreadStatus::Ready || !ready_threads.insert(thread).second) {
+                    return Fail("invalid ready queue");
+                }
+            }
+            for (u32 slot = 0; slot < core.wakeup_slots.size(); ++slot) {
+                const Thread* thread = core.wakeup_slots[slot];
+                if (thread != nullptr && (thread->wakeup_slot != slot || !OnThisCore(thread))) {
+                    return Fail("invalid wakeup slots");
+                }
+            }
+            for (u32 slot : core.free_wakeup_slots) {
+                if (slot >= core.wakeup_slots.size() || core.wakeup_slots[slot] != nullptr) {
+                    return Fail("invalid wakeup slots");
+                }
+            }
+        }
+
+        for (ServerPort* port : hle_ports) {
+            const auto itr = std::find_if(
+                running_objects.begin(), running_objects.end(), [port](const auto& entry) {
+                    const auto running_port = DynamicObjectCast<ServerPort>(entry.second.get());
+                    return running_port != nullptr && running_port->hle_handler != nullptr &&
+                           running_port->name == port->name;
+                });
+            if (itr == running_objects.end()) {
+                LOG_ERROR(Kernel, "The HLE port {} isn't running", port->name);
+                return Fail("the state uses an HLE service that isn't running");
+            }
+            hle_handlers.emplace_back(port,
+                                      static_cast<ServerPort&>(*itr->second).hle_handler);
+        }
+    }
+
+    AddressArbiter* FindArbiter(const Thread& thread) {
+        for (const auto& [id, object] : state_objects) {
+            const auto arbiter = DynamicObjectCast<AddressArbiter>(object.get());
+            if (arbiter != nullptr &&
+                std::any_of(arbiter->waiting_threads.begin(), arbiter->waiting_threads.end(),
+                            [&thread](const auto& t) { return t.get() == &thread; })) {
+                return arbiter;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Unlinks objects from each other and from the kernel, so that destroying them has no effect
+     * on the objects that remain.
+     * @param running Whether the objects are the ones of the running kernel, whose pending timing
+     *     events are cancelled. The events of loaded objects are restored with the timing state.
+     */
+    void Detach(const std::vector<std::shared_ptr<Object>>& objects, bool running) {
+        for (const auto& object : objects) {
+            // Let the HLE services forget the sessions they handle
+            const auto session = DynamicObjectCast<ServerSession>(object);
+            if (session != nullptr && session->hle_handler != nullptr) {
+                session->hle_handler->ClientDisconnected(session);
+            }
+        }
+
+        for (const auto& object : objects) {
+            if (auto wait_object = DynamicObjectCast<WaitObject>(object.get())) {
+                wait_object->waiting_threads.clear();
+                wait_object->hle_notifier = nullptr;
+            }
+
+            switch (object->GetHandleType()) {
+            case HandleType::Thread: {
+                auto& thread = static_cast<Thread&>(*object);
+                if (running) {
+                    kernel.timing.UnscheduleEvent(thread.thread_manager.ThreadWakeupEventType,
+                                                  thread.GetWakeupEventUserdata());
+                }
+                thread.status = ThreadStatus::Dead;
+                thread.wakeup_callback = nullptr;
+                thread.wakeup_callback_kind = WakeupCallbackKind::None;
+                thread.wait_objects.clear();
+                thread.held_mutexes.clear();
+                thread.pending_mutexes.clear();
+                break;
+            }
+            case HandleType::Mutex:
+                static_cast<Mutex&>(*object).holding_thread = nullptr;
+                break;
+            case HandleType::Timer: {
+                auto& timer = static_cast<Timer&>(*object);
+                if (running) {
+                    timer.Cancel();
+                }
+                timer.callback_id = 0;
+                break;
+            }
+            case HandleType::AddressArbiter:
+                static_cast<AddressArbiter&>(*object).waiting_threads.clear();
+                break;
+            case HandleType::SharedMemory: {
+                // The memory it holds is accounted for by the memory regions that replace these
+                auto& shared_memory = static_cast<SharedMemory&>(*object);
+                shared_memory.holding_memory.clear();
+                shared_memory.base_address = 0;
+                break;
+            }
+            case HandleType::ServerPort: {
+                auto& port = static_cast<ServerPort&>(*object);
+                port.pending_sessions.clear();
+                port.hle_handler = nullptr;
+                break;
+            }
+            case HandleType::ServerSession: {
+                auto& session = static_cast<ServerSession&>(*object);
+                session.hle_handler = nullptr;
+                session.pending_requesting_threads.clear();
+                session.currently_handling = nullptr;
+                session.mapped_buffer_context.clear();
+                if (session.parent != nullptr) {
+                    session.parent->port = nullptr;
+                }
+                break;
+            }
+            case HandleType::ClientSession: {
+                auto& session = static_cast<ClientSession&>(*object);
+                if (session.parent != nullptr) {
+                    session.parent->port = nullptr;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        // Released last, as the handle tables may hold the last reference to other objects
+        for (const auto& object : objects) {
+            if (auto process = DynamicObjectCast<Process>(object.get())) {
+                process->handle_table.Clear();
+            }
+        }
+    }
+
+    /// Replaces the objects and tables of the kernel with the loaded ones
+    void Commit() {
+        for (auto& thread_manager : kernel.thread_managers) {
+            while (thread_manager->ready_queue.PopFirst() != nullptr) {
+            }
+        }
+        std::vector<std::shared_ptr<Object>> replaced;
+        for (const auto& [id, object] : running_objects) {
+            replaced.push_back(object);
+        }
+        Detach(replaced, true);
+        kernel.restored_hle_sessions.clear();
+
+        {
+            std::lock_guard lock{kernel.objects_mutex};
+            kernel.objects.clear();
+            for (const auto& [id, object] : state_objects) {
+                object->object_id = id;
+                kernel.objects.emplace(id, object.get());
+            }
+        }
+
+        kernel.next_object_id = next_object_id;
+        kernel.next_process_id = next_process_id;
+        kernel.next_thread_id = next_thread_id;
+        kernel.memory_regions = memory_regions;
+
+        TimerManager& timer_manager = *kernel.timer_manager;
+        timer_manager.next_timer_callback_id = next_timer_callback_id;
+        timer_manager.timer_callback_table.clear();
+        for (const auto& [id, object] : state_objects) {
+            if (const auto timer = DynamicObjectCast<Timer>(object.get())) {
+                timer_manager.timer_callback_table.emplace(timer->callback_id, timer);
+            }
+        }
+
+        for (const auto& [id, object] : state_objects) {
+            const auto thread = DynamicObjectCast<Thread>(object.get());
+            if (thread == nullptr) {
+                continue;
+            }
+            switch (thread->wakeup_callback_kind) {
+            case WakeupCallbackKind::None:
+            case WakeupCallbackKind::HLE:
+                thread->wakeup_callback = nullptr;
+                break;
+            case WakeupCallbackKind::ArbitrateAddress:
+                thread->wakeup_callback = FindArbiter(*thread)->MakeTimeoutCallback();
+                break;
+            default:
+                thread->wakeup_callback =
+                    GetSVCWakeupCallback(kernel.memory, thread->wakeup_callback_kind);
+                break;
+            }
+        }
+
+        kernel.process_list = std::move(process_list);
+        for (u32 core_id = 0; core_id < cores.size(); ++core_id) {
+            CoreState& core = cores[core_id];
+            ThreadManager& thread_manager = *kernel.thread_managers[core_id];
+            thread_manager.thread_list = std::move(core.thread_list);
+            thread_manager.current_thread = std::move(core.current_thread);
+            for (Thread* thread : core.ready_queue) {
+                thread_manager.ready_queue.PushBack(thread->current_priority, thread);
+            }
+            thread_manager.wakeup_slots = std::move(core.wakeup_slots);
+            thread_manager.free_wakeup_slots = std::move(core.free_wakeup_slots);
+            kernel.core_processes[core_id] = std::move(core.process);
+        }
+
+        kernel.named_ports.clear();
+        for (auto& [name, port] : named_ports) {
+            kernel.named_ports.emplace(std::move(name), std::move(port));
+        }
+        kernel.resource_limits->resource_limits = resource_limits;
+        for (auto& [port, handler] : hle_handlers) {
+            port->hle_handler = std::move(handler);
+        }
+
+        // Sessions to HLE ports are connected to the port's handler right away. The services
+        // take over their other sessions when their state is loaded, until which the kernel keeps
+        // the sessions alive.
+        for (auto& session : hle_sessions) {
+            const auto& client_port = session->parent->port;
+            if (client_port != nullptr && client_port->server_port != nullptr &&
+                client_port->server_port->hle_handler != nullptr) {
+                client_port->server_port->hle_handler->ClientConnected(session);
+            } else {
+                kernel.restored_hle_sessions.push_back(std::move(session));
+            }
+        }
+
+        for (u32 core_id = 0; core_id < cores.size(); ++core_id) {
+            if (const auto& process = kernel.core_processes[core_id]) {
+                kernel.memory.SetCurrentPageTable(&process->vm_manager.page_table, core_id);
+            }
+        }
+    }
+
+    KernelSystem& kernel;
+    PointerWrap& p;
+    const bool loading;
+
+    /// The objects that are saved, or the objects that were loaded, keyed by saved ID
+    std::map<u32, std::shared_ptr<Object>> state_objects;
+    /// The objects of the running kernel, which loaded objects replace
+    std::map<u32, std::shared_ptr<Object>> running_objects;
+    u32 running_next_object_id = 0;
+    /// IDs of the saved objects, keyed by object
+    std::unordered_map<const Object*, u32> saved_ids;
+    std::set<const CodeSet*> needed_codesets;
+    std::vector<ServerPort*> hle_ports;
+    std::vector<std::shared_ptr<ServerSession>> hle_sessions;
+    std::vector<std::pair<ServerPort*, std::shared_ptr<SessionRequestHandler>>> hle_handlers;
+
+    u32 next_object_id = 0;
+    u32 next_process_id = 0;
+    u32 next_thread_id = 0;
+    u64 next_timer_callback_id = 0;
+    std::array<MemoryRegionInfo, 3> memory_regions;
+    std::vector<std::shared_ptr<Process>> process_list;
+    std::vector<CoreState> cores;
+    std::vector<std::pair<std::string, std::shared_ptr<ClientPort>>> named_ports;
+    std::array<std::shared_ptr<Kernel::ResourceLimit>, 4> resource_limits;
+};
+
+std::map<u32, std::shared_ptr<Object>> KernelSystem::GetLiveObjects() {
+    std::map<u32, std::shared_ptr<Object>> live_objects;
+    std::lock_guard lock{objects_mutex};
+    for (const auto& [id, object] : objects) {
+        // Objects that are being destroyed can't be referred to anymore
+        if (auto shared = object->weak_from_this().lock()) {
+            live_objects.emplace(id, std::move(shared));
+        }
+    }
+    return live_objects;
+}
+
+void KernelSystem::DoState(PointerWrap& p) {
+    StateSerializer(*this, p).DoState();
+}
+
+void KernelSystem::ReleaseRestoredHLESessions() {
+    for (const auto& session : restored_hle_sessions) {
+        if (session->hle_handler == nullptr) {
+            LOG_WARNING(Kernel, "Session {} wasn't restored by its service, closing it",
+                        session->GetName());
+        }
+    }
+    restored_hle_sessions.clear();
+}
+
+bool KernelSystem::CanSaveState() const {
+    std::lock_guard lock{objects_mutex};
+    for (const auto& [id, object] : objects) {
+        if (const auto thread = DynamicObjectCast<Thread>(object)) {
+            if (!CanRestoreWakeupCallback(*thread)) {
+                return false;
+            }
+        } else if (const auto session = DynamicObjectCast<ServerSession>(object)) {
+            if (!session->mapped_buffer_context.empty()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void KernelSystem::DoObjectReference(PointerWrap& p, std::shared_ptr<Object>& object,
+                                     std::optional<HandleType> type) {
+    u32 id = object != nullptr ? object->GetObjectId() : NO_OBJECT;
+    p.Do(id);
+
+    std::lock_guard lock{objects_mutex};
+    const auto itr = objects.find(id);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        if (object != nullptr && (itr == objects.end() || itr->second != object.get())) {
+            LOG_ERROR(Kernel, "Saving a reference to an unregistered object {}", id);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+        }
+        return;
+    }
+
+    object = nullptr;
+    if (id == NO_OBJECT || p.error == PointerWrap::ERROR_FAILURE) {
+        return;
+    }
+    if (itr != objects.end() && (!type || itr->second->GetHandleType() == *type)) {
+        object = itr->second->weak_from_this().lock();
+    }
+    if (object == nullptr) {
+        LOG_ERROR(Kernel, "Saved state refers to a missing object {}", id);
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+}
+
+} // namespace Kernel
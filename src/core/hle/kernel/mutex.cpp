@@ -36,7 +36,7 @@ std::shared_ptr<Mutex> KernelSystem::CreateMutex(bool initial_locked, std::strin
 
     // Acquire mutex with current thread if initialized as locked
     if (initial_locked)
-        mutex->Acquire(thread_manager->GetCurrentThread());
+        mutex->Acquire(GetThreadManager().GetCurrentThread());
 
     return mutex;
 }
@@ -8,9 +8,13 @@
 
 namespace Kernel {
 
-Object::Object(KernelSystem& kernel) : object_id{kernel.GenerateObjectID()} {}
+Object::Object(KernelSystem& kernel) : kernel(kernel), object_id{kernel.GenerateObjectID()} {
+    kernel.RegisterObject(*this);
+}
 
-Object::~Object() = default;
+Object::~Object() {
+    kernel.UnregisterObject(*this);
+}
 
 bool Object::IsWaitable() const {
     switch (GetHandleType()) {
@@ -43,7 +43,7 @@ public:
     explicit Object(KernelSystem& kernel);
     virtual ~Object();
 
-    /// Returns a unique identifier for the object. For debugging purposes only.
+    /// Returns a unique identifier for the object, which save states refer to the object by.
     u32 GetObjectId() const {
         return object_id.load(std::memory_order_relaxed);
     }
@@ -63,7 +63,10 @@ public:
     bool IsWaitable() const;
 
 private:
+    KernelSystem& kernel;
     std::atomic<u32> object_id;
+
+    friend class KernelSystem;
 };
 
 template <typename T>
@@ -86,4 +89,17 @@ inline std::shared_ptr<T> DynamicObjectCast(std::shared_ptr<Object> object) {
     return nullptr;
 }
 
+/**
+ * Attempts to downcast the given borrowed Object pointer to a pointer to T, without touching the
+ * reference count of the object.
+ * @return Derived pointer to the object, or `nullptr` if `object` isn't of type T.
+ */
+template <typename T>
+inline T* DynamicObjectCast(Object* object) {
+    if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
+        return static_cast<T*>(object);
+    }
+    return nullptr;
+}
+
 } // namespace Kernel
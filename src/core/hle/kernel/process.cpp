@@ -190,6 +190,8 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u32 size, VMAPermission per
                   interval.upper());
         std::fill(kernel.memory.GetFCRAMPointer(interval.lower()),
                   kernel.memory.GetFCRAMPointer(interval.upper()), 0);
+        kernel.memory.MarkHostRegionDirty(kernel.memory.GetFCRAMPointer(interval.lower()),
+                                          interval_size);
         auto vma = vm_manager.MapBackingMemory(interval_target,
                                                kernel.memory.GetFCRAMPointer(interval.lower()),
                                                interval_size, memory_state);
@@ -266,6 +268,7 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
     u8* backing_memory = kernel.memory.GetFCRAMPointer(physical_offset);
 
     std::fill(backing_memory, backing_memory + size, 0);
+    kernel.memory.MarkHostRegionDirty(backing_memory, size);
     auto vma = vm_manager.MapBackingMemory(target, backing_memory, size, MemoryState::Continuous);
     ASSERT(vma.Succeeded());
     vm_manager.Reprotect(vma.Unwrap(), perms);
@@ -126,6 +126,8 @@ public:
 
 private:
     std::array<std::shared_ptr<ResourceLimit>, 4> resource_limits;
+
+    friend class KernelSystem;
 };
 
 } // namespace Kernel
@@ -44,6 +44,7 @@ ResultVal<std::shared_ptr<SharedMemory>> KernelSystem::CreateSharedMemory(
         ASSERT_MSG(offset, "Not enough space in region to allocate shared memory!");
 
         std::fill(memory.GetFCRAMPointer(*offset), memory.GetFCRAMPointer(*offset + size), 0);
+        memory.MarkHostRegionDirty(memory.GetFCRAMPointer(*offset), size);
         shared_memory->backing_blocks = {{memory.GetFCRAMPointer(*offset), size}};
         shared_memory->holding_memory += MemoryRegionInfo::Interval(*offset, *offset + size);
         shared_memory->linear_heap_phys_offset = *offset;
@@ -89,6 +90,8 @@ std::shared_ptr<SharedMemory> KernelSystem::CreateSharedMemoryForApplet(
             {memory.GetFCRAMPointer(interval.lower()), interval.upper() - interval.lower()});
         std::fill(memory.GetFCRAMPointer(interval.lower()),
                   memory.GetFCRAMPointer(interval.upper()), 0);
+        memory.MarkHostRegionDirty(memory.GetFCRAMPointer(interval.lower()),
+                                   interval.upper() - interval.lower());
     }
     shared_memory->base_address = Memory::HEAP_VADDR + offset;
 
@@ -193,6 +196,9 @@ u8* SharedMemory::GetPointer(u32 offset) {
     if (backing_blocks.size() != 1) {
         LOG_WARNING(Kernel, "Unsafe GetPointer on discontinuous SharedMemory");
     }
+    for (const auto& [backing_memory, block_size] : backing_blocks) {
+        kernel.memory.MarkHostRegionDirty(backing_memory, block_size);
+    }
     return backing_blocks[0].first + offset;
 }
 
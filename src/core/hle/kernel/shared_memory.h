@@ -68,7 +68,8 @@ public:
     ResultCode Unmap(Process& target_process, VAddr address);
 
     /**
-     * Gets a pointer to the shared memory block
+     * Gets a pointer to the shared memory block, and marks the block dirty as the caller may write
+     * to it. Callers keeping the pointer have to mark the memory they write to later themselves.
      * @param offset Offset from the start of the shared memory block to get pointer
      * @return A pointer to the shared memory block from the specified offset
      */
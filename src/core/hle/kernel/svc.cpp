@@ -100,8 +100,13 @@ enum class SystemInfoMemUsageRegion {
 class SVC : public SVCWrapper<SVC> {
 public:
     SVC(Core::System& system);
+    ~SVC();
     void CallSVC(u32 immediate);
 
+    const SVCCallCounts& GetCallCounts() const {
+        return call_counts;
+    }
+
 private:
     Core::System& system;
     Kernel::KernelSystem& kernel;
@@ -111,8 +116,19 @@ private:
 
     // ARM interfaces
 
-    u32 GetReg(std::size_t n);
-    void SetReg(std::size_t n, u32 value);
+    // The wrappers access the register file of the running CPU directly, which is looked up once
+    // per call, instead of going through a virtual call for every argument.
+    u32 GetReg(std::size_t n) const {
+        return (*registers)[n];
+    }
+    void SetReg(std::size_t n, u32 value) {
+        (*registers)[n] = value;
+    }
+
+    std::array<u32, 16>* registers = nullptr;
+
+    /// Number of calls to each SVC
+    SVCCallCounts call_counts{};
 
     // SVC interfaces
 
@@ -279,20 +295,29 @@ void SVC::ExitProcess() {
     current_process->status = ProcessStatus::Exited;
 
     // Stop all the process threads that are currently waiting for objects.
-    auto& thread_list = kernel.GetThreadManager().GetThreadList();
-    for (auto& thread : thread_list) {
-        if (thread->owner_process != current_process.get())
-            continue;
-
-        if (thread.get() == kernel.GetThreadManager().GetCurrentThread())
-            continue;
+    for (u32 core_id = 0; core_id < kernel.GetNumCores(); ++core_id) {
+        ThreadManager& thread_manager = kernel.GetThreadManager(core_id);
+        for (auto& thread : thread_manager.GetThreadList()) {
+            if (thread->owner_process != current_process.get())
+                continue;
+
+            if (thread.get() == kernel.GetThreadManager().GetCurrentThread())
+                continue;
+
+            // A thread of this process running on another core is stopped as well, its core
+            // switches away from it on the next reschedule.
+            if (thread.get() == thread_manager.GetCurrentThread()) {
+                thread->Stop();
+                continue;
+            }
 
-        // TODO(Subv): When are the other running/ready threads terminated?
-        ASSERT_MSG(thread->status == ThreadStatus::WaitSynchAny ||
-                       thread->status == ThreadStatus::WaitSynchAll,
-                   "Exiting processes with non-waiting threads is currently unimplemented");
+            // TODO(Subv): When are the other running/ready threads terminated?
+            ASSERT_MSG(thread->status == ThreadStatus::WaitSynchAny ||
+                           thread->status == ThreadStatus::WaitSynchAll,
+                       "Exiting processes with non-waiting threads is currently unimplemented");
 
-        thread->Stop();
+            thread->Stop();
+        }
     }
 
     // Kill the current thread
@@ -308,8 +333,8 @@ ResultCode SVC::MapMemoryBlock(Handle handle, u32 addr, u32 permissions, u32 oth
               "otherpermission={}",
               handle, addr, permissions, other_permissions);
 
-    std::shared_ptr<SharedMemory> shared_memory =
-        kernel.GetCurrentProcess()->handle_table.Get<SharedMemory>(handle);
+    SharedMemory* shared_memory =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<SharedMemory>(handle);
     if (shared_memory == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -338,8 +363,7 @@ ResultCode SVC::UnmapMemoryBlock(Handle handle, u32 addr) {
     // TODO(Subv): Return E0A01BF5 if the address is not in the application's heap
 
     std::shared_ptr<Process> current_process = kernel.GetCurrentProcess();
-    std::shared_ptr<SharedMemory> shared_memory =
-        current_process->handle_table.Get<SharedMemory>(handle);
+    SharedMemory* shared_memory = current_process->handle_table.GetPointer<SharedMemory>(handle);
     if (shared_memory == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -377,8 +401,8 @@ ResultCode SVC::ConnectToPort(Handle* out_handle, VAddr port_name_address) {
 
 /// Makes a blocking IPC call to an OS service.
 ResultCode SVC::SendSyncRequest(Handle handle) {
-    std::shared_ptr<ClientSession> session =
-        kernel.GetCurrentProcess()->handle_table.Get<ClientSession>(handle);
+    ClientSession* session =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<ClientSession>(handle);
     if (session == nullptr) {
         return ERR_INVALID_HANDLE;
     }
@@ -396,9 +420,65 @@ ResultCode SVC::CloseHandle(Handle handle) {
     return kernel.GetCurrentProcess()->handle_table.Close(handle);
 }
 
+static void WaitSynchronization1Wakeup(ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
+                                       std::shared_ptr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+
+    // WaitSynchronization1 doesn't have an output index like WaitSynchronizationN, so we don't have
+    // to do anything else here.
+}
+
+static void WaitSynchronizationAllWakeup(ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
+                                         std::shared_ptr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAll);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+    // The wait_all case does not update the output index.
+}
+
+static void WaitSynchronizationAnyWakeup(ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
+                                         std::shared_ptr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+    thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
+}
+
+/// Makes a thread wait for the given objects, taking references to them
+static void WaitForObjects(Thread* thread, const std::vector<WaitObject*>& objects) {
+    thread->wait_objects.clear();
+    thread->wait_objects.reserve(objects.size());
+    for (WaitObject* object : objects) {
+        object->AddWaitingThread(SharedFrom(thread));
+        thread->wait_objects.push_back(SharedFrom(object));
+    }
+}
+
 /// Wait for a handle to synchronize, timeout after the specified nanoseconds
 ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
-    auto object = kernel.GetCurrentProcess()->handle_table.Get<WaitObject>(handle);
+    WaitObject* object = kernel.GetCurrentProcess()->handle_table.GetPointer<WaitObject>(handle);
     Thread* thread = kernel.GetThreadManager().GetCurrentThread();
 
     if (object == nullptr)
@@ -412,28 +492,15 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
         if (nano_seconds == 0)
             return RESULT_TIMEOUT;
 
-        thread->wait_objects = {object};
+        thread->wait_objects = {SharedFrom(object)};
         object->AddWaitingThread(SharedFrom(thread));
         thread->status = ThreadStatus::WaitSynchAny;
 
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
-                                     std::shared_ptr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-
-            // WaitSynchronization1 doesn't have an output index like WaitSynchronizationN, so we
-            // don't have to do anything else here.
-        };
+        thread->wakeup_callback = WaitSynchronization1Wakeup;
+        thread->wakeup_callback_kind = WakeupCallbackKind::WaitSynch1;
 
         system.PrepareReschedule();
 
@@ -464,12 +531,15 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
     if (handle_count < 0)
         return ERR_OUT_OF_RANGE;
 
-    using ObjectPtr = std::shared_ptr<WaitObject>;
+    // The objects are borrowed from the handle table, and only referenced by the thread if it
+    // has to wait for them.
+    using ObjectPtr = WaitObject*;
     std::vector<ObjectPtr> objects(handle_count);
 
+    const HandleTable& handle_table = kernel.GetCurrentProcess()->handle_table;
     for (int i = 0; i < handle_count; ++i) {
         Handle handle = memory.Read32(handles_address + i * sizeof(Handle));
-        auto object = kernel.GetCurrentProcess()->handle_table.Get<WaitObject>(handle);
+        WaitObject* object = handle_table.GetPointer<WaitObject>(handle);
         if (object == nullptr)
             return ERR_INVALID_HANDLE;
         objects[i] = object;
@@ -499,29 +569,13 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         thread->status = ThreadStatus::WaitSynchAll;
 
         // Add the thread to each of the objects' waiting threads.
-        for (auto& object : objects) {
-            object->AddWaitingThread(SharedFrom(thread));
-        }
-
-        thread->wait_objects = std::move(objects);
+        WaitForObjects(thread, objects);
 
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
-                                     std::shared_ptr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAll);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-            // The wait_all case does not update the output index.
-        };
+        thread->wakeup_callback = WaitSynchronizationAllWakeup;
+        thread->wakeup_callback_kind = WakeupCallbackKind::WaitSynchAll;
 
         system.PrepareReschedule();
 
@@ -538,7 +592,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
 
         if (itr != objects.end()) {
             // We found a ready object, acquire it and set the result value
-            WaitObject* object = itr->get();
+            WaitObject* object = *itr;
             object->Acquire(thread);
             *out = static_cast<s32>(std::distance(objects.begin(), itr));
             return RESULT_SUCCESS;
@@ -555,12 +609,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         thread->status = ThreadStatus::WaitSynchAny;
 
         // Add the thread to each of the objects' waiting threads.
-        for (std::size_t i = 0; i < objects.size(); ++i) {
-            WaitObject* object = objects[i].get();
-            object->AddWaitingThread(SharedFrom(thread));
-        }
-
-        thread->wait_objects = std::move(objects);
+        WaitForObjects(thread, objects);
 
         // Note: If no handles and no timeout were given, then the thread will deadlock, this is
         // consistent with hardware behavior.
@@ -568,20 +617,8 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
-                                     std::shared_ptr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-            thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
-        };
+        thread->wakeup_callback = WaitSynchronizationAnyWakeup;
+        thread->wakeup_callback_kind = WakeupCallbackKind::WaitSynchAny;
 
         system.PrepareReschedule();
 
@@ -622,6 +659,42 @@ static ResultCode ReceiveIPCRequest(Memory::MemorySystem& memory,
     return translation_result;
 }
 
+static void ReplyAndReceiveWakeup(Memory::MemorySystem& memory, ThreadWakeupReason reason,
+                                  std::shared_ptr<Thread> thread,
+                                  std::shared_ptr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    ResultCode result = RESULT_SUCCESS;
+
+    if (object->GetHandleType() == HandleType::ServerSession) {
+        auto server_session = DynamicObjectCast<ServerSession>(object);
+        result = ReceiveIPCRequest(memory, server_session, thread);
+    }
+
+    thread->SetWaitSynchronizationResult(result);
+    thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
+}
+
+std::function<Thread::WakeupCallback> GetSVCWakeupCallback(Memory::MemorySystem& memory,
+                                                           WakeupCallbackKind kind) {
+    switch (kind) {
+    case WakeupCallbackKind::WaitSynch1:
+        return WaitSynchronization1Wakeup;
+    case WakeupCallbackKind::WaitSynchAll:
+        return WaitSynchronizationAllWakeup;
+    case WakeupCallbackKind::WaitSynchAny:
+        return WaitSynchronizationAnyWakeup;
+    case WakeupCallbackKind::ReplyAndReceive:
+        return [&memory](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
+                         std::shared_ptr<WaitObject> object) {
+            ReplyAndReceiveWakeup(memory, reason, std::move(thread), std::move(object));
+        };
+    default:
+        return nullptr;
+    }
+}
+
 /// In a single operation, sends a IPC reply and waits for a new request.
 ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_count,
                                 Handle reply_target) {
@@ -632,14 +705,14 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
     if (handle_count < 0)
         return ERR_OUT_OF_RANGE;
 
-    using ObjectPtr = std::shared_ptr<WaitObject>;
+    using ObjectPtr = WaitObject*;
     std::vector<ObjectPtr> objects(handle_count);
 
-    std::shared_ptr<Process> current_process = kernel.GetCurrentProcess();
+    const std::shared_ptr<Process>& current_process = kernel.GetCurrentProcess();
 
     for (int i = 0; i < handle_count; ++i) {
         Handle handle = memory.Read32(handles_address + i * sizeof(Handle));
-        auto object = current_process->handle_table.Get<WaitObject>(handle);
+        WaitObject* object = current_process->handle_table.GetPointer<WaitObject>(handle);
         if (object == nullptr)
             return ERR_INVALID_HANDLE;
         objects[i] = object;
@@ -651,7 +724,8 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
     u32 cmd_buff_header = memory.Read32(thread->GetCommandBufferAddress());
     IPC::Header header{cmd_buff_header};
     if (reply_target != 0 && header.command_id != 0xFFFF) {
-        auto session = current_process->handle_table.Get<ServerSession>(reply_target);
+        ServerSession* session =
+            current_process->handle_table.GetPointer<ServerSession>(reply_target);
         if (session == nullptr)
             return ERR_INVALID_HANDLE;
 
@@ -699,7 +773,7 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
 
     if (itr != objects.end()) {
         // We found a ready object, acquire it and set the result value
-        WaitObject* object = itr->get();
+        WaitObject* object = *itr;
         object->Acquire(thread);
         *index = static_cast<s32>(std::distance(objects.begin(), itr));
 
@@ -716,29 +790,10 @@ ResultCode SVC::ReplyAndReceive(s32* index, VAddr handles_address, s32 handle_co
     thread->status = ThreadStatus::WaitSynchAny;
 
     // Add the thread to each of the objects' waiting threads.
-    for (std::size_t i = 0; i < objects.size(); ++i) {
-        WaitObject* object = objects[i].get();
-        object->AddWaitingThread(SharedFrom(thread));
-    }
-
-    thread->wait_objects = std::move(objects);
+    WaitForObjects(thread, objects);
 
-    thread->wakeup_callback = [& memory = this->memory](ThreadWakeupReason reason,
-                                                        std::shared_ptr<Thread> thread,
-                                                        std::shared_ptr<WaitObject> object) {
-        ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-        ASSERT(reason == ThreadWakeupReason::Signal);
-
-        ResultCode result = RESULT_SUCCESS;
-
-        if (object->GetHandleType() == HandleType::ServerSession) {
-            auto server_session = DynamicObjectCast<ServerSession>(object);
-            result = ReceiveIPCRequest(memory, server_session, thread);
-        }
-
-        thread->SetWaitSynchronizationResult(result);
-        thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
-    };
+    thread->wakeup_callback = GetSVCWakeupCallback(memory, WakeupCallbackKind::ReplyAndReceive);
+    thread->wakeup_callback_kind = WakeupCallbackKind::ReplyAndReceive;
 
     system.PrepareReschedule();
 
@@ -763,8 +818,8 @@ ResultCode SVC::ArbitrateAddress(Handle handle, u32 address, u32 type, u32 value
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}, address=0x{:08X}, type=0x{:08X}, value=0x{:08X}",
               handle, address, type, value);
 
-    std::shared_ptr<AddressArbiter> arbiter =
-        kernel.GetCurrentProcess()->handle_table.Get<AddressArbiter>(handle);
+    AddressArbiter* arbiter =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<AddressArbiter>(handle);
     if (arbiter == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -814,7 +869,7 @@ ResultCode SVC::GetResourceLimit(Handle* resource_limit, Handle process_handle)
     LOG_TRACE(Kernel_SVC, "called process=0x{:08X}", process_handle);
 
     std::shared_ptr<Process> current_process = kernel.GetCurrentProcess();
-    std::shared_ptr<Process> process = current_process->handle_table.Get<Process>(process_handle);
+    Process* process = current_process->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -829,8 +884,8 @@ ResultCode SVC::GetResourceLimitCurrentValues(VAddr values, Handle resource_limi
     LOG_TRACE(Kernel_SVC, "called resource_limit={:08X}, names={:08X}, name_count={}",
               resource_limit_handle, names, name_count);
 
-    std::shared_ptr<ResourceLimit> resource_limit =
-        kernel.GetCurrentProcess()->handle_table.Get<ResourceLimit>(resource_limit_handle);
+    ResourceLimit* resource_limit =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<ResourceLimit>(resource_limit_handle);
     if (resource_limit == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -849,8 +904,8 @@ ResultCode SVC::GetResourceLimitLimitValues(VAddr values, Handle resource_limit_
     LOG_TRACE(Kernel_SVC, "called resource_limit={:08X}, names={:08X}, name_count={}",
               resource_limit_handle, names, name_count);
 
-    std::shared_ptr<ResourceLimit> resource_limit =
-        kernel.GetCurrentProcess()->handle_table.Get<ResourceLimit>(resource_limit_handle);
+    ResourceLimit* resource_limit =
+        kernel.GetCurrentProcess()->handle_table.GetPointer<ResourceLimit>(resource_limit_handle);
     if (resource_limit == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -893,8 +948,14 @@ ResultCode SVC::CreateThread(Handle* out_handle, u32 entry_point, u32 arg, VAddr
                  "Newly created thread is allowed to be run in any Core, unimplemented.");
         break;
     case ThreadProcessorId1:
-        LOG_ERROR(Kernel_SVC,
-                  "Newly created thread must run in the SysCore (Core1), unimplemented.");
+    case ThreadProcessorId2:
+    case ThreadProcessorId3:
+        if (static_cast<u32>(processor_id) >= kernel.GetNumCores()) {
+            LOG_ERROR(Kernel_SVC,
+                      "Newly created thread must run in Core{}, which is not emulated. Running "
+                      "it in the AppCore instead.",
+                      processor_id);
+        }
         break;
     default:
         // TODO(bunnei): Implement support for other processor IDs
@@ -931,8 +992,7 @@ void SVC::ExitThread() {
 
 /// Gets the priority for the specified thread
 ResultCode SVC::GetThreadPriority(u32* priority, Handle handle) {
-    const std::shared_ptr<Thread> thread =
-        kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -946,7 +1006,7 @@ ResultCode SVC::SetThreadPriority(Handle handle, u32 priority) {
         return ERR_OUT_OF_RANGE;
     }
 
-    std::shared_ptr<Thread> thread = kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -984,7 +1044,7 @@ ResultCode SVC::CreateMutex(Handle* out_handle, u32 initial_locked) {
 ResultCode SVC::ReleaseMutex(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called handle=0x{:08X}", handle);
 
-    std::shared_ptr<Mutex> mutex = kernel.GetCurrentProcess()->handle_table.Get<Mutex>(handle);
+    Mutex* mutex = kernel.GetCurrentProcess()->handle_table.GetPointer<Mutex>(handle);
     if (mutex == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -995,8 +1055,7 @@ ResultCode SVC::ReleaseMutex(Handle handle) {
 ResultCode SVC::GetProcessId(u32* process_id, Handle process_handle) {
     LOG_TRACE(Kernel_SVC, "called process=0x{:08X}", process_handle);
 
-    const std::shared_ptr<Process> process =
-        kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle);
+    Process* process = kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1008,12 +1067,11 @@ ResultCode SVC::GetProcessId(u32* process_id, Handle process_handle) {
 ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x{:08X}", thread_handle);
 
-    const std::shared_ptr<Thread> thread =
-        kernel.GetCurrentProcess()->handle_table.Get<Thread>(thread_handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(thread_handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
-    const std::shared_ptr<Process> process = SharedFrom(thread->owner_process);
+    const Process* process = thread->owner_process;
 
     ASSERT_MSG(process != nullptr, "Invalid parent process for thread={:#010X}", thread_handle);
 
@@ -1025,8 +1083,7 @@ ResultCode SVC::GetProcessIdOfThread(u32* process_id, Handle thread_handle) {
 ResultCode SVC::GetThreadId(u32* thread_id, Handle handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x{:08X}", handle);
 
-    const std::shared_ptr<Thread> thread =
-        kernel.GetCurrentProcess()->handle_table.Get<Thread>(handle);
+    Thread* thread = kernel.GetCurrentProcess()->handle_table.GetPointer<Thread>(handle);
     if (thread == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1051,8 +1108,7 @@ ResultCode SVC::CreateSemaphore(Handle* out_handle, s32 initial_count, s32 max_c
 ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
     LOG_TRACE(Kernel_SVC, "called release_count={}, handle=0x{:08X}", release_count, handle);
 
-    std::shared_ptr<Semaphore> semaphore =
-        kernel.GetCurrentProcess()->handle_table.Get<Semaphore>(handle);
+    Semaphore* semaphore = kernel.GetCurrentProcess()->handle_table.GetPointer<Semaphore>(handle);
     if (semaphore == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1064,8 +1120,7 @@ ResultCode SVC::ReleaseSemaphore(s32* count, Handle handle, s32 release_count) {
 /// Query process memory
 ResultCode SVC::QueryProcessMemory(MemoryInfo* memory_info, PageInfo* page_info,
                                    Handle process_handle, u32 addr) {
-    std::shared_ptr<Process> process =
-        kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle);
+    Process* process = kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1128,7 +1183,7 @@ ResultCode SVC::DuplicateHandle(Handle* out, Handle handle) {
 ResultCode SVC::SignalEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called event=0x{:08X}", handle);
 
-    std::shared_ptr<Event> evt = kernel.GetCurrentProcess()->handle_table.Get<Event>(handle);
+    Event* evt = kernel.GetCurrentProcess()->handle_table.GetPointer<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1141,7 +1196,7 @@ ResultCode SVC::SignalEvent(Handle handle) {
 ResultCode SVC::ClearEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called event=0x{:08X}", handle);
 
-    std::shared_ptr<Event> evt = kernel.GetCurrentProcess()->handle_table.Get<Event>(handle);
+    Event* evt = kernel.GetCurrentProcess()->handle_table.GetPointer<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1164,7 +1219,7 @@ ResultCode SVC::CreateTimer(Handle* out_handle, u32 reset_type) {
 ResultCode SVC::ClearTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called timer=0x{:08X}", handle);
 
-    std::shared_ptr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1180,7 +1235,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
         return ERR_OUT_OF_RANGE_KERNEL;
     }
 
-    std::shared_ptr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1193,7 +1248,7 @@ ResultCode SVC::SetTimer(Handle handle, s64 initial, s64 interval) {
 ResultCode SVC::CancelTimer(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called timer=0x{:08X}", handle);
 
-    std::shared_ptr<Timer> timer = kernel.GetCurrentProcess()->handle_table.Get<Timer>(handle);
+    Timer* timer = kernel.GetCurrentProcess()->handle_table.GetPointer<Timer>(handle);
     if (timer == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1210,8 +1265,15 @@ void SVC::SleepThread(s64 nanoseconds) {
 
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
-    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads())
+    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads()) {
+        // A thread that keeps yielding with nobody to yield to is waiting for an event, let the
+        // CPU skip ahead to it.
+        if (system.CPU().GetIdleLoopDetector().RecordNoOpSVC()) {
+            system.CPU().RequestIdle();
+        }
         return;
+    }
+    system.CPU().GetIdleLoopDetector().ResetNoOpSVCs();
 
     // Sleep current thread and check for next thread to schedule
     thread_manager.WaitCurrentThread_Sleep();
@@ -1304,8 +1366,8 @@ ResultCode SVC::CreatePort(Handle* server_port, Handle* client_port, VAddr name_
 
 ResultCode SVC::CreateSessionToPort(Handle* out_client_session, Handle client_port_handle) {
     std::shared_ptr<Process> current_process = kernel.GetCurrentProcess();
-    std::shared_ptr<ClientPort> client_port =
-        current_process->handle_table.Get<ClientPort>(client_port_handle);
+    ClientPort* client_port =
+        current_process->handle_table.GetPointer<ClientPort>(client_port_handle);
     if (client_port == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1329,8 +1391,8 @@ ResultCode SVC::CreateSession(Handle* server_session, Handle* client_session) {
 
 ResultCode SVC::AcceptSession(Handle* out_server_session, Handle server_port_handle) {
     std::shared_ptr<Process> current_process = kernel.GetCurrentProcess();
-    std::shared_ptr<ServerPort> server_port =
-        current_process->handle_table.Get<ServerPort>(server_port_handle);
+    ServerPort* server_port =
+        current_process->handle_table.GetPointer<ServerPort>(server_port_handle);
     if (server_port == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1385,8 +1447,7 @@ ResultCode SVC::GetSystemInfo(s64* out, u32 type, s32 param) {
 ResultCode SVC::GetProcessInfo(s64* out, Handle process_handle, u32 type) {
     LOG_TRACE(Kernel_SVC, "called process=0x{:08X} type={}", process_handle, type);
 
-    std::shared_ptr<Process> process =
-        kernel.GetCurrentProcess()->handle_table.Get<Process>(process_handle);
+    Process* process = kernel.GetCurrentProcess()->handle_table.GetPointer<Process>(process_handle);
     if (process == nullptr)
         return ERR_INVALID_HANDLE;
 
@@ -1558,6 +1619,7 @@ const SVC::FunctionDef SVC::SVC_Table[] = {
 };
 
 const SVC::FunctionDef* SVC::GetSVCInfo(u32 func_num) {
+    static_assert(ARRAY_SIZE(SVC_Table) <= std::tuple_size_v<SVCCallCounts>);
     if (func_num >= ARRAY_SIZE(SVC_Table)) {
         LOG_ERROR(Kernel_SVC, "unknown svc=0x{:02X}", func_num);
         return nullptr;
@@ -1576,9 +1638,16 @@ void SVC::CallSVC(u32 immediate) {
     DEBUG_ASSERT_MSG(kernel.GetCurrentProcess()->status == ProcessStatus::Running,
                      "Running threads from exiting processes is unimplemented");
 
+    // Anything but yielding and polling the tick counter breaks a spin-wait.
+    if (immediate != 0x0A && immediate != 0x28) {
+        system.CPU().GetIdleLoopDetector().ResetNoOpSVCs();
+    }
+
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
+        ++call_counts[immediate];
         if (info->func) {
+            registers = &system.CPU().GetRegisters();
             (this->*(info->func))();
         } else {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}(..)", info->name);
@@ -1588,19 +1657,36 @@ void SVC::CallSVC(u32 immediate) {
 
 SVC::SVC(Core::System& system) : system(system), kernel(system.Kernel()), memory(system.Memory()) {}
 
-u32 SVC::GetReg(std::size_t n) {
-    return system.CPU().GetReg(static_cast<int>(n));
-}
+SVC::~SVC() {
+    std::vector<u32> called;
+    for (u32 i = 0; i < ARRAY_SIZE(SVC_Table); ++i) {
+        if (call_counts[i] != 0) {
+            called.push_back(i);
+        }
+    }
+    if (called.empty()) {
+        return;
+    }
 
-void SVC::SetReg(std::size_t n, u32 value) {
-    system.CPU().SetReg(static_cast<int>(n), value);
+    std::sort(called.begin(), called.end(),
+              [this](u32 a, u32 b) { return call_counts[a] > call_counts[b]; });
+    LOG_DEBUG(Kernel_SVC, "Most called SVCs:");
+    for (std::size_t i = 0; i < std::min<std::size_t>(called.size(), 10); ++i) {
+        LOG_DEBUG(Kernel_SVC, "  0x{:02X} {:<32} {:>12} calls", called[i],
+                  SVC_Table[called[i]].name, call_counts[called[i]]);
+    }
 }
 
-SVCContext::SVCContext(Core::System& system) : impl(std::make_unique<SVC>(system)) {}
+SVCContext::SVCContext(Core::System& system)
+    : system(system), impl(std::make_unique<SVC>(system)) {}
 SVCContext::~SVCContext() = default;
 
 void SVCContext::CallSVC(u32 immediate) {
-    impl->CallSVC(immediate);
+    system.RunOnEmulationThread([this, immediate] { impl->CallSVC(immediate); });
+}
+
+const SVCCallCounts& SVCContext::GetCallCounts() const {
+    return impl->GetCallCounts();
 }
 
 } // namespace Kernel
@@ -4,25 +4,48 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
 #include <memory>
 #include "common/common_types.h"
+#include "core/hle/kernel/thread.h"
 
 namespace Core {
 class System;
 } // namespace Core
 
+namespace Memory {
+class MemorySystem;
+} // namespace Memory
+
 namespace Kernel {
 
 class SVC;
 
+/// Number of calls to each SVC, indexed by SVC number
+using SVCCallCounts = std::array<u64, 0x80>;
+
 class SVCContext {
 public:
     SVCContext(Core::System& system);
     ~SVCContext();
+
+    /// Handles an SVC of the running core. SVCs are always handled on the emulation thread.
     void CallSVC(u32 immediate);
 
+    const SVCCallCounts& GetCallCounts() const;
+
 private:
+    Core::System& system;
     std::unique_ptr<SVC> impl;
 };
 
+/**
+ * Gets the wakeup callback that an SVC sets on the threads it makes wait, so that save states can
+ * give it back to restored threads.
+ * @returns The callback, or nullptr if the kind isn't set by an SVC.
+ */
+std::function<Thread::WakeupCallback> GetSVCWakeupCallback(Memory::MemorySystem& memory,
+                                                           WakeupCallbackKind kind);
+
 } // namespace Kernel
@@ -4,9 +4,11 @@
 
 #include <algorithm>
 #include <list>
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include "common/assert.h"
+#include "common/bit_set.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
@@ -33,14 +35,112 @@ void Thread::Acquire(Thread* thread) {
     ASSERT_MSG(!ShouldWait(thread), "object unavailable!");
 }
 
-u32 ThreadManager::NewThreadId() {
-    return next_thread_id++;
+Thread::Thread(KernelSystem& kernel, u32 core_id)
+    : WaitObject(kernel), context(kernel.GetThreadManager(core_id).NewContext()),
+      thread_manager(kernel.GetThreadManager(core_id)) {}
+Thread::~Thread() {}
+
+void ReadyQueue::PushFront(u32 priority, Thread* thread) {
+    ASSERT(!thread->in_ready_queue);
+    Level& level = levels[priority];
+    thread->ready_prev = nullptr;
+    thread->ready_next = level.first;
+    if (level.first != nullptr) {
+        level.first->ready_prev = thread;
+    } else {
+        level.last = thread;
+    }
+    level.first = thread;
+    thread->in_ready_queue = true;
+    non_empty_levels |= 1ULL << priority;
 }
 
-Thread::Thread(KernelSystem& kernel)
-    : WaitObject(kernel), context(kernel.GetThreadManager().NewContext()),
-      thread_manager(kernel.GetThreadManager()) {}
-Thread::~Thread() {}
+void ReadyQueue::PushBack(u32 priority, Thread* thread) {
+    ASSERT(!thread->in_ready_queue);
+    Level& level = levels[priority];
+    thread->ready_prev = level.last;
+    thread->ready_next = nullptr;
+    if (level.last != nullptr) {
+        level.last->ready_next = thread;
+    } else {
+        level.first = thread;
+    }
+    level.last = thread;
+    thread->in_ready_queue = true;
+    non_empty_levels |= 1ULL << priority;
+}
+
+void ReadyQueue::Remove(u32 priority, Thread* thread) {
+    if (!thread->in_ready_queue) {
+        return;
+    }
+
+    Level& level = levels[priority];
+    if (thread->ready_prev != nullptr) {
+        thread->ready_prev->ready_next = thread->ready_next;
+    } else {
+        level.first = thread->ready_next;
+    }
+    if (thread->ready_next != nullptr) {
+        thread->ready_next->ready_prev = thread->ready_prev;
+    } else {
+        level.last = thread->ready_prev;
+    }
+    thread->ready_prev = thread->ready_next = nullptr;
+    thread->in_ready_queue = false;
+
+    if (level.first == nullptr) {
+        non_empty_levels &= ~(1ULL << priority);
+    }
+}
+
+void ReadyQueue::Move(Thread* thread, u32 old_priority, u32 new_priority) {
+    Remove(old_priority, thread);
+    PushBack(new_priority, thread);
+}
+
+Thread* ReadyQueue::GetFirst() const {
+    if (non_empty_levels == 0) {
+        return nullptr;
+    }
+    return levels[Common::LeastSignificantSetBit(non_empty_levels)].first;
+}
+
+Thread* ReadyQueue::PopFirst() {
+    if (non_empty_levels == 0) {
+        return nullptr;
+    }
+    const u32 priority = Common::LeastSignificantSetBit(non_empty_levels);
+    Thread* thread = levels[priority].first;
+    Remove(priority, thread);
+    return thread;
+}
+
+Thread* ReadyQueue::PopFirstBetter(u32 priority) {
+    // Only keep the levels strictly better than the given priority
+    const u64 better_levels = non_empty_levels & ((1ULL << priority) - 1);
+    if (better_levels == 0) {
+        return nullptr;
+    }
+    const u32 best_priority = Common::LeastSignificantSetBit(better_levels);
+    Thread* thread = levels[best_priority].first;
+    Remove(best_priority, thread);
+    return thread;
+}
+
+bool ReadyQueue::Contains(const Thread* thread) const {
+    return thread->in_ready_queue;
+}
+
+std::vector<Thread*> ReadyQueue::GetThreads() const {
+    std::vector<Thread*> threads;
+    for (const Level& level : levels) {
+        for (Thread* thread = level.first; thread != nullptr; thread = thread->ready_next) {
+            threads.push_back(thread);
+        }
+    }
+    return threads;
+}
 
 Thread* ThreadManager::GetCurrentThread() const {
     return current_thread.get();
@@ -48,13 +148,14 @@ Thread* ThreadManager::GetCurrentThread() const {
 
 void Thread::Stop() {
     // Cancel any outstanding wakeup events for this thread
-    thread_manager.kernel.timing.UnscheduleEvent(thread_manager.ThreadWakeupEventType, thread_id);
-    thread_manager.wakeup_callback_table.erase(thread_id);
+    thread_manager.kernel.timing.UnscheduleEvent(thread_manager.ThreadWakeupEventType,
+                                                 GetWakeupEventUserdata());
+    thread_manager.FreeWakeupSlot(this);
 
     // Clean up thread from ready queue
     // This is only needed when the thread is termintated forcefully (SVC TerminateProcess)
     if (status == ThreadStatus::Ready) {
-        thread_manager.ready_queue.remove(current_priority, this);
+        thread_manager.ready_queue.Remove(current_priority, this);
     }
 
     status = ThreadStatus::Dead;
@@ -90,7 +191,7 @@ void ThreadManager::SwitchContext(Thread* new_thread) {
         if (previous_thread->status == ThreadStatus::Running) {
             // This is only the case when a reschedule is triggered without the current thread
             // yielding execution (i.e. an event triggered, system core time-sliced, etc)
-            ready_queue.push_front(previous_thread->current_priority, previous_thread);
+            ready_queue.PushFront(previous_thread->current_priority, previous_thread);
             previous_thread->status = ThreadStatus::Ready;
         }
     }
@@ -101,13 +202,13 @@ void ThreadManager::SwitchContext(Thread* new_thread) {
                    "Thread must be ready to become running.");
 
         // Cancel any outstanding wakeup events for this thread
-        timing.UnscheduleEvent(ThreadWakeupEventType, new_thread->thread_id);
+        timing.UnscheduleEvent(ThreadWakeupEventType, new_thread->GetWakeupEventUserdata());
 
         auto previous_process = kernel.GetCurrentProcess();
 
         current_thread = SharedFrom(new_thread);
 
-        ready_queue.remove(new_thread->current_priority, new_thread);
+        ready_queue.Remove(new_thread->current_priority, new_thread);
         new_thread->status = ThreadStatus::Running;
 
         if (previous_process.get() != current_thread->owner_process) {
@@ -132,13 +233,13 @@ Thread* ThreadManager::PopNextReadyThread() {
     if (thread && thread->status == ThreadStatus::Running) {
         // We have to do better than the current thread.
         // This call returns null when that's not possible.
-        next = ready_queue.pop_first_better(thread->current_priority);
+        next = ready_queue.PopFirstBetter(thread->current_priority);
         if (!next) {
             // Otherwise just keep going with the current thread
             next = thread;
         }
     } else {
-        next = ready_queue.pop_first();
+        next = ready_queue.PopFirst();
     }
 
     return next;
@@ -157,12 +258,30 @@ void ThreadManager::ExitCurrentThread() {
                       thread_list.end());
 }
 
-void ThreadManager::ThreadWakeupCallback(u64 thread_id, s64 cycles_late) {
-    std::shared_ptr<Thread> thread = SharedFrom(wakeup_callback_table.at(thread_id));
-    if (thread == nullptr) {
+void ThreadManager::ThreadWakeupCallback(u64 userdata, s64 cycles_late) {
+    const u32 slot = static_cast<u32>(userdata >> 32);
+    const u32 thread_id = static_cast<u32>(userdata);
+
+    Thread* target = nullptr;
+    if (slot < wakeup_slots.size() && wakeup_slots[slot] != nullptr &&
+        wakeup_slots[slot]->thread_id == thread_id) {
+        target = wakeup_slots[slot];
+    } else {
+        // Events restored from a save state may refer to a slot that is now used by another
+        // thread, so fall back to looking the thread up by its ID.
+        const auto itr =
+            std::find_if(thread_list.begin(), thread_list.end(),
+                         [thread_id](const auto& t) { return t->thread_id == thread_id; });
+        if (itr != thread_list.end()) {
+            target = itr->get();
+        }
+    }
+
+    if (target == nullptr) {
         LOG_CRITICAL(Kernel, "Callback fired for invalid thread {:08X}", thread_id);
         return;
     }
+    std::shared_ptr<Thread> thread = SharedFrom(target);
 
     if (thread->status == ThreadStatus::WaitSynchAny ||
         thread->status == ThreadStatus::WaitSynchAll || thread->status == ThreadStatus::WaitArb ||
@@ -181,13 +300,34 @@ void ThreadManager::ThreadWakeupCallback(u64 thread_id, s64 cycles_late) {
     thread->ResumeFromWait();
 }
 
+void ThreadManager::AllocateWakeupSlot(Thread* thread) {
+    if (free_wakeup_slots.empty()) {
+        thread->wakeup_slot = static_cast<u32>(wakeup_slots.size());
+        wakeup_slots.push_back(thread);
+    } else {
+        thread->wakeup_slot = free_wakeup_slots.back();
+        free_wakeup_slots.pop_back();
+        wakeup_slots[thread->wakeup_slot] = thread;
+    }
+}
+
+void ThreadManager::FreeWakeupSlot(Thread* thread) {
+    // Threads may be stopped more than once, but the slot must only be freed the first time.
+    if (thread->wakeup_slot < wakeup_slots.size() &&
+        wakeup_slots[thread->wakeup_slot] == thread) {
+        wakeup_slots[thread->wakeup_slot] = nullptr;
+        free_wakeup_slots.push_back(thread->wakeup_slot);
+    }
+}
+
 void Thread::WakeAfterDelay(s64 nanoseconds) {
     // Don't schedule a wakeup if the thread wants to wait forever
     if (nanoseconds == -1)
         return;
 
     thread_manager.kernel.timing.ScheduleEvent(nsToCycles(nanoseconds),
-                                               thread_manager.ThreadWakeupEventType, thread_id);
+                                               thread_manager.ThreadWakeupEventType,
+                                               GetWakeupEventUserdata());
 }
 
 void Thread::ResumeFromWait() {
@@ -222,8 +362,9 @@ void Thread::ResumeFromWait() {
     }
 
     wakeup_callback = nullptr;
+    wakeup_callback_kind = WakeupCallbackKind::None;
 
-    thread_manager.ready_queue.push_back(current_priority, this);
+    thread_manager.ready_queue.PushBack(current_priority, this);
     status = ThreadStatus::Ready;
     thread_manager.kernel.PrepareReschedule();
 }
@@ -238,9 +379,8 @@ void ThreadManager::DebugThreadQueue() {
     }
 
     for (auto& t : thread_list) {
-        u32 priority = ready_queue.contains(t.get());
-        if (priority != -1) {
-            LOG_DEBUG(Kernel, "0x{:02X} {}", priority, t->GetObjectId());
+        if (ready_queue.Contains(t.get())) {
+            LOG_DEBUG(Kernel, "0x{:02X} {}", t->current_priority, t->GetObjectId());
         }
     }
 }
@@ -287,6 +427,21 @@ static void ResetThreadContext(const std::unique_ptr<ARM_Interface::ThreadContex
     context->SetCpsr(USER32MODE | ((entry_point & 1) << 5)); // Usermode and THUMB mode
 }
 
+/**
+ * Picks the core on which a new thread is scheduled. Threads allowed to run on any core, and
+ * threads targeting a core that is not emulated, are placed on the AppCore.
+ */
+static u32 GetThreadCoreId(const KernelSystem& kernel, s32 processor_id,
+                           const Process& owner_process) {
+    if (processor_id == ThreadProcessorIdDefault) {
+        processor_id = owner_process.ideal_processor;
+    }
+    if (processor_id < 0 || static_cast<u32>(processor_id) >= kernel.GetNumCores()) {
+        return ThreadProcessorId0;
+    }
+    return static_cast<u32>(processor_id);
+}
+
 ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(std::string name, VAddr entry_point,
                                                               u32 priority, u32 arg,
                                                               s32 processor_id, VAddr stack_top,
@@ -297,7 +452,7 @@ ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(std::string name,
         return ERR_OUT_OF_RANGE;
     }
 
-    if (processor_id > ThreadProcessorIdMax) {
+    if (processor_id >= ThreadProcessorIdMax) {
         LOG_ERROR(Kernel_SVC, "Invalid processor id: {}", processor_id);
         return ERR_OUT_OF_RANGE_KERNEL;
     }
@@ -311,12 +466,13 @@ ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(std::string name,
                           ErrorSummary::InvalidArgument, ErrorLevel::Permanent);
     }
 
-    auto thread{std::make_shared<Thread>(*this)};
+    ThreadManager& thread_manager =
+        GetThreadManager(GetThreadCoreId(*this, processor_id, owner_process));
+    auto thread{std::make_shared<Thread>(*this, thread_manager.GetCoreId())};
 
-    thread_manager->thread_list.push_back(thread);
-    thread_manager->ready_queue.prepare(priority);
+    thread_manager.thread_list.push_back(thread);
 
-    thread->thread_id = thread_manager->NewThreadId();
+    thread->thread_id = NewThreadId();
     thread->status = ThreadStatus::Dormant;
     thread->entry_point = entry_point;
     thread->stack_top = stack_top;
@@ -326,7 +482,7 @@ ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(std::string name,
     thread->wait_objects.clear();
     thread->wait_address = 0;
     thread->name = std::move(name);
-    thread_manager->wakeup_callback_table[thread->thread_id] = thread.get();
+    thread_manager.AllocateWakeupSlot(thread.get());
     thread->owner_process = &owner_process;
 
     // Find the next available TLS index, and mark it as used
@@ -367,11 +523,9 @@ ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(std::string name,
 
     memory.ZeroBlock(owner_process, thread->tls_address, Memory::TLS_ENTRY_SIZE);
 
-    // TODO(peachum): move to ScheduleThread() when scheduler is added so selected core is used
-    // to initialize the context
     ResetThreadContext(thread->context, stack_top, entry_point, arg);
 
-    thread_manager->ready_queue.push_back(thread->current_priority, thread.get());
+    thread_manager.ready_queue.PushBack(thread->current_priority, thread.get());
     thread->status = ThreadStatus::Ready;
 
     return MakeResult<std::shared_ptr<Thread>>(std::move(thread));
@@ -382,9 +536,7 @@ void Thread::SetPriority(u32 priority) {
                "Invalid priority value.");
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
-        thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
+        thread_manager.ready_queue.Move(this, current_priority, priority);
 
     nominal_priority = current_priority = priority;
 }
@@ -401,9 +553,7 @@ void Thread::UpdatePriority() {
 void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
-        thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
+        thread_manager.ready_queue.Move(this, current_priority, priority);
     current_priority = priority;
 }
 
@@ -424,7 +574,7 @@ std::shared_ptr<Thread> SetupMainThread(KernelSystem& kernel, u32 entry_point, u
 }
 
 bool ThreadManager::HaveReadyThreads() {
-    return ready_queue.get_first() != nullptr;
+    return ready_queue.GetFirst() != nullptr;
 }
 
 void ThreadManager::Reschedule() {
@@ -463,10 +613,16 @@ VAddr Thread::GetCommandBufferAddress() const {
     return GetTLSAddress() + command_header_offset;
 }
 
-ThreadManager::ThreadManager(Kernel::KernelSystem& kernel) : kernel(kernel) {
+ThreadManager::ThreadManager(Kernel::KernelSystem& kernel, u32 core_id)
+    : kernel(kernel), core_id(core_id) {
+    // Each core keeps its own wakeup table, so every core needs its own event type.
+    std::string event_name = "ThreadWakeupCallback";
+    if (core_id != 0) {
+        event_name += std::to_string(core_id);
+    }
     ThreadWakeupEventType =
-        kernel.timing.RegisterEvent("ThreadWakeupCallback", [this](u64 thread_id, s64 cycle_late) {
-            ThreadWakeupCallback(thread_id, cycle_late);
+        kernel.timing.RegisterEvent(event_name, [this](u64 userdata, s64 cycle_late) {
+            ThreadWakeupCallback(userdata, cycle_late);
         });
 }
 
@@ -4,14 +4,13 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 #include "common/common_types.h"
-#include "common/thread_queue_list.h"
 #include "core/arm/arm_interface.h"
 #include "core/core_timing.h"
 #include "core/hle/kernel/object.h"
@@ -22,6 +21,7 @@ namespace Kernel {
 
 class Mutex;
 class Process;
+class Thread;
 
 enum ThreadPriority : u32 {
     ThreadPrioHighest = 0,      ///< Highest thread priority
@@ -35,7 +35,9 @@ enum ThreadProcessorId : s32 {
     ThreadProcessorIdAll = -1,     ///< Run thread on either core
     ThreadProcessorId0 = 0,        ///< Run thread on core 0 (AppCore)
     ThreadProcessorId1 = 1,        ///< Run thread on core 1 (SysCore)
-    ThreadProcessorIdMax = 2,      ///< Processor ID must be less than this
+    ThreadProcessorId2 = 2,        ///< Run thread on core 2 (New 3DS only)
+    ThreadProcessorId3 = 3,        ///< Run thread on core 3 (New 3DS only)
+    ThreadProcessorIdMax = 4,      ///< Processor ID must be less than this
 };
 
 enum class ThreadStatus {
@@ -56,16 +58,71 @@ enum class ThreadWakeupReason {
     Timeout // The thread was woken up due to a wait timeout.
 };
 
+/// Identifies the wakeup callback of a waiting thread, so that save states can recreate it
+enum class WakeupCallbackKind : u32 {
+    None,
+    HLE, ///< Set by an HLE service, which can't be saved
+    WaitSynch1,
+    WaitSynchAll,
+    WaitSynchAny,
+    ReplyAndReceive,
+    ArbitrateAddress,
+};
+
+/**
+ * Threads that are ready to run on a core, ordered by priority and then by the order in which
+ * they became ready. Each priority level is a list linked through the Thread objects themselves,
+ * and a bitmap of the non-empty levels finds the best one with a single bit scan, so that all
+ * operations take constant time.
+ */
+class ReadyQueue {
+public:
+    /// Adds a thread in front of the others of the same priority
+    void PushFront(u32 priority, Thread* thread);
+
+    /// Adds a thread behind the others of the same priority
+    void PushBack(u32 priority, Thread* thread);
+
+    /// Removes a thread from the queue. Does nothing if the thread is not queued.
+    void Remove(u32 priority, Thread* thread);
+
+    /// Moves a queued thread to the back of another priority level
+    void Move(Thread* thread, u32 old_priority, u32 new_priority);
+
+    /// Returns the thread that would be popped next, or nullptr if the queue is empty
+    Thread* GetFirst() const;
+
+    /// Removes and returns the first thread of the best priority, or nullptr if the queue is empty
+    Thread* PopFirst();
+
+    /// Like PopFirst(), but only returns a thread with a priority better than the given one
+    Thread* PopFirstBetter(u32 priority);
+
+    bool Contains(const Thread* thread) const;
+
+    /// Gets the queued threads in the order they would be popped
+    std::vector<Thread*> GetThreads() const;
+
+private:
+    struct Level {
+        Thread* first = nullptr;
+        Thread* last = nullptr;
+    };
+
+    std::array<Level, ThreadPrioLowest + 1> levels{};
+    /// Bit N is set when priority level N is not empty
+    u64 non_empty_levels = 0;
+};
+
 class ThreadManager {
 public:
-    explicit ThreadManager(Kernel::KernelSystem& kernel);
+    ThreadManager(Kernel::KernelSystem& kernel, u32 core_id);
     ~ThreadManager();
 
-    /**
-     * Creates a new thread ID
-     * @return The new thread ID
-     */
-    u32 NewThreadId();
+    /// Gets the ID of the CPU core this manager schedules threads on
+    u32 GetCoreId() const {
+        return core_id;
+    }
 
     /**
      * Gets the current thread
@@ -125,18 +182,27 @@ private:
 
     /**
      * Callback that will wake up the thread it was scheduled for
-     * @param thread_id The ID of the thread that's been awoken
+     * @param userdata The wakeup slot and ID of the thread that's been awoken
      * @param cycles_late The number of CPU cycles that have passed since the desired wakeup time
      */
-    void ThreadWakeupCallback(u64 thread_id, s64 cycles_late);
+    void ThreadWakeupCallback(u64 userdata, s64 cycles_late);
+
+    /// Assigns a wakeup slot to a new thread
+    void AllocateWakeupSlot(Thread* thread);
+
+    /// Frees the wakeup slot of a stopped thread
+    void FreeWakeupSlot(Thread* thread);
 
     Kernel::KernelSystem& kernel;
+    u32 core_id;
     ARM_Interface* cpu;
 
-    u32 next_thread_id = 1;
     std::shared_ptr<Thread> current_thread;
-    Common::ThreadQueueList<Thread*, ThreadPrioLowest + 1> ready_queue;
-    std::unordered_map<u64, Thread*> wakeup_callback_table;
+    ReadyQueue ready_queue;
+
+    /// Threads indexed by wakeup slot, so that wakeup events find their thread without a search
+    std::vector<Thread*> wakeup_slots;
+    std::vector<u32> free_wakeup_slots;
 
     /// Event type for the thread wake up event
     Core::TimingEventType* ThreadWakeupEventType = nullptr;
@@ -150,7 +216,7 @@ private:
 
 class Thread final : public WaitObject {
 public:
-    explicit Thread(KernelSystem&);
+    Thread(KernelSystem&, u32 core_id);
     ~Thread() override;
 
     std::string GetName() const override {
@@ -213,6 +279,11 @@ public:
      */
     void WakeAfterDelay(s64 nanoseconds);
 
+    /// Gets the userdata of the wakeup events of this thread: its wakeup slot and its ID
+    u64 GetWakeupEventUserdata() const {
+        return (static_cast<u64>(wakeup_slot) << 32) | thread_id;
+    }
+
     /**
      * Sets the result after the thread awakens (from either WaitSynchronization SVC)
      * @param result Value to set to the returned result
@@ -303,9 +374,23 @@ public:
     // was waiting via WaitSynchronizationN then the object will be the last object that became
     // available. In case of a timeout, the object will be nullptr.
     std::function<WakeupCallback> wakeup_callback;
+    /// What set the wakeup callback, which is how save states recreate it
+    WakeupCallbackKind wakeup_callback_kind = WakeupCallbackKind::None;
 
 private:
+    friend class ReadyQueue;
+    friend class ThreadManager;
+    friend class KernelSystem;
+
     ThreadManager& thread_manager;
+
+    /// Index of this thread in the wakeup slots of its ThreadManager
+    u32 wakeup_slot = 0;
+
+    // Links to the neighbouring threads of the same priority while in the ready queue
+    Thread* ready_prev = nullptr;
+    Thread* ready_next = nullptr;
+    bool in_ready_queue = false;
 };
 
 /**
@@ -50,10 +50,12 @@ void VMManager::Reset() {
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma;
     initial_vma.size = MAX_ADDRESS;
-    vma_map.emplace(initial_vma.base, initial_vma);
+    const VMAHandle initial_handle = vma_map.emplace(initial_vma.base, initial_vma).first;
+    UpdateIndex(initial_vma.base, initial_vma.size, initial_handle);
 
     page_table.pointers.fill(nullptr);
     page_table.attributes.fill(Memory::PageType::Unmapped);
+    page_table.write_tracked_pointers.clear();
 
     UpdatePageTableForVMA(initial_vma);
 }
@@ -61,9 +63,13 @@ void VMManager::Reset() {
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS) {
         return vma_map.end();
-    } else {
-        return std::prev(vma_map.upper_bound(target));
     }
+
+    const IndexEntry& entry = vma_index[target >> INDEX_ENTRY_BITS];
+    if (!entry.pages) {
+        return entry.vma;
+    }
+    return (*entry.pages)[(target >> Memory::PAGE_BITS) & (PAGES_PER_INDEX_ENTRY - 1)];
 }
 
 ResultVal<VAddr> VMManager::MapBackingMemoryToBase(VAddr base, u32 region_size, u8* memory,
@@ -325,12 +331,15 @@ VMManager::VMAIter VMManager::SplitVMA(VMAIter vma_handle, u32 offset_in_vma) {
 
     ASSERT(old_vma.CanBeMergedWith(new_vma));
 
-    return vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
+    const VMAIter new_handle = vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
+    UpdateIndex(new_vma.base, new_vma.size, new_handle);
+    return new_handle;
 }
 
 VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     const VMAIter next_vma = std::next(iter);
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
+        UpdateIndex(next_vma->second.base, next_vma->second.size, iter);
         iter->second.size += next_vma->second.size;
         vma_map.erase(next_vma);
     }
@@ -338,6 +347,7 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     if (iter != vma_map.begin()) {
         VMAIter prev_vma = std::prev(iter);
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
+            UpdateIndex(iter->second.base, iter->second.size, prev_vma);
             prev_vma->second.size += iter->second.size;
             vma_map.erase(iter);
             iter = prev_vma;
@@ -361,6 +371,37 @@ void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
     }
 }
 
+void VMManager::UpdateIndex(VAddr base, u32 size, VMAHandle vma) {
+    const VAddr end = base + size;
+    while (base != end) {
+        IndexEntry& entry = vma_index[base >> INDEX_ENTRY_BITS];
+        const VAddr entry_base = base & ~(INDEX_ENTRY_SIZE - 1);
+        const VAddr range_end = std::min(end, entry_base + INDEX_ENTRY_SIZE);
+
+        if (base == entry_base && range_end == entry_base + INDEX_ENTRY_SIZE) {
+            entry.vma = vma;
+            entry.pages.reset();
+        } else {
+            if (!entry.pages) {
+                entry.pages = std::make_unique<std::array<VMAHandle, PAGES_PER_INDEX_ENTRY>>();
+                entry.pages->fill(entry.vma);
+            }
+            const u32 first_page = (base - entry_base) >> Memory::PAGE_BITS;
+            const u32 end_page = (range_end - entry_base) >> Memory::PAGE_BITS;
+            std::fill(entry.pages->begin() + first_page, entry.pages->begin() + end_page, vma);
+
+            // Go back to referring to the VMA directly once it covers the whole entry again
+            if (std::all_of(entry.pages->begin(), entry.pages->end(),
+                            [&](VMAHandle page_vma) { return page_vma == vma; })) {
+                entry.vma = vma;
+                entry.pages.reset();
+            }
+        }
+
+        base = range_end;
+    }
+}
+
 ResultVal<std::vector<std::pair<u8*, u32>>> VMManager::GetBackingBlocksForRange(VAddr address,
                                                                                 u32 size) {
     std::vector<std::pair<u8*, u32>> backing_blocks;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <utility>
@@ -228,6 +229,29 @@ private:
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
 
+    /// Points the index entries of the given address range to the given VMA.
+    void UpdateIndex(VAddr base, u32 size, VMAHandle vma);
+
     Memory::MemorySystem& memory;
+
+    static constexpr u32 INDEX_ENTRY_BITS = 20;
+    static constexpr u32 INDEX_ENTRY_SIZE = 1 << INDEX_ENTRY_BITS;
+    static constexpr u32 PAGES_PER_INDEX_ENTRY = INDEX_ENTRY_SIZE >> Memory::PAGE_BITS;
+
+    /**
+     * One entry of the VMA index, covering 1 MiB of the address space. When a single VMA covers
+     * the whole entry it is referred to directly, otherwise `pages` holds the VMA of every page.
+     */
+    struct IndexEntry {
+        VMAHandle vma;
+        std::unique_ptr<std::array<VMAHandle, PAGES_PER_INDEX_ENTRY>> pages;
+    };
+
+    /**
+     * Two-level radix index from address to the VMA containing it, so that FindVMA doesn't have
+     * to search `vma_map`. It is updated whenever VMAs are split or merged, which only rewrites
+     * the entries covering the range that changed owner.
+     */
+    std::array<IndexEntry, MAX_ADDRESS / INDEX_ENTRY_SIZE> vma_index;
 };
 } // namespace Kernel
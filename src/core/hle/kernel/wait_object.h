@@ -63,6 +63,8 @@ private:
 
     /// Function to call when this object becomes available
     std::function<void()> hle_notifier;
+
+    friend class KernelSystem;
 };
 
 // Specialization of DynamicObjectCast for WaitObjects
@@ -74,4 +76,12 @@ inline std::shared_ptr<WaitObject> DynamicObjectCast<WaitObject>(std::shared_ptr
     return nullptr;
 }
 
+template <>
+inline WaitObject* DynamicObjectCast<WaitObject>(Object* object) {
+    if (object != nullptr && object->IsWaitable()) {
+        return static_cast<WaitObject*>(object);
+    }
+    return nullptr;
+}
+
 } // namespace Kernel
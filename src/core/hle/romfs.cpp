@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <unordered_set>
+#include <utility>
 #include "common/swap.h"
 #include "core/hle/romfs.h"
 
@@ -47,12 +49,6 @@ struct FileMetadata {
 
 static_assert(sizeof(FileMetadata) == 0x20, "FileMetadata has incorrect size");
 
-static bool MatchName(const u8* buffer, u32 name_length, const std::u16string& name) {
-    std::vector<char16_t> name_buffer(name_length / sizeof(char16_t));
-    std::memcpy(name_buffer.data(), buffer, name_length);
-    return name == std::u16string(name_buffer.begin(), name_buffer.end());
-}
-
 RomFSFile::RomFSFile(const u8* data, u64 length) : data(data), length(length) {}
 
 const u8* RomFSFile::Data() const {
@@ -63,50 +59,97 @@ u64 RomFSFile::Length() const {
     return length;
 }
 
-const RomFSFile GetFile(const u8* romfs, const std::vector<std::u16string>& path) {
+RomFSIndex::RomFSIndex(const u8* romfs, std::size_t size) {
     constexpr u32 INVALID_FIELD = 0xFFFFFFFF;
 
-    // Split path into directory names and file name
-    std::vector<std::u16string> dir_names = path;
-    dir_names.pop_back();
-    const std::u16string& file_name = path.back();
-
     Header header;
+    if (size < sizeof(header)) {
+        return;
+    }
     std::memcpy(&header, romfs, sizeof(header));
 
-    // Find directories of each level
-    DirectoryMetadata dir;
-    const u8* current_dir = romfs + header.dir_table_offset;
-    std::memcpy(&dir, current_dir, sizeof(dir));
-    for (const std::u16string& dir_name : dir_names) {
-        u32 child_dir_offset;
-        child_dir_offset = dir.first_child_dir_offset;
-        while (true) {
-            if (child_dir_offset == INVALID_FIELD) {
-                return RomFSFile();
+    // Reads the metadata entry at the given offset of a table, along with its name
+    const auto read_entry = [romfs, size](u32 table_offset, u32 table_length, u32 entry_offset,
+                                          auto& entry, std::u16string& name) {
+        const u64 start = static_cast<u64>(table_offset) + entry_offset;
+        if (entry_offset >= table_length || start + sizeof(entry) > size) {
+            return false;
+        }
+        std::memcpy(&entry, romfs + start, sizeof(entry));
+        if (start + sizeof(entry) + entry.name_length > size) {
+            return false;
+        }
+        name.resize(entry.name_length / sizeof(char16_t));
+        std::memcpy(name.data(), romfs + start + sizeof(entry), name.size() * sizeof(char16_t));
+        return true;
+    };
+
+    // Walk the directory tree from the root, which is the first entry of the directory table. Each
+    // entry is only visited once, so that loops in corrupted images end the walk.
+    std::unordered_set<u32> visited_dirs{0};
+    std::unordered_set<u32> visited_files;
+    std::vector<std::pair<u32, std::u16string>> pending_dirs{{0, u""}};
+    while (!pending_dirs.empty()) {
+        auto [dir_offset, dir_path] = std::move(pending_dirs.back());
+        pending_dirs.pop_back();
+
+        DirectoryMetadata dir;
+        std::u16string name;
+        if (!read_entry(header.dir_table_offset, header.dir_table_length, dir_offset, dir, name) ||
+            directories.count(dir_path) != 0) {
+            continue;
+        }
+        DirectoryListing& listing = directories[dir_path];
+        const std::u16string prefix = dir_path.empty() ? dir_path : dir_path + u'/';
+
+        DirectoryMetadata child;
+        for (u32 child_offset = dir.first_child_dir_offset; child_offset != INVALID_FIELD;
+             child_offset = child.next_dir_offset) {
+            if (!visited_dirs.insert(child_offset).second ||
+                !read_entry(header.dir_table_offset, header.dir_table_length, child_offset, child,
+                            name)) {
+                break;
             }
-            const u8* current_child_dir = romfs + header.dir_table_offset + child_dir_offset;
-            std::memcpy(&dir, current_child_dir, sizeof(dir));
-            if (MatchName(current_child_dir + sizeof(dir), dir.name_length, dir_name)) {
-                current_dir = current_child_dir;
+            listing.directories.push_back(name);
+            pending_dirs.emplace_back(child_offset, prefix + name);
+        }
+
+        FileMetadata file;
+        for (u32 file_offset = dir.first_file_offset; file_offset != INVALID_FIELD;
+             file_offset = file.next_file_offset) {
+            if (!visited_files.insert(file_offset).second ||
+                !read_entry(header.file_table_offset, header.file_table_length, file_offset, file,
+                            name)) {
                 break;
             }
-            child_dir_offset = dir.next_dir_offset;
+            listing.files.push_back(name);
+            const u64 data_start = static_cast<u64>(header.data_offset) + file.data_offset;
+            if (data_start <= size && file.data_length <= size - data_start) {
+                files.emplace(prefix + name, RomFSFile(romfs + data_start, file.data_length));
+            }
         }
     }
+}
+
+RomFSFile RomFSIndex::GetFile(const std::u16string& path) const {
+    const auto itr = files.find(path);
+    return itr != files.end() ? itr->second : RomFSFile();
+}
+
+const RomFSIndex::DirectoryListing* RomFSIndex::GetDirectory(const std::u16string& path) const {
+    const auto itr = directories.find(path);
+    return itr != directories.end() ? &itr->second : nullptr;
+}
 
-    // Find the file
-    FileMetadata file;
-    u32 file_offset = dir.first_file_offset;
-    while (file_offset != INVALID_FIELD) {
-        const u8* current_file = romfs + header.file_table_offset + file_offset;
-        std::memcpy(&file, current_file, sizeof(file));
-        if (MatchName(current_file + sizeof(file), file.name_length, file_name)) {
-            return RomFSFile(romfs + header.data_offset + file.data_offset, file.data_length);
+std::u16string RomFSIndex::JoinPath(const std::vector<std::u16string>& path) {
+    std::u16string joined;
+    for (const std::u16string& component : path) {
+        if (!joined.empty()) {
+            joined += u'/';
         }
-        file_offset = file.next_file_offset;
+        joined += component;
     }
-    return RomFSFile();
+    return joined;
 }
 
 } // namespace RomFS
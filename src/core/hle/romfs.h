@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
 
@@ -23,12 +24,40 @@ private:
 };
 
 /**
- * Gets a RomFSFile class to a file in a RomFS image.
- * @param romfs The pointer to the RomFS image
- * @param path A vector containing the directory names and file name of the path to the file
- * @return the RomFSFile to the file
- * @todo reimplement this with a full RomFS manager
+ * An index of the files and directories of a RomFS image, built once by walking its metadata
+ * tables, so that looking up a path is a single hash table lookup instead of a walk through the
+ * directory and file lists of every level.
+ *
+ * Paths are the directory names and file name joined with '/', without a leading separator.
+ * Corrupted images are indexed as far as they can be: entries pointing outside of the image are
+ * left out, and entries reached again through a loop are skipped.
  */
-const RomFSFile GetFile(const u8* romfs, const std::vector<std::u16string>& path);
+class RomFSIndex {
+public:
+    struct DirectoryListing {
+        std::vector<std::u16string> directories;
+        std::vector<std::u16string> files;
+    };
+
+    /**
+     * Indexes a RomFS image. Entries pointing outside of the image are left out.
+     * @param romfs The pointer to the RomFS image, which must outlive the index
+     * @param size The size of the RomFS image
+     */
+    RomFSIndex(const u8* romfs, std::size_t size);
+
+    /// Gets a file by its path, or an empty RomFSFile if there is no such file
+    RomFSFile GetFile(const std::u16string& path) const;
+
+    /// Gets the contents of a directory by its path, or nullptr if there is no such directory
+    const DirectoryListing* GetDirectory(const std::u16string& path) const;
+
+    /// Joins the components of a path the way the index expects them
+    static std::u16string JoinPath(const std::vector<std::u16string>& path);
+
+private:
+    std::unordered_map<std::u16string, RomFSFile> files;
+    std::unordered_map<std::u16string, DirectoryListing> directories;
+};
 
 } // namespace RomFS
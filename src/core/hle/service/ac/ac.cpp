@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <vector>
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/core.h"
@@ -172,6 +173,17 @@ void Module::Interface::SetClientVersion(Kernel::HLERequestContext& ctx) {
 Module::Interface::Interface(std::shared_ptr<Module> ac, const char* name, u32 max_session)
     : ServiceFramework(name, max_session), ac(std::move(ac)) {}
 
+std::shared_ptr<Module> Module::Interface::GetModule() const {
+    return ac;
+}
+
+void Module::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    p.Do(ac_connected);
+    kernel.DoObjectReference(p, close_event);
+    kernel.DoObjectReference(p, connect_event);
+    kernel.DoObjectReference(p, disconnect_event);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto ac = std::make_shared<Module>();
@@ -179,4 +191,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<AC_U>(ac)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto ac = system.ServiceManager().GetService<Module::Interface>("ac:u")) {
+        ac->GetModule()->DoState(p, system.Kernel());
+    }
+}
+
 } // namespace Service::AC
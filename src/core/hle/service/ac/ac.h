@@ -14,7 +14,8 @@ class System;
 
 namespace Kernel {
 class Event;
-}
+class KernelSystem;
+} // namespace Kernel
 
 namespace Service::AC {
 class Module final {
@@ -23,6 +24,8 @@ public:
     public:
         Interface(std::shared_ptr<Module> ac, const char* name, u32 max_session);
 
+        std::shared_ptr<Module> GetModule() const;
+
         /**
          * AC::CreateDefaultConfig service function
          *  Inputs:
@@ -141,6 +144,8 @@ public:
         std::shared_ptr<Module> ac;
     };
 
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 protected:
     struct ACConfig {
         std::array<u8, 0x200> data;
@@ -157,4 +162,7 @@ protected:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the connection state and the events of the AC module
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::AC
@@ -6,9 +6,8 @@
 #include <cinttypes>
 #include <cstddef>
 #include <cstring>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
 #include <fmt/format.h>
+#include "common/chunk_file.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
@@ -29,6 +28,7 @@
 #include "core/hle/service/am/am_net.h"
 #include "core/hle/service/am/am_sys.h"
 #include "core/hle/service/am/am_u.h"
+#include "core/hle/service/am/content_installer.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
 #include "core/loader/smdh.h"
@@ -76,13 +76,7 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
-class CIAFile::DecryptionState {
-public:
-    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
-};
-
-CIAFile::CIAFile(Service::FS::MediaType media_type)
-    : media_type(media_type), decryption_state(std::make_unique<DecryptionState>()) {}
+CIAFile::CIAFile(Service::FS::MediaType media_type) : media_type(media_type) {}
 
 CIAFile::~CIAFile() {
     Close();
@@ -132,14 +126,18 @@ ResultCode CIAFile::WriteTitleMetadata() {
     auto content_count = container.GetTitleMetadata().GetContentCount();
     content_written.resize(content_count);
 
-    if (auto title_key = container.GetTicket().GetTitleKey()) {
-        decryption_state->content.resize(content_count);
-        for (std::size_t i = 0; i < content_count; ++i) {
-            auto ctr = tmd.GetContentCTRByIndex(i);
-            decryption_state->content[i].SetKeyWithIV(title_key->data(), title_key->size(),
-                                                      ctr.data());
+    const auto title_key = container.GetTicket().GetTitleKey();
+    std::vector<ContentInstaller::Content> contents(content_count);
+    for (u16 i = 0; i < content_count; ++i) {
+        contents[i].path = GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
+        contents[i].size = container.GetContentSize(i);
+        contents[i].hash = tmd.GetContentHashByIndex(i);
+        if (title_key && (tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted)) {
+            contents[i].key = title_key;
+            contents[i].iv = tmd.GetContentCTRByIndex(i);
         }
     }
+    installer = std::make_unique<ContentInstaller>(std::move(contents));
 
     install_state = CIAInstallState::TMDLoaded;
 
@@ -166,24 +164,11 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
             // Figure out how much of this content ID we have just recieved/can write out
             u64 available_to_write = std::min(offset_max, range_max) - range_min;
 
-            // Since the incoming TMD has already been written, we can use GetTitleContentPath
-            // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
-
-            if (!file.IsOpen())
-                return FileSys::ERROR_INSUFFICIENT_SPACE;
-
-            std::vector<u8> temp(buffer + (range_min - offset),
-                                 buffer + (range_min - offset) + available_to_write);
-
-            if (tmd.GetContentTypeByIndex(static_cast<u16>(i)) &
-                FileSys::TMDContentTypeFlag::Encrypted) {
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
-            }
-
-            file.WriteBytes(temp.data(), temp.size());
+            // Decryption, hashing and writing happen on the installer's threads
+            const ResultCode result =
+                installer->Push(i, buffer + (range_min - offset), available_to_write);
+            if (result.IsError())
+                return result;
 
             // Keep tabs on how much of this content ID has been written so new range_min
             // values can be calculated.
@@ -193,6 +178,16 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
         }
     }
 
+    // Once all content is in, wait for it, so that the write completing it fails if the last
+    // content doesn't match its hash
+    for (u16 i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
+        if (content_written[i] < container.GetContentSize(i))
+            return MakeResult<std::size_t>(length);
+    }
+    const ResultCode result = installer->Finish();
+    if (result.IsError())
+        return result;
+
     return MakeResult<std::size_t>(length);
 }
 
@@ -276,7 +271,8 @@ bool CIAFile::SetSize(u64 size) const {
 }
 
 bool CIAFile::Close() const {
-    bool complete = true;
+    // Wait for the content data in flight, which also tells whether it matched the TMD
+    bool complete = !installer || installer->Finish().IsSuccess();
     for (std::size_t i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
         if (content_written[i] < container.GetContentSize(static_cast<u16>(i)))
             complete = false;
@@ -284,7 +280,7 @@ bool CIAFile::Close() const {
 
     // Install aborted
     if (!complete) {
-        LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
+        LOG_ERROR(Service_AM, "CIAFile closed prematurely or corrupted, aborting install...");
         FileUtil::DeleteDir(GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID()));
         return true;
     }
@@ -536,6 +532,10 @@ Module::Interface::Interface(std::shared_ptr<Module> am, const char* name, u32 m
 
 Module::Interface::~Interface() = default;
 
+std::shared_ptr<Module> Module::Interface::GetModule() const {
+    return am;
+}
+
 void Module::Interface::GetNumPrograms(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0001, 1, 0); // 0x00010040
     u32 media_type = rp.Pop<u8>();
@@ -1461,6 +1461,14 @@ Module::Module(Core::System& system) : system(system) {
     system_updater_mutex = system.Kernel().CreateMutex(false, "AM::SystemUpdaterMutex");
 }
 
+void Module::DoState(PointerWrap& p) {
+    system.Kernel().DoObjectReference(p, system_updater_mutex);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // The sessions of CIA installations in progress aren't restored, which ends them
+        cia_installing = false;
+    }
+}
+
 Module::~Module() = default;
 
 void InstallInterfaces(Core::System& system) {
@@ -1472,4 +1480,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<AM_U>(am)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto am = system.ServiceManager().GetService<Module::Interface>("am:u")) {
+        am->GetModule()->DoState(p);
+    }
+}
+
 } // namespace Service::AM
@@ -26,6 +26,8 @@ enum class MediaType : u32;
 
 namespace Service::AM {
 
+class ContentInstaller;
+
 namespace ErrCodes {
 enum {
     CIACurrentlyInstalling = 4,
@@ -92,8 +94,8 @@ private:
     std::vector<u64> content_written;
     Service::FS::MediaType media_type;
 
-    class DecryptionState;
-    std::unique_ptr<DecryptionState> decryption_state;
+    // Decrypts, verifies and writes the content data, created once the TMD is loaded
+    std::unique_ptr<ContentInstaller> installer;
 };
 
 /**
@@ -157,6 +159,8 @@ public:
         Interface(std::shared_ptr<Module> am, const char* name, u32 max_session);
         ~Interface();
 
+        std::shared_ptr<Module> GetModule() const;
+
     protected:
         /**
          * AM::GetNumPrograms service function
@@ -561,6 +565,8 @@ public:
         std::shared_ptr<Module> am;
     };
 
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * Scans the for titles in a storage medium for listing.
@@ -581,4 +587,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the AM module
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::AM
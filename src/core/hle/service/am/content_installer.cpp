@@ -0,0 +1,203 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
+#include "common/assert.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/errors.h"
+#include "core/hle/service/am/content_installer.h"
+
+namespace Service::AM {
+
+namespace {
+
+/// Number of chunks each stage can have waiting before the one feeding it blocks
+constexpr std::size_t QUEUE_CAPACITY = 16;
+
+/// A queue holding a limited number of elements, which blocks writers when full
+template <typename T>
+class BoundedQueue {
+public:
+    void Push(T value) {
+        std::unique_lock lock(mutex);
+        not_full.wait(lock, [this] { return queue.size() < QUEUE_CAPACITY; });
+        queue.push_back(std::move(value));
+        not_empty.notify_one();
+    }
+
+    /// Waits for an element. Returns false once the queue is closed and empty.
+    bool Pop(T& value) {
+        std::unique_lock lock(mutex);
+        not_empty.wait(lock, [this] { return !queue.empty() || closed; });
+        if (queue.empty()) {
+            return false;
+        }
+        value = std::move(queue.front());
+        queue.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    /// Lets the reader finish once the queued elements have been popped
+    void Close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<T> queue;
+    bool closed = false;
+};
+
+struct Chunk {
+    std::size_t content;
+    std::vector<u8> data;
+};
+
+} // Anonymous namespace
+
+class ContentInstaller::Pipeline {
+public:
+    explicit Pipeline(std::vector<Content> contents_)
+        : contents(std::move(contents_)), decryption(contents.size()) {
+        for (std::size_t i = 0; i < contents.size(); ++i) {
+            if (contents[i].key) {
+                decryption[i].SetKeyWithIV(contents[i].key->data(), contents[i].key->size(),
+                                           contents[i].iv.data());
+            }
+        }
+        decrypt_thread = std::thread(&Pipeline::DecryptLoop, this);
+        hash_thread = std::thread(&Pipeline::HashLoop, this);
+        write_thread = std::thread(&Pipeline::WriteLoop, this);
+    }
+
+    void DecryptLoop() {
+        std::shared_ptr<Chunk> chunk;
+        while (decrypt_queue.Pop(chunk)) {
+            if (contents[chunk->content].key) {
+                decryption[chunk->content].ProcessData(chunk->data.data(), chunk->data.data(),
+                                                       chunk->data.size());
+            }
+            hash_queue.Push(chunk);
+            write_queue.Push(std::move(chunk));
+        }
+        hash_queue.Close();
+        write_queue.Close();
+    }
+
+    void HashLoop() {
+        std::vector<CryptoPP::SHA256> hashes(contents.size());
+        std::vector<u64> hashed(contents.size());
+        std::shared_ptr<const Chunk> chunk;
+        while (hash_queue.Pop(chunk)) {
+            const std::size_t index = chunk->content;
+            hashes[index].Update(chunk->data.data(), chunk->data.size());
+            hashed[index] += chunk->data.size();
+            if (hashed[index] != contents[index].size) {
+                continue;
+            }
+
+            std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+            hashes[index].Final(hash.data());
+            if (hash != contents[index].hash) {
+                LOG_ERROR(Service_AM, "Hash mismatch in content {}", index);
+                Fail(ERROR_CONTENT_HASH_MISMATCH);
+            }
+        }
+    }
+
+    void WriteLoop() {
+        std::vector<bool> opened(contents.size());
+        std::size_t current = contents.size();
+        FileUtil::IOFile file;
+        std::shared_ptr<const Chunk> chunk;
+        while (write_queue.Pop(chunk)) {
+            // Keep draining the queue after a failure, so that the stages before don't block
+            if (failed) {
+                continue;
+            }
+            if (chunk->content != current) {
+                current = chunk->content;
+                file = FileUtil::IOFile(contents[current].path, opened[current] ? "ab" : "wb");
+                opened[current] = true;
+            }
+            if (!file.IsOpen() ||
+                file.WriteBytes(chunk->data.data(), chunk->data.size()) != chunk->data.size()) {
+                LOG_ERROR(Service_AM, "Could not write to {}", contents[current].path);
+                Fail(FileSys::ERROR_INSUFFICIENT_SPACE);
+            }
+        }
+    }
+
+    /// Records the first error of the installation, which stops any further writes
+    void Fail(ResultCode code) {
+        std::lock_guard lock(error_mutex);
+        if (!failed) {
+            error = code;
+            failed = true;
+        }
+    }
+
+    ResultCode GetError() {
+        std::lock_guard lock(error_mutex);
+        return error;
+    }
+
+    std::vector<Content> contents;
+    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> decryption;
+
+    BoundedQueue<std::shared_ptr<Chunk>> decrypt_queue;
+    BoundedQueue<std::shared_ptr<const Chunk>> hash_queue;
+    BoundedQueue<std::shared_ptr<const Chunk>> write_queue;
+    std::atomic_bool failed{false};
+    std::mutex error_mutex;
+    ResultCode error = RESULT_SUCCESS;
+    bool finished = false;
+
+    std::thread decrypt_thread;
+    std::thread hash_thread;
+    std::thread write_thread;
+};
+
+ContentInstaller::ContentInstaller(std::vector<Content> contents)
+    : pipeline(std::make_unique<Pipeline>(std::move(contents))) {}
+
+ContentInstaller::~ContentInstaller() {
+    Finish();
+}
+
+ResultCode ContentInstaller::Push(std::size_t index, const u8* data, std::size_t length) {
+    ASSERT_MSG(!pipeline->finished, "Content data pushed after the installation finished");
+    if (pipeline->failed) {
+        return pipeline->GetError();
+    }
+    pipeline->decrypt_queue.Push(std::make_shared<Chunk>(Chunk{index, {data, data + length}}));
+    return RESULT_SUCCESS;
+}
+
+ResultCode ContentInstaller::Finish() {
+    if (!pipeline->finished) {
+        pipeline->finished = true;
+        pipeline->decrypt_queue.Close();
+        pipeline->decrypt_thread.join();
+        pipeline->hash_thread.join();
+        pipeline->write_thread.join();
+    }
+    return pipeline->GetError();
+}
+
+} // namespace Service::AM
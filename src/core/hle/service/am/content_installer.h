@@ -0,0 +1,65 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/result.h"
+
+namespace Service::AM {
+
+/// Returned when the data of a content doesn't match the SHA-256 in its TMD entry
+constexpr ResultCode ERROR_CONTENT_HASH_MISMATCH(ErrorDescription::NotAuthorized, ErrorModule::AM,
+                                                 ErrorSummary::WrongArgument,
+                                                 ErrorLevel::Permanent);
+
+/**
+ * Decrypts, verifies and writes the contents of a CIA on worker threads.
+ *
+ * The caller reads the CIA and pushes its content data in order. A decryption thread decrypts it,
+ * then hands every chunk both to a hashing thread, which checks each content against the SHA-256
+ * from the TMD, and to a thread writing it to disk. The queues between the stages are bounded, so
+ * pushing blocks when the stages after it can't keep up instead of buffering the whole CIA.
+ */
+class ContentInstaller {
+public:
+    struct Content {
+        std::string path;
+        u64 size;
+        std::array<u8, 0x20> hash;
+        /// AES-CBC key of the content, if it is encrypted
+        std::optional<std::array<u8, 16>> key;
+        std::array<u8, 16> iv;
+    };
+
+    explicit ContentInstaller(std::vector<Content> contents);
+    ~ContentInstaller();
+
+    /**
+     * Queues data of a content. Each content has to be pushed from start to end, and contents
+     * in their order in the CIA, before Finish is called.
+     * @returns The error the installation has failed with, in which case the data is dropped
+     */
+    ResultCode Push(std::size_t index, const u8* data, std::size_t length);
+
+    /**
+     * Waits for the pushed data to be written, and stops the worker threads. Nothing can be
+     * pushed afterwards.
+     * @returns ERROR_CONTENT_HASH_MISMATCH if a complete content didn't match its hash,
+     *          ERROR_INSUFFICIENT_SPACE if the data couldn't be written
+     */
+    ResultCode Finish();
+
+private:
+    class Pipeline;
+    std::unique_ptr<Pipeline> pipeline;
+};
+
+} // namespace Service::AM
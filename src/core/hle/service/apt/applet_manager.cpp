@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/common_paths.h"
 #include "core/core.h"
 #include "core/hle/applets/applet.h"
@@ -589,4 +590,39 @@ AppletManager::~AppletManager() {
     HLE::Applets::Shutdown();
 }
 
+void AppletManager::DoState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    const auto DoParameter = [&](MessageParameter& parameter) {
+        p.Do(parameter.sender_id);
+        p.Do(parameter.destination_id);
+        p.Do(parameter.signal);
+        kernel.DoObjectReference(p, parameter.object);
+        p.Do(parameter.buffer);
+    };
+
+    bool has_next_parameter = next_parameter.has_value();
+    p.Do(has_next_parameter);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        next_parameter.reset();
+        if (has_next_parameter) {
+            next_parameter.emplace();
+        }
+    }
+    if (next_parameter) {
+        DoParameter(*next_parameter);
+    }
+
+    for (auto& slot_data : applet_slots) {
+        p.Do(slot_data.applet_id);
+        p.Do(slot_data.title_id);
+        p.Do(slot_data.registered);
+        p.Do(slot_data.loaded);
+        p.Do(slot_data.attributes.raw);
+        kernel.DoObjectReference(p, slot_data.notification_event);
+        kernel.DoObjectReference(p, slot_data.parameter_event);
+    }
+    p.Do(app_jump_parameters);
+    p.Do(library_applet_closing_command);
+}
+
 } // namespace Service::APT
@@ -12,6 +12,8 @@
 #include "core/hle/result.h"
 #include "core/hle/service/fs/archive.h"
 
+class PointerWrap;
+
 namespace Core {
 class System;
 }
@@ -167,6 +169,12 @@ public:
         return app_jump_parameters;
     }
 
+    /**
+     * Saves or restores the applet slots and the pending parameter. The HLE applets running in
+     * the emulator frontend aren't part of the state.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     /// Parameter data to be returned in the next call to Glance/ReceiveParameter.
     std::optional<MessageParameter> next_parameter;
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -138,8 +139,8 @@ bool Module::LoadSharedFont() {
 
     const char16_t* file_name[4] = {u"cbf_std.bcfnt.lz", u"cbf_zh-Hans-CN.bcfnt.lz",
                                     u"cbf_ko-Hang-KR.bcfnt.lz", u"cbf_zh-Hant-TW.bcfnt.lz"};
-    const RomFS::RomFSFile font_file =
-        RomFS::GetFile(romfs_buffer.data(), {file_name[font_region_code - 1]});
+    const RomFS::RomFSIndex romfs_index(romfs_buffer.data(), romfs_buffer.size());
+    const RomFS::RomFSFile font_file = romfs_index.GetFile(file_name[font_region_code - 1]);
     if (font_file.Data() == nullptr)
         return false;
 
@@ -857,6 +858,10 @@ Module::Interface::Interface(std::shared_ptr<Module> apt, const char* name, u32
 
 Module::Interface::~Interface() = default;
 
+std::shared_ptr<Module> Module::Interface::GetModule() const {
+    return apt;
+}
+
 Module::Module(Core::System& system) : system(system) {
     applet_manager = std::make_shared<AppletManager>(system);
 
@@ -872,6 +877,19 @@ Module::Module(Core::System& system) : system(system) {
 
 Module::~Module() {}
 
+void Module::DoState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    kernel.DoObjectReference(p, shared_font_mem);
+    p.Do(shared_font_loaded);
+    p.Do(shared_font_relocated);
+    kernel.DoObjectReference(p, lock);
+    p.Do(cpu_percent);
+    p.Do(unknown_ns_state_field);
+    p.Do(screen_capture_buffer);
+    p.Do(screen_capture_post_permission);
+    applet_manager->DoState(p);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto apt = std::make_shared<Module>(system);
@@ -880,4 +898,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<APT_A>(apt)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto apt = system.ServiceManager().GetService<Module::Interface>("APT:U")) {
+        apt->GetModule()->DoState(p);
+    }
+}
+
 } // namespace Service::APT
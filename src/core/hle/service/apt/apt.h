@@ -64,6 +64,8 @@ public:
         Interface(std::shared_ptr<Module> apt, const char* name, u32 max_session);
         ~Interface();
 
+        std::shared_ptr<Module> GetModule() const;
+
     protected:
         /**
          * APT::Initialize service function
@@ -596,6 +598,8 @@ public:
         bool application_reset_prepared{};
     };
 
+    void DoState(PointerWrap& p);
+
 private:
     bool LoadSharedFont();
     bool LoadLegacySharedFont();
@@ -624,4 +628,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the APT module and of its applet manager
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::APT
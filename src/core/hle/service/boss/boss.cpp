@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
@@ -903,6 +904,17 @@ void Module::Interface::GetNsDataNewFlagPrivileged(Kernel::HLERequestContext& ct
 Module::Interface::Interface(std::shared_ptr<Module> boss, const char* name, u32 max_session)
     : ServiceFramework(name, max_session), boss(std::move(boss)) {}
 
+std::shared_ptr<Module> Module::Interface::GetModule() const {
+    return boss;
+}
+
+void Module::Interface::DoState(PointerWrap& p) {
+    p.Do(new_arrival_flag);
+    p.Do(ns_data_new_flag);
+    p.Do(ns_data_new_flag_privileged);
+    p.Do(output_flag);
+}
+
 Module::Module(Core::System& system) {
     using namespace Kernel;
     // TODO: verify ResetType
@@ -910,6 +922,10 @@ Module::Module(Core::System& system) {
         system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "BOSS::task_finish_event");
 }
 
+void Module::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    kernel.DoObjectReference(p, task_finish_event);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto boss = std::make_shared<Module>(system);
@@ -917,4 +933,16 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<BOSS_U>(boss)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    auto& service_manager = system.ServiceManager();
+    auto boss_p = service_manager.GetService<Module::Interface>("boss:P");
+    auto boss_u = service_manager.GetService<Module::Interface>("boss:U");
+    if (!boss_p || !boss_u) {
+        return;
+    }
+    boss_p->DoState(p);
+    boss_u->DoState(p);
+    boss_u->GetModule()->DoState(p, system.Kernel());
+}
+
 } // namespace Service::BOSS
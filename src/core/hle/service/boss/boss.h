@@ -24,6 +24,11 @@ public:
         Interface(std::shared_ptr<Module> boss, const char* name, u32 max_session);
         ~Interface() = default;
 
+        std::shared_ptr<Module> GetModule() const;
+
+        /// Saves or restores the flags of this interface
+        void DoState(PointerWrap& p);
+
     protected:
         /**
          * BOSS::InitializeSession service function
@@ -961,10 +966,15 @@ public:
         u8 output_flag;
     };
 
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 private:
     std::shared_ptr<Kernel::Event> task_finish_event;
 };
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the BOSS module and of its interfaces
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::BOSS
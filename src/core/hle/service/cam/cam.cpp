@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include "common/bit_set.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -1053,6 +1054,88 @@ void Module::LoadCameraImplementation(CameraConfig& camera, int camera_id) {
     camera.impl->SetResolution(camera.contexts[0].resolution);
 }
 
+void Module::DoState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    const bool loading = p.GetMode() == PointerWrap::MODE_READ;
+    if (loading) {
+        for (int port_id = 0; port_id < static_cast<int>(ports.size()); ++port_id) {
+            if (ports[port_id].is_busy) {
+                CancelReceiving(port_id);
+                cameras[ports[port_id].camera_id].impl->StopCapture();
+            }
+        }
+    }
+
+    for (CameraConfig& camera : cameras) {
+        for (ContextConfig& context : camera.contexts) {
+            p.Do(context.flip);
+            p.Do(context.effect);
+            p.Do(context.format);
+            p.Do(context.resolution);
+        }
+        p.Do(camera.current_context);
+        p.Do(camera.frame_rate);
+    }
+
+    for (PortConfig& port : ports) {
+        p.Do(port.camera_id);
+        p.Do(port.is_active);
+        p.Do(port.is_pending_receiving);
+        p.Do(port.is_busy);
+        p.Do(port.is_receiving);
+        p.Do(port.is_trimming);
+        p.Do(port.x0);
+        p.Do(port.y0);
+        p.Do(port.x1);
+        p.Do(port.y1);
+        p.Do(port.transfer_bytes);
+        kernel.DoObjectReference(p, port.completion_event);
+        kernel.DoObjectReference(p, port.buffer_error_interrupt_event);
+        kernel.DoObjectReference(p, port.vsync_interrupt_event);
+
+        auto dest_process = Kernel::SharedFrom(port.dest_process);
+        kernel.DoObjectReference(p, dest_process);
+        port.dest_process = dest_process.get();
+        p.Do(port.dest);
+        p.Do(port.dest_size);
+    }
+
+    if (!loading || p.error == PointerWrap::ERROR_FAILURE) {
+        return;
+    }
+    for (int camera_id = 0; camera_id < static_cast<int>(cameras.size()); ++camera_id) {
+        CameraConfig& camera = cameras[camera_id];
+        if (camera.current_context < 0 || camera.current_context > 1 ||
+            camera.frame_rate > FrameRate::Rate_30_To_10) {
+            LOG_ERROR(Service_CAM, "Invalid configuration of camera {}", camera_id);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        const ContextConfig& context = camera.contexts[camera.current_context];
+        camera.impl->SetFlip(context.flip);
+        camera.impl->SetEffect(context.effect);
+        camera.impl->SetFormat(context.format);
+        camera.impl->SetResolution(context.resolution);
+        camera.impl->SetFrameRate(camera.frame_rate);
+    }
+    for (int port_id = 0; port_id < static_cast<int>(ports.size()); ++port_id) {
+        PortConfig& port = ports[port_id];
+        if (port.camera_id < 0 || port.camera_id >= NumCameras) {
+            LOG_ERROR(Service_CAM, "Invalid camera of port {}", port_id);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        if (port.is_busy) {
+            cameras[port.camera_id].impl->StartCapture();
+        }
+        if (port.is_receiving) {
+            // The completion event this schedules is replaced by the one of the loaded timing
+            // state, which then waits for this capture
+            StartReceiving(port_id);
+        }
+    }
+}
+
 std::shared_ptr<Module> GetModule(Core::System& system) {
     auto cam = system.ServiceManager().GetService<Service::CAM::Module::Interface>("cam:u");
     if (!cam)
@@ -1070,4 +1153,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<CAM_Q>()->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto cam = GetModule(system)) {
+        cam->DoState(p);
+    }
+}
+
 } // namespace Service::CAM
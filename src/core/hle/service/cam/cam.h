@@ -714,6 +714,12 @@ public:
         std::shared_ptr<Module> cam;
     };
 
+    /**
+     * Saves or restores the configuration of the cameras and ports. Loading restarts the captures
+     * and the receiving processes that were running, as the frames themselves aren't saved.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     void CompletionEventCallBack(u64 port_id, s64);
 
@@ -794,4 +800,7 @@ std::shared_ptr<Module> GetModule(Core::System& system);
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the CAM module
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::CAM
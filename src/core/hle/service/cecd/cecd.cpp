@@ -5,6 +5,7 @@
 #include <cryptopp/base64.h>
 #include <cryptopp/hmac.h>
 #include <cryptopp/sha.h>
+#include "common/chunk_file.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -22,6 +23,7 @@
 #include "core/hle/service/cecd/cecd_s.h"
 #include "core/hle/service/cecd/cecd_u.h"
 #include "core/hle/service/cfg/cfg.h"
+#include "core/hle/service/fs/archive.h"
 #include "fmt/format.h"
 
 namespace Service::CECD {
@@ -1351,9 +1353,45 @@ Module::SessionData::~SessionData() {
         file->Close();
 }
 
+void Module::SessionData::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    p.Do(ncch_program_id);
+    p.Do(data_path_type);
+    p.Do(open_mode.raw);
+    path.DoState(p);
+
+    bool has_file = file != nullptr;
+    p.Do(has_file);
+    if (p.GetMode() != PointerWrap::MODE_READ || !has_file ||
+        p.error == PointerWrap::ERROR_FAILURE) {
+        return;
+    }
+    FileSys::Mode mode;
+    mode.read_flag.Assign(1);
+    mode.write_flag.Assign(1);
+    mode.create_flag.Assign(1);
+    auto file_result = archive->OpenFile(path, mode);
+    if (file_result.Failed()) {
+        LOG_ERROR(Service_CECD, "Failed to reopen file: {}", path.AsString());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+    file = std::move(file_result).Unwrap();
+}
+
 Module::Interface::Interface(std::shared_ptr<Module> cecd, const char* name, u32 max_session)
     : ServiceFramework(name, max_session), cecd(std::move(cecd)) {}
 
+std::shared_ptr<Module> Module::Interface::GetModule() const {
+    return cecd;
+}
+
+std::unique_ptr<Kernel::SessionRequestHandler::SessionDataBase>
+Module::Interface::MakeSessionData() const {
+    auto session_data = std::make_unique<SessionData>();
+    session_data->archive = cecd->cecd_system_save_data_archive.get();
+    return session_data;
+}
+
 Module::Module(Core::System& system) : system(system) {
     using namespace Kernel;
     cecinfo_event = system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "CECD::cecinfo_event");
@@ -1361,7 +1399,8 @@ Module::Module(Core::System& system) : system(system) {
         system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "CECD::change_state_event");
 
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
-    FileSys::ArchiveFactory_SystemSaveData systemsavedata_factory(nand_directory);
+    FileSys::ArchiveFactory_SystemSaveData systemsavedata_factory(
+        nand_directory, system.ArchiveManager().GetWriteBackCache());
 
     // Open the SystemSaveData archive 0x00010026
     FileSys::Path archive_path(cecd_system_savedata_id);
@@ -1435,6 +1474,11 @@ Module::Module(Core::System& system) : system(system) {
 
 Module::~Module() = default;
 
+void Module::DoState(PointerWrap& p) {
+    system.Kernel().DoObjectReference(p, cecinfo_event);
+    system.Kernel().DoObjectReference(p, change_state_event);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto cecd = std::make_shared<Module>(system);
@@ -1443,4 +1487,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<CECD_U>(cecd)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto cecd = system.ServiceManager().GetService<Module::Interface>("cecd:u")) {
+        cecd->GetModule()->DoState(p);
+    }
+}
+
 } // namespace Service::CECD
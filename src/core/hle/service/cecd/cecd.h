@@ -242,12 +242,17 @@ public:
         SessionData();
         ~SessionData();
 
+        void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) override;
+
         u32 ncch_program_id;
         CecDataPathType data_path_type;
         CecOpenMode open_mode;
         FileSys::Path path;
 
         std::unique_ptr<FileSys::FileBackend> file;
+
+        /// The archive the file is reopened from when a state is loaded
+        FileSys::ArchiveBackend* archive = nullptr;
     };
 
     class Interface : public ServiceFramework<Interface, SessionData> {
@@ -255,7 +260,11 @@ public:
         Interface(std::shared_ptr<Module> cecd, const char* name, u32 max_session);
         ~Interface() = default;
 
+        std::shared_ptr<Module> GetModule() const;
+
     protected:
+        std::unique_ptr<SessionDataBase> MakeSessionData() const override;
+
         /**
          * CECD::Open service function
          *  Inputs:
@@ -588,6 +597,8 @@ public:
         std::shared_ptr<Module> cecd;
     };
 
+    void DoState(PointerWrap& p);
+
 private:
     /// String used by cecd for base64 encoding found in the sysmodule disassembly
     const std::string base64_dict =
@@ -618,4 +629,7 @@ private:
 /// Initialize CECD service(s)
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the CECD module
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::CECD
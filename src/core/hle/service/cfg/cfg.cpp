@@ -6,6 +6,7 @@
 #include <tuple>
 #include <cryptopp/osrng.h>
 #include <cryptopp/sha.h>
+#include "common/chunk_file.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -529,7 +530,10 @@ ResultCode Module::FormatConfig() {
 
 ResultCode Module::LoadConfigNANDSaveFile() {
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
-    FileSys::ArchiveFactory_SystemSaveData systemsavedata_factory(nand_directory);
+    // The config is also loaded while no system is running, so it doesn't use the write-back
+    // cache of the system. Its writes reach the host file when the file is closed.
+    FileSys::ArchiveFactory_SystemSaveData systemsavedata_factory(
+        nand_directory, std::make_shared<FileSys::WriteBackCache>(nullptr));
 
     // Open the SystemSaveData archive 0x00010017
     FileSys::Path archive_path(cfg_system_savedata_id);
@@ -579,6 +583,11 @@ Module::Module() {
 
 Module::~Module() = default;
 
+void Module::DoState(PointerWrap& p) {
+    p.DoArray(cfg_config_file_buffer.data(), static_cast<int>(cfg_config_file_buffer.size()));
+    p.Do(preferred_region_code);
+}
+
 /// Checks if the language is available in the chosen region, and returns a proper one
 static std::tuple<u32 /*region*/, SystemLanguage> AdjustLanguageInfoBlock(
     const std::vector<u32>& region_code, SystemLanguage language) {
@@ -759,6 +768,12 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<CFG_NOR>()->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto cfg = GetModule(system)) {
+        cfg->DoState(p);
+    }
+}
+
 std::string GetConsoleIdHash(Core::System& system) {
     u64_le console_id{};
     std::array<u8, sizeof(console_id)> buffer;
@@ -421,6 +421,12 @@ public:
      */
     ResultCode UpdateConfigNANDSavegame();
 
+    /**
+     * Saves or restores the config savegame memory buffer. The config savegame file isn't changed,
+     * like with the changes that aren't written to it yet.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     static constexpr u32 CONFIG_SAVEFILE_SIZE = 0x8000;
     std::array<u8, CONFIG_SAVEFILE_SIZE> cfg_config_file_buffer;
@@ -432,6 +438,9 @@ std::shared_ptr<Module> GetModule(Core::System& system);
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the CFG module
+void DoState(Core::System& system, PointerWrap& p);
+
 /// Convenience function for getting a SHA256 hash of the Console ID
 std::string GetConsoleIdHash(Core::System& system);
 
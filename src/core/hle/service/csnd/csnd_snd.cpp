@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/alignment.h"
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/result.h"
@@ -196,9 +197,23 @@ CSND_SND::CSND_SND(Core::System& system) : ServiceFramework("csnd:SND", 4), syst
     RegisterHandlers(functions);
 };
 
+void CSND_SND::DoState(PointerWrap& p) {
+    system.Kernel().DoObjectReference(p, mutex);
+    system.Kernel().DoObjectReference(p, shared_memory);
+    for (bool& capture_unit : capture_units) {
+        p.Do(capture_unit);
+    }
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     std::make_shared<CSND_SND>(system)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto csnd = system.ServiceManager().GetService<CSND_SND>("csnd:SND")) {
+        csnd->DoState(p);
+    }
+}
+
 } // namespace Service::CSND
@@ -20,6 +20,8 @@ public:
     explicit CSND_SND(Core::System& system);
     ~CSND_SND() = default;
 
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * CSND_SND::Initialize service function
@@ -187,4 +189,7 @@ private:
 /// Initializes the CSND_SND Service
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of csnd:SND
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::CSND
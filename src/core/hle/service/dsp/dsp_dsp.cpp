@@ -4,6 +4,7 @@
 
 #include "audio_core/audio_types.h"
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
@@ -390,6 +391,17 @@ DSP_DSP::~DSP_DSP() {
     pipes = {};
 }
 
+void DSP_DSP::DoState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    kernel.DoObjectReference(p, semaphore_event);
+    p.Do(preset_semaphore);
+    kernel.DoObjectReference(p, interrupt_zero);
+    kernel.DoObjectReference(p, interrupt_one);
+    for (auto& pipe : pipes) {
+        kernel.DoObjectReference(p, pipe);
+    }
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto dsp = std::make_shared<DSP_DSP>(system);
@@ -397,4 +409,11 @@ void InstallInterfaces(Core::System& system) {
     system.DSP().SetServiceToInterrupt(std::move(dsp));
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto dsp = system.ServiceManager().GetService<DSP_DSP>("dsp::DSP")) {
+        dsp->DoState(p);
+        system.DSP().DoState(p);
+    }
+}
+
 } // namespace Service::DSP
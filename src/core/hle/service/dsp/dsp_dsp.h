@@ -31,6 +31,8 @@ public:
     /// Signal interrupt on pipe
     void SignalInterrupt(InterruptType type, AudioCore::DspPipe pipe);
 
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * DSP_DSP::RecvData service function
@@ -268,4 +270,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of dsp::DSP and of the emulated DSP
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::DSP
@@ -10,9 +10,11 @@
 #include <type_traits>
 #include <utility>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "core/core.h"
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/archive_ncch.h"
@@ -23,6 +25,7 @@
 #include "core/file_sys/archive_selfncch.h"
 #include "core/file_sys/archive_systemsavedata.h"
 #include "core/file_sys/directory_backend.h"
+#include "core/file_sys/directory_snapshot.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
@@ -32,7 +35,7 @@ namespace Service::FS {
 
 ArchiveBackend* ArchiveManager::GetArchive(ArchiveHandle handle) {
     auto itr = handle_map.find(handle);
-    return (itr == handle_map.end()) ? nullptr : itr->second.get();
+    return (itr == handle_map.end()) ? nullptr : itr->second.backend.get();
 }
 
 ResultVal<ArchiveHandle> ArchiveManager::OpenArchive(ArchiveIdCode id_code,
@@ -51,7 +54,8 @@ ResultVal<ArchiveHandle> ArchiveManager::OpenArchive(ArchiveIdCode id_code,
     while (handle_map.count(next_handle) != 0) {
         ++next_handle;
     }
-    handle_map.emplace(next_handle, std::move(res));
+    handle_map.emplace(next_handle,
+                       OpenArchiveInfo{std::move(res), {id_code, archive_path, program_id}});
     return MakeResult<ArchiveHandle>(next_handle++);
 }
 
@@ -91,6 +95,8 @@ ArchiveManager::OpenFileFromArchive(ArchiveHandle archive_handle, const FileSys:
         return std::make_tuple(backend.Code(), open_timeout_ns);
 
     auto file = std::shared_ptr<File>(new File(system, std::move(backend).Unwrap(), path));
+    PruneClosed();
+    open_files.push_back({file, handle_map.at(archive_handle).origin, path, mode});
     return std::make_tuple(MakeResult<std::shared_ptr<File>>(std::move(file)), open_timeout_ns);
 }
 
@@ -184,6 +190,8 @@ ResultVal<std::shared_ptr<Directory>> ArchiveManager::OpenDirectoryFromArchive(
         return backend.Code();
 
     auto directory = std::shared_ptr<Directory>(new Directory(std::move(backend).Unwrap(), path));
+    PruneClosed();
+    open_directories.push_back({directory, handle_map.at(archive_handle).origin, path});
     return MakeResult<std::shared_ptr<Directory>>(std::move(directory));
 }
 
@@ -294,13 +302,15 @@ void ArchiveManager::RegisterArchiveTypes() {
 
     std::string sdmc_directory = FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir);
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
-    auto sdmc_factory = std::make_unique<FileSys::ArchiveFactory_SDMC>(sdmc_directory);
+    auto sdmc_factory =
+        std::make_unique<FileSys::ArchiveFactory_SDMC>(sdmc_directory, write_back_cache);
     if (sdmc_factory->Initialize())
         RegisterArchiveType(std::move(sdmc_factory), ArchiveIdCode::SDMC);
     else
         LOG_ERROR(Service_FS, "Can't instantiate SDMC archive with path {}", sdmc_directory);
 
-    auto sdmcwo_factory = std::make_unique<FileSys::ArchiveFactory_SDMCWriteOnly>(sdmc_directory);
+    auto sdmcwo_factory =
+        std::make_unique<FileSys::ArchiveFactory_SDMCWriteOnly>(sdmc_directory, write_back_cache);
     if (sdmcwo_factory->Initialize())
         RegisterArchiveType(std::move(sdmcwo_factory), ArchiveIdCode::SDMCWriteOnly);
     else
@@ -308,7 +318,8 @@ void ArchiveManager::RegisterArchiveTypes() {
                   sdmc_directory);
 
     // Create the SaveData archive
-    auto sd_savedata_source = std::make_shared<FileSys::ArchiveSource_SDSaveData>(sdmc_directory);
+    auto sd_savedata_source =
+        std::make_shared<FileSys::ArchiveSource_SDSaveData>(sdmc_directory, write_back_cache);
     auto savedata_factory = std::make_unique<FileSys::ArchiveFactory_SaveData>(sd_savedata_source);
     RegisterArchiveType(std::move(savedata_factory), ArchiveIdCode::SaveData);
     auto other_savedata_permitted_factory =
@@ -321,11 +332,13 @@ void ArchiveManager::RegisterArchiveTypes() {
                         ArchiveIdCode::OtherSaveDataGeneral);
 
     auto extsavedata_factory =
-        std::make_unique<FileSys::ArchiveFactory_ExtSaveData>(sdmc_directory, false);
+        std::make_unique<FileSys::ArchiveFactory_ExtSaveData>(sdmc_directory, false,
+                                                              write_back_cache);
     RegisterArchiveType(std::move(extsavedata_factory), ArchiveIdCode::ExtSaveData);
 
     auto sharedextsavedata_factory =
-        std::make_unique<FileSys::ArchiveFactory_ExtSaveData>(nand_directory, true);
+        std::make_unique<FileSys::ArchiveFactory_ExtSaveData>(nand_directory, true,
+                                                              write_back_cache);
     RegisterArchiveType(std::move(sharedextsavedata_factory), ArchiveIdCode::SharedExtSaveData);
 
     // Create the NCCH archive, basically a small variation of the RomFS archive
@@ -333,7 +346,8 @@ void ArchiveManager::RegisterArchiveTypes() {
     RegisterArchiveType(std::move(savedatacheck_factory), ArchiveIdCode::NCCH);
 
     auto systemsavedata_factory =
-        std::make_unique<FileSys::ArchiveFactory_SystemSaveData>(nand_directory);
+        std::make_unique<FileSys::ArchiveFactory_SystemSaveData>(nand_directory,
+                                                                 write_back_cache);
     RegisterArchiveType(std::move(systemsavedata_factory), ArchiveIdCode::SystemSaveData);
 
     auto selfncch_factory = std::make_unique<FileSys::ArchiveFactory_SelfNCCH>();
@@ -352,8 +366,171 @@ void ArchiveManager::RegisterSelfNCCH(Loader::AppLoader& app_loader) {
     factory->Register(app_loader);
 }
 
-ArchiveManager::ArchiveManager(Core::System& system) : system(system) {
+ArchiveManager::ArchiveManager(Core::System& system)
+    : system(system),
+      write_back_cache(std::make_shared<FileSys::WriteBackCache>(&system.CoreTiming())) {
+    // Snapshots are global, and could still hold the directories of a previous session
+    FileSys::ClearDirectorySnapshots();
     RegisterArchiveTypes();
 }
 
+ArchiveManager::~ArchiveManager() {
+    FileSys::ClearDirectorySnapshots();
+}
+
+void ArchiveManager::ArchiveOrigin::DoState(PointerWrap& p) {
+    p.Do(id_code);
+    path.DoState(p);
+    p.Do(program_id);
+}
+
+ResultVal<std::unique_ptr<ArchiveBackend>> ArchiveManager::ReopenArchive(
+    const ArchiveOrigin& origin) {
+    auto itr = id_code_map.find(origin.id_code);
+    if (itr == id_code_map.end()) {
+        return FileSys::ERROR_NOT_FOUND;
+    }
+    return itr->second->Open(origin.path, origin.program_id);
+}
+
+void ArchiveManager::PruneClosed() {
+    open_files.erase(std::remove_if(open_files.begin(), open_files.end(),
+                                    [](const OpenFileInfo& info) { return info.file.expired(); }),
+                     open_files.end());
+    open_directories.erase(
+        std::remove_if(open_directories.begin(), open_directories.end(),
+                       [](const OpenDirectoryInfo& info) { return info.directory.expired(); }),
+        open_directories.end());
+}
+
+void ArchiveManager::DoState(PointerWrap& p) {
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        PruneClosed();
+    }
+    DoArchivesState(p);
+    DoFilesState(p);
+    DoDirectoriesState(p);
+}
+
+void ArchiveManager::DoArchivesState(PointerWrap& p) {
+    p.Do(next_handle);
+
+    std::vector<ArchiveHandle> handles;
+    for (const auto& [handle, archive] : handle_map) {
+        handles.push_back(handle);
+    }
+    std::sort(handles.begin(), handles.end());
+    u32 num_archives = static_cast<u32>(handles.size());
+    p.Do(num_archives);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (ArchiveHandle handle : handles) {
+            p.Do(handle);
+            handle_map.at(handle).origin.DoState(p);
+        }
+        return;
+    }
+
+    std::unordered_map<ArchiveHandle, OpenArchiveInfo> archives;
+    for (u32 i = 0; i < num_archives && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        ArchiveHandle handle{};
+        ArchiveOrigin origin{};
+        p.Do(handle);
+        origin.DoState(p);
+        if (p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+        auto backend = ReopenArchive(origin);
+        if (backend.Failed()) {
+            LOG_ERROR(Service_FS, "Could not open archive 0x{:08X} {} again",
+                      static_cast<u32>(origin.id_code), origin.path.DebugStr());
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        archives.emplace(handle, OpenArchiveInfo{std::move(backend).Unwrap(), std::move(origin)});
+    }
+    handle_map = std::move(archives);
+}
+
+void ArchiveManager::DoFilesState(PointerWrap& p) {
+    Kernel::KernelSystem& kernel = system.Kernel();
+    u32 num_files = static_cast<u32>(open_files.size());
+    p.Do(num_files);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (auto& info : open_files) {
+            info.archive.DoState(p);
+            info.path.DoState(p);
+            p.Do(info.mode.hex);
+            info.file.lock()->DoSessionsState(p, kernel);
+        }
+        return;
+    }
+
+    std::vector<OpenFileInfo> files;
+    for (u32 i = 0; i < num_files && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        OpenFileInfo info{};
+        info.archive.DoState(p);
+        info.path.DoState(p);
+        p.Do(info.mode.hex);
+        if (p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+        auto archive = ReopenArchive(info.archive);
+        auto backend = archive.Succeeded() ? (*archive)->OpenFile(info.path, info.mode)
+                                           : archive.Code();
+        if (backend.Failed()) {
+            LOG_ERROR(Service_FS, "Could not open file {} again", info.path.DebugStr());
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        // The sessions of the file keep it open, like they do when it is opened by a client.
+        auto file = std::make_shared<File>(system, std::move(backend).Unwrap(), info.path);
+        file->DoSessionsState(p, kernel);
+        info.file = file;
+        files.push_back(std::move(info));
+    }
+    open_files = std::move(files);
+}
+
+void ArchiveManager::DoDirectoriesState(PointerWrap& p) {
+    Kernel::KernelSystem& kernel = system.Kernel();
+    u32 num_directories = static_cast<u32>(open_directories.size());
+    p.Do(num_directories);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        for (auto& info : open_directories) {
+            const auto directory = info.directory.lock();
+            info.archive.DoState(p);
+            info.path.DoState(p);
+            p.Do(directory->entries_read);
+            directory->DoSessionsState(p, kernel);
+        }
+        return;
+    }
+
+    std::vector<OpenDirectoryInfo> directories;
+    for (u32 i = 0; i < num_directories && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+        OpenDirectoryInfo info{};
+        u32 entries_read = 0;
+        info.archive.DoState(p);
+        info.path.DoState(p);
+        p.Do(entries_read);
+        if (p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+        auto archive = ReopenArchive(info.archive);
+        auto backend =
+            archive.Succeeded() ? (*archive)->OpenDirectory(info.path) : archive.Code();
+        if (backend.Failed()) {
+            LOG_ERROR(Service_FS, "Could not open directory {} again", info.path.DebugStr());
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        auto directory = std::make_shared<Directory>(std::move(backend).Unwrap(), info.path);
+        directory->SkipEntries(entries_read);
+        directory->DoSessionsState(p, kernel);
+        info.directory = directory;
+        directories.push_back(std::move(info));
+    }
+    open_directories = std::move(directories);
+}
+
 } // namespace Service::FS
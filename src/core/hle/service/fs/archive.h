@@ -11,10 +11,13 @@
 #include <boost/container/flat_map.hpp>
 #include "common/common_types.h"
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 #include "core/hle/service/fs/directory.h"
 #include "core/hle/service/fs/file.h"
 
+class PointerWrap;
+
 /// The unique system identifier hash, also known as ID0
 static constexpr char SYSTEM_ID[]{"00000000000000000000000000000000"};
 /// The scrambled SD card CID, also known as ID1
@@ -55,6 +58,7 @@ using FileSys::ArchiveFactory;
 class ArchiveManager {
 public:
     explicit ArchiveManager(Core::System& system);
+    ~ArchiveManager();
 
     /**
      * Opens an archive
@@ -233,9 +237,61 @@ public:
     /// Registers a new NCCH file with the SelfNCCH archive factory
     void RegisterSelfNCCH(Loader::AppLoader& app_loader);
 
+    /// Returns the cache holding the writes to host files that haven't reached them yet
+    std::shared_ptr<FileSys::WriteBackCache> GetWriteBackCache() const {
+        return write_back_cache;
+    }
+
+    /**
+     * Saves or restores the open archives, files and directories. Loading opens them again from
+     * the host, and connects the files and directories to their sessions from the restored kernel
+     * state.
+     */
+    void DoState(PointerWrap& p);
+
 private:
+    /// What an archive was opened with, to open it again when a state is loaded
+    struct ArchiveOrigin {
+        ArchiveIdCode id_code;
+        FileSys::Path path;
+        u64 program_id;
+
+        void DoState(PointerWrap& p);
+    };
+
+    struct OpenArchiveInfo {
+        std::unique_ptr<ArchiveBackend> backend;
+        ArchiveOrigin origin;
+    };
+
+    struct OpenFileInfo {
+        std::weak_ptr<File> file;
+        ArchiveOrigin archive;
+        FileSys::Path path;
+        FileSys::Mode mode;
+    };
+
+    struct OpenDirectoryInfo {
+        std::weak_ptr<Directory> directory;
+        ArchiveOrigin archive;
+        FileSys::Path path;
+    };
+
+    /// Opens an archive with the parameters it was opened with before
+    ResultVal<std::unique_ptr<ArchiveBackend>> ReopenArchive(const ArchiveOrigin& origin);
+
+    void DoArchivesState(PointerWrap& p);
+    void DoFilesState(PointerWrap& p);
+    void DoDirectoriesState(PointerWrap& p);
+
+    /// Forgets about the files and directories that were closed
+    void PruneClosed();
+
     Core::System& system;
 
+    /// Shared by every archive backed by host files, and by the files they open
+    std::shared_ptr<FileSys::WriteBackCache> write_back_cache;
+
     /**
      * Registers an Archive type, instances of which can later be opened using its IdCode.
      * @param factory File system backend interface to the archive
@@ -258,8 +314,12 @@ private:
     /**
      * Map of active archive handles to archive objects
      */
-    std::unordered_map<ArchiveHandle, std::unique_ptr<ArchiveBackend>> handle_map;
+    std::unordered_map<ArchiveHandle, OpenArchiveInfo> handle_map;
     ArchiveHandle next_handle = 1;
+
+    /// Files and directories opened from archives, which may outlive the handle of their archive
+    std::vector<OpenFileInfo> open_files;
+    std::vector<OpenDirectoryInfo> open_directories;
 };
 
 } // namespace Service::FS
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
 #include "common/logging/log.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/hle/ipc_helpers.h"
@@ -23,6 +25,18 @@ Directory::Directory(std::unique_ptr<FileSys::DirectoryBackend>&& backend,
 
 Directory::~Directory() {}
 
+void Directory::SkipEntries(u32 count) {
+    std::vector<FileSys::Entry> entries(std::min<u32>(count, 64));
+    while (entries_read < count) {
+        const u32 batch = std::min<u32>(count - entries_read, static_cast<u32>(entries.size()));
+        const u32 read = backend->Read(batch, entries.data());
+        if (read == 0) {
+            break;
+        }
+        entries_read += read;
+    }
+}
+
 void Directory::Read(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0801, 1, 2);
     u32 count = rp.Pop<u32>();
@@ -31,6 +45,7 @@ void Directory::Read(Kernel::HLERequestContext& ctx) {
     LOG_TRACE(Service_FS, "Read {}: count={}", GetName(), count);
     // Number of entries actually read
     u32 read = backend->Read(static_cast<u32>(entries.size()), entries.data());
+    entries_read += read;
     buffer.Write(entries.data(), 0, read * sizeof(FileSys::Entry));
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
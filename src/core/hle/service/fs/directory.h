@@ -21,6 +21,10 @@ public:
 
     FileSys::Path path;                                 ///< Path of the directory
     std::unique_ptr<FileSys::DirectoryBackend> backend; ///< File backend interface
+    u32 entries_read = 0;                               ///< Number of entries read by the client
+
+    /// Skips the entries that were read from the directory before it was opened again
+    void SkipEntries(u32 count);
 
 protected:
     void Read(Kernel::HLERequestContext& ctx);
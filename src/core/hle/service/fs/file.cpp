@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
@@ -15,6 +16,13 @@
 
 namespace Service::FS {
 
+void FileSessionSlot::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    p.Do(priority);
+    p.Do(offset);
+    p.Do(size);
+    p.Do(subfile);
+}
+
 File::File(Core::System& system, std::unique_ptr<FileSys::FileBackend>&& backend,
            const FileSys::Path& path)
     : ServiceFramework("", 1), path(path), backend(std::move(backend)), system(system) {
@@ -58,15 +66,25 @@ void File::Read(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
-    if (read.Failed()) {
-        rb.Push(read.Code());
-        rb.Push<u32>(0);
-    } else {
-        buffer.Write(data.data(), 0, *read);
+    // Files kept in host memory are copied to the guest buffer directly.
+    const u64 size = backend->GetSize();
+    const u32 available =
+        offset < size ? static_cast<u32>(std::min<u64>(length, size - offset)) : 0;
+    if (const u8* pointer = backend->GetDataPointer(offset, available)) {
+        buffer.Write(pointer, 0, available);
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*read));
+        rb.Push<u32>(available);
+    } else {
+        std::vector<u8> data(length);
+        ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
+        if (read.Failed()) {
+            rb.Push(read.Code());
+            rb.Push<u32>(0);
+        } else {
+            buffer.Write(data.data(), 0, *read);
+            rb.Push(RESULT_SUCCESS);
+            rb.Push<u32>(static_cast<u32>(*read));
+        }
     }
     rb.PushMappedBuffer(buffer);
 
@@ -19,6 +19,8 @@ struct FileSessionSlot : public Kernel::SessionRequestHandler::SessionDataBase {
     u64 offset;   ///< Offset that this session will start reading from.
     u64 size;     ///< Max size of the file that this session is allowed to access
     bool subfile; ///< Whether this file was opened via OpenSubFile or not.
+
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) override;
 };
 
 // TODO: File is not a real service, but it can still utilize ServiceFramework::RegisterHandlers.
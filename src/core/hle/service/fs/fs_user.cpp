@@ -4,6 +4,7 @@
 
 #include <cinttypes>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -892,8 +893,23 @@ FS_USER::FS_USER(Core::System& system)
     RegisterHandlers(functions);
 }
 
+void ClientSlot::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    p.Do(program_id);
+}
+
+void FS_USER::DoState(PointerWrap& p) {
+    p.Do(priority);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     std::make_shared<FS_USER>(system)->InstallAsService(service_manager);
 }
+
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto fs_user = system.ServiceManager().GetService<FS_USER>("fs:USER")) {
+        fs_user->DoState(p);
+    }
+    system.ArchiveManager().DoState(p);
+}
 } // namespace Service::FS
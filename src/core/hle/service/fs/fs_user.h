@@ -22,12 +22,16 @@ struct ClientSlot : public Kernel::SessionRequestHandler::SessionDataBase {
     // behaviour is modified. Since we don't emulate fs:REG mechanism, we assume the program ID is
     // the same as codeset ID and fetch from there directly.
     u64 program_id = 0;
+
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) override;
 };
 
 class FS_USER final : public ServiceFramework<FS_USER, ClientSlot> {
 public:
     explicit FS_USER(Core::System& system);
 
+    void DoState(PointerWrap& p);
+
 private:
     void Initialize(Kernel::HLERequestContext& ctx);
 
@@ -549,4 +553,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of fs:USER and of the open archives, files and directories
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::FS
@@ -33,4 +33,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<GSP_LCD>()->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto gpu = gsp_gpu.lock()) {
+        gpu->DoState(p);
+    }
+}
+
 } // namespace Service::GSP
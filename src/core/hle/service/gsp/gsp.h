@@ -32,4 +32,7 @@ FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index);
 void SignalInterrupt(InterruptId interrupt_id);
 
 void InstallInterfaces(Core::System& system);
+
+/// Saves or restores the state of gsp::Gpu
+void DoState(Core::System& system, PointerWrap& p);
 } // namespace Service::GSP
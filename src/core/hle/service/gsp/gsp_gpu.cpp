@@ -4,6 +4,7 @@
 
 #include <vector>
 #include "common/bit_field.h"
+#include "common/chunk_file.h"
 #include "common/microprofile.h"
 #include "common/swap.h"
 #include "core/core.h"
@@ -775,6 +776,26 @@ SessionData* GSP_GPU::FindRegisteredThreadData(u32 thread_id) {
     return nullptr;
 }
 
+void GSP_GPU::DoState(PointerWrap& p) {
+    system.Kernel().DoObjectReference(p, shared_memory);
+    p.Do(active_thread_id);
+    p.Do(first_initialization);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        return;
+    }
+
+    used_thread_ids.fill(false);
+    for (const auto& session_info : connected_sessions) {
+        const u32 thread_id = static_cast<SessionData*>(session_info.data.get())->thread_id;
+        if (used_thread_ids[thread_id]) {
+            LOG_ERROR(Service_GSP, "Thread id {} is used by several sessions", thread_id);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        used_thread_ids[thread_id] = true;
+    }
+}
+
 GSP_GPU::GSP_GPU(Core::System& system) : ServiceFramework("gsp::Gpu", 2), system(system) {
     static const FunctionInfo functions[] = {
         {0x00010082, &GSP_GPU::WriteHWRegs, "WriteHWRegs"},
@@ -834,4 +855,18 @@ SessionData::~SessionData() {
     used_thread_ids[thread_id] = false;
 }
 
+void SessionData::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    kernel.DoObjectReference(p, interrupt_event);
+    // The thread id is only replaced by a valid one, as it indexes the ids in use
+    u32 saved_thread_id = thread_id;
+    p.Do(saved_thread_id);
+    if (saved_thread_id >= MaxGSPThreads) {
+        LOG_ERROR(Service_GSP, "Invalid thread id {}", saved_thread_id);
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+    thread_id = saved_thread_id;
+    p.Do(registered);
+}
+
 } // namespace Service::GSP
@@ -187,6 +187,8 @@ struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
     SessionData();
     ~SessionData();
 
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) override;
+
     /// Event triggered when GSP interrupt has been signalled
     std::shared_ptr<Kernel::Event> interrupt_event;
     /// Thread index into interrupt relay queue
@@ -218,6 +220,12 @@ public:
      */
     FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index);
 
+    /**
+     * Saves or restores the state of the service. Must be called after the state of its sessions
+     * was restored, as the thread ids in use are taken from them.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * Signals that the specified interrupt type has occurred to userland code for the specified GSP
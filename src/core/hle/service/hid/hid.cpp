@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/3ds.h"
 #include "core/core.h"
@@ -410,6 +411,23 @@ const PadState& Module::GetState() const {
     return state;
 }
 
+void Module::DoState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    kernel.DoObjectReference(p, shared_mem);
+    kernel.DoObjectReference(p, event_pad_or_touch_1);
+    kernel.DoObjectReference(p, event_pad_or_touch_2);
+    kernel.DoObjectReference(p, event_accelerometer);
+    kernel.DoObjectReference(p, event_gyroscope);
+    kernel.DoObjectReference(p, event_debug_pad);
+    p.Do(state.hex);
+    p.Do(next_pad_index);
+    p.Do(next_touch_index);
+    p.Do(next_accelerometer_index);
+    p.Do(next_gyroscope_index);
+    p.Do(enable_accelerometer_count);
+    p.Do(enable_gyroscope_count);
+}
+
 std::shared_ptr<Module> GetModule(Core::System& system) {
     auto hid = system.ServiceManager().GetService<Service::HID::Module::Interface>("hid:USER");
     if (!hid)
@@ -424,4 +442,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<Spvr>(hid)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto hid = GetModule(system)) {
+        hid->DoState(p);
+    }
+}
+
 } // namespace Service::HID
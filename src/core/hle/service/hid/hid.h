@@ -302,6 +302,8 @@ public:
 
     const PadState& GetState() const;
 
+    void DoState(PointerWrap& p);
+
 private:
     void LoadInputDevices();
     void UpdatePadCallback(u64 userdata, s64 cycles_late);
@@ -347,4 +349,7 @@ private:
 std::shared_ptr<Module> GetModule(Core::System& system);
 
 void InstallInterfaces(Core::System& system);
+
+/// Saves or restores the state of the HID module
+void DoState(Core::System& system, PointerWrap& p);
 } // namespace Service::HID
@@ -2,8 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/file_sys/archive_ncch.h"
 #include "core/file_sys/file_backend.h"
@@ -739,8 +741,8 @@ void HTTP_C::DecryptClCertA() {
     }
     HW::AES::AESKey key = HW::AES::GetNormalKey(HW::AES::KeySlotID::SSLKey);
 
-    const RomFS::RomFSFile cert_file =
-        RomFS::GetFile(romfs_buffer.data(), {u"ctr-common-1-cert.bin"});
+    const RomFS::RomFSIndex romfs_index(romfs_buffer.data(), romfs_buffer.size());
+    const RomFS::RomFSFile cert_file = romfs_index.GetFile(u"ctr-common-1-cert.bin");
     if (cert_file.Length() == 0) {
         LOG_ERROR(Service_HTTP, "ctr-common-1-cert.bin missing");
         return;
@@ -761,8 +763,7 @@ void HTTP_C::DecryptClCertA() {
     aes_cert.ProcessData(cert_data.data(), cert_file.Data() + iv_length,
                          cert_file.Length() - iv_length);
 
-    const RomFS::RomFSFile key_file =
-        RomFS::GetFile(romfs_buffer.data(), {u"ctr-common-1-key.bin"});
+    const RomFS::RomFSFile key_file = romfs_index.GetFile(u"ctr-common-1-key.bin");
     if (key_file.Length() == 0) {
         LOG_ERROR(Service_HTTP, "ctr-common-1-key.bin missing");
         return;
@@ -787,6 +788,133 @@ void HTTP_C::DecryptClCertA() {
     ClCertA.init = true;
 }
 
+void SessionData::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    bool has_http_context = current_http_context.has_value();
+    Context::Handle http_context = current_http_context.value_or(0);
+    p.Do(has_http_context);
+    p.Do(http_context);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        current_http_context.reset();
+        if (has_http_context) {
+            current_http_context = http_context;
+        }
+    }
+    p.Do(session_id);
+    p.Do(num_http_contexts);
+    p.Do(num_client_certs);
+    p.Do(initialized);
+}
+
+void HTTP_C::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    const bool loading = p.GetMode() == PointerWrap::MODE_READ;
+    kernel.DoObjectReference(p, shared_memory);
+    p.Do(session_counter);
+    p.Do(context_counter);
+    p.Do(client_certs_counter);
+
+    // The contexts are saved in handle order, so that saving the same state gives the same data
+    const auto SortedHandles = [](const auto& map) {
+        std::vector<u32> handles;
+        for (const auto& [handle, value] : map) {
+            handles.push_back(handle);
+        }
+        std::sort(handles.begin(), handles.end());
+        return handles;
+    };
+
+    std::vector<u32> cert_handles = SortedHandles(client_certs);
+    p.Do(cert_handles);
+    if (loading) {
+        client_certs.clear();
+    }
+    for (const u32 handle : cert_handles) {
+        auto& cert = client_certs[handle];
+        if (loading) {
+            cert = std::make_shared<ClientCertContext>();
+        }
+        p.Do(cert->handle);
+        p.Do(cert->session_id);
+        p.Do(cert->cert_id);
+        p.Do(cert->certificate);
+        p.Do(cert->private_key);
+    }
+
+    std::vector<u32> context_handles = SortedHandles(contexts);
+    p.Do(context_handles);
+    if (loading) {
+        contexts.clear();
+    }
+    for (const u32 handle : context_handles) {
+        Context& context = contexts[handle];
+        p.Do(context.handle);
+        p.Do(context.session_id);
+        p.Do(context.url);
+        p.Do(context.method);
+        p.Do(context.state);
+
+        bool has_proxy = context.proxy.has_value();
+        p.Do(has_proxy);
+        if (loading && has_proxy) {
+            context.proxy.emplace();
+        }
+        if (has_proxy) {
+            p.Do(context.proxy->url);
+            p.Do(context.proxy->username);
+            p.Do(context.proxy->password);
+            p.Do(context.proxy->port);
+        }
+
+        bool has_basic_auth = context.basic_auth.has_value();
+        p.Do(has_basic_auth);
+        if (loading && has_basic_auth) {
+            context.basic_auth.emplace();
+        }
+        if (has_basic_auth) {
+            p.Do(context.basic_auth->username);
+            p.Do(context.basic_auth->password);
+        }
+
+        p.Do(context.ssl_config.options);
+        const auto client_cert = context.ssl_config.client_cert_ctx.lock();
+        bool has_client_cert = client_cert != nullptr;
+        u32 client_cert_handle = has_client_cert ? client_cert->handle : 0;
+        p.Do(has_client_cert);
+        p.Do(client_cert_handle);
+        if (loading && has_client_cert) {
+            const auto itr = client_certs.find(client_cert_handle);
+            if (itr == client_certs.end()) {
+                LOG_ERROR(Service_HTTP, "Context {} refers to a missing ClientCert context {}",
+                          handle, client_cert_handle);
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                return;
+            }
+            context.ssl_config.client_cert_ctx = itr->second;
+        }
+
+        p.Do(context.socket_buffer_size);
+        const auto DoPairs = [&](auto& pairs) {
+            u32 count = static_cast<u32>(pairs.size());
+            p.Do(count);
+            if (loading) {
+                pairs.clear();
+                for (u32 i = 0; i < count && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+                    std::string name, value;
+                    p.Do(name);
+                    p.Do(value);
+                    pairs.emplace_back(std::move(name), std::move(value));
+                }
+                return;
+            }
+            for (auto& pair : pairs) {
+                p.Do(pair.name);
+                p.Do(pair.value);
+            }
+        };
+        DoPairs(context.headers);
+        DoPairs(context.post_data);
+    }
+}
+
 HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
     static const FunctionInfo functions[] = {
         {0x00010044, &HTTP_C::Initialize, "Initialize"},
@@ -855,4 +983,10 @@ void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     std::make_shared<HTTP_C>()->InstallAsService(service_manager);
 }
+
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto http = system.ServiceManager().GetService<HTTP_C>("http:C")) {
+        http->DoState(p, system.Kernel());
+    }
+}
 } // namespace Service::HTTP
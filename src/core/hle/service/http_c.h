@@ -126,6 +126,8 @@ public:
 };
 
 struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) override;
+
     /// The HTTP context that is currently bound to this session, this can be empty if no context
     /// has been bound. Certain commands can only be called on a session with a bound context.
     std::optional<Context::Handle> current_http_context;
@@ -146,6 +148,12 @@ class HTTP_C final : public ServiceFramework<HTTP_C, SessionData> {
 public:
     HTTP_C();
 
+    /**
+     * Saves or restores the HTTP and ClientCert contexts. No connection is ever open, as requests
+     * aren't sent over the network.
+     */
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 private:
     /**
      * HTTP_C::Initialize service function
@@ -330,4 +338,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of http:C
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::HTTP
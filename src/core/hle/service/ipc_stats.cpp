@@ -0,0 +1,153 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/hle/service/ipc_stats.h"
+
+namespace Service::IPCStats {
+
+namespace {
+
+constexpr std::size_t ENTRIES_PER_CHUNK = 256;
+constexpr std::size_t MAX_CHUNKS = 64;
+
+/// Number of commands listed in each log summary
+constexpr std::size_t SUMMARY_ENTRIES = 10;
+
+// Entries live in fixed chunks that are never moved or freed, so that readers only need the
+// published count to access them.
+std::array<std::unique_ptr<std::array<IPCCommandStats, ENTRIES_PER_CHUNK>>, MAX_CHUNKS> chunks;
+std::atomic<std::size_t> entry_count{0};
+std::mutex registration_mutex;
+
+/// Shared by the commands registered after all chunks are full
+IPCCommandStats overflow_entry;
+
+IPCCommandStats& EntryAt(std::size_t index) {
+    return (*chunks[index / ENTRIES_PER_CHUNK])[index % ENTRIES_PER_CHUNK];
+}
+
+bool NameEquals(const IPCCommandStats& entry, const std::string& service_name) {
+    return service_name.size() <= entry.service_name.size() &&
+           std::equal(service_name.begin(), service_name.end(), entry.service_name.begin()) &&
+           std::all_of(entry.service_name.begin() + service_name.size(), entry.service_name.end(),
+                       [](char c) { return c == '\0'; });
+}
+
+/// Counters at the time of the previous summary, indexed like the entries
+struct Snapshot {
+    u64 calls;
+    u64 host_ns;
+    u64 sleep_ticks;
+};
+std::vector<Snapshot> last_summary;
+
+Core::TimingEventType* summary_event = nullptr;
+
+void LogSummary() {
+    const std::size_t count = GetEntryCount();
+    last_summary.resize(count, Snapshot{});
+
+    struct Delta {
+        std::size_t index;
+        Snapshot stats;
+    };
+    std::vector<Delta> deltas;
+    u64 total_calls = 0;
+    u64 total_host_ns = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const IPCCommandStats& entry = EntryAt(i);
+        const Snapshot current{entry.calls.load(std::memory_order_relaxed),
+                               entry.host_ns.load(std::memory_order_relaxed),
+                               entry.sleep_ticks.load(std::memory_order_relaxed)};
+        Snapshot& last = last_summary[i];
+        if (current.calls != last.calls) {
+            const Snapshot delta{current.calls - last.calls, current.host_ns - last.host_ns,
+                                 current.sleep_ticks - last.sleep_ticks};
+            deltas.push_back({i, delta});
+            total_calls += delta.calls;
+            total_host_ns += delta.host_ns;
+        }
+        last = current;
+    }
+
+    if (deltas.empty()) {
+        return;
+    }
+
+    std::sort(deltas.begin(), deltas.end(), [](const Delta& a, const Delta& b) {
+        return a.stats.host_ns > b.stats.host_ns;
+    });
+    if (deltas.size() > SUMMARY_ENTRIES) {
+        deltas.resize(SUMMARY_ENTRIES);
+    }
+
+    LOG_DEBUG(Service, "HLE IPC in the last {} s: {} calls, {:.3f} ms host time",
+              SUMMARY_INTERVAL_SECONDS, total_calls, total_host_ns / 1e6);
+    for (const Delta& delta : deltas) {
+        const IPCCommandStats& entry = EntryAt(delta.index);
+        const std::string service_name(
+            entry.service_name.begin(),
+            std::find(entry.service_name.begin(), entry.service_name.end(), '\0'));
+        LOG_DEBUG(Service, "  {:<8} {:#010X} {:<32} {:>8} calls {:>10.3f} ms {:>10.3f} ms asleep",
+                  service_name, entry.header, entry.name, delta.stats.calls,
+                  delta.stats.host_ns / 1e6,
+                  delta.stats.sleep_ticks * 1000.0 / BASE_CLOCK_RATE_ARM11);
+    }
+}
+
+} // Anonymous namespace
+
+IPCCommandStats* GetEntry(const std::string& service_name, u32 header, const char* name) {
+    std::lock_guard lock{registration_mutex};
+
+    const std::size_t count = entry_count.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < count; ++i) {
+        IPCCommandStats& entry = EntryAt(i);
+        if (entry.header == header && NameEquals(entry, service_name)) {
+            return &entry;
+        }
+    }
+
+    if (count == ENTRIES_PER_CHUNK * MAX_CHUNKS) {
+        return &overflow_entry;
+    }
+    if (!chunks[count / ENTRIES_PER_CHUNK]) {
+        chunks[count / ENTRIES_PER_CHUNK] =
+            std::make_unique<std::array<IPCCommandStats, ENTRIES_PER_CHUNK>>();
+    }
+
+    IPCCommandStats& entry = EntryAt(count);
+    std::copy_n(service_name.begin(), std::min(service_name.size(), entry.service_name.size()),
+                entry.service_name.begin());
+    entry.header = header;
+    entry.name = name;
+    entry_count.store(count + 1, std::memory_order_release);
+    return &entry;
+}
+
+std::size_t GetEntryCount() {
+    return entry_count.load(std::memory_order_acquire);
+}
+
+const IPCCommandStats& GetEntryAt(std::size_t index) {
+    return EntryAt(index);
+}
+
+void ScheduleSummary(Core::Timing& timing) {
+    constexpr s64 interval = static_cast<s64>(SUMMARY_INTERVAL_SECONDS * BASE_CLOCK_RATE_ARM11);
+    summary_event =
+        timing.RegisterEvent("IPCStats::Summary", [&timing](u64 userdata, s64 cycles_late) {
+            LogSummary();
+            timing.ScheduleEvent(interval - cycles_late, summary_event);
+        });
+    timing.ScheduleEvent(interval, summary_event);
+}
+
+} // namespace Service::IPCStats
@@ -0,0 +1,75 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "common/common_types.h"
+
+namespace Core {
+class Timing;
+}
+
+namespace Service {
+
+/**
+ * Call statistics of one command of an HLE service. Only the emulation thread updates them, so
+ * the counters are incremented with plain loads and stores. They are atomic so that other threads
+ * can read them without locking.
+ */
+struct IPCCommandStats {
+    /// Port name of the service, not null-terminated if it is 8 characters long
+    std::array<char, 8> service_name{};
+    /// Command header the handler is registered for
+    u32 header = 0;
+    /// Name of the handler
+    const char* name = nullptr;
+
+    std::atomic<u64> calls{0};
+    /// Host time spent in the handler, in nanoseconds
+    std::atomic<u64> host_ns{0};
+    /// Guest ticks client threads spent asleep in SleepClientThread for this command
+    std::atomic<u64> sleep_ticks{0};
+
+    void RecordCall(u64 ns) {
+        calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        host_ns.store(host_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    }
+
+    void RecordSleep(u64 ticks) {
+        sleep_ticks.store(sleep_ticks.load(std::memory_order_relaxed) + ticks,
+                          std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Statistics of every command of every HLE service. Entries are created when services register
+ * their handlers and are never removed, so the handlers can keep pointers to them and readers can
+ * walk them without locking. When a service is created again, e.g. on the next boot, it keeps
+ * adding to the entries of its previous instance.
+ */
+namespace IPCStats {
+
+/// Gets the entry of a command, creating it if needed.
+IPCCommandStats* GetEntry(const std::string& service_name, u32 header, const char* name);
+
+/// Gets the number of entries. Entries below this index can be read from any thread.
+std::size_t GetEntryCount();
+
+const IPCCommandStats& GetEntryAt(std::size_t index);
+
+/**
+ * Schedules a debug log summary of the commands that took the most host time, repeated every
+ * SUMMARY_INTERVAL_SECONDS of emulated time. Used when the log_ipc_stats setting is enabled.
+ */
+void ScheduleSummary(Core::Timing& timing);
+
+constexpr u64 SUMMARY_INTERVAL_SECONDS = 10;
+
+} // namespace IPCStats
+
+} // namespace Service
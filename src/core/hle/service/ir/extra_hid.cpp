@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/alignment.h"
+#include "common/chunk_file.h"
 #include "common/string_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -260,6 +261,11 @@ void ExtraHID::RequestInputDevicesReload() {
     is_device_reload_pending.store(true);
 }
 
+void ExtraHID::DoState(PointerWrap& p) {
+    p.Do(hid_period);
+    p.Do(calibration_data);
+}
+
 void ExtraHID::LoadInputDevices() {
     zl = Input::CreateDevice<Input::ButtonDevice>(
         Settings::values.current_input_profile.buttons[Settings::NativeButton::ZL]);
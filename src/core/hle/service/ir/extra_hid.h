@@ -51,6 +51,8 @@ public:
     /// Requests input devices reload from current settings. Called when the input settings change.
     void RequestInputDevicesReload();
 
+    void DoState(PointerWrap& p);
+
 private:
     void SendHIDStatus();
     void HandleConfigureHIDPollingRequest(const std::vector<u8>& request);
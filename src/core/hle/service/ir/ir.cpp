@@ -23,4 +23,15 @@ void InstallInterfaces(Core::System& system) {
     ir_rst->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    auto& service_manager = system.ServiceManager();
+    auto ir_user = service_manager.GetService<IR_USER>("ir:USER");
+    auto ir_rst = service_manager.GetService<IR_RST>("ir:rst");
+    if (!ir_user || !ir_rst) {
+        return;
+    }
+    ir_user->DoState(p, system.Kernel());
+    ir_rst->DoState(p);
+}
+
 } // namespace Service::IR
@@ -4,6 +4,8 @@
 
 #pragma once
 
+class PointerWrap;
+
 namespace Core {
 class System;
 }
@@ -16,4 +18,7 @@ namespace Service::IR {
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of ir:USER and ir:rst
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::IR
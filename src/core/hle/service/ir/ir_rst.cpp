@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
@@ -175,4 +176,16 @@ void IR_RST::ReloadInputDevices() {
     is_device_reload_pending.store(true);
 }
 
+void IR_RST::DoState(PointerWrap& p) {
+    system.Kernel().DoObjectReference(p, update_event);
+    system.Kernel().DoObjectReference(p, shared_memory);
+    p.Do(next_pad_index);
+    p.Do(raw_c_stick);
+    p.Do(update_period);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // The restored update callback may run without Initialize having loaded the devices
+        is_device_reload_pending.store(true);
+    }
+}
+
 } // namespace Service::IR
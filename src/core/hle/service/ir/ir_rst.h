@@ -42,6 +42,8 @@ public:
     ~IR_RST();
     void ReloadInputDevices();
 
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * GetHandles service function
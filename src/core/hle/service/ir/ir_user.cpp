@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <boost/crc.hpp>
+#include "common/chunk_file.h"
 #include "common/string_util.h"
 #include "common/swap.h"
 #include "core/core.h"
@@ -133,6 +134,19 @@ public:
         return true;
     }
 
+    u32 GetMaxPacketCount() const {
+        return max_packet_count;
+    }
+
+    u32 GetBufferSize() const {
+        return max_data_size + sizeof(PacketInfo) * max_packet_count;
+    }
+
+    /// Saves or restores the position of the packets in the buffer
+    void DoState(PointerWrap& p) {
+        p.Do(info);
+    }
+
 private:
     struct BufferInfo {
         u32_le begin_index;
@@ -381,6 +395,40 @@ void IR_USER::ReleaseReceivedData(Kernel::HLERequestContext& ctx) {
     LOG_TRACE(Service_IR, "called, count={}", count);
 }
 
+void IR_USER::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    kernel.DoObjectReference(p, conn_status_event);
+    kernel.DoObjectReference(p, send_event);
+    kernel.DoObjectReference(p, receive_event);
+    kernel.DoObjectReference(p, shared_memory);
+
+    bool connected = connected_device != nullptr;
+    p.Do(connected);
+    extra_hid->DoState(p);
+
+    bool has_receive_buffer = receive_buffer != nullptr;
+    u32 packet_count = has_receive_buffer ? receive_buffer->GetMaxPacketCount() : 0;
+    u32 buffer_size = has_receive_buffer ? receive_buffer->GetBufferSize() : 0;
+    p.Do(has_receive_buffer);
+    p.Do(packet_count);
+    p.Do(buffer_size);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        if (p.error == PointerWrap::ERROR_FAILURE ||
+            (has_receive_buffer && (shared_memory == nullptr || packet_count == 0))) {
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        connected_device = connected ? extra_hid.get() : nullptr;
+        receive_buffer = nullptr;
+        if (has_receive_buffer) {
+            receive_buffer = std::make_unique<BufferManager>(shared_memory, 0x10, 0x20,
+                                                             packet_count, buffer_size);
+        }
+    }
+    if (receive_buffer != nullptr) {
+        receive_buffer->DoState(p);
+    }
+}
+
 IR_USER::IR_USER(Core::System& system) : ServiceFramework("ir:USER", 1) {
     const FunctionInfo functions[] = {
         {0x00010182, nullptr, "InitializeIrNop"},
@@ -56,6 +56,9 @@ public:
 
     void ReloadInputDevices();
 
+    /// Saves or restores the buffers and the connection of the service, and of ExtraHID
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 private:
     /**
      * InitializeIrNopShared service function
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <tuple>
+#include <vector>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/result.h"
@@ -15,7 +16,9 @@ namespace Kernel {
 class Process;
 }
 
-class ARM_Interface;
+namespace Core {
+class System;
+}
 
 namespace Service::LDR {
 
@@ -34,8 +37,8 @@ class CROHelper final {
 public:
     // TODO (wwylele): pass in the process handle for memory access
     explicit CROHelper(VAddr cro_address, Kernel::Process& process, Memory::MemorySystem& memory,
-                       ARM_Interface& cpu)
-        : module_address(cro_address), process(process), memory(memory), cpu(cpu) {}
+                       Core::System& system)
+        : module_address(cro_address), process(process), memory(memory), system(system) {}
 
     std::string ModuleName() const {
         return memory.ReadCString(GetField(ModuleNameOffset), GetField(ModuleNameSize));
@@ -141,11 +144,17 @@ public:
      */
     std::tuple<VAddr, u32> GetExecutablePages() const;
 
+    /**
+     * Gets all modules registered with this static module (CRS), not including itself.
+     * @returns the virtual addresses of the modules, auto-link modules first.
+     */
+    std::vector<VAddr> GetRegisteredModules() const;
+
 private:
     const VAddr module_address; ///< the virtual address of this module
     Kernel::Process& process;   ///< the owner process of this module
     Memory::MemorySystem& memory;
-    ARM_Interface& cpu;
+    Core::System& system;
 
     /**
      * Each item in this enum represents a u32 field in the header begin from address+0x80,
@@ -475,11 +484,11 @@ private:
      */
     template <typename FunctionObject>
     static ResultCode ForEachAutoLinkCRO(Kernel::Process& process, Memory::MemorySystem& memory,
-                                         ARM_Interface& cpu, VAddr crs_address,
+                                         Core::System& system, VAddr crs_address,
                                          FunctionObject func) {
         VAddr current = crs_address;
         while (current != 0) {
-            CROHelper cro(current, process, memory, cpu);
+            CROHelper cro(current, process, memory, system);
             CASCADE_RESULT(bool next, func(cro));
             if (!next)
                 break;
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/alignment.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/arm/arm_interface.h"
@@ -115,7 +116,7 @@ void RO::Initialize(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    CROHelper crs(crs_address, *process, system.Memory(), system.CPU());
+    CROHelper crs(crs_address, *process, system.Memory(), system);
     crs.InitCRS();
 
     result = crs.Rebase(0, crs_size, 0, 0, 0, 0, true);
@@ -126,6 +127,7 @@ void RO::Initialize(Kernel::HLERequestContext& ctx) {
     }
 
     slot->loaded_crs = crs_address;
+    slot->process_id = process->process_id;
 
     rb.Push(RESULT_SUCCESS);
 }
@@ -249,7 +251,7 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
         return;
     }
 
-    CROHelper cro(cro_address, *process, system.Memory(), system.CPU());
+    CROHelper cro(cro_address, *process, system.Memory(), system);
 
     result = cro.VerifyHash(cro_size, crr_address);
     if (result.IsError()) {
@@ -313,7 +315,7 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
         }
     }
 
-    system.CPU().InvalidateCacheRange(cro_address, cro_size);
+    system.InvalidateCacheRange(cro_address, cro_size);
 
     LOG_INFO(Service_LDR, "CRO \"{}\" loaded at 0x{:08X}, fixed_end=0x{:08X}", cro.ModuleName(),
              cro_address, cro_address + fix_size);
@@ -331,7 +333,7 @@ void RO::UnloadCRO(Kernel::HLERequestContext& ctx) {
     LOG_DEBUG(Service_LDR, "called, cro_address=0x{:08X}, zero={}, cro_buffer_ptr=0x{:08X}",
               cro_address, zero, cro_buffer_ptr);
 
-    CROHelper cro(cro_address, *process, system.Memory(), system.CPU());
+    CROHelper cro(cro_address, *process, system.Memory(), system);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
 
@@ -386,7 +388,7 @@ void RO::UnloadCRO(Kernel::HLERequestContext& ctx) {
         LOG_ERROR(Service_LDR, "Error unmapping CRO {:08X}", result.raw);
     }
 
-    system.CPU().InvalidateCacheRange(cro_address, fixed_size);
+    system.InvalidateCacheRange(cro_address, fixed_size);
 
     rb.Push(result);
 }
@@ -398,7 +400,7 @@ void RO::LinkCRO(Kernel::HLERequestContext& ctx) {
 
     LOG_DEBUG(Service_LDR, "called, cro_address=0x{:08X}", cro_address);
 
-    CROHelper cro(cro_address, *process, system.Memory(), system.CPU());
+    CROHelper cro(cro_address, *process, system.Memory(), system);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
 
@@ -438,7 +440,7 @@ void RO::UnlinkCRO(Kernel::HLERequestContext& ctx) {
 
     LOG_DEBUG(Service_LDR, "called, cro_address=0x{:08X}", cro_address);
 
-    CROHelper cro(cro_address, *process, system.Memory(), system.CPU());
+    CROHelper cro(cro_address, *process, system.Memory(), system);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
 
@@ -487,7 +489,7 @@ void RO::Shutdown(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    CROHelper crs(slot->loaded_crs, *process, system.Memory(), system.CPU());
+    CROHelper crs(slot->loaded_crs, *process, system.Memory(), system);
     crs.Unrebase(true);
 
     ResultCode result = RESULT_SUCCESS;
@@ -502,6 +504,31 @@ void RO::Shutdown(Kernel::HLERequestContext& ctx) {
     rb.Push(result);
 }
 
+std::vector<LoadedModule> RO::GetLoadedModules(Kernel::Process& process) {
+    std::vector<LoadedModule> modules;
+    for (const auto& session : connected_sessions) {
+        const auto* slot = static_cast<const ClientSlot*>(session.data.get());
+        if (slot->loaded_crs == 0 || slot->process_id != process.process_id) {
+            continue;
+        }
+
+        CROHelper crs(slot->loaded_crs, process, system.Memory(), system);
+        for (VAddr module_address : crs.GetRegisteredModules()) {
+            CROHelper cro(module_address, process, system.Memory(), system);
+            const auto [code_address, code_size] = cro.GetExecutablePages();
+            if (code_size != 0) {
+                modules.push_back({cro.ModuleName(), code_address, code_size});
+            }
+        }
+    }
+    return modules;
+}
+
+void ClientSlot::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    p.Do(loaded_crs);
+    p.Do(process_id);
+}
+
 RO::RO(Core::System& system) : ServiceFramework("ldr:ro", 2), system(system) {
     static const FunctionInfo functions[] = {
         {0x000100C2, &RO::Initialize, "Initialize"},
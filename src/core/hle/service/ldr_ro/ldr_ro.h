@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
 #include "core/hle/service/service.h"
 
 namespace Core {
@@ -14,12 +16,28 @@ namespace Service::LDR {
 
 struct ClientSlot : public Kernel::SessionRequestHandler::SessionDataBase {
     VAddr loaded_crs = 0; ///< the virtual address of the static module
+    u32 process_id = 0;   ///< the process that initialized the slot
+
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) override;
+};
+
+/// The code segment of a loaded CRO
+struct LoadedModule {
+    std::string name;
+    VAddr code_address;
+    u32 code_size;
 };
 
 class RO final : public ServiceFramework<RO, ClientSlot> {
 public:
     explicit RO(Core::System& system);
 
+    /**
+     * Gets the code segments of all CROs loaded by the given process, used to attribute guest code
+     * addresses to modules.
+     */
+    std::vector<LoadedModule> GetLoadedModules(Kernel::Process& process);
+
 private:
     /**
      * RO::Initialize service function
@@ -5,6 +5,7 @@
 #ifdef HAVE_CUBEB
 #include "audio_core/cubeb_input.h"
 #endif
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/frontend/mic.h"
@@ -15,6 +16,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/mic_u.h"
+#include "core/memory.h"
 #include "core/settings.h"
 
 namespace Service::MIC {
@@ -98,7 +100,7 @@ struct State {
 };
 
 struct MIC_U::Impl {
-    explicit Impl(Core::System& system) : timing(system.CoreTiming()) {
+    explicit Impl(Core::System& system) : timing(system.CoreTiming()), memory(system.Memory()) {
         buffer_full_event =
             system.Kernel().CreateEvent(Kernel::ResetType::OneShot, "MIC_U::buffer_full_event");
         buffer_write_event =
@@ -145,6 +147,7 @@ struct MIC_U::Impl {
         if (!samples.empty()) {
             // write the samples to sharedmem page
             state.WriteSamples(samples);
+            memory.MarkHostRegionDirty(state.sharedmem_buffer, state.sharedmem_size);
         }
 
         // schedule next run
@@ -353,6 +356,54 @@ struct MIC_U::Impl {
         change_mic_impl_requested.store(false);
     }
 
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+        if (p.GetMode() == PointerWrap::MODE_READ) {
+            mic->StopSampling();
+        }
+
+        kernel.DoObjectReference(p, buffer_full_event);
+        kernel.DoObjectReference(p, shared_memory);
+        p.Do(client_version);
+        p.Do(allow_shell_closed);
+        p.Do(clamp);
+
+        p.Do(state.sharedmem_size);
+        p.Do(state.size);
+        p.Do(state.offset);
+        p.Do(state.initial_offset);
+        p.Do(state.looped_buffer);
+        p.Do(state.sample_size);
+        p.Do(state.sample_rate);
+
+        u8 gain = mic->GetGain();
+        bool power = mic->GetPower();
+        bool sampling = mic->IsSampling();
+        Frontend::Mic::Parameters params = mic->GetParameters();
+        p.Do(gain);
+        p.Do(power);
+        p.Do(sampling);
+        p.Do(params);
+
+        if (p.GetMode() != PointerWrap::MODE_READ) {
+            return;
+        }
+        if (state.sample_rate > SampleRate::Rate8180 ||
+            (shared_memory && (state.sharedmem_size < sizeof(u32) ||
+                               state.sharedmem_size > shared_memory->GetSize() ||
+                               state.size > state.sharedmem_size - sizeof(u32) ||
+                               state.offset > state.size))) {
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        state.sharedmem_buffer = shared_memory ? shared_memory->GetPointer() : nullptr;
+        mic->SetGain(gain);
+        mic->SetPower(power);
+        // The pending buffer_write_event is brought back by the timing state
+        if (sampling && shared_memory) {
+            mic->StartSampling(params);
+        }
+    }
+
     std::atomic<bool> change_mic_impl_requested = false;
     std::shared_ptr<Kernel::Event> buffer_full_event;
     Core::TimingEventType* buffer_write_event = nullptr;
@@ -362,6 +413,7 @@ struct MIC_U::Impl {
     bool clamp = false;
     std::unique_ptr<Frontend::Mic::Interface> mic;
     Core::Timing& timing;
+    Memory::MemorySystem& memory;
     State state{};
 };
 
@@ -462,6 +514,10 @@ void MIC_U::ReloadMic() {
     impl->change_mic_impl_requested.store(true);
 }
 
+void MIC_U::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    impl->DoState(p, kernel);
+}
+
 void ReloadMic(Core::System& system) {
     auto micu = system.ServiceManager().GetService<Service::MIC::MIC_U>("mic:u");
     if (!micu)
@@ -474,4 +530,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<MIC_U>(system)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto micu = system.ServiceManager().GetService<MIC_U>("mic:u")) {
+        micu->DoState(p, system.Kernel());
+    }
+}
+
 } // namespace Service::MIC
@@ -21,6 +21,9 @@ public:
 
     void ReloadMic();
 
+    /// Saves or restores the state of the service, resuming the sampling it was doing
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 private:
     /**
      * MIC::MapSharedMem service function
@@ -196,4 +199,7 @@ void ReloadMic(Core::System& system);
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of mic:u
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::MIC
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/service/ndm/ndm_u.h"
@@ -237,9 +238,25 @@ NDM_U::NDM_U() : ServiceFramework("ndm:u", 6) {
     RegisterHandlers(functions);
 }
 
+void NDM_U::DoState(PointerWrap& p) {
+    p.Do(daemon_bit_mask);
+    p.Do(default_daemon_bit_mask);
+    p.Do(daemon_status);
+    p.Do(exclusive_state);
+    p.Do(scan_interval);
+    p.Do(retry_interval);
+    p.Do(daemon_lock_enabled);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     std::make_shared<NDM_U>()->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto ndm = system.ServiceManager().GetService<NDM_U>("ndm:u")) {
+        ndm->DoState(p);
+    }
+}
+
 } // namespace Service::NDM
@@ -17,6 +17,8 @@ class NDM_U final : public ServiceFramework<NDM_U> {
 public:
     NDM_U();
 
+    void DoState(PointerWrap& p);
+
 private:
     /**
      *  NDM::EnterExclusiveState service function
@@ -274,4 +276,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of ndm:u
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::NDM
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
@@ -329,6 +330,18 @@ Module::Module(Core::System& system) {
 
 Module::~Module() = default;
 
+void Module::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    kernel.DoObjectReference(p, tag_in_range_event);
+    kernel.DoObjectReference(p, tag_out_of_range_event);
+    TagState tag_state = nfc_tag_state;
+    p.Do(tag_state);
+    p.Do(nfc_status);
+    p.DoArray(reinterpret_cast<u8*>(&amiibo_data), sizeof(amiibo_data));
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        nfc_tag_state = tag_state;
+    }
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto nfc = std::make_shared<Module>(system);
@@ -336,4 +349,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<NFC_U>(nfc)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto nfc = system.ServiceManager().GetService<Module::Interface>("nfc:u")) {
+        nfc->GetModule()->DoState(p, system.Kernel());
+    }
+}
+
 } // namespace Service::NFC
@@ -15,6 +15,7 @@ class System;
 
 namespace Kernel {
 class Event;
+class KernelSystem;
 } // namespace Kernel
 
 namespace Service::NFC {
@@ -230,6 +231,8 @@ public:
         std::shared_ptr<Module> nfc;
     };
 
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 private:
     std::shared_ptr<Kernel::Event> tag_in_range_event;
     std::shared_ptr<Kernel::Event> tag_out_of_range_event;
@@ -241,4 +244,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the NFC module
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::NFC
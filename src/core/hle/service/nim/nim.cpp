@@ -17,4 +17,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<NIM_U>(system)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto nim_u = system.ServiceManager().GetService<NIM_U>("nim:u")) {
+        nim_u->DoState(p, system.Kernel());
+    }
+}
+
 } // namespace Service::NIM
@@ -14,4 +14,7 @@ namespace Service::NIM {
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of nim:u
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::NIM
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
@@ -44,4 +45,8 @@ void NIM_U::CheckSysUpdateAvailable(Kernel::HLERequestContext& ctx) {
     LOG_WARNING(Service_NIM, "(STUBBED) called");
 }
 
+void NIM_U::DoState(PointerWrap& p, Kernel::KernelSystem& kernel) {
+    kernel.DoObjectReference(p, nim_system_update_event);
+}
+
 } // namespace Service::NIM
@@ -18,6 +18,8 @@ public:
     explicit NIM_U(Core::System& system);
     ~NIM_U();
 
+    void DoState(PointerWrap& p, Kernel::KernelSystem& kernel);
+
 private:
     /**
      * NIM::CheckForSysUpdateEvent service function
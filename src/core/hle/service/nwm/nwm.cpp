@@ -25,4 +25,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<NWM_UDS>(system)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto uds = system.ServiceManager().GetService<NWM_UDS>("nwm::UDS")) {
+        uds->DoState(p);
+    }
+}
+
 } // namespace Service::NWM
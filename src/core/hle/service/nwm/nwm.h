@@ -15,4 +15,7 @@ namespace Service::NWM {
 /// Initialize all NWM services
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of nwm::UDS
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::NWM
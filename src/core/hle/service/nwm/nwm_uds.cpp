@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cryptopp/osrng.h>
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/core.h"
@@ -1398,6 +1399,84 @@ NWM_UDS::NWM_UDS(Core::System& system) : ServiceFramework("nwm::UDS"), system(sy
     system.Kernel().GetSharedPageHandler().SetWifiLinkLevel(SharedPage::WifiLinkLevel::BEST);
 }
 
+void NWM_UDS::DoState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    kernel.DoObjectReference(p, connection_status_event);
+    kernel.DoObjectReference(p, connection_event);
+    kernel.DoObjectReference(p, recv_buffer_memory);
+    bool is_initialized = initialized;
+    p.Do(is_initialized);
+    p.DoArray(reinterpret_cast<u8*>(&current_node), sizeof(current_node));
+    p.Do(network_channel);
+
+    u32 status = connection_status.status;
+    p.Do(status);
+
+    u32 num_bind_nodes = static_cast<u32>(channel_data.size());
+    p.Do(num_bind_nodes);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        channel_data.clear();
+        for (u32 i = 0; i < num_bind_nodes && p.error != PointerWrap::ERROR_FAILURE; ++i) {
+            u32 data_channel = 0;
+            p.Do(data_channel);
+            BindNodeData& data = channel_data[data_channel];
+            p.Do(data.bind_node_id);
+            p.Do(data.channel);
+            p.Do(data.network_node_id);
+            kernel.DoObjectReference(p, data.event);
+            p.Do(data.received_packets);
+        }
+    } else {
+        for (auto& [data_channel, data] : channel_data) {
+            u32 channel_id = data_channel;
+            p.Do(channel_id);
+            p.Do(data.bind_node_id);
+            p.Do(data.channel);
+            p.Do(data.network_node_id);
+            kernel.DoObjectReference(p, data.event);
+            p.Do(data.received_packets);
+        }
+    }
+
+    if (p.GetMode() != PointerWrap::MODE_READ || p.error == PointerWrap::ERROR_FAILURE) {
+        return;
+    }
+
+    auto room_member = Network::GetRoomMember().lock();
+    if (room_member) {
+        room_member->Unbind(wifi_packet_received);
+    }
+    wifi_packet_received = nullptr;
+    initialized = is_initialized;
+    if (is_initialized && room_member) {
+        wifi_packet_received = room_member->BindOnWifiPacketReceived(
+            [this](const Network::WifiPacket& packet) { OnWifiPacketReceived(packet); });
+    }
+
+    {
+        std::lock_guard lock(connection_status_mutex);
+        connection_status = {};
+        connection_status.status = is_initialized ? static_cast<u32>(NetworkStatus::NotConnected)
+                                                  : status;
+        node_info.clear();
+        if (is_initialized) {
+            node_info.push_back(current_node);
+        }
+        node_map.clear();
+        network_info = {};
+    }
+    {
+        std::lock_guard lock(beacon_mutex);
+        received_beacons.clear();
+    }
+
+    // Let the application know that it was disconnected from the network it was part of
+    if (is_initialized && status != static_cast<u32>(NetworkStatus::NotConnected) &&
+        connection_status_event) {
+        connection_status_event->Signal();
+    }
+}
+
 NWM_UDS::~NWM_UDS() {
     if (auto room_member = Network::GetRoomMember().lock())
         room_member->Unbind(wifi_packet_received);
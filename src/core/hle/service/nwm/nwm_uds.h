@@ -127,6 +127,12 @@ public:
     explicit NWM_UDS(Core::System& system);
     ~NWM_UDS();
 
+    /**
+     * Saves or restores the state of the service. The network the console was part of isn't
+     * saved: a restored service is disconnected from it, as if the connection had been lost.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     Core::System& system;
 
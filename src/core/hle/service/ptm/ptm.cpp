@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cinttypes>
+#include "common/chunk_file.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -10,6 +11,7 @@
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
+#include "core/hle/service/fs/archive.h"
 #include "core/hle/service/ptm/ptm.h"
 #include "core/hle/service/ptm/ptm_gets.h"
 #include "core/hle/service/ptm/ptm_play.h"
@@ -137,7 +139,8 @@ void Module::Interface::CheckNew3DS(Kernel::HLERequestContext& ctx) {
 
 static void WriteGameCoinData(GameCoin gamecoin_data) {
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
-    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(nand_directory, true);
+    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(
+        nand_directory, true, Core::System::GetInstance().ArchiveManager().GetWriteBackCache());
 
     FileSys::Path archive_path(ptm_shared_extdata_id);
     auto archive_result = extdata_archive_factory.Open(archive_path, 0);
@@ -170,7 +173,8 @@ static void WriteGameCoinData(GameCoin gamecoin_data) {
 
 static GameCoin ReadGameCoinData() {
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
-    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(nand_directory, true);
+    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(
+        nand_directory, true, Core::System::GetInstance().ArchiveManager().GetWriteBackCache());
 
     FileSys::Path archive_path(ptm_shared_extdata_id);
     auto archive_result = extdata_archive_factory.Open(archive_path, 0);
@@ -200,7 +204,8 @@ Module::Module() {
     // Open the SharedExtSaveData archive 0xF000000B and create the gamecoin.dat file if it doesn't
     // exist
     std::string nand_directory = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir);
-    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(nand_directory, true);
+    FileSys::ArchiveFactory_ExtSaveData extdata_archive_factory(
+        nand_directory, true, Core::System::GetInstance().ArchiveManager().GetWriteBackCache());
     FileSys::Path archive_path(ptm_shared_extdata_id);
     auto archive_result = extdata_archive_factory.Open(archive_path, 0);
     // If the archive didn't exist, write the default game coin file
@@ -224,6 +229,16 @@ void Module::SetPlayCoins(u16 play_coins) {
 Module::Interface::Interface(std::shared_ptr<Module> ptm, const char* name, u32 max_session)
     : ServiceFramework(name, max_session), ptm(std::move(ptm)) {}
 
+std::shared_ptr<Module> Module::Interface::GetModule() const {
+    return ptm;
+}
+
+void Module::DoState(PointerWrap& p) {
+    p.Do(shell_open);
+    p.Do(battery_is_charging);
+    p.Do(pedometer_is_counting);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto ptm = std::make_shared<Module>();
@@ -235,4 +250,10 @@ void InstallInterfaces(Core::System& system) {
     std::make_shared<PTM_U>(ptm)->InstallAsService(service_manager);
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    if (auto ptm = system.ServiceManager().GetService<Module::Interface>("ptm:u")) {
+        ptm->GetModule()->DoState(p);
+    }
+}
+
 } // namespace Service::PTM
@@ -55,6 +55,8 @@ public:
     public:
         Interface(std::shared_ptr<Module> ptm, const char* name, u32 max_session);
 
+        std::shared_ptr<Module> GetModule() const;
+
     protected:
         /**
          * It is unknown if GetAdapterState is the same as GetBatteryChargeState,
@@ -141,6 +143,8 @@ public:
         std::shared_ptr<Module> ptm;
     };
 
+    void DoState(PointerWrap& p);
+
 private:
     bool shell_open = true;
     bool battery_is_charging = true;
@@ -149,4 +153,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of the PTM module
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::PTM
@@ -3,8 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
 #include <fmt/format.h>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
@@ -32,6 +36,7 @@
 #include "core/hle/service/gsp/gsp_lcd.h"
 #include "core/hle/service/hid/hid.h"
 #include "core/hle/service/http_c.h"
+#include "core/hle/service/ipc_stats.h"
 #include "core/hle/service/ir/ir.h"
 #include "core/hle/service/ldr_ro/ldr_ro.h"
 #include "core/hle/service/mic_u.h"
@@ -53,49 +58,55 @@
 #include "core/hle/service/soc_u.h"
 #include "core/hle/service/ssl_c.h"
 #include "core/hle/service/y2r_u.h"
+#include "core/settings.h"
 
 namespace Service {
 
 const std::array<ServiceModuleInfo, 40> service_module_map{
-    {{"FS", 0x00040130'00001102, FS::InstallInterfaces},
+    {{"FS", 0x00040130'00001102, FS::InstallInterfaces, FS::DoState},
      {"PM", 0x00040130'00001202, PM::InstallInterfaces},
      {"LDR", 0x00040130'00003702, LDR::InstallInterfaces},
      {"PXI", 0x00040130'00001402, PXI::InstallInterfaces},
 
      {"ERR", 0x00040030'00008A02, ERR::InstallInterfaces},
-     {"AC", 0x00040130'00002402, AC::InstallInterfaces},
+     {"AC", 0x00040130'00002402, AC::InstallInterfaces, AC::DoState},
      {"ACT", 0x00040130'00003802, ACT::InstallInterfaces},
-     {"AM", 0x00040130'00001502, AM::InstallInterfaces},
-     {"BOSS", 0x00040130'00003402, BOSS::InstallInterfaces},
+     {"AM", 0x00040130'00001502, AM::InstallInterfaces, AM::DoState},
+     {"BOSS", 0x00040130'00003402, BOSS::InstallInterfaces, BOSS::DoState},
      {"CAM", 0x00040130'00001602,
       [](Core::System& system) {
           CAM::InstallInterfaces(system);
           Y2R::InstallInterfaces(system);
+      },
+      [](Core::System& system, PointerWrap& p) {
+          CAM::DoState(system, p);
+          Y2R::DoState(system, p);
       }},
-     {"CECD", 0x00040130'00002602, CECD::InstallInterfaces},
-     {"CFG", 0x00040130'00001702, CFG::InstallInterfaces},
+     {"CECD", 0x00040130'00002602, CECD::InstallInterfaces, CECD::DoState},
+     {"CFG", 0x00040130'00001702, CFG::InstallInterfaces, CFG::DoState},
      {"DLP", 0x00040130'00002802, DLP::InstallInterfaces},
-     {"DSP", 0x00040130'00001A02, DSP::InstallInterfaces},
+     {"DSP", 0x00040130'00001A02, DSP::InstallInterfaces, DSP::DoState},
      {"FRD", 0x00040130'00003202, FRD::InstallInterfaces},
-     {"GSP", 0x00040130'00001C02, GSP::InstallInterfaces},
-     {"HID", 0x00040130'00001D02, HID::InstallInterfaces},
-     {"IR", 0x00040130'00003302, IR::InstallInterfaces},
-     {"MIC", 0x00040130'00002002, MIC::InstallInterfaces},
+     {"GSP", 0x00040130'00001C02, GSP::InstallInterfaces, GSP::DoState},
+     {"HID", 0x00040130'00001D02, HID::InstallInterfaces, HID::DoState},
+     {"IR", 0x00040130'00003302, IR::InstallInterfaces, IR::DoState},
+     {"MIC", 0x00040130'00002002, MIC::InstallInterfaces, MIC::DoState},
      {"MVD", 0x00040130'20004102, MVD::InstallInterfaces},
-     {"NDM", 0x00040130'00002B02, NDM::InstallInterfaces},
+     {"NDM", 0x00040130'00002B02, NDM::InstallInterfaces, NDM::DoState},
      {"NEWS", 0x00040130'00003502, NEWS::InstallInterfaces},
-     {"NFC", 0x00040130'00004002, NFC::InstallInterfaces},
-     {"NIM", 0x00040130'00002C02, NIM::InstallInterfaces},
+     {"NFC", 0x00040130'00004002, NFC::InstallInterfaces, NFC::DoState},
+     {"NIM", 0x00040130'00002C02, NIM::InstallInterfaces, NIM::DoState},
      {"NS", 0x00040130'00008002,
       [](Core::System& system) {
           NS::InstallInterfaces(system);
           APT::InstallInterfaces(system);
-      }},
-     {"NWM", 0x00040130'00002D02, NWM::InstallInterfaces},
-     {"PTM", 0x00040130'00002202, PTM::InstallInterfaces},
+      },
+      APT::DoState},
+     {"NWM", 0x00040130'00002D02, NWM::InstallInterfaces, NWM::DoState},
+     {"PTM", 0x00040130'00002202, PTM::InstallInterfaces, PTM::DoState},
      {"QTM", 0x00040130'00004202, QTM::InstallInterfaces},
-     {"CSND", 0x00040130'00002702, CSND::InstallInterfaces},
-     {"HTTP", 0x00040130'00002902, HTTP::InstallInterfaces},
+     {"CSND", 0x00040130'00002702, CSND::InstallInterfaces, CSND::DoState},
+     {"HTTP", 0x00040130'00002902, HTTP::InstallInterfaces, HTTP::DoState},
      {"SOC", 0x00040130'00002E02, SOC::InstallInterfaces},
      {"SSL", 0x00040130'00002F02, SSL::InstallInterfaces},
      {"PS", 0x00040130'00003102, PS::InstallInterfaces},
@@ -146,7 +157,10 @@ void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* function
     handlers.reserve(handlers.size() + n);
     for (std::size_t i = 0; i < n; ++i) {
         // Usually this array is sorted by id already, so hint to insert at the end
-        handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
+        auto itr = handlers.emplace_hint(handlers.cend(), functions[i].expected_header,
+                                         functions[i]);
+        itr->second.stats =
+            IPCStats::GetEntry(service_name, functions[i].expected_header, functions[i].name);
     }
 }
 
@@ -181,7 +195,13 @@ void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context)
 
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+
+    context.SetCommandStats(info->stats);
+    const auto start = std::chrono::steady_clock::now();
     handler_invoker(this, info->handler_callback, context);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    info->stats->RecordCall(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -207,6 +227,9 @@ static bool AttemptLLE(const ServiceModuleInfo& service_module) {
 /// Initialize ServiceManager
 void Init(Core::System& core) {
     SM::ServiceManager::InstallInterfaces(core);
+    if (Settings::values.log_ipc_stats) {
+        IPCStats::ScheduleSummary(core.CoreTiming());
+    }
 
     for (const auto& service_module : service_module_map) {
         if (!AttemptLLE(service_module) && service_module.init_function != nullptr)
@@ -215,4 +238,34 @@ void Init(Core::System& core) {
     LOG_DEBUG(Service, "initialized OK");
 }
 
+void DoState(Core::System& system, PointerWrap& p) {
+    Kernel::KernelSystem& kernel = system.Kernel();
+    system.ServiceManager().DoState(p);
+
+    // The services installed as named ports, like srv:
+    std::vector<std::string> port_names;
+    for (const auto& [name, port] : kernel.named_ports) {
+        port_names.push_back(name);
+    }
+    std::sort(port_names.begin(), port_names.end());
+    for (const auto& name : port_names) {
+        const auto server_port = kernel.named_ports.at(name)->GetServerPort();
+        if (server_port != nullptr && server_port->hle_handler != nullptr) {
+            server_port->hle_handler->DoSessionsState(p, kernel);
+        }
+    }
+
+    for (const auto& service_module : service_module_map) {
+        if (p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+        if (service_module.do_state != nullptr) {
+            // A module that runs as LLE in only one of the systems saves nothing in it, which
+            // the marker catches
+            service_module.do_state(system, p);
+            p.DoMarker(service_module.name.c_str());
+        }
+    }
+}
+
 } // namespace Service
@@ -15,6 +15,8 @@
 #include "core/hle/kernel/object.h"
 #include "core/hle/service/sm/sm.h"
 
+class PointerWrap;
+
 namespace Core {
 class System;
 }
@@ -28,6 +30,8 @@ class ServerSession;
 
 namespace Service {
 
+struct IPCCommandStats;
+
 namespace SM {
 class ServiceManager;
 }
@@ -77,6 +81,8 @@ private:
         u32 expected_header;
         HandlerFnP<ServiceFrameworkBase> handler_callback;
         const char* name;
+        /// Call statistics of the command, set when the handler is registered
+        IPCCommandStats* stats = nullptr;
     };
 
     using InvokerFn = void(ServiceFrameworkBase* object, HandlerFnP<ServiceFrameworkBase> member,
@@ -181,10 +187,19 @@ private:
 /// Initialize ServiceManager
 void Init(Core::System& system);
 
+/**
+ * Saves or restores the state of the HLE services: the registered services, the sessions connected
+ * to them and the state of the service modules. The kernel state must have been restored before,
+ * as the services refer to kernel objects by ID.
+ */
+void DoState(Core::System& system, PointerWrap& p);
+
 struct ServiceModuleInfo {
     std::string name;
     u64 title_id;
     std::function<void(Core::System&)> init_function;
+    /// Saves or restores the state of the module, for modules that have some
+    std::function<void(Core::System&, PointerWrap&)> do_state;
 };
 
 extern const std::array<ServiceModuleInfo, 40> service_module_map;
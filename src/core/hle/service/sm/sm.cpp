@@ -2,16 +2,23 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <tuple>
+#include <vector>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/result.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/hle/service/sm/srv.h"
 
 namespace Service::SM {
 
+/// Most services a state may register, to not trust counts read from corrupted states blindly
+constexpr u32 MAX_SERVICES = 0x400;
+
 static ResultCode ValidateServiceName(const std::string& name) {
     if (name.size() <= 0 || name.size() > 8) {
         return ERR_INVALID_NAME_SIZE;
@@ -65,4 +72,54 @@ ResultVal<std::shared_ptr<Kernel::ClientSession>> ServiceManager::ConnectToServi
     return client_port->Connect();
 }
 
+void ServiceManager::DoState(PointerWrap& p) {
+    Kernel::KernelSystem& kernel = system.Kernel();
+
+    // Services registered by emulated modules are part of the state, so the saved list replaces
+    // the current one instead of being matched against it.
+    std::vector<std::pair<std::string, std::shared_ptr<Kernel::ClientPort>>> services(
+        registered_services.begin(), registered_services.end());
+    std::sort(services.begin(), services.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    u32 num_services = static_cast<u32>(services.size());
+    p.Do(num_services);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        if (num_services > MAX_SERVICES) {
+            LOG_ERROR(Service_SRV, "Invalid number of registered services");
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        services.clear();
+        services.resize(num_services);
+    }
+    for (auto& [name, port] : services) {
+        p.Do(name);
+        kernel.DoObjectReference(p, port);
+        if (p.error == PointerWrap::ERROR_FAILURE) {
+            return;
+        }
+        if (port == nullptr) {
+            LOG_ERROR(Service_SRV, "Registered service {} has no port", name);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+    }
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        registered_services.clear();
+        registered_services.insert(services.begin(), services.end());
+    }
+
+    for (const auto& [name, port] : services) {
+        const auto server_port = port->GetServerPort();
+        if (server_port != nullptr && server_port->hle_handler != nullptr) {
+            server_port->hle_handler->DoSessionsState(p, kernel);
+        }
+    }
+
+    if (auto srv = srv_interface.lock()) {
+        srv->DoState(p);
+    }
+}
+
 } // namespace Service::SM
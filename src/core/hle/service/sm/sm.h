@@ -14,6 +14,8 @@
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
 
+class PointerWrap;
+
 namespace Core {
 class System;
 }
@@ -68,6 +70,12 @@ public:
         return std::static_pointer_cast<T>(port->hle_handler);
     }
 
+    /**
+     * Saves or restores the registered services along with the sessions connected to the HLE ones,
+     * and the state of srv:. The kernel state must have been restored before.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     Core::System& system;
     std::weak_ptr<SRV> srv_interface;
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <tuple>
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/core.h"
@@ -265,4 +266,12 @@ SRV::SRV(Core::System& system) : ServiceFramework("srv:", 4), system(system) {
 
 SRV::~SRV() = default;
 
+void SRV::DoState(PointerWrap& p) {
+    system.Kernel().DoObjectReference(p, notification_semaphore);
+    // Delayed requests keep their client thread paused, which prevents saving.
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        get_service_handle_delayed_map.clear();
+    }
+}
+
 } // namespace Service::SM
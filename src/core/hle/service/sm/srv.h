@@ -8,6 +8,8 @@
 #include <unordered_map>
 #include "core/hle/service/service.h"
 
+class PointerWrap;
+
 namespace Core {
 class System;
 }
@@ -25,6 +27,8 @@ public:
     explicit SRV(Core::System& system);
     ~SRV();
 
+    void DoState(PointerWrap& p);
+
 private:
     void RegisterClient(Kernel::HLERequestContext& ctx);
     void EnableNotification(Kernel::HLERequestContext& ctx);
@@ -151,6 +151,8 @@ public:
     explicit Y2R_U(Core::System& system);
     ~Y2R_U() override;
 
+    void DoState(PointerWrap& p);
+
 private:
     void SetInputFormat(Kernel::HLERequestContext& ctx);
     void GetInputFormat(Kernel::HLERequestContext& ctx);
@@ -305,4 +307,7 @@ private:
 
 void InstallInterfaces(Core::System& system);
 
+/// Saves or restores the state of y2r:u
+void DoState(Core::System& system, PointerWrap& p);
+
 } // namespace Service::Y2R
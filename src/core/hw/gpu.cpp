@@ -103,6 +103,7 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
 
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
+    g_memory->MarkRegionDirty(start_addr, end_addr - start_addr);
 
     if (config.fill_24bit) {
         // fill with 24-bit values
@@ -193,6 +194,7 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
 
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+    g_memory->MarkRegionDirty(dst_addr, output_size);
 
     for (u32 y = 0; y < output_height; ++y) {
         for (u32 x = 0; x < output_width; ++x) {
@@ -360,6 +362,7 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     const auto FlushInvalidate_fn = (output_gap != 0) ? Memory::RasterizerFlushAndInvalidateRegion
                                                       : Memory::RasterizerInvalidateRegion;
     FlushInvalidate_fn(config.GetPhysicalOutputAddress(), static_cast<u32>(contiguous_output_size));
+    g_memory->MarkRegionDirty(dst_addr, static_cast<u32>(contiguous_output_size));
 
     u32 remaining_input = input_width;
     u32 remaining_output = output_width;
@@ -6,6 +6,8 @@
 
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Memory {
 class MemorySystem;
 }
@@ -51,4 +53,7 @@ void Init(Memory::MemorySystem& memory);
 /// Shutdown hardware
 void Shutdown();
 
+/// Save or restore the hardware registers
+void DoState(PointerWrap& p);
+
 } // namespace HW
@@ -105,7 +105,8 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
 static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
                      int amount_of_data, OutputFormat output_format, u8 alpha) {
 
-    u8* output = memory.GetPointer(buf.address);
+    u8* const output_start = memory.GetPointer(buf.address);
+    u8* output = output_start;
 
     while (amount_of_data > 0) {
         u8* unit_end = output + buf.transfer_unit;
@@ -139,6 +140,8 @@ static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionB
         buf.address += buf.transfer_unit + buf.gap;
         buf.image_size -= buf.transfer_unit;
     }
+
+    memory.MarkHostRegionDirty(output_start, output - output_start);
 }
 
 static const u8 linear_lut[TILE_SIZE] = {
@@ -298,8 +298,13 @@ ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileSys::RomFSReader>
 
     // Check if the 3DSX has a RomFS...
     if (hdr.fs_offset != 0) {
+        const u64 file_size = file.GetSize();
+        if (hdr.fs_offset > file_size) {
+            LOG_ERROR(Loader, "RomFS offset {:#010X} is past the end of the file", hdr.fs_offset);
+            return ResultStatus::ErrorInvalidFormat;
+        }
         u32 romfs_offset = hdr.fs_offset;
-        u32 romfs_size = static_cast<u32>(file.GetSize()) - hdr.fs_offset;
+        u32 romfs_size = static_cast<u32>(file_size - hdr.fs_offset);
 
         LOG_DEBUG(Loader, "RomFS offset:           {:#010X}", romfs_offset);
         LOG_DEBUG(Loader, "RomFS size:             {:#010X}", romfs_size);
@@ -0,0 +1,224 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <thread>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "core/loader/title_info_cache.h"
+
+namespace Loader {
+
+namespace {
+
+constexpr u32 CACHE_MAGIC = 0x43495443; // "CTIC"
+constexpr u32 CACHE_VERSION = 1;
+
+/// Largest path or SMDH accepted when reading the cache, to reject corrupted lengths early
+constexpr u32 MAX_FIELD_SIZE = 0x10000;
+
+struct CacheHeader {
+    u32_le magic;
+    u32_le version;
+    u32_le num_entries;
+    INSERT_PADDING_WORDS(1);
+};
+static_assert(sizeof(CacheHeader) == 16, "CacheHeader has incorrect size");
+
+struct CacheEntryHeader {
+    u64_le size;
+    s64_le modification_time;
+    u64_le program_id;
+    u64_le extdata_id;
+    u32_le file_type;
+    u32_le path_length;
+    u32_le smdh_length;
+    INSERT_PADDING_WORDS(1);
+};
+static_assert(sizeof(CacheEntryHeader) == 48, "CacheEntryHeader has incorrect size");
+
+/// Whether a loader failed to read something the file has, rather than the file not having it
+bool IsReadError(ResultStatus status) {
+    return status != ResultStatus::Success && status != ResultStatus::ErrorNotImplemented &&
+           status != ResultStatus::ErrorNotUsed;
+}
+
+/**
+ * Reads the info of a file.
+ * @returns Whether all of the info could be read. Parts of it can be missing for example when the
+ *          file is encrypted with keys that are missing.
+ */
+bool ReadTitleInfo(const std::string& path, TitleInfo& info) {
+    const std::unique_ptr<AppLoader> loader = GetLoader(path);
+    if (!loader) {
+        return false;
+    }
+    info.file_type = loader->GetFileType();
+    const bool read_program_id = !IsReadError(loader->ReadProgramId(info.program_id));
+    const bool read_extdata_id = !IsReadError(loader->ReadExtdataId(info.extdata_id));
+    const bool read_icon = !IsReadError(loader->ReadIcon(info.smdh));
+    return read_program_id && read_extdata_id && read_icon;
+}
+
+} // Anonymous namespace
+
+TitleInfoCache::TitleInfoCache(std::string cache_path_) : cache_path(std::move(cache_path_)) {
+    FileUtil::IOFile file(cache_path, "rb");
+    if (!file.IsOpen()) {
+        return;
+    }
+
+    CacheHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) || header.magic != CACHE_MAGIC ||
+        header.version != CACHE_VERSION) {
+        LOG_WARNING(Loader, "Ignoring invalid title info cache {}", cache_path);
+        return;
+    }
+
+    for (u32 i = 0; i < header.num_entries; ++i) {
+        CacheEntryHeader entry_header{};
+        if (file.ReadBytes(&entry_header, sizeof(entry_header)) != sizeof(entry_header) ||
+            entry_header.path_length > MAX_FIELD_SIZE ||
+            entry_header.smdh_length > MAX_FIELD_SIZE) {
+            break;
+        }
+
+        std::string path(entry_header.path_length, '\0');
+        Entry entry{entry_header.size, entry_header.modification_time, {}};
+        entry.info.file_type = static_cast<FileType>(static_cast<u32>(entry_header.file_type));
+        entry.info.program_id = entry_header.program_id;
+        entry.info.extdata_id = entry_header.extdata_id;
+        entry.info.smdh.resize(entry_header.smdh_length);
+        if (file.ReadBytes(path.data(), path.size()) != path.size() ||
+            file.ReadBytes(entry.info.smdh.data(), entry.info.smdh.size()) !=
+                entry.info.smdh.size()) {
+            break;
+        }
+        entries.emplace(std::move(path), std::move(entry));
+    }
+    LOG_DEBUG(Loader, "Loaded {} entries from {}", entries.size(), cache_path);
+}
+
+TitleInfo TitleInfoCache::Get(const std::string& path) {
+    const u64 size = FileUtil::GetSize(path);
+    const s64 modification_time = FileUtil::GetModificationTime(path);
+    {
+        std::lock_guard lock(mutex);
+        const auto itr = entries.find(path);
+        if (itr != entries.end() && itr->second.size == size &&
+            itr->second.modification_time == modification_time) {
+            return itr->second.info;
+        }
+    }
+
+    // Read outside of the lock, so that other threads can read other files meanwhile
+    TitleInfo info;
+    const bool complete = ReadTitleInfo(path, info);
+    std::lock_guard lock(mutex);
+    if (!complete) {
+        // Failures aren't remembered, so that the file is read again next time
+        dirty |= entries.erase(path) != 0;
+        return info;
+    }
+    entries[path] = Entry{size, modification_time, info};
+    dirty = true;
+    return info;
+}
+
+std::vector<TitleInfo> TitleInfoCache::Scan(const std::vector<std::string>& paths,
+                                            const std::atomic_bool* cancel) {
+    std::vector<TitleInfo> infos(paths.size());
+    std::atomic_size_t next{0};
+    std::atomic_size_t done{0};
+    const auto worker = [&] {
+        for (std::size_t i = next++; i < paths.size(); i = next++) {
+            if (cancel && *cancel) {
+                break;
+            }
+            infos[i] = Get(paths[i]);
+            ++done;
+        }
+    };
+
+    const std::size_t num_threads =
+        std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1U), paths.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (done != paths.size()) {
+        infos.clear();
+    }
+    return infos;
+}
+
+bool TitleInfoCache::Save() {
+    std::lock_guard lock(mutex);
+    for (auto itr = entries.begin(); itr != entries.end();) {
+        if (!FileUtil::Exists(itr->first)) {
+            itr = entries.erase(itr);
+            dirty = true;
+        } else {
+            ++itr;
+        }
+    }
+    if (!dirty) {
+        return true;
+    }
+
+    // Write to a temporary file first, so that a crash can't leave a truncated cache behind
+    const std::string temp_path = cache_path + ".tmp";
+    if (!FileUtil::CreateFullPath(cache_path)) {
+        return false;
+    }
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        CacheHeader header{};
+        header.magic = CACHE_MAGIC;
+        header.version = CACHE_VERSION;
+        header.num_entries = static_cast<u32>(entries.size());
+        bool success = file.IsOpen() && file.WriteObject(header) == 1;
+        for (const auto& [path, entry] : entries) {
+            CacheEntryHeader entry_header{};
+            entry_header.size = entry.size;
+            entry_header.modification_time = entry.modification_time;
+            entry_header.program_id = entry.info.program_id;
+            entry_header.extdata_id = entry.info.extdata_id;
+            entry_header.file_type = static_cast<u32>(entry.info.file_type);
+            entry_header.path_length = static_cast<u32>(path.size());
+            entry_header.smdh_length = static_cast<u32>(entry.info.smdh.size());
+            success = success && file.WriteObject(entry_header) == 1 &&
+                      file.WriteBytes(path.data(), path.size()) == path.size() &&
+                      file.WriteBytes(entry.info.smdh.data(), entry.info.smdh.size()) ==
+                          entry.info.smdh.size();
+        }
+        if (!success || !file.Close()) {
+            LOG_ERROR(Loader, "Failed to write the title info cache {}", temp_path);
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+
+    FileUtil::Delete(cache_path);
+    if (!FileUtil::Rename(temp_path, cache_path)) {
+        LOG_ERROR(Loader, "Failed to replace the title info cache {}", cache_path);
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+std::string GetDefaultTitleInfoCachePath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "game_list" DIR_SEP
+                                                                 "title_info.bin";
+}
+
+} // namespace Loader
@@ -0,0 +1,69 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "core/loader/loader.h"
+
+namespace Loader {
+
+/// What a title list needs to know about a bootable file
+struct TitleInfo {
+    /// FileType::Unknown if no loader could open the file
+    FileType file_type = FileType::Unknown;
+    u64 program_id = 0;
+    u64 extdata_id = 0;
+    std::vector<u8> smdh;
+};
+
+/**
+ * Remembers the TitleInfo of files between runs, so that listing a large collection of titles
+ * only has to open the files that were added or changed since the last time.
+ *
+ * Entries are keyed by path and are only used while the size and modification time of the file
+ * are the ones it had when it was read. Files that couldn't be read completely aren't remembered,
+ * so that they are read again once the keys or seeds they need have been added.
+ */
+class TitleInfoCache {
+public:
+    /// Loads the cache from a file. A missing or invalid file gives an empty cache.
+    explicit TitleInfoCache(std::string cache_path);
+
+    /// Returns the info of a file, reading it if it isn't cached or has changed. Thread-safe.
+    TitleInfo Get(const std::string& path);
+
+    /**
+     * Gets the info of several files, reading the ones that aren't cached on worker threads.
+     * @param cancel Stops the scan early when set. The remaining files are left out of the result.
+     * @returns The info of each file, in the order of paths
+     */
+    std::vector<TitleInfo> Scan(const std::vector<std::string>& paths,
+                                const std::atomic_bool* cancel = nullptr);
+
+    /// Writes the cache back if it changed, leaving out entries whose file no longer exists
+    bool Save();
+
+private:
+    struct Entry {
+        u64 size;
+        s64 modification_time;
+        TitleInfo info;
+    };
+
+    std::string cache_path;
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    bool dirty = false;
+};
+
+/// Returns the path of the title info cache shared by the frontends
+std::string GetDefaultTitleInfoCachePath();
+
+} // namespace Loader
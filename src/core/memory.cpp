@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstring>
 #include "audio_core/dsp_interface.h"
 #include "common/assert.h"
@@ -54,38 +56,279 @@ private:
     std::array<bool, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
 };
 
+/// Size of the memory whose writes are tracked: FCRAM, VRAM and the N3DS extra RAM
+constexpr std::size_t TRACKED_MEMORY_SIZE = FCRAM_N3DS_SIZE + VRAM_SIZE + N3DS_EXTRA_RAM_SIZE;
+constexpr std::size_t TRACKED_PAGE_COUNT = TRACKED_MEMORY_SIZE / PAGE_SIZE;
+
+/// CPU core whose page table the calling host thread uses, see MemorySystem::SetRunningCore()
+static thread_local u32 running_core_id = 0;
+
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // Visual Studio would try to allocate this on compile time if it was a std::array, which would
+    // exceed the memory limit. FCRAM, VRAM and the N3DS extra RAM share the allocation so that
+    // turning a host pointer into a dirty page index takes a single range check.
+    std::unique_ptr<u8[]> backing_memory = std::make_unique<u8[]>(TRACKED_MEMORY_SIZE);
+    u8* const fcram = backing_memory.get();
+    u8* const vram = fcram + FCRAM_N3DS_SIZE;
+    u8* const n3ds_extra_ram = vram + VRAM_SIZE;
+
+    /// One bit per page of the backing memory, set when the page is written. The host threads
+    /// running the CPU cores write to memory at the same time, so the bits are set atomically.
+    std::vector<std::atomic<u64>> dirty_pages =
+        std::vector<std::atomic<u64>>((TRACKED_PAGE_COUNT + 63) / 64);
+    /// Whether clean pages are write protected in the page tables, see SetWriteTracking()
+    bool write_tracking = false;
+
+    /// A page table entry that maps a page of the backing memory
+    struct PageMapping {
+        PageTable* page_table;
+        std::size_t page;
+    };
+    /// For every page of the backing memory, the entries of the registered page tables that mapped
+    /// it while write tracking was enabled, so that clearing the dirty flags of a range only has to
+    /// visit the entries of that range. Entries can be stale, as they are not removed when the page
+    /// is remapped, and are checked against the page table before they are used. Empty while write
+    /// tracking is disabled.
+    std::vector<std::vector<PageMapping>> page_mappings;
+
+    /// The page table a CPU core accesses memory through, and the core to notify of changes
+    struct CoreState {
+        PageTable* page_table = nullptr;
+        ARM_Interface* cpu = nullptr;
+    };
+    std::vector<CoreState> cores = std::vector<CoreState>(1);
 
-    PageTable* current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
     std::vector<PageTable*> page_table_list;
 
-    ARM_Interface* cpu = nullptr;
     AudioCore::DspInterface* dsp = nullptr;
+
+    PageTable* GetCurrentPageTable() const {
+        return cores[running_core_id].page_table;
+    }
+
+    /// Returns the offset of a pointer into the backing memory, which is at least
+    /// TRACKED_MEMORY_SIZE for pointers outside of it
+    std::size_t GetTrackedOffset(const u8* pointer) const {
+        return reinterpret_cast<std::uintptr_t>(pointer) - reinterpret_cast<std::uintptr_t>(fcram);
+    }
+
+    /// Marks the pages of the backing memory overlapping the given host range as dirty. Pointers
+    /// outside of the backing memory, like those to DSP RAM, are ignored.
+    void MarkDirty(const u8* pointer, std::size_t size) {
+        const std::size_t offset = GetTrackedOffset(pointer);
+        if (offset >= TRACKED_MEMORY_SIZE || size == 0) {
+            return;
+        }
+        const std::size_t end = std::min(offset + size, TRACKED_MEMORY_SIZE);
+        const std::size_t first_page = offset >> PAGE_BITS;
+        const std::size_t last_page = (end - 1) >> PAGE_BITS;
+        for (std::size_t page = first_page; page <= last_page; ++page) {
+            std::atomic<u64>& word = dirty_pages[page / 64];
+            const u64 bit = u64{1} << (page % 64);
+            // Most writes hit pages that are already dirty, which doesn't need a locked operation
+            if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+                word.fetch_or(bit, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Checks whether the pointer is into a page of the backing memory that is not dirty
+    bool IsCleanPage(const u8* pointer) const {
+        const std::size_t offset = GetTrackedOffset(pointer);
+        if (offset >= TRACKED_MEMORY_SIZE) {
+            return false;
+        }
+        const std::size_t page = offset >> PAGE_BITS;
+        const u64 word = dirty_pages[page / 64].load(std::memory_order_relaxed);
+        return (word & (u64{1} << (page % 64))) == 0;
+    }
+
+    bool IsRegistered(const PageTable& page_table) const {
+        return std::find(page_table_list.begin(), page_table_list.end(), &page_table) !=
+               page_table_list.end();
+    }
+
+    /// Makes accesses to a page of regular memory go through MemorySystem until it is written
+    static void ProtectPage(PageTable& page_table, std::size_t page) {
+        page_table.write_tracked_pointers[page] = page_table.pointers[page];
+        page_table.attributes[page] = PageType::WriteTrackedMemory;
+        page_table.pointers[page] = nullptr;
+    }
+
+    /// Gives a write tracked page its pointer back, returning it
+    static u8* UnprotectPage(PageTable& page_table, std::size_t page) {
+        const auto itr = page_table.write_tracked_pointers.find(page);
+        ASSERT(itr != page_table.write_tracked_pointers.end());
+        u8* const pointer = itr->second;
+        page_table.write_tracked_pointers.erase(itr);
+        page_table.attributes[page] = PageType::Memory;
+        page_table.pointers[page] = pointer;
+        return pointer;
+    }
+
+    /// Remembers that a page table entry maps memory, if it is memory whose writes are tracked
+    void AddPageMapping(PageTable& page_table, std::size_t page, const u8* pointer) {
+        const std::size_t offset = GetTrackedOffset(pointer);
+        if (offset >= TRACKED_MEMORY_SIZE) {
+            return;
+        }
+        auto& mappings = page_mappings[offset >> PAGE_BITS];
+        const auto itr = std::find_if(mappings.begin(), mappings.end(), [&](const auto& mapping) {
+            return mapping.page_table == &page_table && mapping.page == page;
+        });
+        if (itr == mappings.end()) {
+            mappings.push_back({&page_table, page});
+        }
+    }
+
+    /// Write protects the clean pages of the backing memory in every registered page table, and
+    /// starts remembering the entries that map them
+    void StartWriteTracking() {
+        page_mappings.resize(TRACKED_PAGE_COUNT);
+        for (PageTable* page_table : page_table_list) {
+            for (std::size_t page = 0; page < PAGE_TABLE_NUM_ENTRIES; ++page) {
+                if (page_table->attributes[page] != PageType::Memory) {
+                    continue;
+                }
+                AddPageMapping(*page_table, page, page_table->pointers[page]);
+                if (IsCleanPage(page_table->pointers[page])) {
+                    ProtectPage(*page_table, page);
+                }
+            }
+        }
+    }
+
+    /// Gives every write protected page in the registered page tables its pointer back
+    void StopWriteTracking() {
+        for (PageTable* page_table : page_table_list) {
+            for (const auto& [page, pointer] : page_table->write_tracked_pointers) {
+                page_table->attributes[page] = PageType::Memory;
+                page_table->pointers[page] = pointer;
+            }
+            page_table->write_tracked_pointers.clear();
+        }
+        page_mappings = {};
+    }
+
+    /// Write protects the entries mapping the clean pages among [first_page, end_page) of the
+    /// backing memory, and forgets the entries that don't map them anymore
+    void ProtectCleanPages(std::size_t first_page, std::size_t end_page) {
+        for (std::size_t tracked_page = first_page; tracked_page < end_page; ++tracked_page) {
+            u8* const pointer = fcram + (tracked_page << PAGE_BITS);
+            if (!IsCleanPage(pointer)) {
+                continue;
+            }
+            // Protects an entry that still maps the page, and returns whether it is stale
+            const auto protect_entry = [pointer](const PageMapping& mapping) {
+                PageTable& page_table = *mapping.page_table;
+                switch (page_table.attributes[mapping.page]) {
+                case PageType::Memory:
+                    if (page_table.pointers[mapping.page] != pointer) {
+                        return true;
+                    }
+                    ProtectPage(page_table, mapping.page);
+                    return false;
+                case PageType::WriteTrackedMemory: {
+                    const auto itr = page_table.write_tracked_pointers.find(mapping.page);
+                    return itr == page_table.write_tracked_pointers.end() || itr->second != pointer;
+                }
+                case PageType::RasterizerCachedMemory:
+                    // Checked once the page is no longer cached
+                    return false;
+                default:
+                    return true;
+                }
+            };
+            auto& mappings = page_mappings[tracked_page];
+            mappings.erase(std::remove_if(mappings.begin(), mappings.end(), protect_entry),
+                           mappings.end());
+        }
+    }
+
+    /**
+     * Finds the dirty pages tracking a physical range.
+     * @returns the first page and the end page, or an empty range if the memory is not tracked
+     */
+    std::pair<std::size_t, std::size_t> GetPageRange(PAddr address, u32 size) const {
+        struct TrackedArea {
+            PAddr paddr_base;
+            u32 size;
+            std::size_t offset;
+        };
+        static constexpr TrackedArea tracked_areas[] = {
+            {FCRAM_PADDR, FCRAM_N3DS_SIZE, 0},
+            {VRAM_PADDR, VRAM_SIZE, FCRAM_N3DS_SIZE},
+            {N3DS_EXTRA_RAM_PADDR, N3DS_EXTRA_RAM_SIZE, FCRAM_N3DS_SIZE + VRAM_SIZE},
+        };
+
+        for (const auto& area : tracked_areas) {
+            if (address < area.paddr_base || address - area.paddr_base >= area.size) {
+                continue;
+            }
+            const u32 offset_into_area = address - area.paddr_base;
+            const u32 clamped_size = std::min(size, area.size - offset_into_area);
+            if (clamped_size == 0) {
+                break;
+            }
+            const std::size_t begin = area.offset + offset_into_area;
+            return {begin >> PAGE_BITS, ((begin + clamped_size - 1) >> PAGE_BITS) + 1};
+        }
+        return {0, 0};
+    }
+
+    /**
+     * Calls func(word, mask) for every word of the dirty bitmap covering the pages
+     * [first_page, end_page), with the bits of those pages set in mask. Stops early when func
+     * returns true.
+     * @returns whether func returned true
+     */
+    template <typename Func>
+    bool ForEachDirtyWord(std::size_t first_page, std::size_t end_page, Func&& func) {
+        while (first_page < end_page) {
+            const std::size_t word = first_page / 64;
+            const std::size_t word_end = std::min(end_page, (word + 1) * 64);
+            const std::size_t bits = word_end - first_page;
+            const u64 mask = (bits == 64 ? ~u64{0} : ((u64{1} << bits) - 1)) << (first_page % 64);
+            if (func(dirty_pages[word], mask)) {
+                return true;
+            }
+            first_page = word_end;
+        }
+        return false;
+    }
 };
 
 MemorySystem::MemorySystem() : impl(std::make_unique<Impl>()) {}
 MemorySystem::~MemorySystem() = default;
 
-void MemorySystem::SetCPU(ARM_Interface& cpu) {
-    impl->cpu = &cpu;
+void MemorySystem::SetCPU(ARM_Interface& cpu, u32 core_id) {
+    if (core_id >= impl->cores.size()) {
+        impl->cores.resize(core_id + 1);
+    }
+    impl->cores[core_id].cpu = &cpu;
+}
+
+void MemorySystem::SetRunningCore(u32 core_id) {
+    ASSERT(core_id < impl->cores.size());
+    running_core_id = core_id;
 }
 
 void MemorySystem::SetCurrentPageTable(PageTable* page_table) {
-    impl->current_page_table = page_table;
-    if (impl->cpu != nullptr) {
-        impl->cpu->PageTableChanged();
-    }
+    SetCurrentPageTable(page_table, running_core_id);
 }
 
 PageTable* MemorySystem::GetCurrentPageTable() const {
-    return impl->current_page_table;
+    return impl->GetCurrentPageTable();
+}
+
+void MemorySystem::SetCurrentPageTable(PageTable* page_table, u32 core_id) {
+    Impl::CoreState& core = impl->cores.at(core_id);
+    core.page_table = page_table;
+    if (core.cpu != nullptr) {
+        core.cpu->PageTableChanged();
+    }
 }
 
 void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memory, PageType type) {
@@ -95,17 +338,28 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    const bool registered = impl->write_tracking && impl->IsRegistered(page_table);
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
 
         page_table.attributes[base] = type;
         page_table.pointers[base] = memory;
+        if (!page_table.write_tracked_pointers.empty()) {
+            page_table.write_tracked_pointers.erase(base);
+        }
 
         // If the memory to map is already rasterizer-cached, mark the page
         if (type == PageType::Memory && impl->cache_marker.IsCached(base * PAGE_SIZE)) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
+        } else if (type == PageType::Memory && impl->write_tracking) {
+            if (registered) {
+                impl->AddPageMapping(page_table, base, memory);
+            }
+            if (impl->IsCleanPage(memory)) {
+                Impl::ProtectPage(page_table, base);
+            }
         }
 
         base += 1;
@@ -137,13 +391,13 @@ void MemorySystem::UnmapRegion(PageTable& page_table, VAddr base, u32 size) {
 
 u8* MemorySystem::GetPointerForRasterizerCache(VAddr addr) {
     if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - LINEAR_HEAP_VADDR);
+        return impl->fcram + (addr - LINEAR_HEAP_VADDR);
     }
     if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - NEW_LINEAR_HEAP_VADDR);
+        return impl->fcram + (addr - NEW_LINEAR_HEAP_VADDR);
     }
     if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
-        return impl->vram.get() + (addr - VRAM_VADDR);
+        return impl->vram + (addr - VRAM_VADDR);
     }
     UNREACHABLE();
 }
@@ -155,6 +409,13 @@ void MemorySystem::RegisterPageTable(PageTable* page_table) {
 void MemorySystem::UnregisterPageTable(PageTable* page_table) {
     impl->page_table_list.erase(
         std::find(impl->page_table_list.begin(), impl->page_table_list.end(), page_table));
+    for (auto& mappings : impl->page_mappings) {
+        mappings.erase(std::remove_if(mappings.begin(), mappings.end(),
+                                      [page_table](const Impl::PageMapping& mapping) {
+                                          return mapping.page_table == page_table;
+                                      }),
+                       mappings.end());
+    }
 }
 
 /**
@@ -170,12 +431,23 @@ static MMIORegionPointer GetMMIOHandler(const PageTable& page_table, VAddr vaddr
     return nullptr; // Should never happen
 }
 
+/**
+ * This function should only be called for virtual addreses with attribute
+ * `PageType::WriteTrackedMemory`.
+ */
+static u8* GetPointerForWriteTracking(const PageTable& page_table, VAddr vaddr) {
+    const auto itr = page_table.write_tracked_pointers.find(vaddr >> PAGE_BITS);
+    ASSERT_MSG(itr != page_table.write_tracked_pointers.end(),
+               "Write tracked page without a pointer @ {:08X}", vaddr);
+    return itr->second + (vaddr & PAGE_MASK);
+}
+
 template <typename T>
 T ReadMMIO(MMIORegionPointer mmio_handler, VAddr addr);
 
 template <typename T>
 T MemorySystem::Read(const VAddr vaddr) {
-    const u8* page_pointer = impl->current_page_table->pointers[vaddr >> PAGE_BITS];
+    const u8* page_pointer = impl->GetCurrentPageTable()->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
         // NOTE: Avoid adding any extra logic to this fast-path block
         T value;
@@ -183,7 +455,15 @@ T MemorySystem::Read(const VAddr vaddr) {
         return value;
     }
 
-    PageType type = impl->current_page_table->attributes[vaddr >> PAGE_BITS];
+    PageType type = impl->GetCurrentPageTable()->attributes[vaddr >> PAGE_BITS];
+    if (type != PageType::Unmapped && Core::System::GetInstance().IsCoreThread()) {
+        // The rasterizer, the MMIO handlers and the write tracking are only used from the
+        // emulation thread.
+        T value{};
+        Core::System::GetInstance().RunOnEmulationThread([&] { value = Read<T>(vaddr); });
+        return value;
+    }
+
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Read{} @ 0x{:08X}", sizeof(T) * 8, vaddr);
@@ -198,8 +478,14 @@ T MemorySystem::Read(const VAddr vaddr) {
         std::memcpy(&value, GetPointerForRasterizerCache(vaddr), sizeof(T));
         return value;
     }
+    case PageType::WriteTrackedMemory: {
+        T value;
+        std::memcpy(&value, GetPointerForWriteTracking(*impl->GetCurrentPageTable(), vaddr),
+                    sizeof(T));
+        return value;
+    }
     case PageType::Special:
-        return ReadMMIO<T>(GetMMIOHandler(*impl->current_page_table, vaddr), vaddr);
+        return ReadMMIO<T>(GetMMIOHandler(*impl->GetCurrentPageTable(), vaddr), vaddr);
     default:
         UNREACHABLE();
     }
@@ -210,14 +496,22 @@ void WriteMMIO(MMIORegionPointer mmio_handler, VAddr addr, const T data);
 
 template <typename T>
 void MemorySystem::Write(const VAddr vaddr, const T data) {
-    u8* page_pointer = impl->current_page_table->pointers[vaddr >> PAGE_BITS];
+    u8* page_pointer = impl->GetCurrentPageTable()->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
-        // NOTE: Avoid adding any extra logic to this fast-path block
+        // NOTE: Avoid adding any extra logic but dirty tracking to this fast-path block
         std::memcpy(&page_pointer[vaddr & PAGE_MASK], &data, sizeof(T));
+        impl->MarkDirty(&page_pointer[vaddr & PAGE_MASK], sizeof(T));
+        return;
+    }
+
+    PageType type = impl->GetCurrentPageTable()->attributes[vaddr >> PAGE_BITS];
+    if (type != PageType::Unmapped && Core::System::GetInstance().IsCoreThread()) {
+        // The rasterizer, the MMIO handlers and the write tracking are only used from the
+        // emulation thread.
+        Core::System::GetInstance().RunOnEmulationThread([&] { Write<T>(vaddr, data); });
         return;
     }
 
-    PageType type = impl->current_page_table->attributes[vaddr >> PAGE_BITS];
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Write{} 0x{:08X} @ 0x{:08X}", sizeof(data) * 8, (u32)data,
@@ -228,11 +522,21 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         break;
     case PageType::RasterizerCachedMemory: {
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
+        u8* pointer = GetPointerForRasterizerCache(vaddr);
+        std::memcpy(pointer, &data, sizeof(T));
+        impl->MarkDirty(pointer, sizeof(T));
+        break;
+    }
+    case PageType::WriteTrackedMemory: {
+        // First write to the page since it was cleared. Later ones can take the fast path.
+        u8* pointer = Impl::UnprotectPage(*impl->GetCurrentPageTable(), vaddr >> PAGE_BITS) +
+                      (vaddr & PAGE_MASK);
+        std::memcpy(pointer, &data, sizeof(T));
+        impl->MarkDirty(pointer, sizeof(T));
         break;
     }
     case PageType::Special:
-        WriteMMIO<T>(GetMMIOHandler(*impl->current_page_table, vaddr), vaddr, data);
+        WriteMMIO<T>(GetMMIOHandler(*impl->GetCurrentPageTable(), vaddr), vaddr, data);
         break;
     default:
         UNREACHABLE();
@@ -246,7 +550,8 @@ bool IsValidVirtualAddress(const Kernel::Process& process, const VAddr vaddr) {
     if (page_pointer)
         return true;
 
-    if (page_table.attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory)
+    if (page_table.attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory ||
+        page_table.attributes[vaddr >> PAGE_BITS] == PageType::WriteTrackedMemory)
         return true;
 
     if (page_table.attributes[vaddr >> PAGE_BITS] != PageType::Special)
@@ -265,16 +570,22 @@ bool MemorySystem::IsValidPhysicalAddress(const PAddr paddr) {
 }
 
 u8* MemorySystem::GetPointer(const VAddr vaddr) {
-    u8* page_pointer = impl->current_page_table->pointers[vaddr >> PAGE_BITS];
+    u8* page_pointer = impl->GetCurrentPageTable()->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
         return page_pointer + (vaddr & PAGE_MASK);
     }
 
-    if (impl->current_page_table->attributes[vaddr >> PAGE_BITS] ==
+    if (impl->GetCurrentPageTable()->attributes[vaddr >> PAGE_BITS] ==
         PageType::RasterizerCachedMemory) {
         return GetPointerForRasterizerCache(vaddr);
     }
 
+    if (impl->GetCurrentPageTable()->attributes[vaddr >> PAGE_BITS] ==
+        PageType::WriteTrackedMemory) {
+        // The caller has to mark the region dirty if it writes to it
+        return GetPointerForWriteTracking(*impl->GetCurrentPageTable(), vaddr);
+    }
+
     LOG_ERROR(HW_Memory, "unknown GetPointer @ 0x{:08x}", vaddr);
     return nullptr;
 }
@@ -323,16 +634,16 @@ u8* MemorySystem::GetPhysicalPointer(PAddr address) {
     u8* target_pointer = nullptr;
     switch (area->paddr_base) {
     case VRAM_PADDR:
-        target_pointer = impl->vram.get() + offset_into_region;
+        target_pointer = impl->vram + offset_into_region;
         break;
     case DSP_RAM_PADDR:
         target_pointer = impl->dsp->GetDspMemory().data() + offset_into_region;
         break;
     case FCRAM_PADDR:
-        target_pointer = impl->fcram.get() + offset_into_region;
+        target_pointer = impl->fcram + offset_into_region;
         break;
     case N3DS_EXTRA_RAM_PADDR:
-        target_pointer = impl->n3ds_extra_ram.get() + offset_into_region;
+        target_pointer = impl->n3ds_extra_ram + offset_into_region;
         break;
     default:
         UNREACHABLE();
@@ -385,6 +696,11 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         page_type = PageType::RasterizerCachedMemory;
                         page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
                         break;
+                    case PageType::WriteTrackedMemory:
+                        // Writes to rasterizer-cached pages are tracked anyway
+                        page_type = PageType::RasterizerCachedMemory;
+                        page_table->write_tracked_pointers.erase(vaddr >> PAGE_BITS);
+                        break;
                     default:
                         UNREACHABLE();
                     }
@@ -397,8 +713,14 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         break;
                     case PageType::RasterizerCachedMemory: {
                         page_type = PageType::Memory;
-                        page_table->pointers[vaddr >> PAGE_BITS] =
-                            GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+                        u8* const pointer = GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+                        page_table->pointers[vaddr >> PAGE_BITS] = pointer;
+                        if (impl->write_tracking) {
+                            impl->AddPageMapping(*page_table, vaddr >> PAGE_BITS, pointer);
+                            if (impl->IsCleanPage(pointer)) {
+                                Impl::ProtectPage(*page_table, vaddr >> PAGE_BITS);
+                            }
+                        }
                         break;
                     }
                     default:
@@ -530,6 +852,11 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
             std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
             break;
         }
+        case PageType::WriteTrackedMemory: {
+            std::memcpy(dest_buffer, GetPointerForWriteTracking(page_table, current_vaddr),
+                        copy_amount);
+            break;
+        }
         default:
             UNREACHABLE();
         }
@@ -580,6 +907,7 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
 
             u8* dest_ptr = page_table.pointers[page_index] + page_offset;
             std::memcpy(dest_ptr, src_buffer, copy_amount);
+            impl->MarkDirty(dest_ptr, copy_amount);
             break;
         }
         case PageType::Special: {
@@ -591,7 +919,15 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
         case PageType::RasterizerCachedMemory: {
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Invalidate);
-            std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
+            u8* dest_ptr = GetPointerForRasterizerCache(current_vaddr);
+            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            impl->MarkDirty(dest_ptr, copy_amount);
+            break;
+        }
+        case PageType::WriteTrackedMemory: {
+            u8* dest_ptr = GetPointerForWriteTracking(page_table, current_vaddr);
+            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            impl->MarkDirty(dest_ptr, copy_amount);
             break;
         }
         default:
@@ -630,6 +966,7 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
 
             u8* dest_ptr = page_table.pointers[page_index] + page_offset;
             std::memset(dest_ptr, 0, copy_amount);
+            impl->MarkDirty(dest_ptr, copy_amount);
             break;
         }
         case PageType::Special: {
@@ -641,7 +978,15 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
         case PageType::RasterizerCachedMemory: {
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Invalidate);
-            std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
+            u8* dest_ptr = GetPointerForRasterizerCache(current_vaddr);
+            std::memset(dest_ptr, 0, copy_amount);
+            impl->MarkDirty(dest_ptr, copy_amount);
+            break;
+        }
+        case PageType::WriteTrackedMemory: {
+            u8* dest_ptr = GetPointerForWriteTracking(page_table, current_vaddr);
+            std::memset(dest_ptr, 0, copy_amount);
+            impl->MarkDirty(dest_ptr, copy_amount);
             break;
         }
         default:
@@ -700,6 +1045,11 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
                        copy_amount);
             break;
         }
+        case PageType::WriteTrackedMemory: {
+            WriteBlock(dest_process, dest_addr,
+                       GetPointerForWriteTracking(page_table, current_vaddr), copy_amount);
+            break;
+        }
         default:
             UNREACHABLE();
         }
@@ -752,14 +1102,93 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
     mmio_handler->Write64(addr, data);
 }
 
+std::optional<PAddr> MemorySystem::GetPhysicalAddress(const u8* pointer) const {
+    const std::size_t offset = impl->GetTrackedOffset(pointer);
+    if (offset < FCRAM_N3DS_SIZE) {
+        return FCRAM_PADDR + static_cast<u32>(offset);
+    }
+    if (offset < FCRAM_N3DS_SIZE + VRAM_SIZE) {
+        return VRAM_PADDR + static_cast<u32>(offset - FCRAM_N3DS_SIZE);
+    }
+    if (offset < TRACKED_MEMORY_SIZE) {
+        return N3DS_EXTRA_RAM_PADDR + static_cast<u32>(offset - FCRAM_N3DS_SIZE - VRAM_SIZE);
+    }
+    if (impl->dsp != nullptr) {
+        const u8* dsp_memory = impl->dsp->GetDspMemory().data();
+        if (pointer >= dsp_memory && pointer < dsp_memory + DSP_RAM_SIZE) {
+            return DSP_RAM_PADDR + static_cast<u32>(pointer - dsp_memory);
+        }
+    }
+    return std::nullopt;
+}
+
 u32 MemorySystem::GetFCRAMOffset(u8* pointer) {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return pointer - impl->fcram.get();
+    ASSERT(pointer >= impl->fcram && pointer <= impl->fcram + Memory::FCRAM_N3DS_SIZE);
+    return pointer - impl->fcram;
 }
 
 u8* MemorySystem::GetFCRAMPointer(u32 offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
+}
+
+void MemorySystem::MarkRegionDirty(PAddr start, u32 size) {
+    const auto [first_page, end_page] = impl->GetPageRange(start, size);
+    impl->ForEachDirtyWord(first_page, end_page, [](std::atomic<u64>& word, u64 mask) {
+        word |= mask;
+        return false;
+    });
+}
+
+void MemorySystem::MarkHostRegionDirty(const u8* pointer, std::size_t size) {
+    impl->MarkDirty(pointer, size);
+}
+
+bool MemorySystem::IsRegionDirty(PAddr start, u32 size) const {
+    const auto [first_page, end_page] = impl->GetPageRange(start, size);
+    return impl->ForEachDirtyWord(first_page, end_page, [](std::atomic<u64>& word, u64 mask) {
+        return (word & mask) != 0;
+    });
+}
+
+void MemorySystem::ClearRegionDirty(PAddr start, u32 size) {
+    const auto [first_page, end_page] = impl->GetPageRange(start, size);
+    impl->ForEachDirtyWord(first_page, end_page, [](std::atomic<u64>& word, u64 mask) {
+        word &= ~mask;
+        return false;
+    });
+    if (impl->write_tracking) {
+        impl->ProtectCleanPages(first_page, end_page);
+    }
+}
+
+bool MemorySystem::CheckAndClearRegionDirty(PAddr start, u32 size) {
+    const auto [first_page, end_page] = impl->GetPageRange(start, size);
+    bool dirty = false;
+    impl->ForEachDirtyWord(first_page, end_page, [&dirty](std::atomic<u64>& word, u64 mask) {
+        dirty = (word.fetch_and(~mask) & mask) != 0 || dirty;
+        return false;
+    });
+    if (impl->write_tracking) {
+        impl->ProtectCleanPages(first_page, end_page);
+    }
+    return dirty;
+}
+
+void MemorySystem::SetWriteTracking(bool enabled) {
+    if (enabled == impl->write_tracking) {
+        return;
+    }
+    impl->write_tracking = enabled;
+    if (enabled) {
+        impl->StartWriteTracking();
+    } else {
+        impl->StopWriteTracking();
+    }
+}
+
+bool MemorySystem::IsWriteTrackingEnabled() const {
+    return impl->write_tracking;
 }
 
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
@@ -7,7 +7,9 @@
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
 #include "core/mmio.h"
@@ -46,6 +48,10 @@ enum class PageType {
     RasterizerCachedMemory,
     /// Page is mapped to a I/O region. Writing and reading to this page is handled by functions.
     Special,
+    /// Page is mapped to regular memory that hasn't been written since its dirty flag was cleared,
+    /// while write tracking is enabled. Accesses go through MemorySystem so that the first write,
+    /// including one made by the JIT, marks the page dirty.
+    WriteTrackedMemory,
 };
 
 struct SpecialRegion {
@@ -78,6 +84,9 @@ struct PageTable {
      * the corresponding entry in `pointers` MUST be set to null.
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+
+    /// Memory backing the pages whose entries in the `attributes` array are `WriteTrackedMemory`
+    std::unordered_map<std::size_t, u8*> write_tracked_pointers;
 };
 
 /// Physical memory regions as seen from the ARM11
@@ -220,8 +229,14 @@ public:
     MemorySystem();
     ~MemorySystem();
 
-    /// Sets CPU to notify page table change
-    void SetCPU(ARM_Interface& cpu);
+    /// Sets the CPU core with the given ID, which is notified when its page table changes
+    void SetCPU(ARM_Interface& cpu, u32 core_id);
+
+    /**
+     * Makes the calling host thread access memory through the page table of the given CPU core.
+     * Every host thread starts out as core 0.
+     */
+    void SetRunningCore(u32 core_id);
 
     /**
      * Maps an allocated buffer onto a region of the emulated process address space.
@@ -244,10 +259,13 @@ public:
 
     void UnmapRegion(PageTable& page_table, VAddr base, u32 size);
 
-    /// Currently active page table
+    /// Page table of the CPU core the calling host thread runs
     void SetCurrentPageTable(PageTable* page_table);
     PageTable* GetCurrentPageTable() const;
 
+    /// Sets the page table of the given CPU core
+    void SetCurrentPageTable(PageTable* page_table, u32 core_id);
+
     u8 Read8(VAddr addr);
     u16 Read16(VAddr addr);
     u32 Read32(VAddr addr);
@@ -275,6 +293,13 @@ public:
      */
     u8* GetPhysicalPointer(PAddr address);
 
+    /**
+     * Gets the physical address of a pointer into the emulated physical memory, the reverse of
+     * GetPhysicalPointer().
+     * @returns The address, or std::nullopt if the pointer doesn't point into physical memory.
+     */
+    std::optional<PAddr> GetPhysicalAddress(const u8* pointer) const;
+
     u8* GetPointer(VAddr vaddr);
 
     bool IsValidPhysicalAddress(PAddr paddr);
@@ -298,6 +323,43 @@ public:
 
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /**
+     * Marks each page touching the physical region as dirty.
+     *
+     * Pages of FCRAM, VRAM and the N3DS extra RAM are tracked, other memory is ignored. Writes made
+     * through Write8-64, WriteBlock, ZeroBlock and CopyBlock, and GPU DMA, mark their pages
+     * automatically. Code writing through GetPointer(), GetPhysicalPointer() or GetFCRAMPointer()
+     * has to call this or MarkHostRegionDirty(). Writes the JIT makes through the page table are
+     * only tracked while write tracking is enabled.
+     */
+    void MarkRegionDirty(PAddr start, u32 size);
+
+    /// Marks each page touching the region as dirty, given a pointer into the emulated memory
+    void MarkHostRegionDirty(const u8* pointer, std::size_t size);
+
+    /// Checks whether any page touching the physical region was written since it was cleared
+    bool IsRegionDirty(PAddr start, u32 size) const;
+
+    /// Marks each page touching the physical region as clean
+    void ClearRegionDirty(PAddr start, u32 size);
+
+    /**
+     * Checks whether any page touching the physical region was written since it was cleared, and
+     * marks them all as clean. Meant for consumers polling a region once per frame.
+     */
+    bool CheckAndClearRegionDirty(PAddr start, u32 size);
+
+    /**
+     * Enables or disables write tracking. While it is enabled, the page table entries of clean
+     * pages don't point at their memory, so that the first write to them goes through
+     * MemorySystem even when made by the JIT, at the cost of slower reads until then. Enabling it
+     * scans all page tables, after which clearing the dirty flags of a region only protects the
+     * page table entries mapping that region.
+     */
+    void SetWriteTracking(bool enabled);
+
+    bool IsWriteTrackingEnabled() const;
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -14,6 +14,7 @@ enum class PacketType {
     Undefined = 0,
     ReadMemory,
     WriteMemory,
+    GetIPCStats,
 };
 
 struct PacketHeader {
@@ -25,9 +26,10 @@ struct PacketHeader {
 
 constexpr u32 CURRENT_VERSION = 1;
 constexpr u32 MIN_PACKET_SIZE = sizeof(PacketHeader);
-constexpr u32 MAX_PACKET_DATA_SIZE = 32;
+constexpr u32 MAX_PACKET_DATA_SIZE = 40;
 constexpr u32 MAX_PACKET_SIZE = MIN_PACKET_SIZE + MAX_PACKET_DATA_SIZE;
-constexpr u32 MAX_READ_SIZE = MAX_PACKET_DATA_SIZE;
+/// Largest memory read, which also bounds memory writes together with their address and size
+constexpr u32 MAX_READ_SIZE = 32;
 
 class Packet {
 public:
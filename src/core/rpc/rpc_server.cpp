@@ -1,7 +1,9 @@
+#include "common/common_funcs.h"
 #include "common/logging/log.h"
-#include "core/arm/arm_interface.h"
+#include "common/swap.h"
 #include "core/core.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/service/ipc_stats.h"
 #include "core/memory.h"
 #include "core/rpc/packet.h"
 #include "core/rpc/rpc_server.h"
@@ -46,17 +48,48 @@ void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u
         Core::System::GetInstance().Memory().WriteBlock(
             *Core::System::GetInstance().Kernel().GetCurrentProcess(), address, data, data_size);
         // If the memory happens to be executable code, make sure the changes become visible
-        Core::CPU().InvalidateCacheRange(address, data_size);
+        Core::System::GetInstance().InvalidateCacheRange(address, data_size);
     }
     packet.SetPacketDataSize(0);
     packet.SendReply();
 }
 
+void RPCServer::HandleGetIPCStats(Packet& packet, u32 index) {
+    // Replies with the statistics of one service command, or with no data past the last one
+    struct IPCStatsReply {
+        std::array<char, 8> service_name;
+        u32_le header;
+        INSERT_PADDING_WORDS(1);
+        u64_le calls;
+        u64_le host_ns;
+        u64_le sleep_ticks;
+    };
+    static_assert(sizeof(IPCStatsReply) == MAX_PACKET_DATA_SIZE);
+
+    if (index >= Service::IPCStats::GetEntryCount()) {
+        packet.SetPacketDataSize(0);
+        packet.SendReply();
+        return;
+    }
+
+    const Service::IPCCommandStats& entry = Service::IPCStats::GetEntryAt(index);
+    IPCStatsReply reply{};
+    reply.service_name = entry.service_name;
+    reply.header = entry.header;
+    reply.calls = entry.calls.load(std::memory_order_relaxed);
+    reply.host_ns = entry.host_ns.load(std::memory_order_relaxed);
+    reply.sleep_ticks = entry.sleep_ticks.load(std::memory_order_relaxed);
+    std::memcpy(packet.GetPacketData().data(), &reply, sizeof(reply));
+    packet.SetPacketDataSize(sizeof(reply));
+    packet.SendReply();
+}
+
 bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
     if (packet_header.version <= CURRENT_VERSION) {
         switch (packet_header.packet_type) {
         case PacketType::ReadMemory:
         case PacketType::WriteMemory:
+        case PacketType::GetIPCStats:
             if (packet_header.packet_size >= (sizeof(u32) * 2)) {
                 return true;
             }
@@ -87,12 +120,17 @@ void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
             }
             break;
         case PacketType::WriteMemory:
-            if (data_size > 0 && data_size <= MAX_PACKET_DATA_SIZE - (sizeof(u32) * 2)) {
+            if (data_size > 0 && data_size <= MAX_READ_SIZE - (sizeof(u32) * 2)) {
                 const u8* data = request_packet->GetPacketData().data() + (sizeof(u32) * 2);
                 HandleWriteMemory(*request_packet, address, data, data_size);
                 success = true;
             }
             break;
+        case PacketType::GetIPCStats:
+            // The address field holds the index of the entry
+            HandleGetIPCStats(*request_packet, address);
+            success = true;
+            break;
         default:
             break;
         }
@@ -0,0 +1,572 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <cryptopp/filters.h>
+#include <cryptopp/zlib.h>
+#include "common/chunk_file.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/service/service.h"
+#include "core/hw/hw.h"
+#include "core/memory.h"
+#include "core/savestate.h"
+#include "video_core/pica.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<u8, 4> STATE_MAGIC{{'C', 'S', 'T', 0x1A}};
+constexpr u32 STATE_VERSION = 4;
+
+/// Number of incremental states an incremental state may be based on
+constexpr std::size_t MAX_STATE_CHAIN_LENGTH = 256;
+
+/// Speed matters more than size here, and deflate levels above 1 are several times slower.
+constexpr unsigned int DEFLATE_LEVEL = 1;
+
+/// Number of memory pages covered by each memory chunk
+constexpr u32 PAGES_PER_CHUNK = 256;
+
+/// Largest chunk accepted when loading, to not trust sizes read from corrupted files blindly
+constexpr u32 MAX_CHUNK_SIZE = 16 * 1024 * 1024;
+
+enum class ChunkType : u32 {
+    End = 0,
+    Kernel = 1,
+    Timing = 2,
+    CPU = 3,
+    Hardware = 4,
+    Pica = 5,
+    Memory = 6,
+    Services = 7,
+};
+
+struct StateHeader {
+    std::array<u8, 4> magic;
+    u32_le version;
+    u64_le program_id;
+    u64_le snapshot_id;
+    /// Snapshot ID of the state an incremental state is based on, 0 for full states
+    u64_le base_snapshot_id;
+    /// File name of the state an incremental state is based on
+    std::array<char, 128> base_file_name;
+};
+static_assert(std::is_trivially_copyable_v<StateHeader>);
+
+struct ChunkHeader {
+    u32_le type;
+    u32_le raw_size;
+    u32_le compressed_size;
+};
+static_assert(std::is_trivially_copyable_v<ChunkHeader>);
+
+struct MemoryChunkHeader {
+    u32_le region;
+    u32_le first_page;
+    u32_le num_pages;
+    /// Bit i is set if page first_page + i is stored in the chunk. Pages are stored in order.
+    std::array<u8, PAGES_PER_CHUNK / 8> stored_pages;
+};
+static_assert(std::is_trivially_copyable_v<MemoryChunkHeader>);
+
+struct MemoryRegion {
+    PAddr paddr;
+    u32 size;
+    /// Whether MemorySystem tracks the pages written in this region. Incremental states store
+    /// all of the other regions.
+    bool dirty_tracked;
+};
+
+constexpr std::array<MemoryRegion, 4> MEMORY_REGIONS{{
+    {Memory::FCRAM_PADDR, Memory::FCRAM_N3DS_SIZE, true},
+    {Memory::VRAM_PADDR, Memory::VRAM_SIZE, true},
+    {Memory::DSP_RAM_PADDR, Memory::DSP_RAM_SIZE, false},
+    {Memory::N3DS_EXTRA_RAM_PADDR, Memory::N3DS_EXTRA_RAM_SIZE, true},
+}};
+
+u64 GenerateSnapshotId() {
+    std::random_device device;
+    u64 id;
+    do {
+        id = (static_cast<u64>(device()) << 32) | device();
+    } while (id == 0);
+    return id;
+}
+
+std::string GetDirectory(const std::string& path) {
+    return path.substr(0, path.find_last_of("/\\") + 1);
+}
+
+std::string GetFileName(const std::string& path) {
+    return path.substr(path.find_last_of("/\\") + 1);
+}
+
+bool IsZeroPage(const u8* page) {
+    return std::all_of(page, page + Memory::PAGE_SIZE, [](u8 value) { return value == 0; });
+}
+
+/// Runs do_state in measure and then in write mode, returning the written data
+template <typename Func>
+std::vector<u8> SerializeState(Func&& do_state) {
+    u8* ptr = nullptr;
+    PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+    do_state(measure);
+
+    std::vector<u8> data(reinterpret_cast<std::size_t>(ptr));
+    ptr = data.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    do_state(p);
+    ASSERT(ptr == data.data() + data.size());
+    return data;
+}
+
+/// Runs do_state in read mode, checking that it consumed exactly the given data
+template <typename Func>
+bool DeserializeState(std::vector<u8>& data, Func&& do_state) {
+    u8* ptr = data.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_READ);
+    do_state(p);
+    if (p.error == PointerWrap::ERROR_FAILURE || ptr != data.data() + data.size()) {
+        LOG_ERROR(Core, "Failed to restore state chunk");
+        return false;
+    }
+    return true;
+}
+
+bool WriteChunk(FileUtil::IOFile& file, ChunkType type, const std::vector<u8>& data) {
+    std::string compressed;
+    try {
+        CryptoPP::ZlibCompressor compressor(new CryptoPP::StringSink(compressed), DEFLATE_LEVEL);
+        compressor.Put(data.data(), data.size());
+        compressor.MessageEnd();
+    } catch (const CryptoPP::Exception& e) {
+        LOG_ERROR(Core, "Failed to compress state chunk: {}", e.what());
+        return false;
+    }
+
+    ChunkHeader header;
+    header.type = static_cast<u32>(type);
+    header.raw_size = static_cast<u32>(data.size());
+    header.compressed_size = static_cast<u32>(compressed.size());
+    return file.WriteObject(header) == 1 &&
+           file.WriteBytes(compressed.data(), compressed.size()) == compressed.size();
+}
+
+bool ReadChunk(FileUtil::IOFile& file, ChunkType& type, std::vector<u8>& data) {
+    ChunkHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        LOG_ERROR(Core, "State file is truncated");
+        return false;
+    }
+
+    if (header.raw_size > MAX_CHUNK_SIZE || header.compressed_size > MAX_CHUNK_SIZE) {
+        LOG_ERROR(Core, "State chunk is too large");
+        return false;
+    }
+
+    std::vector<u8> compressed(header.compressed_size);
+    if (file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        LOG_ERROR(Core, "State file is truncated");
+        return false;
+    }
+
+    type = static_cast<ChunkType>(static_cast<u32>(header.type));
+    data.resize(header.raw_size);
+    try {
+        auto sink = new CryptoPP::ArraySink(data.data(), data.size());
+        CryptoPP::ZlibDecompressor decompressor(sink);
+        decompressor.Put(compressed.data(), compressed.size());
+        decompressor.MessageEnd();
+        if (sink->TotalPutLength() != data.size()) {
+            LOG_ERROR(Core, "State chunk has the wrong size");
+            return false;
+        }
+    } catch (const CryptoPP::Exception& e) {
+        LOG_ERROR(Core, "Failed to decompress state chunk: {}", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool ReadHeader(FileUtil::IOFile& file, StateHeader& header, u64 program_id) {
+    if (!file.IsOpen() || file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != STATE_MAGIC) {
+        LOG_ERROR(Core, "Not a state file");
+        return false;
+    }
+    if (header.version != STATE_VERSION) {
+        LOG_ERROR(Core, "Unsupported state file version {}", static_cast<u32>(header.version));
+        return false;
+    }
+    if (static_cast<u64>(header.program_id) != program_id) {
+        LOG_ERROR(Core, "State file was saved from another title ({:016X})",
+                  static_cast<u64>(header.program_id));
+        return false;
+    }
+    return true;
+}
+
+void DoThreadContext(PointerWrap& p, ARM_Interface::ThreadContext& context) {
+    std::array<u32, 16> cpu_registers;
+    std::array<u32, 64> fpu_registers;
+    for (std::size_t i = 0; i < cpu_registers.size(); ++i) {
+        cpu_registers[i] = context.GetCpuRegister(i);
+    }
+    for (std::size_t i = 0; i < fpu_registers.size(); ++i) {
+        fpu_registers[i] = context.GetFpuRegister(i);
+    }
+    u32 cpsr = context.GetCpsr();
+    u32 fpscr = context.GetFpscr();
+    u32 fpexc = context.GetFpexc();
+
+    p.Do(cpu_registers);
+    p.Do(fpu_registers);
+    p.Do(cpsr);
+    p.Do(fpscr);
+    p.Do(fpexc);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        for (std::size_t i = 0; i < cpu_registers.size(); ++i) {
+            context.SetCpuRegister(i, cpu_registers[i]);
+        }
+        for (std::size_t i = 0; i < fpu_registers.size(); ++i) {
+            context.SetFpuRegister(i, fpu_registers[i]);
+        }
+        context.SetCpsr(cpsr);
+        context.SetFpscr(fpscr);
+        context.SetFpexc(fpexc);
+    }
+}
+
+u64 GetProgramId(System& system) {
+    const auto process = system.Kernel().GetCurrentProcess();
+    return process != nullptr ? process->codeset->program_id : 0;
+}
+
+} // Anonymous namespace
+
+SaveStateManager::SaveStateManager(System& system) : system(system) {}
+
+SaveStateManager::~SaveStateManager() = default;
+
+bool SaveStateManager::Save(const std::string& path, SaveStateMode mode) {
+    if (mode == SaveStateMode::Incremental &&
+        (last_snapshot_id == 0 || last_state_path == path ||
+         GetDirectory(last_state_path) != GetDirectory(path) ||
+         GetFileName(last_state_path).size() >= sizeof(StateHeader::base_file_name) ||
+         !FileUtil::Exists(last_state_path) || !system.Memory().IsWriteTrackingEnabled())) {
+        LOG_WARNING(Core, "No previous state to base an incremental state on, saving a full one");
+        mode = SaveStateMode::Full;
+    }
+    const bool incremental = mode == SaveStateMode::Incremental;
+
+    if (!system.Kernel().CanSaveState()) {
+        LOG_ERROR(Core, "The emulated system is waiting on an HLE service and can't be saved");
+        return false;
+    }
+
+    StateHeader header{};
+    header.magic = STATE_MAGIC;
+    header.version = STATE_VERSION;
+    header.program_id = GetProgramId(system);
+    header.snapshot_id = GenerateSnapshotId();
+    header.base_snapshot_id = incremental ? last_snapshot_id : 0;
+    if (incremental) {
+        const std::string base_file_name = GetFileName(last_state_path);
+        std::copy(base_file_name.begin(), base_file_name.end(), header.base_file_name.begin());
+    }
+
+    // Surfaces cached by the rasterizer may hold newer data than the emulated memory.
+    VideoCore::g_renderer->Rasterizer()->FlushAll();
+
+    FileUtil::CreateFullPath(path);
+    FileUtil::IOFile file(path, "wb");
+    bool success = file.IsOpen() && file.WriteObject(header) == 1;
+
+    const auto WriteState = [&](ChunkType type, auto&& do_state) {
+        success = success && WriteChunk(file, type, SerializeState(do_state));
+    };
+    WriteState(ChunkType::Kernel, [this](PointerWrap& p) { system.Kernel().DoState(p); });
+    WriteState(ChunkType::Services, [this](PointerWrap& p) { Service::DoState(system, p); });
+    WriteState(ChunkType::Timing, [this](PointerWrap& p) { system.CoreTiming().DoState(p); });
+    WriteState(ChunkType::CPU, [this](PointerWrap& p) { DoCpuState(p); });
+    WriteState(ChunkType::Hardware, [](PointerWrap& p) { HW::DoState(p); });
+    WriteState(ChunkType::Pica, [](PointerWrap& p) { Pica::DoState(p); });
+    success = success && WriteMemory(file, incremental);
+    success = success && WriteChunk(file, ChunkType::End, {});
+
+    if (!success || !file.Close()) {
+        LOG_ERROR(Core, "Failed to write state file {}", path);
+        // The dirty pages may no longer match any state on disk.
+        last_snapshot_id = 0;
+        return false;
+    }
+
+    ResetDirtyPages();
+    last_snapshot_id = header.snapshot_id;
+    last_state_path = path;
+    LOG_INFO(Core, "Saved {} state to {}", incremental ? "incremental" : "full", path);
+    return true;
+}
+
+bool SaveStateManager::Load(const std::string& path) {
+    const u64 program_id = GetProgramId(system);
+    FileUtil::IOFile file(path, "rb");
+    StateHeader header;
+    if (!ReadHeader(file, header, program_id)) {
+        LOG_ERROR(Core, "Failed to load state file {}", path);
+        return false;
+    }
+
+    // Find the states this one is based on, most recent first, before touching anything.
+    std::vector<std::string> base_paths;
+    StateHeader base_header = header;
+    while (static_cast<u64>(base_header.base_snapshot_id) != 0) {
+        if (base_paths.size() >= MAX_STATE_CHAIN_LENGTH) {
+            LOG_ERROR(Core, "Too many incremental states based on each other");
+            return false;
+        }
+        const u64 expected_id = base_header.base_snapshot_id;
+        const std::string base_file_name(base_header.base_file_name.data(),
+                                         strnlen(base_header.base_file_name.data(),
+                                                 base_header.base_file_name.size()));
+        const std::string base_path = GetDirectory(path) + base_file_name;
+        FileUtil::IOFile base_file(base_path, "rb");
+        if (!ReadHeader(base_file, base_header, program_id) ||
+            static_cast<u64>(base_header.snapshot_id) != expected_id) {
+            LOG_ERROR(Core, "State {} is based on {}, which is missing or was overwritten", path,
+                      base_path);
+            return false;
+        }
+        base_paths.push_back(base_path);
+    }
+
+    // The kernel state comes first, and refuses to load without modifying anything if the saved
+    // kernel objects can't be restored into the running system.
+    ChunkType type;
+    std::vector<u8> data;
+    if (!ReadChunk(file, type, data) || type != ChunkType::Kernel ||
+        !DeserializeState(data, [this](PointerWrap& p) { system.Kernel().DoState(p); })) {
+        LOG_ERROR(Core, "Failed to load state file {}", path);
+        return false;
+    }
+
+    // The services follow, referring to the objects of the kernel state.
+    if (!ReadChunk(file, type, data) || type != ChunkType::Services ||
+        !DeserializeState(data, [this](PointerWrap& p) { Service::DoState(system, p); })) {
+        LOG_CRITICAL(Core, "State file {} has invalid services, the system is now unusable", path);
+        last_snapshot_id = 0;
+        return false;
+    }
+    system.Kernel().ReleaseRestoredHLESessions();
+
+    // Memory is restored starting from the full state at the bottom of the chain.
+    ClearMemory();
+    bool success = true;
+    for (auto itr = base_paths.rbegin(); success && itr != base_paths.rend(); ++itr) {
+        FileUtil::IOFile base_file(*itr, "rb");
+        success = ReadHeader(base_file, base_header, program_id) && LoadChunks(base_file, true);
+    }
+    success = success && LoadChunks(file, false);
+
+    system.ClearInstructionCache();
+    for (const auto& region : MEMORY_REGIONS) {
+        VideoCore::g_renderer->Rasterizer()->InvalidateRegion(region.paddr, region.size);
+    }
+
+    if (!success) {
+        LOG_CRITICAL(Core, "State file {} is corrupted, the emulated system is now unusable", path);
+        last_snapshot_id = 0;
+        return false;
+    }
+
+    ResetDirtyPages();
+    last_snapshot_id = header.snapshot_id;
+    last_state_path = path;
+    LOG_INFO(Core, "Loaded state from {}", path);
+    return true;
+}
+
+void SaveStateManager::DoCpuState(PointerWrap& p) {
+    auto& kernel = system.Kernel();
+    for (u32 core_id = 0; core_id < system.GetNumCores(); ++core_id) {
+        ARM_Interface& cpu = system.GetCore(core_id);
+        auto context = cpu.NewContext();
+        cpu.SaveContext(context);
+        DoThreadContext(p, *context);
+
+        u32 thread_uprw = cpu.GetCP15Register(CP15_THREAD_UPRW);
+        u32 thread_uro = cpu.GetCP15Register(CP15_THREAD_URO);
+        p.Do(thread_uprw);
+        p.Do(thread_uro);
+
+        if (p.GetMode() == PointerWrap::MODE_READ) {
+            cpu.LoadContext(context);
+            cpu.SetCP15Register(CP15_THREAD_UPRW, thread_uprw);
+            cpu.SetCP15Register(CP15_THREAD_URO, thread_uro);
+        }
+
+        // The kernel state already put the thread lists back in the order they were saved in.
+        for (const auto& thread : kernel.GetThreadManager(core_id).GetThreadList()) {
+            u32 object_id = thread->GetObjectId();
+            p.Do(object_id);
+            if (object_id != thread->GetObjectId()) {
+                LOG_ERROR(Core, "Saved thread contexts don't match the threads");
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                return;
+            }
+            DoThreadContext(p, *thread->context);
+        }
+    }
+}
+
+bool SaveStateManager::WriteMemory(FileUtil::IOFile& file, bool incremental) {
+    Memory::MemorySystem& memory = system.Memory();
+    std::vector<u8> data;
+    for (u32 region_index = 0; region_index < MEMORY_REGIONS.size(); ++region_index) {
+        const MemoryRegion& region = MEMORY_REGIONS[region_index];
+        const u8* region_memory = memory.GetPhysicalPointer(region.paddr);
+        const u32 num_pages = region.size / Memory::PAGE_SIZE;
+
+        for (u32 first_page = 0; first_page < num_pages; first_page += PAGES_PER_CHUNK) {
+            const u32 chunk_pages = std::min(PAGES_PER_CHUNK, num_pages - first_page);
+            MemoryChunkHeader header{};
+            header.region = region_index;
+            header.first_page = first_page;
+            header.num_pages = chunk_pages;
+
+            data.resize(sizeof(header));
+            for (u32 i = 0; i < chunk_pages; ++i) {
+                const u32 page_offset = (first_page + i) * Memory::PAGE_SIZE;
+                const u8* page = region_memory + page_offset;
+                if (incremental) {
+                    if (region.dirty_tracked &&
+                        !memory.IsRegionDirty(region.paddr + page_offset, Memory::PAGE_SIZE)) {
+                        continue;
+                    }
+                } else if (IsZeroPage(page)) {
+                    continue;
+                }
+                header.stored_pages[i / 8] |= 1 << (i % 8);
+                data.insert(data.end(), page, page + Memory::PAGE_SIZE);
+            }
+
+            if (data.size() == sizeof(header)) {
+                continue;
+            }
+            std::memcpy(data.data(), &header, sizeof(header));
+            if (!WriteChunk(file, ChunkType::Memory, data)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SaveStateManager::LoadMemoryChunk(const std::vector<u8>& data) {
+    MemoryChunkHeader header;
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    const u32 region_index = header.region;
+    const u32 first_page = header.first_page;
+    const u32 num_pages = header.num_pages;
+    if (region_index >= MEMORY_REGIONS.size() || num_pages > PAGES_PER_CHUNK ||
+        first_page + num_pages > MEMORY_REGIONS[region_index].size / Memory::PAGE_SIZE) {
+        return false;
+    }
+
+    u8* memory = system.Memory().GetPhysicalPointer(MEMORY_REGIONS[region_index].paddr);
+    std::size_t offset = sizeof(header);
+    for (u32 i = 0; i < num_pages; ++i) {
+        if ((header.stored_pages[i / 8] & (1 << (i % 8))) == 0) {
+            continue;
+        }
+        if (offset + Memory::PAGE_SIZE > data.size()) {
+            return false;
+        }
+        std::memcpy(memory + (first_page + i) * Memory::PAGE_SIZE, data.data() + offset,
+                    Memory::PAGE_SIZE);
+        offset += Memory::PAGE_SIZE;
+    }
+    return offset == data.size();
+}
+
+bool SaveStateManager::LoadChunks(FileUtil::IOFile& file, bool memory_only) {
+    ChunkType type;
+    std::vector<u8> data;
+    while (ReadChunk(file, type, data)) {
+        if (type != ChunkType::Memory && memory_only) {
+            if (type == ChunkType::End) {
+                return true;
+            }
+            continue;
+        }
+
+        bool success = false;
+        switch (type) {
+        case ChunkType::End:
+            return true;
+        case ChunkType::Timing:
+            success = DeserializeState(data, [this](PointerWrap& p) {
+                system.CoreTiming().DoState(p);
+            });
+            break;
+        case ChunkType::CPU:
+            success = DeserializeState(data, [this](PointerWrap& p) { DoCpuState(p); });
+            break;
+        case ChunkType::Hardware:
+            success = DeserializeState(data, [](PointerWrap& p) { HW::DoState(p); });
+            break;
+        case ChunkType::Pica:
+            success = DeserializeState(data, [](PointerWrap& p) { Pica::DoState(p); });
+            break;
+        case ChunkType::Memory:
+            success = LoadMemoryChunk(data);
+            break;
+        default:
+            LOG_ERROR(Core, "Unexpected state chunk type {}", static_cast<u32>(type));
+            break;
+        }
+        if (!success) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void SaveStateManager::ClearMemory() {
+    for (const auto& region : MEMORY_REGIONS) {
+        std::memset(system.Memory().GetPhysicalPointer(region.paddr), 0, region.size);
+    }
+}
+
+void SaveStateManager::ResetDirtyPages() {
+    Memory::MemorySystem& memory = system.Memory();
+    memory.SetWriteTracking(true);
+    for (const auto& region : MEMORY_REGIONS) {
+        if (region.dirty_tracked) {
+            memory.ClearRegionDirty(region.paddr, region.size);
+        }
+    }
+}
+
+} // namespace Core
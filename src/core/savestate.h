@@ -0,0 +1,94 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+class PointerWrap;
+
+namespace FileUtil {
+class IOFile;
+}
+
+namespace Core {
+
+class System;
+
+/// How much of the emulated memory a save state stores
+enum class SaveStateMode {
+    /// Stores all of the emulated memory
+    Full,
+    /// Only stores the memory pages written since the previous save or load, and refers to that
+    /// state for the rest
+    Incremental,
+};
+
+/**
+ * Saves and restores the state of the emulated system.
+ *
+ * A state file is a header followed by a sequence of independently deflated chunks, so neither
+ * saving nor loading needs more than one chunk in host memory at a time. Memory is stored page by
+ * page, leaving out pages that are entirely zero. An incremental state only stores the pages that
+ * were written since the state it is based on, as tracked by MemorySystem's write tracking,
+ * which the first save or load enables. It must be in the same directory as that state, and is
+ * loaded by first loading the memory of that state.
+ *
+ * Loading recreates the kernel objects and restores the state of the HLE services, so a state can
+ * be loaded into a system that just booted the same title instead of the one that saved it. Host
+ * resources aren't part of a state: files opened through the HLE services are reopened, while
+ * network connections and the state of HLE frontend applets are lost.
+ */
+class SaveStateManager {
+public:
+    explicit SaveStateManager(System& system);
+    ~SaveStateManager();
+
+    /**
+     * Saves the state of the emulated system. Must be called from the emulation thread, between
+     * two runs of the CPU. Fails while a thread waits on an HLE service (see
+     * KernelSystem::CanSaveState()).
+     * @param mode Incremental saves fall back to full ones if there is no previous state to base
+     *             them on
+     * @returns true on success
+     */
+    bool Save(const std::string& path, SaveStateMode mode);
+
+    /**
+     * Loads the state of the emulated system. Must be called from the emulation thread, between
+     * two runs of the CPU.
+     * @returns true on success. On failure, the system is left untouched unless the error was
+     *          found after the kernel state was accepted, which happens for corrupted files and
+     *          for states whose services don't match the running ones (e.g. LLE modules).
+     */
+    bool Load(const std::string& path);
+
+private:
+    void DoCpuState(PointerWrap& p);
+
+    /// Writes the memory chunks
+    bool WriteMemory(FileUtil::IOFile& file, bool incremental);
+
+    /// Applies a memory chunk read from a state file
+    bool LoadMemoryChunk(const std::vector<u8>& data);
+
+    /// Reads and applies the chunks of a state file up to its end
+    bool LoadChunks(FileUtil::IOFile& file, bool memory_only);
+
+    /// Zeroes all of the emulated memory
+    void ClearMemory();
+
+    /// Starts tracking the pages written from now on, which the next incremental state stores
+    void ResetDirtyPages();
+
+    System& system;
+
+    /// ID and path of the state last saved or loaded, which incremental states are based on
+    u64 last_snapshot_id = 0;
+    std::string last_state_path;
+};
+
+} // namespace Core
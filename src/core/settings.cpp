@@ -2,8 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstdlib>
 #include <utility>
 #include "audio_core/dsp_interface.h"
+#include "common/string_util.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/hid/hid.h"
@@ -70,6 +72,9 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_EnableIdleLoopDetection", Settings::values.enable_idle_loop_detection);
+    LogSetting("Core_IdleLoopDetectionExcludedTitles",
+               Settings::values.idle_loop_detection_excluded_titles);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
@@ -102,10 +107,30 @@ void LogSettings() {
     LogSetting("Camera_OuterLeftConfig", Settings::values.camera_config[OuterLeftCamera]);
     LogSetting("Camera_OuterLeftFlip", Settings::values.camera_flip[OuterLeftCamera]);
     LogSetting("DataStorage_UseVirtualSd", Settings::values.use_virtual_sd);
+    LogSetting("DataStorage_KeepSavesInMemory", Settings::values.keep_saves_in_memory);
+    LogSetting("DataStorage_UseSharedTitleCache", Settings::values.use_shared_title_cache);
     LogSetting("System_IsNew3ds", Settings::values.is_new_3ds);
     LogSetting("System_RegionValue", Settings::values.region_value);
     LogSetting("Debugging_UseGdbstub", Settings::values.use_gdbstub);
     LogSetting("Debugging_GdbstubPort", Settings::values.gdbstub_port);
+    LogSetting("Debugging_EnableGuestProfiler", Settings::values.enable_guest_profiler);
+    LogSetting("Debugging_LogIPCStats", Settings::values.log_ipc_stats);
+}
+
+bool IsIdleLoopDetectionEnabled(u64 program_id) {
+    if (!values.enable_idle_loop_detection) {
+        return false;
+    }
+
+    std::vector<std::string> excluded_titles;
+    Common::SplitString(values.idle_loop_detection_excluded_titles, ',', excluded_titles);
+    for (const std::string& title : excluded_titles) {
+        const std::string trimmed = Common::StripSpaces(title);
+        if (!trimmed.empty() && std::strtoull(trimmed.c_str(), nullptr, 16) == program_id) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void LoadProfile(int index) {
@@ -126,9 +126,13 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    bool enable_idle_loop_detection;
+    std::string idle_loop_detection_excluded_titles;
 
     // Data Storage
     bool use_virtual_sd;
+    bool keep_saves_in_memory;
+    bool use_shared_title_cache;
 
     // System
     int region_value;
@@ -184,6 +188,8 @@ struct Values {
     // Debugging
     bool use_gdbstub;
     u16 gdbstub_port;
+    bool enable_guest_profiler;
+    bool log_ipc_stats;
     std::string log_filter;
     std::unordered_map<std::string, bool> lle_modules;
 
@@ -201,6 +207,9 @@ static constexpr int REGION_VALUE_AUTO_SELECT = -1;
 void Apply();
 void LogSettings();
 
+/// Whether idle loop detection should be used for the title with the given program ID
+bool IsIdleLoopDetectionEnabled(u64 program_id);
+
 // Input profiles
 void LoadProfile(int index);
 void SaveProfile(int index);
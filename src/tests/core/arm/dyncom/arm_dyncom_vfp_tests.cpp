@@ -2,8 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <random>
 #include <catch2/catch.hpp>
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/skyeye_common/armstate.h"
+#include "core/arm/skyeye_common/vfp/asm_vfp.h"
+#include "core/arm/skyeye_common/vfp/vfp.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "tests/core/arm/arm_test_common.h"
@@ -47,4 +52,94 @@ TEST_CASE("ARM_DynCom (vfp): vadd", "[arm_dyncom]") {
     }
 }
 
+TEST_CASE("ARM_DynCom (vfp): host fast path", "[arm_dyncom]") {
+    TestEnvironment test_env(false);
+    ARMul_State state(nullptr, test_env.GetMemory(), USER32MODE);
+
+    struct Operation {
+        VFPFastOp op;
+        u32 instr; // Single precision, sd = s2, sn = s4, sm = s6
+    };
+    constexpr std::array<Operation, 5> operations{{
+        {VFPFastOp::Add, 0xEE321A03},  // vadd.f32 s2, s4, s6
+        {VFPFastOp::Sub, 0xEE321A43},  // vsub.f32 s2, s4, s6
+        {VFPFastOp::Mul, 0xEE221A03},  // vmul.f32 s2, s4, s6
+        {VFPFastOp::Div, 0xEE821A03},  // vdiv.f32 s2, s4, s6
+        {VFPFastOp::Sqrt, 0xEEB11AC3}, // vsqrt.f32 s2, s6
+    }};
+    // What titles run with (round towards zero, flush-to-zero, default NaN), then the other modes
+    constexpr std::array<u32, 4> fpscrs{{0x03C00000, FPSCR_ROUND_NEAREST, FPSCR_ROUND_PLUSINF,
+                                         FPSCR_ROUND_MINUSINF | FPSCR_IXC}};
+    constexpr u32 DOUBLE_PRECISION = 1 << 8;
+
+    // Random operands of moderate magnitude, with a few zeroes and identical operands thrown in
+    // so that exact results and cancellations are covered too
+    std::mt19937_64 random(1);
+    const auto random_operand = [&random](bool double_precision) -> u64 {
+        const u64 bits = random();
+        const u64 sign = bits >> 63;
+        if (bits % 16 == 0) {
+            return sign << (double_precision ? 63 : 31);
+        }
+        if (double_precision) {
+            return sign << 63 | (0x3C0 + (bits >> 20) % 0x80) << 52 | (bits & 0xFFFFFFFFFFFFF);
+        }
+        return sign << 31 | (0x60 + (bits >> 20) % 0x40) << 23 | (bits & 0x7FFFFF);
+    };
+    const auto set_operands = [&state](bool double_precision, u64 n, u64 m) {
+        if (double_precision) {
+            state.ExtReg[4] = static_cast<u32>(n);
+            state.ExtReg[5] = static_cast<u32>(n >> 32);
+            state.ExtReg[6] = static_cast<u32>(m);
+            state.ExtReg[7] = static_cast<u32>(m >> 32);
+        } else {
+            state.ExtReg[4] = static_cast<u32>(n);
+            state.ExtReg[6] = static_cast<u32>(m);
+        }
+        state.ExtReg[2] = state.ExtReg[3] = 0xDEADBEEF;
+    };
+
+    std::size_t fast_path_runs = 0;
+    std::size_t title_mode_runs = 0;
+    for (int i = 0; i < 20000; ++i) {
+        const bool double_precision = i % 2 != 0;
+        const Operation& operation = operations[i / 2 % operations.size()];
+        const u32 fpscr = fpscrs[i / 2 / operations.size() % fpscrs.size()];
+        const u32 instr = operation.instr | (double_precision ? DOUBLE_PRECISION : 0);
+        const u64 n = random_operand(double_precision);
+        const u64 m = i % 37 == 0 ? n : random_operand(double_precision);
+
+        set_operands(double_precision, n, m);
+        state.VFP[VFP_FPSCR] = fpscr;
+        if (!vfp_fast_cpdo(&state, operation.op, instr, double_precision)) {
+            continue;
+        }
+        const std::array<u32, 2> fast_result{{state.ExtReg[2], state.ExtReg[3]}};
+        const u32 fast_fpscr = state.VFP[VFP_FPSCR];
+
+        set_operands(double_precision, n, m);
+        state.VFP[VFP_FPSCR] = fpscr;
+        const u32 exceptions = double_precision ? vfp_double_cpdo(&state, instr, fpscr)
+                                                : vfp_single_cpdo(&state, instr, fpscr);
+        vfp_raise_exceptions(&state, exceptions, instr, state.VFP[VFP_FPSCR]);
+
+        INFO("instr " << std::hex << instr << " fpscr " << fpscr << " n " << n << " m " << m);
+        REQUIRE(fast_result[0] == state.ExtReg[2]);
+        if (double_precision) {
+            REQUIRE(fast_result[1] == state.ExtReg[3]);
+        }
+        REQUIRE(fast_fpscr == state.VFP[VFP_FPSCR]);
+
+        ++fast_path_runs;
+        if (fpscr == fpscrs[0]) {
+            ++title_mode_runs;
+        }
+    }
+
+    // Most of these operations are simple enough for the fast path, including in the mode
+    // titles actually use
+    REQUIRE(fast_path_runs > 10000);
+    REQUIRE(title_mode_runs > 2500);
+}
+
 } // namespace ArmTests
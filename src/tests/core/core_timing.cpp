@@ -6,6 +6,8 @@
 
 #include <array>
 #include <bitset>
+#include <chrono>
+#include <random>
 #include <string>
 #include "common/file_util.h"
 #include "core/core.h"
@@ -226,3 +228,175 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == timing.GetDowncount());
 }
+
+TEST_CASE("CoreTiming[Unschedule]", "[core]") {
+    using namespace SharedSlotTest;
+
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", FifoCallback<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", FifoCallback<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", FifoCallback<2>);
+    Core::TimingEventType* cb_d = timing.RegisterEvent("callbackD", FifoCallback<3>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    timing.ScheduleEvent(1000, cb_a, CB_IDS[0]);
+    timing.ScheduleEvent(300, cb_d, CB_IDS[0]);
+    timing.ScheduleEvent(1000, cb_b, CB_IDS[1]);
+    timing.ScheduleEvent(200, cb_c, CB_IDS[3]);
+    timing.ScheduleEvent(1000, cb_c, CB_IDS[2]);
+    timing.ScheduleEvent(500, cb_d, CB_IDS[3]);
+    REQUIRE(200 == timing.GetDowncount());
+
+    // Only the matching (type, userdata) pairs are removed, and the remaining events still run in
+    // the order they were scheduled in.
+    timing.UnscheduleEvent(cb_c, CB_IDS[3]);
+    timing.UnscheduleEvent(cb_d, CB_IDS[0]);
+    timing.RemoveEvent(cb_d);
+
+    callbacks_ran_flags = 0;
+    counter = 0;
+    lateness = 0;
+    timing.AddTicks(timing.GetDowncount());
+    timing.Advance();
+    REQUIRE(0 == callbacks_ran_flags.to_ullong());
+    REQUIRE(800 == timing.GetDowncount());
+
+    timing.AddTicks(timing.GetDowncount());
+    timing.Advance();
+    REQUIRE(0x7ULL == callbacks_ran_flags.to_ullong());
+    REQUIRE(MAX_SLICE_LENGTH == timing.GetDowncount());
+}
+
+TEST_CASE("CoreTiming[IdleAcrossCores]", "[core]") {
+    Core::Timing timing(2);
+
+    // Enter slice 0
+    timing.Advance();
+
+    // One core idles through the whole slice while another runs half of it, so the slice is
+    // only idle for the half after the second core idled too
+    timing.Idle();
+    timing.SetRunningCore(1);
+    REQUIRE(MAX_SLICE_LENGTH == timing.GetDowncount());
+    timing.AddTicks(MAX_SLICE_LENGTH / 2);
+    REQUIRE(MAX_SLICE_LENGTH / 2 == timing.GetTicks());
+    timing.Idle();
+    timing.SetRunningCore(0);
+    timing.Advance();
+    REQUIRE(MAX_SLICE_LENGTH / 2 == timing.GetIdleTicks());
+    REQUIRE(MAX_SLICE_LENGTH == timing.GetTicks());
+
+    // A core that doesn't idle at all keeps the whole slice busy
+    timing.Idle();
+    timing.SetRunningCore(1);
+    timing.AddTicks(MAX_SLICE_LENGTH);
+    timing.SetRunningCore(0);
+    timing.Advance();
+    REQUIRE(MAX_SLICE_LENGTH / 2 == timing.GetIdleTicks());
+
+    // The slice ends at the furthest point any core reached
+    timing.AddTicks(100);
+    timing.SetRunningCore(1);
+    timing.AddTicks(300);
+    timing.SetRunningCore(0);
+    timing.Advance();
+    REQUIRE(2 * MAX_SLICE_LENGTH + 300 == timing.GetTicks());
+
+    // A core that sits the slice out doesn't keep it busy either
+    timing.AddTicks(100);
+    timing.Idle();
+    timing.Advance();
+    REQUIRE(MAX_SLICE_LENGTH / 2 + MAX_SLICE_LENGTH - 100 == timing.GetIdleTicks());
+}
+
+TEST_CASE("CoreTiming[ManyEvents]", "[core]") {
+    constexpr u64 NUM_EVENTS = 4000;
+    constexpr u64 NUM_TYPES = 16;
+    constexpr s64 MAX_TIME = 1000000;
+
+    Core::Timing timing;
+
+    // Event i is scheduled with type i % NUM_TYPES and userdata i / 2, so that every userdata is
+    // shared by two event types
+    std::array<s64, NUM_EVENTS> due_times;
+    std::array<int, NUM_EVENTS> runs{};
+    s64 last_time = 0;
+    std::array<Core::TimingEventType*, NUM_TYPES> types;
+    for (u64 t = 0; t < NUM_TYPES; ++t) {
+        types[t] = timing.RegisterEvent("event" + std::to_string(t), [&, t](u64 userdata, s64) {
+            const u64 i = userdata * 2 + t % 2;
+            const s64 time = static_cast<s64>(timing.GetTicks());
+            REQUIRE(time >= last_time);
+            REQUIRE(time == due_times[i]);
+            last_time = time;
+            ++runs[i];
+        });
+    }
+
+    // Enter slice 0
+    timing.Advance();
+
+    // Schedule events at random times, then cancel some of them like services that reschedule
+    // their timeouts do
+    std::mt19937 random(1);
+    for (u64 i = 0; i < NUM_EVENTS; ++i) {
+        due_times[i] = static_cast<s64>(random() % MAX_TIME);
+        timing.ScheduleEvent(due_times[i], types[i % NUM_TYPES], i / 2);
+    }
+    for (u64 i = 0; i < NUM_EVENTS; i += 3) {
+        timing.UnscheduleEvent(types[i % NUM_TYPES], i / 2);
+    }
+    timing.RemoveEvent(types[5]);
+
+    while (static_cast<s64>(timing.GetTicks()) <= MAX_TIME) {
+        timing.AddTicks(timing.GetDowncount());
+        timing.Advance();
+    }
+
+    for (u64 i = 0; i < NUM_EVENTS; ++i) {
+        const bool cancelled = i % 3 == 0 || i % NUM_TYPES == 5;
+        REQUIRE(runs[i] == (cancelled ? 0 : 1));
+    }
+}
+
+TEST_CASE("CoreTiming[Throughput]", "[core][.benchmark]") {
+    constexpr u64 NUM_EVENTS = 100000;
+    constexpr u64 NUM_TYPES = 16;
+
+    Core::Timing timing;
+
+    u64 events_run = 0;
+    std::array<Core::TimingEventType*, NUM_TYPES> types;
+    for (u64 i = 0; i < NUM_TYPES; ++i) {
+        types[i] = timing.RegisterEvent("event" + std::to_string(i),
+                                        [&events_run](u64, s64) { ++events_run; });
+    }
+
+    // Enter slice 0
+    timing.Advance();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Schedule events at random times, then cancel half of them like services that constantly
+    // reschedule their timeouts do
+    std::mt19937 random(1);
+    for (u64 i = 0; i < NUM_EVENTS; ++i) {
+        timing.ScheduleEvent(static_cast<s64>(random() % 10000000), types[i % NUM_TYPES], i);
+    }
+    for (u64 i = 0; i < NUM_EVENTS; i += 2) {
+        timing.UnscheduleEvent(types[i % NUM_TYPES], i);
+    }
+    while (events_run < NUM_EVENTS / 2) {
+        timing.AddTicks(timing.GetDowncount());
+        timing.Advance();
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    REQUIRE(NUM_EVENTS / 2 == events_run);
+    WARN(NUM_EVENTS << " events scheduled, " << NUM_EVENTS / 2 << " cancelled in "
+                    << elapsed.count() << " us");
+}
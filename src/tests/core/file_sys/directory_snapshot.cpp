@@ -0,0 +1,57 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/directory_snapshot.h"
+#include "core/file_sys/write_back_cache.h"
+#include "tests/temp_dir.h"
+
+namespace FileSys {
+
+TEST_CASE("DirectorySnapshot", "[core][file_sys]") {
+    const Tests::TempDir temp_dir;
+    const std::string dir = temp_dir.GetPath("dir");
+    const std::string sub_dir = dir + DIR_SEP "sub";
+    WriteBackCache write_back_cache(temp_dir.GetPath("journal") + DIR_SEP, nullptr);
+    REQUIRE(FileUtil::CreateDir(dir));
+    REQUIRE(FileUtil::CreateDir(sub_dir));
+    REQUIRE(FileUtil::WriteStringToFile(false, "abc", (dir + DIR_SEP "file.bin").c_str()) == 3);
+
+    const auto snapshot = GetDirectorySnapshot(dir, write_back_cache);
+    REQUIRE(snapshot->size() == 2);
+    for (const Entry& entry : *snapshot) {
+        if (entry.is_directory) {
+            REQUIRE(entry.filename == std::u16string(u"sub"));
+            REQUIRE(entry.file_size == 0);
+        } else {
+            REQUIRE(entry.filename == std::u16string(u"file.bin"));
+            REQUIRE(entry.file_size == 3);
+            REQUIRE(entry.is_archive);
+        }
+    }
+
+    // Unchanged directories are only scanned once, however their path is spelled
+    REQUIRE(GetDirectorySnapshot(dir + DIR_SEP, write_back_cache) == snapshot);
+
+    // Changing anything in a directory makes the next handle see a new snapshot
+    REQUIRE(FileUtil::CreateEmptyFile(sub_dir + DIR_SEP "new.bin"));
+    const auto sub_snapshot = GetDirectorySnapshot(sub_dir, write_back_cache);
+    InvalidateDirectorySnapshots(sub_dir + DIR_SEP "new.bin");
+    REQUIRE(GetDirectorySnapshot(dir, write_back_cache) == snapshot);
+    REQUIRE(GetDirectorySnapshot(sub_dir, write_back_cache) != sub_snapshot);
+
+    // Changing a directory also drops the snapshots of its parent and of anything under it
+    InvalidateDirectorySnapshots(sub_dir);
+    const auto new_snapshot = GetDirectorySnapshot(dir, write_back_cache);
+    REQUIRE(new_snapshot != snapshot);
+    REQUIRE(snapshot->size() == 2);
+
+    // A new session starts without any of the snapshots of the previous one
+    ClearDirectorySnapshots();
+    REQUIRE(GetDirectorySnapshot(dir, write_back_cache) != new_snapshot);
+}
+
+} // namespace FileSys
@@ -0,0 +1,135 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include "common/file_util.h"
+#include "core/file_sys/ivfc_archive.h"
+#include "tests/temp_dir.h"
+
+namespace FileSys {
+
+namespace {
+
+u8 ByteAt(std::size_t offset) {
+    return static_cast<u8>((offset * 7) ^ (offset >> 8));
+}
+
+std::vector<u8> MakeTestData(std::size_t size) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = ByteAt(i);
+    }
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("IVFCFile::GetDataPointer", "[core][file_sys]") {
+    constexpr std::size_t ROMFS_OFFSET = 0x200;
+    constexpr std::size_t ROMFS_SIZE = 0x10000;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    const std::vector<u8> data = MakeTestData(ROMFS_OFFSET + ROMFS_SIZE);
+    REQUIRE(FileUtil::IOFile(path, "wb").WriteBytes(data.data(), data.size()) == data.size());
+
+    SECTION("points into the mapped RomFS") {
+        auto reader =
+            std::make_shared<RomFSReader>(FileUtil::IOFile(path, "rb"), ROMFS_OFFSET, ROMFS_SIZE);
+        REQUIRE(reader->IsMapped());
+        const IVFCFile file(reader, std::make_unique<IVFCDelayGenerator>());
+
+        const u8* pointer = file.GetDataPointer(0x1000, 0x100);
+        REQUIRE(pointer == reader->GetDataPointer(0x1000, 0x100));
+        REQUIRE(pointer[0] == ByteAt(ROMFS_OFFSET + 0x1000));
+        REQUIRE(file.GetDataPointer(ROMFS_SIZE, 0) != nullptr);
+        REQUIRE(file.GetDataPointer(ROMFS_SIZE - 0x10, 0x100) == nullptr);
+        REQUIRE(file.GetDataPointer(ROMFS_SIZE + 1, 0) == nullptr);
+    }
+
+    SECTION("points into a file in memory") {
+        const IVFCFileInMemory file(data, ROMFS_OFFSET, ROMFS_SIZE,
+                                    std::make_unique<IVFCDelayGenerator>());
+        const u8* pointer = file.GetDataPointer(0x1000, 0x100);
+        REQUIRE(pointer != nullptr);
+        REQUIRE(pointer[0] == ByteAt(ROMFS_OFFSET + 0x1000));
+        REQUIRE(file.GetDataPointer(ROMFS_SIZE - 0x10, 0x100) == nullptr);
+    }
+}
+
+TEST_CASE("IVFCFile[ReadAhead]", "[core][file_sys]") {
+    // Encrypted RomFS are not mapped, so their files are read ahead.
+    constexpr std::size_t BLOCK_SIZE = 0x10000;
+    constexpr std::size_t ROMFS_SIZE = 16 * BLOCK_SIZE + 0x800;
+    constexpr std::size_t READ_SIZE = 0x1000;
+    constexpr std::array<u8, 16> key{};
+    constexpr std::array<u8, 16> ctr{};
+    std::vector<u8> encrypted = MakeTestData(ROMFS_SIZE);
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption encryption;
+    encryption.SetKeyWithIV(key.data(), key.size(), ctr.data());
+    encryption.ProcessData(encrypted.data(), encrypted.data(), encrypted.size());
+
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    REQUIRE(FileUtil::IOFile(path, "wb").WriteBytes(encrypted.data(), encrypted.size()) ==
+            encrypted.size());
+    const auto CreateFile = [&] {
+        auto reader = std::make_shared<RomFSReader>(FileUtil::IOFile(path, "rb"), 0, ROMFS_SIZE,
+                                                    key, ctr, 0);
+        REQUIRE(!reader->IsMapped());
+        return std::make_pair(
+            reader, std::make_unique<IVFCFile>(reader, std::make_unique<IVFCDelayGenerator>()));
+    };
+    const auto ReadMatches = [](const IVFCFile& file, u64 offset, std::size_t length) {
+        std::vector<u8> buffer(length);
+        const std::size_t expected = std::min<std::size_t>(length, ROMFS_SIZE - offset);
+        if (file.Read(offset, length, buffer.data()).Unwrap() != expected) {
+            return false;
+        }
+        for (std::size_t i = 0; i < expected; ++i) {
+            if (buffer[i] != ByteAt(offset + i)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    SECTION("sequential reads are served from the read ahead") {
+        const auto [reader, file] = CreateFile();
+        for (u64 offset = 0; offset < ROMFS_SIZE; offset += READ_SIZE) {
+            REQUIRE(ReadMatches(*file, offset, READ_SIZE));
+        }
+        // Without reading ahead, every block would go through the block cache once.
+        REQUIRE(reader->GetCacheStats().misses < ROMFS_SIZE / BLOCK_SIZE / 2);
+    }
+
+    SECTION("jumps and interleaved files read the right data") {
+        const auto [reader_a, file_a] = CreateFile();
+        const auto [reader_b, file_b] = CreateFile();
+        for (u64 offset = 0; offset < 8 * READ_SIZE; offset += READ_SIZE) {
+            REQUIRE(ReadMatches(*file_a, offset, READ_SIZE));
+            REQUIRE(ReadMatches(*file_b, ROMFS_SIZE / 2 + offset, READ_SIZE));
+        }
+        // Jump back into the data that was read ahead, past it, and across the end
+        REQUIRE(ReadMatches(*file_a, 2 * READ_SIZE + 0x10, READ_SIZE));
+        REQUIRE(ReadMatches(*file_a, 10 * BLOCK_SIZE + 0x123, 3 * READ_SIZE));
+        REQUIRE(ReadMatches(*file_b, ROMFS_SIZE - 0x100, READ_SIZE));
+    }
+
+    SECTION("files can be closed while reading ahead") {
+        for (int i = 0; i < 8; ++i) {
+            auto [reader, file] = CreateFile();
+            for (u64 offset = 0; offset < 4 * READ_SIZE; offset += READ_SIZE) {
+                REQUIRE(ReadMatches(*file, offset, READ_SIZE));
+            }
+        }
+    }
+}
+
+} // namespace FileSys
@@ -0,0 +1,306 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include "common/file_util.h"
+#include "core/file_sys/romfs_reader.h"
+#include "tests/temp_dir.h"
+
+namespace FileSys {
+
+namespace {
+
+u8 ByteAt(std::size_t offset) {
+    return static_cast<u8>((offset * 7) ^ (offset >> 8));
+}
+
+/// Creates a file whose bytes are a function of their offset
+void CreateTestFile(const std::string& path, std::size_t size) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = ByteAt(i);
+    }
+    FileUtil::IOFile file(path, "wb");
+    REQUIRE(file.WriteBytes(data.data(), data.size()) == data.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RomFSReader[Read]", "[core][file_sys]") {
+    constexpr std::size_t FILE_SIZE = 0x30000;
+    constexpr std::size_t ROMFS_OFFSET = 0x1234;
+    constexpr std::size_t ROMFS_SIZE = 0x20000;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    CreateTestFile(path, FILE_SIZE);
+
+    RomFSReader reader(FileUtil::IOFile(path, "rb"), ROMFS_OFFSET, ROMFS_SIZE);
+    REQUIRE(reader.GetSize() == ROMFS_SIZE);
+
+    std::vector<u8> buffer(0x100);
+    REQUIRE(reader.ReadFile(0x5000, buffer.size(), buffer.data()) == buffer.size());
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        REQUIRE(buffer[i] == ByteAt(ROMFS_OFFSET + 0x5000 + i));
+    }
+
+    // Reads are clamped to the end of the RomFS
+    REQUIRE(reader.ReadFile(ROMFS_SIZE - 0x10, buffer.size(), buffer.data()) == 0x10);
+    REQUIRE(buffer[0xF] == ByteAt(ROMFS_OFFSET + ROMFS_SIZE - 1));
+    REQUIRE(reader.ReadFile(ROMFS_SIZE, buffer.size(), buffer.data()) == 0);
+
+    // Unencrypted RomFS are mapped on the hosts the tests run on
+    REQUIRE(reader.IsMapped());
+    const u8* pointer = reader.GetDataPointer(0x5000, 0x100);
+    REQUIRE(pointer != nullptr);
+    REQUIRE(pointer[0] == ByteAt(ROMFS_OFFSET + 0x5000));
+    REQUIRE(pointer[0xFF] == ByteAt(ROMFS_OFFSET + 0x50FF));
+    REQUIRE(reader.GetDataPointer(ROMFS_SIZE - 0x10, 0x10) == pointer + ROMFS_SIZE - 0x5010);
+    REQUIRE(reader.GetDataPointer(ROMFS_SIZE - 0x10, 0x100) == nullptr);
+}
+
+TEST_CASE("RomFSReader[PastEndOfFile]", "[core][file_sys]") {
+    constexpr std::size_t FILE_SIZE = 0x30000;
+    constexpr std::size_t ROMFS_OFFSET = 0x10000;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    CreateTestFile(path, FILE_SIZE);
+    std::vector<u8> buffer(0x100);
+
+    SECTION("doesn't map a RomFS that ends past the end of the file") {
+        RomFSReader reader(FileUtil::IOFile(path, "rb"), ROMFS_OFFSET, FILE_SIZE);
+        REQUIRE(!reader.IsMapped());
+        REQUIRE(reader.GetDataPointer(0, 0x10) == nullptr);
+        REQUIRE(reader.ReadFile(FILE_SIZE - ROMFS_OFFSET - 0x10, buffer.size(), buffer.data()) ==
+                0x10);
+        REQUIRE(buffer[0] == ByteAt(FILE_SIZE - 0x10));
+        REQUIRE(reader.ReadFile(FILE_SIZE - ROMFS_OFFSET, buffer.size(), buffer.data()) == 0);
+    }
+
+    SECTION("stops using the mapping once the file is truncated") {
+        RomFSReader reader(FileUtil::IOFile(path, "rb"), ROMFS_OFFSET, FILE_SIZE - ROMFS_OFFSET);
+        REQUIRE(reader.IsMapped());
+        REQUIRE(FileUtil::IOFile(path, "r+b").Resize(ROMFS_OFFSET + 0x8000));
+
+        // Reading the cut off pages through the mapping would raise SIGBUS
+        REQUIRE(reader.ReadFile(0x8000 - 0x10, buffer.size(), buffer.data()) == 0x10);
+        REQUIRE(buffer[0] == ByteAt(ROMFS_OFFSET + 0x8000 - 0x10));
+        REQUIRE(reader.ReadFile(0x10000, buffer.size(), buffer.data()) == 0);
+        REQUIRE(!reader.IsMapped());
+        REQUIRE(reader.GetDataPointer(0, 0x10) == nullptr);
+    }
+}
+
+TEST_CASE("RomFSReader[ConcurrentRead]", "[core][file_sys]") {
+    constexpr std::size_t ROMFS_SIZE = 0x100000;
+    constexpr std::size_t READ_SIZE = 0x1000;
+    constexpr std::size_t NUM_THREADS = 4;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    CreateTestFile(path, ROMFS_SIZE);
+    RomFSReader reader(FileUtil::IOFile(path, "rb"), 0, ROMFS_SIZE);
+
+    // Every thread reads the whole RomFS in an interleaved order, and checks what it read.
+    std::vector<std::size_t> mismatches(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&reader, &mismatches, t] {
+            std::vector<u8> buffer(READ_SIZE);
+            for (std::size_t i = 0; i < ROMFS_SIZE / READ_SIZE; ++i) {
+                const std::size_t offset =
+                    ((i + t * ROMFS_SIZE / READ_SIZE / NUM_THREADS) * READ_SIZE) % ROMFS_SIZE;
+                if (reader.ReadFile(offset, READ_SIZE, buffer.data()) != READ_SIZE ||
+                    buffer.front() != ByteAt(offset) ||
+                    buffer.back() != ByteAt(offset + READ_SIZE - 1)) {
+                    ++mismatches[t];
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(mismatches == std::vector<std::size_t>(NUM_THREADS));
+}
+
+TEST_CASE("RomFSReader[Encrypted]", "[core][file_sys]") {
+    // Matches the block size and the number of blocks cached by RomFSReader
+    constexpr std::size_t BLOCK_SIZE = 0x10000;
+    constexpr std::size_t MAX_CACHED_BLOCKS = 64;
+    constexpr std::size_t FILE_OFFSET = 0x200;
+    constexpr std::size_t CRYPTO_OFFSET = 0x1000;
+    constexpr std::size_t ROMFS_SIZE = (MAX_CACHED_BLOCKS + 2) * BLOCK_SIZE + 0x1234;
+    constexpr std::array<u8, 16> key{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    constexpr std::array<u8, 16> ctr{0xC0, 0xFF, 0xEE};
+
+    std::vector<u8> encrypted(FILE_OFFSET + ROMFS_SIZE);
+    for (std::size_t i = 0; i < ROMFS_SIZE; ++i) {
+        encrypted[FILE_OFFSET + i] = ByteAt(i);
+    }
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption encryption;
+    encryption.SetKeyWithIV(key.data(), key.size(), ctr.data());
+    encryption.Seek(CRYPTO_OFFSET);
+    encryption.ProcessData(&encrypted[FILE_OFFSET], &encrypted[FILE_OFFSET], ROMFS_SIZE);
+
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    const auto CreateReader = [&](std::size_t file_size) {
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(encrypted.data(), file_size) == file_size);
+        file.Close();
+        return std::make_unique<RomFSReader>(FileUtil::IOFile(path, "rb"), FILE_OFFSET,
+                                             ROMFS_SIZE, key, ctr, CRYPTO_OFFSET);
+    };
+    const auto Matches = [](const std::vector<u8>& buffer, std::size_t offset,
+                            std::size_t length) {
+        for (std::size_t i = 0; i < length; ++i) {
+            if (buffer[i] != ByteAt(offset + i)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    std::vector<u8> buffer(2 * BLOCK_SIZE);
+
+    SECTION("caches the blocks of small reads") {
+        auto reader = CreateReader(encrypted.size());
+        REQUIRE(!reader->IsMapped());
+        REQUIRE(reader->GetDataPointer(0, 0x10) == nullptr);
+
+        REQUIRE(reader->ReadFile(0x10, 0x100, buffer.data()) == 0x100);
+        REQUIRE(Matches(buffer, 0x10, 0x100));
+        REQUIRE(reader->ReadFile(0x8000, 0x100, buffer.data()) == 0x100);
+        REQUIRE(Matches(buffer, 0x8000, 0x100));
+        REQUIRE(reader->GetCacheStats().misses == 1);
+        REQUIRE(reader->GetCacheStats().hits == 1);
+
+        // A read across two blocks uses both
+        REQUIRE(reader->ReadFile(BLOCK_SIZE - 0x10, 0x20, buffer.data()) == 0x20);
+        REQUIRE(Matches(buffer, BLOCK_SIZE - 0x10, 0x20));
+        REQUIRE(reader->GetCacheStats().misses == 2);
+        REQUIRE(reader->GetCacheStats().hits == 2);
+
+        // Whole blocks are decrypted without going through the cache
+        REQUIRE(reader->ReadFile(2 * BLOCK_SIZE, BLOCK_SIZE, buffer.data()) == BLOCK_SIZE);
+        REQUIRE(Matches(buffer, 2 * BLOCK_SIZE, BLOCK_SIZE));
+        REQUIRE(reader->GetCacheStats().misses == 2);
+        REQUIRE(reader->GetCacheStats().hits == 2);
+    }
+
+    SECTION("evicts the least recently used block") {
+        auto reader = CreateReader(encrypted.size());
+        for (std::size_t block = 0; block < MAX_CACHED_BLOCKS; ++block) {
+            REQUIRE(reader->ReadFile(block * BLOCK_SIZE, 0x10, buffer.data()) == 0x10);
+        }
+        // Makes block 1 the least recently used one
+        REQUIRE(reader->ReadFile(0, 0x10, buffer.data()) == 0x10);
+        REQUIRE(reader->ReadFile(MAX_CACHED_BLOCKS * BLOCK_SIZE, 0x10, buffer.data()) == 0x10);
+        REQUIRE(Matches(buffer, MAX_CACHED_BLOCKS * BLOCK_SIZE, 0x10));
+        REQUIRE(reader->GetCacheStats().misses == MAX_CACHED_BLOCKS + 1);
+
+        REQUIRE(reader->ReadFile(0x20, 0x10, buffer.data()) == 0x10);
+        REQUIRE(reader->GetCacheStats().misses == MAX_CACHED_BLOCKS + 1);
+        REQUIRE(reader->ReadFile(BLOCK_SIZE + 0x20, 0x10, buffer.data()) == 0x10);
+        REQUIRE(Matches(buffer, BLOCK_SIZE + 0x20, 0x10));
+        REQUIRE(reader->GetCacheStats().misses == MAX_CACHED_BLOCKS + 2);
+    }
+
+    SECTION("reads the last partial block") {
+        auto reader = CreateReader(encrypted.size());
+        const std::size_t last_block = ROMFS_SIZE / BLOCK_SIZE * BLOCK_SIZE;
+        REQUIRE(reader->ReadFile(ROMFS_SIZE - 0x20, 0x100, buffer.data()) == 0x20);
+        REQUIRE(Matches(buffer, ROMFS_SIZE - 0x20, 0x20));
+        REQUIRE(reader->ReadFile(last_block, BLOCK_SIZE, buffer.data()) == ROMFS_SIZE - last_block);
+        REQUIRE(Matches(buffer, last_block, ROMFS_SIZE - last_block));
+        REQUIRE(reader->GetCacheStats().misses == 1);
+        REQUIRE(reader->GetCacheStats().hits == 1);
+        REQUIRE(reader->ReadFile(ROMFS_SIZE, 0x100, buffer.data()) == 0);
+    }
+
+    SECTION("doesn't cache blocks cut short by the end of the file") {
+        const std::size_t truncated_size = encrypted.size() - 0x100;
+        auto reader = CreateReader(truncated_size);
+        REQUIRE(reader->ReadFile(ROMFS_SIZE - 0x200, 0x200, buffer.data()) == 0x100);
+        REQUIRE(Matches(buffer, ROMFS_SIZE - 0x200, 0x100));
+
+        // Once the rest of the file is there, the whole block is read.
+        FileUtil::IOFile file(path, "ab");
+        REQUIRE(file.WriteBytes(&encrypted[truncated_size], 0x100) == 0x100);
+        file.Close();
+        REQUIRE(reader->ReadFile(ROMFS_SIZE - 0x200, 0x200, buffer.data()) == 0x200);
+        REQUIRE(Matches(buffer, ROMFS_SIZE - 0x200, 0x200));
+        REQUIRE(reader->GetCacheStats().misses == 2);
+    }
+}
+
+TEST_CASE("RomFSReader[Throughput]", "[core][file_sys][.benchmark]") {
+    constexpr std::size_t ROMFS_SIZE = 256 * 1024 * 1024;
+    constexpr std::size_t TOTAL_READ_SIZE = 1024 * 1024 * 1024;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("romfs.bin");
+    CreateTestFile(path, ROMFS_SIZE);
+
+    // Scattered reads, like a game streaming assets, both small and large
+    for (const std::size_t read_size : {std::size_t{0x1000}, std::size_t{0x10000}}) {
+        const std::size_t num_reads = TOTAL_READ_SIZE / read_size;
+        std::vector<std::size_t> offsets(num_reads);
+        u64 seed = 1;
+        for (auto& offset : offsets) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            offset = static_cast<std::size_t>(seed >> 20) % (ROMFS_SIZE - read_size);
+        }
+
+        std::vector<u8> buffer(read_size);
+        const auto report = [read_size](const char* name,
+                                        std::chrono::steady_clock::duration duration) {
+            const double seconds = std::chrono::duration<double>(duration).count();
+            WARN(name << ", 0x" << std::hex << read_size << std::dec << " byte reads: "
+                      << TOTAL_READ_SIZE / seconds / (1024 * 1024) << " MiB/s");
+        };
+
+        {
+            // What the reader did before: a seek and a buffered read on a shared file
+            FileUtil::IOFile file(path, "rb");
+            std::size_t total_read = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (const std::size_t offset : offsets) {
+                file.Seek(offset, SEEK_SET);
+                total_read += file.ReadBytes(buffer.data(), read_size);
+            }
+            report("Seek and read", std::chrono::steady_clock::now() - start);
+            REQUIRE(total_read == TOTAL_READ_SIZE);
+        }
+
+        {
+            FileUtil::IOFile file(path, "rb");
+            std::size_t total_read = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (const std::size_t offset : offsets) {
+                total_read += file.ReadBytesAt(buffer.data(), read_size, offset);
+            }
+            report("Positional read", std::chrono::steady_clock::now() - start);
+            REQUIRE(total_read == TOTAL_READ_SIZE);
+        }
+
+        {
+            RomFSReader reader(FileUtil::IOFile(path, "rb"), 0, ROMFS_SIZE);
+            REQUIRE(reader.IsMapped());
+            std::size_t total_read = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (const std::size_t offset : offsets) {
+                total_read += reader.ReadFile(offset, read_size, buffer.data());
+            }
+            report("Mapped read", std::chrono::steady_clock::now() - start);
+            REQUIRE(total_read == TOTAL_READ_SIZE);
+        }
+    }
+}
+
+} // namespace FileSys
@@ -0,0 +1,40 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/title_image_cache.h"
+#include "tests/temp_dir.h"
+
+namespace FileSys {
+
+TEST_CASE("TitleImageCache", "[core][file_sys]") {
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("image.bin");
+    std::vector<u8> data(0x345678);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7);
+    }
+
+    // A source that fails leaves nothing behind for other instances to pick up
+    const auto failing_source = [](u64 offset, std::size_t length, u8* buffer) {
+        return offset == 0;
+    };
+    REQUIRE(!StoreTitleImage(path, data.size(), failing_source));
+    REQUIRE(!FileUtil::Exists(path));
+
+    REQUIRE(StoreTitleImage(path, data));
+    std::vector<u8> image;
+    REQUIRE(ReadTitleImage(path, image));
+    REQUIRE(image == data);
+
+    // An existing image is kept as it is
+    REQUIRE(StoreTitleImage(path, std::vector<u8>(16)));
+    REQUIRE(ReadTitleImage(path, image));
+    REQUIRE(image == data);
+}
+
+} // namespace FileSys
@@ -0,0 +1,236 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/core_timing.h"
+#include "core/file_sys/write_back_cache.h"
+#include "tests/temp_dir.h"
+
+namespace FileSys {
+
+namespace {
+
+std::vector<u8> MakeTestData(std::size_t size, u8 seed) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>(i * 7 + seed);
+    }
+    return data;
+}
+
+void CreateTestFile(const std::string& path, const std::vector<u8>& data) {
+    REQUIRE(FileUtil::IOFile(path, "wb").WriteBytes(data.data(), data.size()) == data.size());
+}
+
+std::vector<u8> ReadHostFile(const std::string& path) {
+    std::vector<u8> data(static_cast<std::size_t>(FileUtil::GetSize(path)));
+    FileUtil::IOFile(path, "rb").ReadBytes(data.data(), data.size());
+    return data;
+}
+
+std::vector<u8> ReadOverlay(const FileOverlay& overlay, const FileUtil::IOFile& file) {
+    std::vector<u8> data(static_cast<std::size_t>(overlay.GetSize()));
+    REQUIRE(overlay.Read(file, 0, data.size(), data.data()) == data.size());
+    return data;
+}
+
+/// Writes to an overlay, and makes the same write to the expected contents of the file
+void Write(FileOverlay& overlay, std::vector<u8>& expected, u64 offset, std::size_t length,
+           u8 seed) {
+    const std::vector<u8> data = MakeTestData(length, seed);
+    overlay.Write(offset, data.size(), data.data());
+    expected.resize(std::max<std::size_t>(expected.size(), offset + length));
+    std::copy(data.begin(), data.end(), expected.begin() + offset);
+}
+
+std::vector<std::string> ListJournals(const std::string& directory) {
+    std::vector<std::string> journals;
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, directory,
+        [&journals](u64*, const std::string& parent, const std::string& virtual_name) {
+            journals.push_back(parent + DIR_SEP + virtual_name);
+            return true;
+        });
+    return journals;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("FileOverlay", "[core][file_sys]") {
+    constexpr std::size_t HOST_SIZE = 0x100;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("save.bin");
+    const std::string journal_path = temp_dir.GetPath("save.journal");
+    std::vector<u8> expected = MakeTestData(HOST_SIZE, 0);
+    CreateTestFile(path, expected);
+    const FileUtil::IOFile file(path, "rb");
+    FileOverlay overlay(path, HOST_SIZE, false);
+
+    SECTION("merges writes that overlap or touch") {
+        Write(overlay, expected, 0x10, 0x10, 1);
+        Write(overlay, expected, 0x30, 0x10, 2);
+        REQUIRE(overlay.GetNumExtents() == 2);
+        REQUIRE(overlay.GetPendingBytes() == 0x20);
+
+        // Bridges the gap, touching both extents
+        Write(overlay, expected, 0x20, 0x10, 3);
+        REQUIRE(overlay.GetNumExtents() == 1);
+        REQUIRE(overlay.GetPendingBytes() == 0x30);
+
+        // Starts before the extent, and ends inside of it
+        Write(overlay, expected, 0x8, 0x10, 4);
+        REQUIRE(overlay.GetNumExtents() == 1);
+        REQUIRE(overlay.GetPendingBytes() == 0x38);
+
+        // Lies within the extent
+        Write(overlay, expected, 0x18, 0x4, 5);
+        REQUIRE(overlay.GetPendingBytes() == 0x38);
+
+        // Extends the file past the end of the host file
+        Write(overlay, expected, HOST_SIZE - 0x8, 0x20, 6);
+        REQUIRE(overlay.GetNumExtents() == 2);
+        REQUIRE(overlay.GetSize() == HOST_SIZE + 0x18);
+
+        REQUIRE(ReadOverlay(overlay, file) == expected);
+        REQUIRE(ReadHostFile(path) == MakeTestData(HOST_SIZE, 0));
+    }
+
+    SECTION("truncates the host file and the pending writes") {
+        Write(overlay, expected, 0x40, 0x40, 1);
+        Write(overlay, expected, 0xC0, 0x10, 2);
+        overlay.Resize(0x60);
+        expected.resize(0x60);
+        REQUIRE(overlay.GetNumExtents() == 1);
+        REQUIRE(overlay.GetPendingBytes() == 0x20);
+        REQUIRE(ReadOverlay(overlay, file) == expected);
+
+        // Growing the file again doesn't bring back the truncated data
+        overlay.Resize(HOST_SIZE);
+        expected.resize(HOST_SIZE, 0);
+        REQUIRE(ReadOverlay(overlay, file) == expected);
+
+        std::vector<u8> buffer(0x10);
+        REQUIRE(overlay.Read(file, HOST_SIZE - 0x8, buffer.size(), buffer.data()) == 0x8);
+        REQUIRE(overlay.Read(file, HOST_SIZE, buffer.size(), buffer.data()) == 0);
+    }
+
+    SECTION("applies the pending writes when flushed") {
+        Write(overlay, expected, 0x10, 0x20, 1);
+        Write(overlay, expected, HOST_SIZE, 0x10, 2);
+        overlay.Resize(HOST_SIZE + 0x8);
+        expected.resize(HOST_SIZE + 0x8);
+
+        FileUtil::IOFile write_file(path, "r+b");
+        REQUIRE(overlay.Flush(write_file, journal_path));
+        write_file.Close();
+        REQUIRE(!overlay.IsDirty());
+        REQUIRE(overlay.GetNumExtents() == 0);
+        REQUIRE(ReadHostFile(path) == expected);
+        REQUIRE(ReadOverlay(overlay, file) == expected);
+        REQUIRE(!FileUtil::Exists(journal_path));
+    }
+
+    SECTION("keeps in-memory writes off the host file") {
+        FileOverlay memory_overlay(path, HOST_SIZE, true);
+        Write(memory_overlay, expected, 0x10, 0x20, 1);
+        memory_overlay.Resize(0x80);
+        expected.resize(0x80);
+
+        FileUtil::IOFile write_file(path, "r+b");
+        REQUIRE(memory_overlay.Flush(write_file, journal_path));
+        write_file.Close();
+        REQUIRE(memory_overlay.IsDirty());
+        REQUIRE(ReadOverlay(memory_overlay, file) == expected);
+        REQUIRE(ReadHostFile(path) == MakeTestData(HOST_SIZE, 0));
+    }
+}
+
+TEST_CASE("WriteBackCache", "[core][file_sys]") {
+    constexpr std::size_t HOST_SIZE = 0x100;
+    const Tests::TempDir temp_dir;
+    const std::string path = temp_dir.GetPath("save.bin");
+    const std::string journal_directory = temp_dir.GetPath("journal") + DIR_SEP;
+    std::vector<u8> expected = MakeTestData(HOST_SIZE, 0);
+    CreateTestFile(path, expected);
+    Core::Timing timing;
+    timing.Advance();
+
+    SECTION("shares overlays between handles") {
+        WriteBackCache cache(journal_directory, &timing);
+        auto overlay = cache.AcquireFileOverlay(path, HOST_SIZE, false);
+        auto other_overlay =
+            cache.AcquireFileOverlay(temp_dir.GetPath() + DIR_SEP DIR_SEP "save.bin", 0, false);
+        REQUIRE(overlay == other_overlay);
+
+        Write(*overlay, expected, HOST_SIZE, 0x10, 1);
+        REQUIRE(cache.GetPendingFileSize(path) == HOST_SIZE + 0x10);
+
+        // Forgotten once the last handle releases it
+        cache.ReleaseFileOverlay(other_overlay);
+        REQUIRE(cache.GetPendingFileSize(path).has_value());
+        FileUtil::IOFile file(path, "r+b");
+        REQUIRE(cache.Flush(*overlay, file));
+        cache.ReleaseFileOverlay(overlay);
+        REQUIRE(!cache.GetPendingFileSize(path).has_value());
+    }
+
+    SECTION("flushes pending writes periodically") {
+        WriteBackCache cache(journal_directory, &timing);
+        auto overlay = cache.AcquireFileOverlay(path, HOST_SIZE, false);
+        Write(*overlay, expected, 0x20, 0x10, 1);
+
+        // Nothing is written until a second of emulated time has passed
+        const u64 flush_time = timing.GetTicks() + msToCycles(1000);
+        REQUIRE(ReadHostFile(path) == MakeTestData(HOST_SIZE, 0));
+        while (overlay->IsDirty()) {
+            REQUIRE(timing.GetTicks() < flush_time);
+            timing.AddTicks(timing.GetDowncount());
+            timing.Advance();
+        }
+        REQUIRE(timing.GetTicks() == flush_time);
+        REQUIRE(ReadHostFile(path) == expected);
+        cache.ReleaseFileOverlay(overlay);
+    }
+
+    SECTION("replays the journals of interrupted flushes") {
+        WriteBackCache cache(journal_directory, nullptr);
+        {
+            // An overlay the cache doesn't track stands in for one lost in a crash, and a handle
+            // that can't write makes its flush fail after the batch was journaled
+            FileOverlay overlay(path, HOST_SIZE, false);
+            Write(overlay, expected, 0x80, 0x100, 1);
+            FileUtil::IOFile read_only_file(path, "rb");
+            REQUIRE(!cache.Flush(overlay, read_only_file));
+        }
+        REQUIRE(ListJournals(journal_directory).size() == 1);
+        REQUIRE(ReadHostFile(path) == MakeTestData(HOST_SIZE, 0));
+
+        SECTION("complete journal") {
+            auto overlay = cache.AcquireFileOverlay(path, HOST_SIZE, false);
+            REQUIRE(overlay->GetSize() == expected.size());
+            REQUIRE(ReadHostFile(path) == expected);
+        }
+        SECTION("journal cut short before its commit marker") {
+            const std::string journal_path = ListJournals(journal_directory).front();
+            const std::vector<u8> journal = ReadHostFile(journal_path);
+            CreateTestFile(journal_path, std::vector<u8>(journal.begin(), journal.end() - 4));
+            cache.AcquireFileOverlay(path, HOST_SIZE, false);
+            REQUIRE(ReadHostFile(path) == MakeTestData(HOST_SIZE, 0));
+        }
+        SECTION("journal of a deleted file") {
+            cache.DiscardPendingWrites(temp_dir.GetPath());
+            cache.AcquireFileOverlay(path, HOST_SIZE, false);
+            REQUIRE(ReadHostFile(path) == MakeTestData(HOST_SIZE, 0));
+        }
+        REQUIRE(ListJournals(journal_directory).empty());
+    }
+}
+
+} // namespace FileSys
@@ -0,0 +1,268 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/chunk_file.h"
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/skyeye_common/armstate.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/server_port.h"
+#include "core/hle/kernel/session.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/timer.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+namespace {
+
+class TestHandler final : public SessionRequestHandler {
+public:
+    struct SessionData : SessionDataBase {
+        u32 value = 0;
+
+        void DoState(PointerWrap& p, KernelSystem& kernel) override {
+            p.Do(value);
+        }
+    };
+
+    void HandleSyncRequest(HLERequestContext& context) override {}
+
+    SessionData* GetData(std::shared_ptr<ServerSession> session) {
+        return GetSessionData<SessionData>(std::move(session));
+    }
+
+protected:
+    std::unique_ptr<SessionDataBase> MakeSessionData() const override {
+        return std::make_unique<SessionData>();
+    }
+};
+
+/// A kernel with a CPU to create threads with, and an HLE port like the services register
+struct TestKernel {
+    TestKernel() {
+        kernel.GetThreadManager(0).SetCPU(cpu);
+        auto [server, client] = kernel.CreatePortPair(1, "test:hle");
+        server->SetHleHandler(handler);
+        kernel.AddNamedPort("test:hle", std::move(client));
+        hle_port = std::move(server);
+    }
+
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    KernelSystem kernel{memory, timing, [] {}, 0};
+    ARM_DynCom cpu{nullptr, memory, USER32MODE};
+    std::shared_ptr<TestHandler> handler = std::make_shared<TestHandler>();
+    std::shared_ptr<ServerPort> hle_port;
+};
+
+constexpr VAddr entry_point = Memory::PROCESS_IMAGE_VADDR;
+
+/// Creates a process with code mapped at the entry point, so that it can create threads
+std::shared_ptr<Process> CreateProcess(TestKernel& test, std::string name, u64 program_id) {
+    auto codeset = test.kernel.CreateCodeSet(std::move(name), program_id);
+    auto process = test.kernel.CreateProcess(std::move(codeset));
+    process->vm_manager
+        .MapBackingMemory(entry_point, test.memory.GetFCRAMPointer(0), Memory::PAGE_SIZE,
+                          MemoryState::Code)
+        .Unwrap();
+    test.kernel.MapSharedPages(process->vm_manager);
+    return process;
+}
+
+/// Saves or restores the kernel followed by the service, like Core::SaveStateManager does
+void DoState(TestKernel& test, PointerWrap& p) {
+    test.kernel.DoState(p);
+    if (p.error != PointerWrap::ERROR_FAILURE) {
+        test.handler->DoSessionsState(p, test.kernel);
+    }
+}
+
+std::vector<u8> SaveKernel(TestKernel& test) {
+    u8* ptr = nullptr;
+    PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+    DoState(test, measure);
+
+    std::vector<u8> data(reinterpret_cast<std::size_t>(ptr));
+    ptr = data.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    DoState(test, p);
+    return data;
+}
+
+bool LoadKernel(TestKernel& test, std::vector<u8> data) {
+    u8* ptr = data.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_READ);
+    DoState(test, p);
+    const bool success = p.error != PointerWrap::ERROR_FAILURE && ptr == data.data() + data.size();
+    if (success) {
+        test.kernel.ReleaseRestoredHLESessions();
+    }
+    return success;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("KernelSystem::DoState", "[core][kernel]") {
+    std::vector<u8> saved;
+    Handle event_handle, mutex_handle, semaphore_handle, timer_handle;
+    Handle hle_session_handle, port_handle, session_handle;
+
+    // Saves the state of a kernel that is then torn down, to be loaded into a new one
+    {
+        TestKernel original;
+        KernelSystem& kernel = original.kernel;
+        ThreadManager& thread_manager = kernel.GetThreadManager(0);
+
+        auto process = CreateProcess(original, "test", 0x1234);
+        kernel.SetCurrentProcess(process);
+        original.memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+        const auto CreateThread = [&](u32 priority) {
+            return kernel
+                .CreateThread("", entry_point, priority, 0, ThreadProcessorId0, 0, *process)
+                .Unwrap();
+        };
+        auto waiting_thread = CreateThread(30);
+        auto running_thread = CreateThread(40);
+        auto ready_thread = CreateThread(50);
+
+        auto event = kernel.CreateEvent(ResetType::OneShot);
+        auto mutex = kernel.CreateMutex(false);
+        auto semaphore = kernel.CreateSemaphore(1, 4).Unwrap();
+        auto timer = kernel.CreateTimer(ResetType::Sticky, "timer");
+        event_handle = process->handle_table.Create(event).Unwrap();
+        mutex_handle = process->handle_table.Create(mutex).Unwrap();
+        semaphore_handle = process->handle_table.Create(semaphore).Unwrap();
+        timer_handle = process->handle_table.Create(timer).Unwrap();
+
+        auto hle_session = kernel.named_ports.at("test:hle")->Connect().Unwrap();
+        hle_session_handle = process->handle_table.Create(hle_session).Unwrap();
+        original.handler->GetData(SharedFrom(hle_session->parent->server))->value = 0x5678;
+        auto [server_port, client_port] = kernel.CreatePortPair(1, "test:lle");
+        port_handle = process->handle_table.Create(server_port).Unwrap();
+        session_handle = process->handle_table.Create(client_port->Connect().Unwrap()).Unwrap();
+
+        // The first thread runs and waits for the event, like WaitSynchronization1 would make it.
+        thread_manager.Reschedule();
+        REQUIRE(thread_manager.GetCurrentThread() == waiting_thread.get());
+        waiting_thread->status = ThreadStatus::WaitSynchAny;
+        waiting_thread->wait_objects = {event};
+        waiting_thread->wakeup_callback_kind = WakeupCallbackKind::WaitSynch1;
+        waiting_thread->wakeup_callback =
+            GetSVCWakeupCallback(original.memory, WakeupCallbackKind::WaitSynch1);
+        event->AddWaitingThread(waiting_thread);
+        thread_manager.Reschedule();
+        REQUIRE(thread_manager.GetCurrentThread() == running_thread.get());
+        mutex->Acquire(running_thread.get());
+
+        REQUIRE(kernel.CanSaveState());
+        saved = SaveKernel(original);
+    }
+
+    TestKernel restored;
+    KernelSystem& kernel = restored.kernel;
+    ThreadManager& thread_manager = kernel.GetThreadManager(0);
+
+    SECTION("recreates the saved objects") {
+        REQUIRE(LoadKernel(restored, saved));
+        CHECK(SaveKernel(restored) == saved);
+
+        const auto process = kernel.GetCurrentProcess();
+        REQUIRE(process != nullptr);
+        CHECK(process->codeset->name == "test");
+        CHECK(process->codeset->program_id == 0x1234);
+        CHECK(Memory::IsValidVirtualAddress(*process, entry_point));
+        CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR));
+        CHECK(restored.memory.GetPointer(entry_point) == restored.memory.GetFCRAMPointer(0));
+
+        const auto event = process->handle_table.Get<Event>(event_handle);
+        const auto mutex = process->handle_table.Get<Mutex>(mutex_handle);
+        const auto semaphore = process->handle_table.Get<Semaphore>(semaphore_handle);
+        const auto timer = process->handle_table.Get<Timer>(timer_handle);
+        REQUIRE(event != nullptr);
+        REQUIRE(mutex != nullptr);
+        REQUIRE(semaphore != nullptr);
+        REQUIRE(timer != nullptr);
+        CHECK(timer->GetName() == "timer");
+        CHECK(semaphore->available_count == 1);
+
+        const auto& threads = thread_manager.GetThreadList();
+        REQUIRE(threads.size() == 3);
+        const auto& waiting_thread = threads[0];
+        const auto& running_thread = threads[1];
+        const auto& ready_thread = threads[2];
+        CHECK(waiting_thread->owner_process == process.get());
+        CHECK(thread_manager.GetCurrentThread() == running_thread.get());
+        CHECK(event->GetWaitingThreads() == std::vector<std::shared_ptr<Thread>>{waiting_thread});
+        CHECK(mutex->holding_thread == running_thread);
+        CHECK(running_thread->held_mutexes.count(mutex) == 1);
+
+        // The session to the HLE port is handled by the service of the new kernel.
+        const auto hle_session = process->handle_table.Get<ClientSession>(hle_session_handle);
+        REQUIRE(hle_session != nullptr);
+        REQUIRE(hle_session->parent->server != nullptr);
+        CHECK(hle_session->parent->server->hle_handler == restored.handler);
+        CHECK(restored.handler->GetData(SharedFrom(hle_session->parent->server))->value == 0x5678);
+        CHECK(restored.hle_port->hle_handler == nullptr);
+
+        const auto port = process->handle_table.Get<ServerPort>(port_handle);
+        const auto session = process->handle_table.Get<ClientSession>(session_handle);
+        REQUIRE(port != nullptr);
+        REQUIRE(session != nullptr);
+        REQUIRE(port->pending_sessions.size() == 1);
+        CHECK(port->pending_sessions[0]->parent == session->parent);
+
+        // The restored wakeup callback and ready queue schedule the threads like before.
+        event->Signal();
+        CHECK(waiting_thread->status == ThreadStatus::Ready);
+        CHECK(waiting_thread->wakeup_callback == nullptr);
+        running_thread->status = ThreadStatus::WaitSleep;
+        thread_manager.Reschedule();
+        CHECK(thread_manager.GetCurrentThread() == waiting_thread.get());
+        waiting_thread->status = ThreadStatus::WaitSleep;
+        thread_manager.Reschedule();
+        CHECK(thread_manager.GetCurrentThread() == ready_thread.get());
+    }
+
+    SECTION("refuses states that don't fit the running kernel") {
+        const std::vector<u8> current = SaveKernel(restored);
+
+        // Without the HLE service the state was saved with
+        restored.hle_port->SetHleHandler(nullptr);
+        CHECK_FALSE(LoadKernel(restored, saved));
+        restored.hle_port->SetHleHandler(restored.handler);
+        CHECK(SaveKernel(restored) == current);
+
+        std::vector<u8> truncated = saved;
+        truncated.resize(truncated.size() / 2);
+        CHECK_FALSE(LoadKernel(restored, truncated));
+        CHECK(SaveKernel(restored) == current);
+    }
+
+    SECTION("refuses to save threads paused by an HLE service") {
+        auto process = CreateProcess(restored, "", 0);
+        auto thread =
+            kernel.CreateThread("", entry_point, 30, 0, ThreadProcessorId0, 0, *process).Unwrap();
+        CHECK(kernel.CanSaveState());
+        thread->wakeup_callback = [](ThreadWakeupReason, std::shared_ptr<Thread>,
+                                     std::shared_ptr<WaitObject>) {};
+        thread->wakeup_callback_kind = WakeupCallbackKind::HLE;
+        CHECK_FALSE(kernel.CanSaveState());
+    }
+}
+
+} // namespace Kernel
@@ -0,0 +1,171 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hle/romfs.h"
+
+namespace RomFS {
+
+namespace {
+
+/// Builds RomFS images out of directory and file entries, linked by their offsets
+class ImageBuilder {
+public:
+    static constexpr std::size_t HEADER_SIZE = 0x28;
+    static constexpr std::size_t DIR_ENTRY_SIZE = 0x18;
+    static constexpr std::size_t FILE_ENTRY_SIZE = 0x20;
+
+    /// Adds a directory without children, and returns its offset
+    u32 AddDirectory(const std::u16string& name) {
+        return AddEntry(dir_table, DIR_ENTRY_SIZE, name);
+    }
+
+    /// Adds a file with the given data, and returns its offset
+    u32 AddFile(const std::u16string& name, const std::string& contents) {
+        const u32 offset = AddEntry(file_table, FILE_ENTRY_SIZE, name);
+        SetFileData(offset, data.size(), contents.size());
+        data.insert(data.end(), contents.begin(), contents.end());
+        return offset;
+    }
+
+    void SetNextDirectory(u32 dir, u32 next) {
+        Write32(dir_table, dir + 0x4, next);
+    }
+    void SetFirstChildDirectory(u32 dir, u32 child) {
+        Write32(dir_table, dir + 0x8, child);
+    }
+    void SetFirstFile(u32 dir, u32 file) {
+        Write32(dir_table, dir + 0xC, file);
+    }
+    void SetNextFile(u32 file, u32 next) {
+        Write32(file_table, file + 0x4, next);
+    }
+    void SetFileData(u32 file, u64 offset, u64 length) {
+        Write64(file_table, file + 0x8, offset);
+        Write64(file_table, file + 0x10, length);
+    }
+
+    std::vector<u8> Build() const {
+        const u32 dir_table_offset = HEADER_SIZE;
+        const u32 file_table_offset = dir_table_offset + static_cast<u32>(dir_table.size());
+        const u32 data_offset = file_table_offset + static_cast<u32>(file_table.size());
+        std::vector<u8> image(HEADER_SIZE);
+        Write32(image, 0x0, HEADER_SIZE);
+        Write32(image, 0xC, dir_table_offset);
+        Write32(image, 0x10, static_cast<u32>(dir_table.size()));
+        Write32(image, 0x1C, file_table_offset);
+        Write32(image, 0x20, static_cast<u32>(file_table.size()));
+        Write32(image, 0x24, data_offset);
+        image.insert(image.end(), dir_table.begin(), dir_table.end());
+        image.insert(image.end(), file_table.begin(), file_table.end());
+        image.insert(image.end(), data.begin(), data.end());
+        return image;
+    }
+
+private:
+    static void Write32(std::vector<u8>& buffer, std::size_t offset, u32 value) {
+        std::memcpy(&buffer[offset], &value, sizeof(value));
+    }
+    static void Write64(std::vector<u8>& buffer, std::size_t offset, u64 value) {
+        std::memcpy(&buffer[offset], &value, sizeof(value));
+    }
+
+    static u32 AddEntry(std::vector<u8>& table, std::size_t entry_size,
+                        const std::u16string& name) {
+        const u32 offset = static_cast<u32>(table.size());
+        const u32 name_length = static_cast<u32>(name.size() * sizeof(char16_t));
+        // Entries are 4-byte aligned, and all their offsets start out invalid.
+        table.resize(offset + entry_size + ((name_length + 3) & ~3u), 0);
+        std::memset(&table[offset], 0xFF, entry_size - sizeof(u32));
+        Write32(table, offset + entry_size - sizeof(u32), name_length);
+        std::memcpy(&table[offset + entry_size], name.data(), name_length);
+        return offset;
+    }
+
+    std::vector<u8> dir_table;
+    std::vector<u8> file_table;
+    std::vector<u8> data;
+};
+
+std::string GetContents(const RomFSFile& file) {
+    return file.Data() != nullptr ? std::string(file.Data(), file.Data() + file.Length()) : "";
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RomFSIndex", "[core][romfs]") {
+    ImageBuilder builder;
+    const u32 root = builder.AddDirectory(u"");
+    const u32 dir_a = builder.AddDirectory(u"a");
+    const u32 dir_b = builder.AddDirectory(u"b");
+    const u32 root_file = builder.AddFile(u"root.bin", "root");
+    const u32 file_x = builder.AddFile(u"x.bin", "xx");
+    const u32 file_y = builder.AddFile(u"y.bin", "yyy");
+    const u32 file_z = builder.AddFile(u"z.bin", "z");
+    builder.SetFirstChildDirectory(root, dir_a);
+    builder.SetFirstFile(root, root_file);
+    builder.SetFirstChildDirectory(dir_a, dir_b);
+    builder.SetFirstFile(dir_a, file_x);
+    builder.SetNextFile(file_x, file_z);
+    builder.SetFirstFile(dir_b, file_y);
+
+    SECTION("indexes files and directories by path") {
+        const std::vector<u8> image = builder.Build();
+        const RomFSIndex index(image.data(), image.size());
+
+        CHECK(GetContents(index.GetFile(u"root.bin")) == "root");
+        CHECK(GetContents(index.GetFile(u"a/x.bin")) == "xx");
+        CHECK(GetContents(index.GetFile(u"a/z.bin")) == "z");
+        CHECK(GetContents(index.GetFile(RomFSIndex::JoinPath({u"a", u"b", u"y.bin"}))) == "yyy");
+        CHECK(index.GetFile(u"y.bin").Data() == nullptr);
+        CHECK(index.GetFile(u"a/b").Data() == nullptr);
+
+        const auto* root_listing = index.GetDirectory(u"");
+        REQUIRE(root_listing != nullptr);
+        CHECK(root_listing->directories == std::vector<std::u16string>{u"a"});
+        CHECK(root_listing->files == std::vector<std::u16string>{u"root.bin"});
+        const auto* a_listing = index.GetDirectory(u"a");
+        REQUIRE(a_listing != nullptr);
+        CHECK(a_listing->files == std::vector<std::u16string>{u"x.bin", u"z.bin"});
+        CHECK(index.GetDirectory(u"a/b") != nullptr);
+        CHECK(index.GetDirectory(u"c") == nullptr);
+    }
+
+    SECTION("leaves out entries outside of the image") {
+        builder.SetFileData(file_z, 0x10000, 1);
+        std::vector<u8> image = builder.Build();
+        const RomFSIndex index(image.data(), image.size());
+        CHECK(index.GetFile(u"a/z.bin").Data() == nullptr);
+        CHECK(index.GetDirectory(u"a")->files.size() == 2);
+
+        // Cutting the image short loses the entries past the end, but nothing before them.
+        const RomFSIndex truncated_index(image.data(), ImageBuilder::HEADER_SIZE + dir_b);
+        CHECK(truncated_index.GetDirectory(u"a") != nullptr);
+        CHECK(truncated_index.GetDirectory(u"a/b") == nullptr);
+        CHECK(truncated_index.GetFile(u"root.bin").Data() == nullptr);
+
+        const RomFSIndex empty_index(image.data(), ImageBuilder::HEADER_SIZE - 1);
+        CHECK(empty_index.GetDirectory(u"") == nullptr);
+    }
+
+    SECTION("stops at loops") {
+        // A directory that is its own sibling, one that is the parent of the root, and a file
+        // that is followed by the first file of its directory
+        builder.SetNextDirectory(dir_a, dir_a);
+        builder.SetFirstChildDirectory(dir_b, root);
+        builder.SetNextFile(file_z, file_x);
+        const std::vector<u8> image = builder.Build();
+        const RomFSIndex index(image.data(), image.size());
+
+        CHECK(index.GetDirectory(u"")->directories == std::vector<std::u16string>{u"a"});
+        CHECK(index.GetDirectory(u"a")->files == std::vector<std::u16string>{u"x.bin", u"z.bin"});
+        CHECK(index.GetDirectory(u"a/b")->directories.empty());
+        CHECK(GetContents(index.GetFile(u"a/b/y.bin")) == "yyy");
+    }
+}
+
+} // namespace RomFS
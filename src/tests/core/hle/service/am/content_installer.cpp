@@ -0,0 +1,192 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/errors.h"
+#include "core/hle/service/am/content_installer.h"
+#include "tests/temp_dir.h"
+
+namespace Service::AM {
+
+namespace {
+
+constexpr std::array<u8, 16> TITLE_KEY{0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                       0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+
+/// Pieces the contents are pushed in, small enough to fill the queues between the stages
+constexpr std::size_t PIECE_SIZE = 0x400;
+
+/// Contents of a made-up CIA, in plain text and as stored in the CIA
+struct TestContents {
+    TestContents(const Tests::TempDir& temp_dir, const std::vector<std::size_t>& sizes,
+                 bool encrypted) {
+        for (std::size_t i = 0; i < sizes.size(); ++i) {
+            std::vector<u8> data(sizes[i]);
+            for (std::size_t j = 0; j < data.size(); ++j) {
+                data[j] = static_cast<u8>(j * 13 + i);
+            }
+
+            ContentInstaller::Content content;
+            content.path = temp_dir.GetPath(std::to_string(i) + ".app");
+            content.size = data.size();
+            CryptoPP::SHA256().CalculateDigest(content.hash.data(), data.data(), data.size());
+
+            std::vector<u8> stored = data;
+            if (encrypted) {
+                content.key = TITLE_KEY;
+                content.iv = {static_cast<u8>(i)};
+                CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption encryption;
+                encryption.SetKeyWithIV(TITLE_KEY.data(), TITLE_KEY.size(), content.iv.data());
+                encryption.ProcessData(stored.data(), stored.data(), stored.size());
+            }
+
+            contents.push_back(content);
+            plain.push_back(std::move(data));
+            this->stored.push_back(std::move(stored));
+        }
+    }
+
+    /// Pushes every content, and returns the first error
+    ResultCode Push(ContentInstaller& installer, std::size_t piece_size = PIECE_SIZE) const {
+        for (std::size_t i = 0; i < stored.size(); ++i) {
+            for (std::size_t offset = 0; offset < stored[i].size(); offset += piece_size) {
+                const std::size_t length = std::min(piece_size, stored[i].size() - offset);
+                const ResultCode result = installer.Push(i, stored[i].data() + offset, length);
+                if (result.IsError()) {
+                    return result;
+                }
+            }
+        }
+        return RESULT_SUCCESS;
+    }
+
+    std::vector<u8> ReadInstalled(std::size_t index) const {
+        std::string written;
+        FileUtil::ReadFileToString(false, contents[index].path.c_str(), written);
+        return std::vector<u8>(written.begin(), written.end());
+    }
+
+    std::vector<ContentInstaller::Content> contents;
+    std::vector<std::vector<u8>> plain;
+    std::vector<std::vector<u8>> stored;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("ContentInstaller", "[core][am]") {
+    const Tests::TempDir temp_dir;
+
+    SECTION("installs encrypted contents") {
+        const TestContents cia(temp_dir, {0x12340, 0x800, 0x4560}, true);
+        ContentInstaller installer(cia.contents);
+        REQUIRE(cia.Push(installer) == RESULT_SUCCESS);
+        REQUIRE(installer.Finish() == RESULT_SUCCESS);
+        for (std::size_t i = 0; i < cia.contents.size(); ++i) {
+            REQUIRE(cia.ReadInstalled(i) == cia.plain[i]);
+        }
+    }
+
+    SECTION("installs plain contents") {
+        const TestContents cia(temp_dir, {0x800, 0x3000}, false);
+        ContentInstaller installer(cia.contents);
+        REQUIRE(cia.Push(installer) == RESULT_SUCCESS);
+        REQUIRE(installer.Finish() == RESULT_SUCCESS);
+        REQUIRE(cia.ReadInstalled(0) == cia.plain[0]);
+        REQUIRE(cia.ReadInstalled(1) == cia.plain[1]);
+    }
+
+    SECTION("rejects a content that doesn't match its hash") {
+        TestContents cia(temp_dir, {0x800, 0x40000}, true);
+        cia.contents[0].hash[0] ^= 1;
+        ContentInstaller installer(cia.contents);
+        const ResultCode push_result = cia.Push(installer);
+        REQUIRE((push_result == RESULT_SUCCESS || push_result == ERROR_CONTENT_HASH_MISMATCH));
+        REQUIRE(installer.Finish() == ERROR_CONTENT_HASH_MISMATCH);
+    }
+
+    SECTION("reports a mismatch in the last content when finishing") {
+        TestContents cia(temp_dir, {0x800, 0x800}, false);
+        cia.contents[1].hash[0] ^= 1;
+        ContentInstaller installer(cia.contents);
+        REQUIRE(cia.Push(installer) == RESULT_SUCCESS);
+        REQUIRE(installer.Finish() == ERROR_CONTENT_HASH_MISMATCH);
+        REQUIRE(installer.Finish() == ERROR_CONTENT_HASH_MISMATCH);
+    }
+
+    SECTION("doesn't check contents that are cut short") {
+        const TestContents cia(temp_dir, {0x800}, false);
+        ContentInstaller installer(cia.contents);
+        REQUIRE(installer.Push(0, cia.stored[0].data(), 0x400) == RESULT_SUCCESS);
+        REQUIRE(installer.Finish() == RESULT_SUCCESS);
+        REQUIRE(cia.ReadInstalled(0) ==
+                std::vector<u8>(cia.plain[0].begin(), cia.plain[0].begin() + 0x400));
+    }
+
+    SECTION("reports contents that can't be written") {
+        TestContents cia(temp_dir, {0x800}, false);
+        cia.contents[0].path = temp_dir.GetPath("missing") + DIR_SEP "0.app";
+        ContentInstaller installer(cia.contents);
+        const ResultCode push_result = cia.Push(installer);
+        REQUIRE((push_result == RESULT_SUCCESS ||
+                 push_result == FileSys::ERROR_INSUFFICIENT_SPACE));
+        REQUIRE(installer.Finish() == FileSys::ERROR_INSUFFICIENT_SPACE);
+    }
+}
+
+TEST_CASE("ContentInstaller[Throughput]", "[core][am][.benchmark]") {
+    constexpr std::size_t BENCHMARK_PIECE_SIZE = 0x10000;
+    const Tests::TempDir temp_dir;
+    const TestContents cia(temp_dir, {64 << 20, 128 << 20, 64 << 20}, true);
+    std::size_t total_size = 0;
+    for (const auto& content : cia.contents) {
+        total_size += content.size;
+    }
+    const auto report = [total_size](const char* name, std::chrono::steady_clock::duration time) {
+        const double seconds = std::chrono::duration<double>(time).count();
+        WARN(name << ": " << total_size / seconds / (1024 * 1024) << " MiB/s");
+    };
+
+    {
+        // What CIAFile did before: decrypt, hash and write each piece in turn on one thread
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < cia.contents.size(); ++i) {
+            const auto& content = cia.contents[i];
+            CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption decryption;
+            decryption.SetKeyWithIV(content.key->data(), content.key->size(), content.iv.data());
+            CryptoPP::SHA256 sha;
+            FileUtil::IOFile file(content.path, "wb");
+            std::vector<u8> piece(BENCHMARK_PIECE_SIZE);
+            for (std::size_t offset = 0; offset < content.size; offset += piece.size()) {
+                const auto length = std::min<std::size_t>(piece.size(), content.size - offset);
+                decryption.ProcessData(piece.data(), cia.stored[i].data() + offset, length);
+                sha.Update(piece.data(), length);
+                file.WriteBytes(piece.data(), length);
+            }
+            std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+            sha.Final(hash.data());
+            REQUIRE(hash == content.hash);
+        }
+        report("Serial", std::chrono::steady_clock::now() - start);
+    }
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        ContentInstaller installer(cia.contents);
+        REQUIRE(cia.Push(installer, BENCHMARK_PIECE_SIZE) == RESULT_SUCCESS);
+        REQUIRE(installer.Finish() == RESULT_SUCCESS);
+        report("Pipelined", std::chrono::steady_clock::now() - start);
+    }
+}
+
+} // namespace Service::AM
@@ -0,0 +1,134 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/swap.h"
+#include "core/loader/title_info_cache.h"
+#include "tests/temp_dir.h"
+
+namespace Loader {
+
+namespace {
+
+constexpr u32 HEADER_SIZE = 0x2C;
+
+/// Writes a 3DSX that has nothing but an icon, as that is all a title list reads from it
+void Create3DSX(const std::string& path, const std::vector<u8>& smdh,
+                u16 header_size = HEADER_SIZE) {
+    std::array<u32_le, HEADER_SIZE / sizeof(u32)> header{};
+    header[0] = MakeMagic('3', 'D', 'S', 'X');
+    header[1] = header_size;
+    header[8] = HEADER_SIZE;                   // SMDH offset
+    header[9] = static_cast<u32>(smdh.size()); // SMDH size
+    FileUtil::IOFile file(path, "wb");
+    REQUIRE(file.WriteBytes(header.data(), HEADER_SIZE) == HEADER_SIZE);
+    REQUIRE(file.WriteBytes(smdh.data(), smdh.size()) == smdh.size());
+}
+
+std::vector<u8> ReadFile(const std::string& path) {
+    std::vector<u8> data(static_cast<std::size_t>(FileUtil::GetSize(path)));
+    FileUtil::IOFile(path, "rb").ReadBytes(data.data(), data.size());
+    return data;
+}
+
+u32 ReadWord(const std::vector<u8>& data, std::size_t offset) {
+    u32_le word;
+    std::memcpy(&word, data.data() + offset, sizeof(word));
+    return word;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("TitleInfoCache", "[core][loader]") {
+    constexpr std::size_t CACHE_HEADER_SIZE = 0x10;
+    constexpr std::size_t ENTRY_HEADER_SIZE = 0x30;
+    const Tests::TempDir temp_dir;
+    const std::string cache_path = temp_dir.GetPath("title_info.bin");
+    const std::string path = temp_dir.GetPath("title.3dsx");
+    const std::vector<u8> smdh(0x40, 0xAB);
+    Create3DSX(path, smdh);
+
+    {
+        TitleInfoCache cache(cache_path);
+        const TitleInfo info = cache.Get(path);
+        REQUIRE(info.file_type == FileType::THREEDSX);
+        REQUIRE(info.smdh == smdh);
+        REQUIRE(cache.Save());
+    }
+
+    SECTION("stores each entry with the size and modification time of its file") {
+        const std::vector<u8> data = ReadFile(cache_path);
+        REQUIRE(data.size() == CACHE_HEADER_SIZE + ENTRY_HEADER_SIZE + path.size() + smdh.size());
+        REQUIRE(ReadWord(data, 0) == MakeMagic('C', 'T', 'I', 'C'));
+        REQUIRE(ReadWord(data, 8) == 1);
+
+        const std::size_t entry = CACHE_HEADER_SIZE;
+        REQUIRE(ReadWord(data, entry) == FileUtil::GetSize(path));
+        REQUIRE(ReadWord(data, entry + 8) ==
+                static_cast<u32>(FileUtil::GetModificationTime(path)));
+        REQUIRE(ReadWord(data, entry + 0x20) == static_cast<u32>(FileType::THREEDSX));
+        REQUIRE(ReadWord(data, entry + 0x24) == path.size());
+        REQUIRE(ReadWord(data, entry + 0x28) == smdh.size());
+        const auto path_start = data.begin() + entry + ENTRY_HEADER_SIZE;
+        REQUIRE(std::string(path_start, path_start + path.size()) == path);
+        REQUIRE(std::vector<u8>(path_start + path.size(), data.end()) == smdh);
+    }
+
+    // The cached icon is changed behind the cache's back, to tell cached info from reread info
+    std::vector<u8> data = ReadFile(cache_path);
+    data.back() = 0xCD;
+    FileUtil::IOFile(cache_path, "wb").WriteBytes(data.data(), data.size());
+    std::vector<u8> cached_smdh = smdh;
+    cached_smdh.back() = 0xCD;
+
+    SECTION("uses the cached info of unchanged files") {
+        TitleInfoCache cache(cache_path);
+        REQUIRE(cache.Get(path).smdh == cached_smdh);
+    }
+
+    SECTION("rereads files whose size changed") {
+        const std::vector<u8> new_smdh(0x80, 0x12);
+        Create3DSX(path, new_smdh);
+        TitleInfoCache cache(cache_path);
+        REQUIRE(cache.Get(path).smdh == new_smdh);
+        REQUIRE(cache.Save());
+        REQUIRE(TitleInfoCache(cache_path).Get(path).smdh == new_smdh);
+    }
+
+    SECTION("doesn't remember files that couldn't be read") {
+        Create3DSX(path, {}, HEADER_SIZE + 4);
+        TitleInfoCache cache(cache_path);
+        REQUIRE(cache.Get(path).smdh.empty());
+        REQUIRE(cache.Save());
+        REQUIRE(ReadWord(ReadFile(cache_path), 8) == 0);
+    }
+
+    SECTION("drops the entries of deleted files") {
+        REQUIRE(FileUtil::Delete(path));
+        TitleInfoCache cache(cache_path);
+        REQUIRE(cache.Save());
+        REQUIRE(ReadWord(ReadFile(cache_path), 8) == 0);
+    }
+
+    SECTION("ignores entries cut short") {
+        data.pop_back();
+        FileUtil::IOFile(cache_path, "wb").WriteBytes(data.data(), data.size());
+        TitleInfoCache cache(cache_path);
+        REQUIRE(cache.Get(path).smdh == smdh);
+    }
+
+    SECTION("ignores an invalid cache") {
+        data[0] ^= 1;
+        FileUtil::IOFile(cache_path, "wb").WriteBytes(data.data(), data.size());
+        TitleInfoCache cache(cache_path);
+        REQUIRE(cache.Get(path).smdh == smdh);
+    }
+}
+
+} // namespace Loader
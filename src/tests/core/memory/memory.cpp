@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include <catch2/catch.hpp>
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -54,3 +55,114 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::DirtyTracking", "[core][memory]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    auto& page_table = process->vm_manager.page_table;
+    memory.SetCurrentPageTable(&page_table);
+
+    constexpr VAddr vaddr = Memory::HEAP_VADDR;
+    constexpr u32 fcram_offset = 0x10000;
+    constexpr PAddr paddr = Memory::FCRAM_PADDR + fcram_offset;
+    u8* const backing_memory = memory.GetFCRAMPointer(fcram_offset);
+    process->vm_manager
+        .MapBackingMemory(vaddr, backing_memory, 2 * Memory::PAGE_SIZE,
+                          Kernel::MemoryState::Private)
+        .Unwrap();
+    const std::size_t page = vaddr >> Memory::PAGE_BITS;
+
+    SECTION("writes mark their pages") {
+        CHECK_FALSE(memory.IsRegionDirty(paddr, 2 * Memory::PAGE_SIZE));
+        memory.Write32(vaddr + Memory::PAGE_SIZE + 4, 0x12345678);
+        CHECK_FALSE(memory.IsRegionDirty(paddr, Memory::PAGE_SIZE));
+        CHECK(memory.CheckAndClearRegionDirty(paddr + Memory::PAGE_SIZE, 1));
+        CHECK_FALSE(memory.IsRegionDirty(paddr, 2 * Memory::PAGE_SIZE));
+
+        memory.MarkHostRegionDirty(backing_memory + Memory::PAGE_SIZE - 1, 2);
+        CHECK(memory.IsRegionDirty(paddr, 1));
+        CHECK(memory.IsRegionDirty(paddr + Memory::PAGE_SIZE, 1));
+    }
+
+    SECTION("write tracking protects clean pages until they are written") {
+        memory.MarkRegionDirty(paddr + Memory::PAGE_SIZE, 1);
+        std::memset(backing_memory, 0xAB, Memory::PAGE_SIZE);
+        memory.SetWriteTracking(true);
+        CHECK(page_table.pointers[page] == nullptr);
+        CHECK(page_table.attributes[page] == Memory::PageType::WriteTrackedMemory);
+        CHECK(page_table.pointers[page + 1] == backing_memory + Memory::PAGE_SIZE);
+        CHECK(Memory::IsValidVirtualAddress(*process, vaddr));
+
+        CHECK(memory.Read32(vaddr) == 0xABABABAB);
+        CHECK(memory.GetPointer(vaddr + 8) == backing_memory + 8);
+        CHECK_FALSE(memory.IsRegionDirty(paddr, 1));
+
+        memory.Write32(vaddr, 0x12345678);
+        CHECK(page_table.pointers[page] == backing_memory);
+        CHECK(page_table.attributes[page] == Memory::PageType::Memory);
+        CHECK(memory.IsRegionDirty(paddr, 1));
+
+        memory.ClearRegionDirty(paddr, 2 * Memory::PAGE_SIZE);
+        CHECK(page_table.pointers[page] == nullptr);
+        CHECK(page_table.pointers[page + 1] == nullptr);
+
+        u8 buffer[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        memory.WriteBlock(*process, vaddr + Memory::PAGE_SIZE - 4, buffer, sizeof(buffer));
+        CHECK(memory.IsRegionDirty(paddr, 1));
+        CHECK(memory.IsRegionDirty(paddr + Memory::PAGE_SIZE, 1));
+        CHECK(memory.Read32(vaddr + Memory::PAGE_SIZE) == 0x08070605);
+
+        memory.SetWriteTracking(false);
+        CHECK(page_table.pointers[page] == backing_memory);
+        CHECK(page_table.pointers[page + 1] == backing_memory + Memory::PAGE_SIZE);
+        CHECK(page_table.write_tracked_pointers.empty());
+    }
+
+    SECTION("clearing a region only protects the pages of that region") {
+        // An alias of the first page, mapped while write tracking is enabled
+        constexpr VAddr alias_vaddr = Memory::HEAP_VADDR + 0x100000;
+        const std::size_t alias_page = alias_vaddr >> Memory::PAGE_BITS;
+        memory.SetWriteTracking(true);
+        process->vm_manager
+            .MapBackingMemory(alias_vaddr, backing_memory, Memory::PAGE_SIZE,
+                              Kernel::MemoryState::Private)
+            .Unwrap();
+        CHECK(page_table.attributes[alias_page] == Memory::PageType::WriteTrackedMemory);
+
+        memory.Write32(vaddr, 1);
+        memory.Write32(alias_vaddr + 4, 2);
+        memory.Write32(vaddr + Memory::PAGE_SIZE, 3);
+        CHECK(page_table.pointers[page] == backing_memory);
+        CHECK(page_table.pointers[alias_page] == backing_memory);
+        CHECK(page_table.pointers[page + 1] == backing_memory + Memory::PAGE_SIZE);
+
+        memory.ClearRegionDirty(paddr, Memory::PAGE_SIZE);
+        CHECK(page_table.attributes[page] == Memory::PageType::WriteTrackedMemory);
+        CHECK(page_table.attributes[alias_page] == Memory::PageType::WriteTrackedMemory);
+        CHECK(page_table.pointers[page + 1] == backing_memory + Memory::PAGE_SIZE);
+        CHECK(memory.Read32(alias_vaddr) == 1);
+
+        CHECK(memory.CheckAndClearRegionDirty(paddr + Memory::PAGE_SIZE, 1));
+        CHECK(page_table.attributes[page + 1] == Memory::PageType::WriteTrackedMemory);
+
+        // A page remapped elsewhere isn't protected on behalf of the memory it used to map
+        u8* const other_memory = memory.GetFCRAMPointer(fcram_offset + 0x10000);
+        memory.MarkHostRegionDirty(other_memory, Memory::PAGE_SIZE);
+        process->vm_manager.UnmapRange(alias_vaddr, Memory::PAGE_SIZE);
+        process->vm_manager
+            .MapBackingMemory(alias_vaddr, other_memory, Memory::PAGE_SIZE,
+                              Kernel::MemoryState::Private)
+            .Unwrap();
+        memory.ClearRegionDirty(paddr, Memory::PAGE_SIZE);
+        CHECK(page_table.pointers[alias_page] == other_memory);
+    }
+
+    SECTION("remapping a write tracked page drops its protection") {
+        memory.SetWriteTracking(true);
+        process->vm_manager.UnmapRange(vaddr, 2 * Memory::PAGE_SIZE);
+        CHECK(page_table.attributes[page] == Memory::PageType::Unmapped);
+        CHECK(page_table.write_tracked_pointers.empty());
+    }
+}
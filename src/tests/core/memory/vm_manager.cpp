@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <vector>
 #include <catch2/catch.hpp>
 #include "core/hle/kernel/errors.h"
@@ -137,3 +138,124 @@ TEST_CASE("Memory Basics", "[kernel][memory]") {
         REQUIRE(code == RESULT_SUCCESS);
     }
 }
+
+TEST_CASE("VMManager::FindVMA", "[kernel][memory]") {
+    constexpr u32 INDEX_ENTRY_SIZE = 0x100000;
+    std::vector<u8> block(INDEX_ENTRY_SIZE + 4 * Memory::PAGE_SIZE);
+    Memory::MemorySystem memory;
+    // Because of the PageTable, Kernel::VMManager is too big to be created on the stack.
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+
+    // Compares the index used by FindVMA with a search of the VMA map for every page.
+    const auto CheckIndex = [&manager] {
+        for (VAddr page = 0; page < Kernel::VMManager::MAX_ADDRESS; page += Memory::PAGE_SIZE) {
+            const auto expected = std::prev(manager->vma_map.upper_bound(page));
+            if (manager->FindVMA(page) != expected ||
+                manager->FindVMA(page + Memory::PAGE_SIZE - 1) != expected) {
+                FAIL("FindVMA returned the wrong VMA for page 0x" << std::hex << page);
+            }
+        }
+        CHECK(manager->FindVMA(Kernel::VMManager::MAX_ADDRESS) == manager->vma_map.end());
+    };
+
+    CheckIndex();
+
+    // A mapping across the boundary between two index entries splits both of them.
+    const VAddr straddling = Memory::HEAP_VADDR + INDEX_ENTRY_SIZE - Memory::PAGE_SIZE;
+    REQUIRE(manager
+                ->MapBackingMemory(straddling, block.data(), 3 * Memory::PAGE_SIZE,
+                                   Kernel::MemoryState::Private)
+                .Succeeded());
+    CheckIndex();
+
+    // A mapping covering exactly one index entry.
+    const VAddr aligned = Memory::HEAP_VADDR + 4 * INDEX_ENTRY_SIZE;
+    REQUIRE(manager
+                ->MapBackingMemory(aligned, block.data() + 4 * Memory::PAGE_SIZE,
+                                   INDEX_ENTRY_SIZE, Kernel::MemoryState::Private)
+                .Succeeded());
+    CheckIndex();
+
+    // Changing the permissions of a single page splits its VMA, and restoring them merges it.
+    REQUIRE(manager->ReprotectRange(straddling + Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                                    Kernel::VMAPermission::Read) == RESULT_SUCCESS);
+    REQUIRE(manager->ReprotectRange(aligned + INDEX_ENTRY_SIZE / 2, Memory::PAGE_SIZE,
+                                    Kernel::VMAPermission::Read) == RESULT_SUCCESS);
+    CheckIndex();
+    REQUIRE(manager->ReprotectRange(straddling + Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                                    Kernel::VMAPermission::ReadWrite) == RESULT_SUCCESS);
+    REQUIRE(manager->ReprotectRange(aligned + INDEX_ENTRY_SIZE / 2, Memory::PAGE_SIZE,
+                                    Kernel::VMAPermission::ReadWrite) == RESULT_SUCCESS);
+    CheckIndex();
+
+    // Unmapping part of a VMA splits it, and unmapping everything merges the free VMAs again.
+    REQUIRE(manager->UnmapRange(aligned + Memory::PAGE_SIZE, 2 * Memory::PAGE_SIZE) ==
+            RESULT_SUCCESS);
+    CheckIndex();
+    REQUIRE(manager->UnmapRange(straddling, 3 * Memory::PAGE_SIZE) == RESULT_SUCCESS);
+    REQUIRE(manager->UnmapRange(aligned, Memory::PAGE_SIZE) == RESULT_SUCCESS);
+    REQUIRE(manager->UnmapRange(aligned + 3 * Memory::PAGE_SIZE,
+                                INDEX_ENTRY_SIZE - 3 * Memory::PAGE_SIZE) == RESULT_SUCCESS);
+    CheckIndex();
+    CHECK(manager->vma_map.size() == 1);
+}
+
+TEST_CASE("VMManager[Churn]", "[kernel][memory][.benchmark]") {
+    constexpr u32 NUM_OPERATIONS = 100000;
+    constexpr u32 NUM_SLOTS = 256;
+    constexpr u32 SLOT_SIZE = 16 * Memory::PAGE_SIZE;
+
+    std::vector<u8> block(NUM_SLOTS * SLOT_SIZE);
+    std::vector<bool> mapped(NUM_SLOTS);
+    Memory::MemorySystem memory;
+    // Because of the PageTable, Kernel::VMManager is too big to be created on the stack.
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Map and unmap pseudo-randomly sized blocks, and query addresses in between like
+    // svcQueryMemory and IPC buffer validation do.
+    u64 seed = 1;
+    u32 queries_matched = 0;
+    for (u32 i = 0; i < NUM_OPERATIONS; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        const u32 slot = static_cast<u32>(seed >> 33) % NUM_SLOTS;
+        const u32 pages = 1 + static_cast<u32>(seed >> 20) % (SLOT_SIZE / Memory::PAGE_SIZE);
+        const VAddr address = Memory::HEAP_VADDR + slot * SLOT_SIZE;
+
+        if (mapped[slot]) {
+            REQUIRE(manager->UnmapRange(address, SLOT_SIZE) == RESULT_SUCCESS);
+            mapped[slot] = false;
+        } else {
+            REQUIRE(manager
+                        ->MapBackingMemory(address, &block[slot * SLOT_SIZE],
+                                           pages * Memory::PAGE_SIZE, Kernel::MemoryState::Private)
+                        .Succeeded());
+            // Fill the rest of the slot so that it can be unmapped as a whole
+            if (pages * Memory::PAGE_SIZE != SLOT_SIZE) {
+                REQUIRE(manager
+                            ->MapBackingMemory(address + pages * Memory::PAGE_SIZE,
+                                               &block[slot * SLOT_SIZE + pages * Memory::PAGE_SIZE],
+                                               SLOT_SIZE - pages * Memory::PAGE_SIZE,
+                                               Kernel::MemoryState::Continuous)
+                            .Succeeded());
+            }
+            mapped[slot] = true;
+        }
+
+        for (u32 query = 0; query < 16; ++query) {
+            const u32 offset = static_cast<u32>(seed >> (query + 8)) % (NUM_SLOTS * SLOT_SIZE);
+            const VAddr target = Memory::HEAP_VADDR + offset;
+            const auto vma = manager->FindVMA(target);
+            if (vma->second.base <= target && target - vma->second.base < vma->second.size) {
+                ++queries_matched;
+            }
+        }
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    REQUIRE(NUM_OPERATIONS * 16 == queries_matched);
+    WARN(NUM_OPERATIONS << " map/unmap operations and " << NUM_OPERATIONS * 16 << " queries in "
+                        << elapsed.count() << " us");
+}
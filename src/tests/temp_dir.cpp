@@ -0,0 +1,71 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/string_util.h"
+#include "tests/temp_dir.h"
+
+namespace Tests {
+
+namespace {
+
+std::string GetHostTempPath() {
+#ifdef _WIN32
+    wchar_t buffer[MAX_PATH + 1];
+    const DWORD length = GetTempPathW(MAX_PATH + 1, buffer);
+    std::string path = Common::UTF16ToUTF8(std::wstring(buffer, length));
+#else
+    const char* tmpdir = std::getenv("TMPDIR");
+    std::string path = tmpdir != nullptr && tmpdir[0] != '\0' ? tmpdir : "/tmp";
+#endif
+    while (!path.empty() && (path.back() == '/' || path.back() == '\\')) {
+        path.pop_back();
+    }
+    return path;
+}
+
+u64 GetProcessId() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<u64>(getpid());
+#endif
+}
+
+std::atomic<u32> next_dir_id{0};
+
+} // Anonymous namespace
+
+TempDir::TempDir() {
+    const std::string base = GetHostTempPath() + DIR_SEP "citra-tests-" +
+                             std::to_string(GetProcessId()) + "-";
+    // Directories left behind by a crashed run of a process with the same ID are skipped.
+    for (u32 attempt = 0; attempt < 1000; ++attempt) {
+        const std::string candidate = base + std::to_string(next_dir_id++);
+        if (!FileUtil::Exists(candidate) && FileUtil::CreateDir(candidate)) {
+            path = candidate;
+            return;
+        }
+    }
+    throw std::runtime_error("Could not create a temporary directory in " + base);
+}
+
+TempDir::~TempDir() {
+    FileUtil::DeleteDirRecursively(path);
+}
+
+std::string TempDir::GetPath(const std::string& name) const {
+    return path + DIR_SEP + name;
+}
+
+} // namespace Tests
@@ -0,0 +1,33 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include "common/common_types.h"
+
+namespace Tests {
+
+/**
+ * Creates an empty directory in the temporary directory of the host, and deletes it along with
+ * its contents when destroyed, so that tests don't write to the working directory.
+ */
+class TempDir final : NonCopyable {
+public:
+    TempDir();
+    ~TempDir();
+
+    /// Gets the path of the directory, without a trailing separator
+    const std::string& GetPath() const {
+        return path;
+    }
+
+    /// Gets the path of an entry in the directory
+    std::string GetPath(const std::string& name) const;
+
+private:
+    std::string path;
+};
+
+} // namespace Tests
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include "common/chunk_file.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -21,6 +22,42 @@ void Shutdown() {
     Shader::Shutdown();
 }
 
+void DoState(PointerWrap& p) {
+    State& state = g_state;
+    p.DoVoid(&state.regs, sizeof(state.regs));
+    for (Shader::ShaderSetup* setup : {&state.vs, &state.gs}) {
+        p.DoVoid(&setup->uniforms, sizeof(setup->uniforms));
+        p.DoVoid(setup->program_code.data(), sizeof(setup->program_code));
+        p.DoVoid(setup->swizzle_data.data(), sizeof(setup->swizzle_data));
+    }
+    p.DoVoid(&state.input_default_attributes, sizeof(state.input_default_attributes));
+    p.DoVoid(&state.proctex, sizeof(state.proctex));
+    p.DoVoid(&state.lighting, sizeof(state.lighting));
+    p.DoVoid(&state.fog, sizeof(state.fog));
+    p.DoVoid(&state.immediate.input_vertex, sizeof(state.immediate.input_vertex));
+    p.Do(state.immediate.current_attribute);
+    p.Do(state.immediate.reset_geometry_pipeline);
+    p.DoVoid(&state.gs_unit.registers, sizeof(state.gs_unit.registers));
+    p.Do(state.gs_unit.conditional_code);
+    p.Do(state.gs_unit.address_registers);
+
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        return;
+    }
+
+    for (Shader::ShaderSetup* setup : {&state.vs, &state.gs}) {
+        setup->MarkProgramCodeDirty();
+        setup->MarkSwizzleDataDirty();
+    }
+    // States are saved between command lists, so there is no partially assembled primitive to
+    // restore.
+    state.primitive_assembler.Reconfigure(state.regs.pipeline.triangle_topology);
+    state.geometry_pipeline.Reconfigure();
+    for (u32 id = 0; id < Regs::NUM_REGS; ++id) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+}
+
 template <typename T>
 void Zero(T& o) {
     memset(&o, 0, sizeof(o));
@@ -5,6 +5,9 @@
 #pragma once
 
 #include "video_core/regs_texturing.h"
+
+class PointerWrap;
+
 namespace Pica {
 
 /// Initialize Pica state
@@ -13,4 +16,7 @@ void Init();
 /// Shutdown Pica state
 void Shutdown();
 
+/// Saves or restores the Pica state, including the shader setup and the lookup tables
+void DoState(PointerWrap& p);
+
 } // namespace Pica
@@ -119,6 +119,26 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/**
+ * Marks the bound color and depth buffers as modified for the memory dirty tracking, since the
+ * pixel writes go through host pointers. This covers the whole buffers once per triangle instead
+ * of marking every single pixel.
+ */
+static void MarkFramebufferDirty() {
+    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    if (framebuffer.allow_color_write != 0) {
+        // Shadow rendering always writes 4 bytes per pixel, so use that as the upper bound
+        VideoCore::g_memory->MarkRegionDirty(framebuffer.GetColorBufferPhysicalAddress(),
+                                             num_pixels * 4);
+    }
+    if (framebuffer.allow_depth_stencil_write != 0) {
+        VideoCore::g_memory->MarkRegionDirty(
+            framebuffer.GetDepthBufferPhysicalAddress(),
+            num_pixels * FramebufferRegs::BytesPerDepthPixel(framebuffer.depth_format));
+    }
+}
+
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
  * culling via recursion.
@@ -160,6 +180,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             return;
     }
 
+    MarkFramebufferDirty();
+
     u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
     u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
     u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});